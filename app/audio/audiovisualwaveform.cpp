@@ -20,7 +20,14 @@
 
 #include "audiovisualwaveform.h"
 
+#include <cmath>
+#include <limits>
 #include <QDebug>
+#include <QVarLengthArray>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include "config/config.h"
 #include "common/functiontimer.h"
@@ -35,11 +42,13 @@ AudioVisualWaveform::AudioVisualWaveform() :
   static const rational kMaximumSampleRate = 8192;
 
   for (rational i=kMinimumSampleRate; i<=kMaximumSampleRate; i*=2) {
-    mipmapped_data_.insert({i, Sample()});
+    mipmapped_data_.insert({i, QuantizedData()});
   }
 }
 
-void AudioVisualWaveform::OverwriteSamplesFromBuffer(SampleBufferPtr samples, int sample_rate, const rational &start, double target_rate, Sample& data, int &start_index, int &samples_length)
+const float AudioVisualWaveform::kQuantizedUnity = 16384.0f;
+
+void AudioVisualWaveform::OverwriteSamplesFromBuffer(SampleBufferPtr samples, int sample_rate, const rational &start, double target_rate, QuantizedData& data, int &start_index, int &samples_length)
 {
   start_index = time_to_samples(start, target_rate);
   samples_length = time_to_samples(static_cast<double>(samples->sample_count()) / static_cast<double>(sample_rate), target_rate);
@@ -50,21 +59,27 @@ void AudioVisualWaveform::OverwriteSamplesFromBuffer(SampleBufferPtr samples, in
   }
 
   int chunk_size = sample_rate / target_rate;
+  int buffer_channels = qMin(channels_, samples->audio_params().channel_count());
+  QuantizedSample* dst = data.data() + start_index;
 
   for (int i=0; i<samples_length; i+=channels_) {
     int src_index = (i * chunk_size) / channels_;
+    int src_length = qMin(chunk_size, samples->sample_count() - src_index);
+
+    memset(&dst[i], 0, channels_ * sizeof(QuantizedSample));
 
-    Sample summary = SumSamples(samples,
-                                src_index,
-                                qMin(chunk_size, samples->sample_count() - src_index));
+    for (int channel=0; channel<buffer_channels; channel++) {
+      SamplePerChannel sum = {0, 0};
 
-    memcpy(&data.data()[i + start_index],
-        summary.constData(),
-        summary.size() * sizeof(SamplePerChannel));
+      SumPlanarSamplesInto(samples->data(channel) + src_index, src_length, &sum);
+
+      dst[i + channel].min = Quantize(sum.min);
+      dst[i + channel].max = Quantize(sum.max);
+    }
   }
 }
 
-void AudioVisualWaveform::OverwriteSamplesFromMipmap(const AudioVisualWaveform::Sample &input, double input_sample_rate, int &input_start, int &input_length, const rational &start, double output_rate, AudioVisualWaveform::Sample &output_data)
+void AudioVisualWaveform::OverwriteSamplesFromMipmap(const QuantizedData &input, double input_sample_rate, int &input_start, int &input_length, const rational &start, double output_rate, QuantizedData &output_data)
 {
   int start_index = time_to_samples(start, output_rate);
   int samples_length = time_to_samples(static_cast<double>(input_length / channels_) / input_sample_rate, output_rate);
@@ -75,13 +90,13 @@ void AudioVisualWaveform::OverwriteSamplesFromMipmap(const AudioVisualWaveform::
   }
 
   int chunk_size = input_sample_rate / output_rate;
+  const QuantizedSample* src = input.constData() + input_start;
+  QuantizedSample* dst = output_data.data() + start_index;
 
   for (int i=0; i<samples_length; i+=channels_) {
-    Sample summary = ReSumSamples(&input.constData()[input_start + (i*chunk_size)], chunk_size * channels_, channels_);
+    memset(&dst[i], 0, channels_ * sizeof(QuantizedSample));
 
-    memcpy(&output_data.data()[i + start_index],
-        summary.constData(),
-        summary.size() * sizeof(SamplePerChannel));
+    ReSumQuantizedInto(&src[i*chunk_size], chunk_size * channels_, channels_, &dst[i]);
   }
 
   input_start = start_index;
@@ -131,8 +146,8 @@ void AudioVisualWaveform::OverwriteSums(const AudioVisualWaveform &sums, const r
   for (auto it=mipmapped_data_.begin(); it!=mipmapped_data_.end(); it++) {
     rational rate = it->first;
 
-    Sample& our_arr = it->second;
-    const Sample& their_arr = sums.mipmapped_data_.at(rate);
+    QuantizedData& our_arr = it->second;
+    const QuantizedData& their_arr = sums.mipmapped_data_.at(rate);
 
     double rate_dbl = rate.toDouble();
 
@@ -154,9 +169,9 @@ void AudioVisualWaveform::OverwriteSums(const AudioVisualWaveform &sums, const r
       our_arr.resize(end_index);
     }
 
-    memcpy(reinterpret_cast<char*>(our_arr.data()) + our_start_index * sizeof(SamplePerChannel),
-           reinterpret_cast<const char*>(their_arr.constData()) + their_start_index * sizeof(SamplePerChannel),
-           copy_len * sizeof(SamplePerChannel));
+    memcpy(reinterpret_cast<char*>(our_arr.data()) + our_start_index * sizeof(QuantizedSample),
+           reinterpret_cast<const char*>(their_arr.constData()) + their_start_index * sizeof(QuantizedSample),
+           copy_len * sizeof(QuantizedSample));
   }
 
   length_ = qMax(length_, dest + length);
@@ -167,7 +182,7 @@ void AudioVisualWaveform::Shift(const rational &from, const rational &to)
   for (auto it=mipmapped_data_.begin(); it!=mipmapped_data_.end(); it++) {
     rational rate = it->first;
     double rate_dbl = rate.toDouble();
-    Sample& data = it->second;
+    QuantizedData& data = it->second;
 
     int from_index = time_to_samples(from, rate_dbl);
     int to_index = time_to_samples(to, rate_dbl);
@@ -203,7 +218,7 @@ void AudioVisualWaveform::Shift(const rational &from, const rational &to)
         data.replace(data.size() - i - 1, data.at(old_sz - i - 1));
       }
 
-      memset(reinterpret_cast<char*>(&data[from_index]), 0, distance * sizeof(SamplePerChannel));
+      memset(reinterpret_cast<char*>(&data[from_index]), 0, distance * sizeof(QuantizedSample));
     }
   }
 
@@ -220,7 +235,9 @@ AudioVisualWaveform::Sample AudioVisualWaveform::GetSummaryFromTime(const ration
   int start_sample = time_to_samples(start, rate_dbl);
   int sample_length = time_to_samples(length, rate_dbl);
 
-  return ReSumSamples(&using_mipmap->second.constData()[start_sample], sample_length, channels_);
+  Sample summary;
+  SummarizeQuantized(&using_mipmap->second.constData()[start_sample], sample_length, &summary);
+  return summary;
 }
 
 AudioVisualWaveform::Sample AudioVisualWaveform::SumSamples(const float *samples, int nb_samples, int nb_channels)
@@ -238,12 +255,8 @@ AudioVisualWaveform::Sample AudioVisualWaveform::SumSamples(SampleBufferPtr samp
 {
   AudioVisualWaveform::Sample summed_samples(samples->audio_params().channel_count());
 
-  int end_index = start_index + length;
-
-  for (int i=start_index; i<end_index; i++) {
-    for (int channel=0; channel<samples->audio_params().channel_count(); channel++) {
-      ExpandMinMax(summed_samples[channel], samples->data(channel)[i]);
-    }
+  for (int channel=0; channel<samples->audio_params().channel_count(); channel++) {
+    SumPlanarSamplesInto(samples->data(channel) + start_index, length, &summed_samples[channel]);
   }
 
   return summed_samples;
@@ -255,21 +268,101 @@ AudioVisualWaveform::Sample AudioVisualWaveform::ReSumSamples(const SamplePerCha
 {
   AudioVisualWaveform::Sample summed_samples(nb_channels);
 
-  for (int i=0;i<nb_samples;i+=nb_channels) {
-    for (int j=0;j<nb_channels;j++) {
-      const AudioVisualWaveform::SamplePerChannel& sample = samples[i + j];
+  ReSumSamplesInto(samples, nb_samples, nb_channels, summed_samples.data());
+
+  return summed_samples;
+}
+
+void AudioVisualWaveform::SumPlanarSamplesInto(const float *samples, int nb_samples, SamplePerChannel *out)
+{
+  int i = 0;
+  float min = out->min;
+  float max = out->max;
+
+#if defined(__SSE2__)
+  if (nb_samples >= 4) {
+    __m128 vmin = _mm_set1_ps(min);
+    __m128 vmax = _mm_set1_ps(max);
+
+    for (; i+4<=nb_samples; i+=4) {
+      // Accumulators are the second operand so NaNs are skipped like ExpandMinMax() does
+      __m128 v = _mm_loadu_ps(samples + i);
+      vmin = _mm_min_ps(v, vmin);
+      vmax = _mm_max_ps(v, vmax);
+    }
+
+    alignas(16) float lanes_min[4];
+    alignas(16) float lanes_max[4];
+    _mm_store_ps(lanes_min, vmin);
+    _mm_store_ps(lanes_max, vmax);
+
+    for (int j=0; j<4; j++) {
+      min = qMin(min, lanes_min[j]);
+      max = qMax(max, lanes_max[j]);
+    }
+  }
+#endif
+
+  for (; i<nb_samples; i++) {
+    if (samples[i] < min) {
+      min = samples[i];
+    }
+
+    if (samples[i] > max) {
+      max = samples[i];
+    }
+  }
+
+  out->min = min;
+  out->max = max;
+}
+
+void AudioVisualWaveform::ReSumSamplesInto(const SamplePerChannel *samples, int nb_samples, int nb_channels, SamplePerChannel *out)
+{
+  if (nb_channels <= 0) {
+    return;
+  }
+
+  // Summaries are pairs of floats, so treat each frame (one summary per channel) as a flat row of
+  // alternating minimums and maximums and reduce the rows together
+  const float* src = reinterpret_cast<const float*>(samples);
+  float* dst = reinterpret_cast<float*>(out);
+  int row_length = nb_channels * 2;
+  int nb_rows = nb_samples / nb_channels;
+  int j = 0;
+
+#if defined(__SSE2__)
+  for (; j+4<=row_length; j+=4) {
+    __m128 vmin = _mm_loadu_ps(dst + j);
+    __m128 vmax = vmin;
+
+    for (int row=0; row<nb_rows; row++) {
+      __m128 v = _mm_loadu_ps(src + row * row_length + j);
+      vmin = _mm_min_ps(v, vmin);
+      vmax = _mm_max_ps(v, vmax);
+    }
+
+    // Take even lanes (minimums) from vmin and odd lanes (maximums) from vmax
+    __m128 shuffled = _mm_shuffle_ps(vmin, vmax, _MM_SHUFFLE(3, 1, 2, 0));
+    _mm_storeu_ps(dst + j, _mm_shuffle_ps(shuffled, shuffled, _MM_SHUFFLE(3, 1, 2, 0)));
+  }
+#endif
+
+  for (; j<row_length; j+=2) {
+    SamplePerChannel& sum = out[j/2];
+
+    for (int row=0; row<nb_rows; row++) {
+      const float* sample = src + row * row_length + j;
 
-      if (sample.min < summed_samples[j].min) {
-        summed_samples[j].min = sample.min;
+      if (sample[0] < sum.min) {
+        sum.min = sample[0];
       }
 
-      if (sample.max > summed_samples[j].max) {
-        summed_samples[j].max = sample.max;
+      if (sample[1] > sum.max) {
+        sum.max = sample[1];
       }
     }
   }
-
-  return summed_samples;
 }
 
 void AudioVisualWaveform::DrawSample(QPainter *painter, const Sample& sample, int x, int y, int height, bool rectified)
@@ -315,7 +408,7 @@ void AudioVisualWaveform::DrawWaveform(QPainter *painter, const QRect& rect, con
 
   rational rate = using_mipmap->first;
   double rate_dbl = rate.toDouble();
-  const Sample& arr = using_mipmap->second;
+  const QuantizedData& arr = using_mipmap->second;
 
   int start_sample_index = samples.time_to_samples(start_time, rate_dbl);
 
@@ -348,9 +441,9 @@ void AudioVisualWaveform::DrawWaveform(QPainter *painter, const QRect& rect, con
                              start_sample_index + qFloor(rate_dbl * static_cast<double>(i - rect.x() + 1) / scale) * samples.channel_count());
 
     if (summary_index != sample_index) {
-      summary = AudioVisualWaveform::ReSumSamples(&arr.at(sample_index),
-                                                  qMax(samples.channel_count(), next_sample_index - sample_index),
-                                                  samples.channel_count());
+      samples.SummarizeQuantized(&arr.at(sample_index),
+                                 qMax(samples.channel_count(), next_sample_index - sample_index),
+                                 &summary);
       summary_index = sample_index;
     }
 
@@ -368,7 +461,7 @@ int AudioVisualWaveform::time_to_samples(const double &time, double sample_rate)
   return qFloor(time * sample_rate) * channels_;
 }
 
-std::map<rational, AudioVisualWaveform::Sample>::const_iterator AudioVisualWaveform::GetMipmapForScale(double scale) const
+std::map<rational, AudioVisualWaveform::QuantizedData>::const_iterator AudioVisualWaveform::GetMipmapForScale(double scale) const
 {
   // Find largest mipmap for this scale (or the largest if we don't find one sufficient)
   auto using_mipmap = mipmapped_data_.cend();
@@ -382,6 +475,90 @@ std::map<rational, AudioVisualWaveform::Sample>::const_iterator AudioVisualWavef
   return using_mipmap;
 }
 
+qint64 AudioVisualWaveform::memory_usage() const
+{
+  qint64 sz = 0;
+
+  for (auto it=mipmapped_data_.cbegin(); it!=mipmapped_data_.cend(); it++) {
+    sz += it->second.capacity() * qint64(sizeof(QuantizedSample));
+  }
+
+  return sz;
+}
+
+qint16 AudioVisualWaveform::Quantize(float f)
+{
+  float q = std::round(f * kQuantizedUnity);
+
+  // Also catches NaN, which would otherwise be undefined to convert
+  if (!(q > std::numeric_limits<qint16>::min())) {
+    return std::numeric_limits<qint16>::min();
+  } else if (q >= std::numeric_limits<qint16>::max()) {
+    return std::numeric_limits<qint16>::max();
+  } else {
+    return qint16(q);
+  }
+}
+
+void AudioVisualWaveform::ReSumQuantizedInto(const QuantizedSample *samples, int nb_samples, int nb_channels, QuantizedSample *out)
+{
+  if (nb_channels <= 0) {
+    return;
+  }
+
+  // Same approach as ReSumSamplesInto(), only with eight 16-bit lanes per vector
+  const qint16* src = reinterpret_cast<const qint16*>(samples);
+  qint16* dst = reinterpret_cast<qint16*>(out);
+  int row_length = nb_channels * 2;
+  int nb_rows = nb_samples / nb_channels;
+  int j = 0;
+
+#if defined(__SSE2__)
+  // Selects the low (minimum) half of every 32-bit summary
+  const __m128i min_mask = _mm_set1_epi32(0x0000FFFF);
+
+  for (; j+8<=row_length; j+=8) {
+    __m128i vmin = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + j));
+    __m128i vmax = vmin;
+
+    for (int row=0; row<nb_rows; row++) {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + row * row_length + j));
+      vmin = _mm_min_epi16(vmin, v);
+      vmax = _mm_max_epi16(vmax, v);
+    }
+
+    __m128i merged = _mm_or_si128(_mm_and_si128(vmin, min_mask), _mm_andnot_si128(min_mask, vmax));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + j), merged);
+  }
+#endif
+
+  for (; j<row_length; j+=2) {
+    QuantizedSample& sum = out[j/2];
+
+    for (int row=0; row<nb_rows; row++) {
+      const qint16* sample = src + row * row_length + j;
+
+      sum.min = qMin(sum.min, sample[0]);
+      sum.max = qMax(sum.max, sample[1]);
+    }
+  }
+}
+
+void AudioVisualWaveform::SummarizeQuantized(const QuantizedSample *samples, int nb_samples, Sample *out) const
+{
+  QVarLengthArray<QuantizedSample, 8> quantized(channels_);
+  memset(quantized.data(), 0, channels_ * sizeof(QuantizedSample));
+
+  ReSumQuantizedInto(samples, nb_samples, channels_, quantized.data());
+
+  out->resize(channels_);
+
+  for (int i=0; i<channels_; i++) {
+    (*out)[i].min = quantized.at(i).min / kQuantizedUnity;
+    (*out)[i].max = quantized.at(i).max / kQuantizedUnity;
+  }
+}
+
 void AudioVisualWaveform::ExpandMinMax(AudioVisualWaveform::SamplePerChannel &sum, float value)
 {
   if (value < sum.min) {
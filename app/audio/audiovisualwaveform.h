@@ -97,25 +97,66 @@ public:
 
   static Sample ReSumSamples(const SamplePerChannel *samples, int nb_samples, int nb_channels);
 
+  /**
+   * @brief Expands `out` to cover every value of a single planar channel
+   *
+   * Unlike SumSamples(), this doesn't allocate anything so it can write straight into a mipmap.
+   */
+  static void SumPlanarSamplesInto(const float* samples, int nb_samples, SamplePerChannel* out);
+
+  /**
+   * @brief Expands `out` (`nb_channels` long) to cover interleaved summaries
+   *
+   * Unlike ReSumSamples(), this doesn't allocate anything so it can write straight into a mipmap.
+   */
+  static void ReSumSamplesInto(const SamplePerChannel *samples, int nb_samples, int nb_channels, SamplePerChannel* out);
+
   static void DrawSample(QPainter* painter, const Sample &sample, int x, int y, int height, bool rectified);
 
   static void DrawWaveform(QPainter* painter, const QRect &rect, const double &scale, const AudioVisualWaveform& samples, const rational &start_time);
 
+  /**
+   * @brief Number of bytes used by all mipmaps
+   */
+  qint64 memory_usage() const;
+
 private:
+  /**
+   * @brief Summary as it's stored in the mipmaps
+   *
+   * Mipmaps are stored as 16-bit fixed point, where kQuantizedUnity is 1.0, to use half the
+   * memory of float pairs. That's far more precision than a waveform or meter can show, and leaves
+   * headroom above 1.0 so clipping is still visible.
+   */
+  struct QuantizedSample {
+    qint16 min;
+    qint16 max;
+  };
+
+  using QuantizedData = QVector<QuantizedSample>;
+
+  static const float kQuantizedUnity;
+
+  static qint16 Quantize(float f);
+
+  static void ReSumQuantizedInto(const QuantizedSample* samples, int nb_samples, int nb_channels, QuantizedSample* out);
+
   static void ExpandMinMax(SamplePerChannel &sum, float value);
 
-  void OverwriteSamplesFromBuffer(SampleBufferPtr samples, int sample_rate, const rational& start, double target_rate, Sample &data, int &start_index, int &samples_length);
+  void SummarizeQuantized(const QuantizedSample* samples, int nb_samples, Sample* out) const;
+
+  void OverwriteSamplesFromBuffer(SampleBufferPtr samples, int sample_rate, const rational& start, double target_rate, QuantizedData &data, int &start_index, int &samples_length);
 
-  void OverwriteSamplesFromMipmap(const Sample& input, double input_sample_rate, int &input_start, int &input_length, const rational& start, double output_rate, Sample &output_data);
+  void OverwriteSamplesFromMipmap(const QuantizedData& input, double input_sample_rate, int &input_start, int &input_length, const rational& start, double output_rate, QuantizedData &output_data);
 
   int time_to_samples(const rational& time, double sample_rate) const;
   int time_to_samples(const double& time, double sample_rate) const;
 
-  std::map<rational, Sample>::const_iterator GetMipmapForScale(double scale) const;
+  std::map<rational, QuantizedData>::const_iterator GetMipmapForScale(double scale) const;
 
   int channels_;
 
-  std::map<rational, Sample> mipmapped_data_;
+  std::map<rational, QuantizedData> mipmapped_data_;
 
   rational length_;
 
@@ -42,9 +42,14 @@ QMutex Decoder::currently_conforming_mutex_;
 QWaitCondition Decoder::currently_conforming_wait_cond_;
 QVector<Decoder::CurrentlyConforming> Decoder::currently_conforming_;
 
+QAtomicInt Decoder::read_ahead_frames_limit_ = 0;
+QAtomicInt Decoder::read_ahead_memory_limit_ = 0;
+
 const rational Decoder::kAnyTimecode = RATIONAL_MIN;
 
-Decoder::Decoder()
+Decoder::Decoder() :
+  read_ahead_frames_(0),
+  read_ahead_memory_(0)
 {
   UpdateLastAccessed();
 }
@@ -80,6 +85,10 @@ bool Decoder::Open(const CodecStream &stream)
     // Set stream
     stream_ = stream;
 
+    // Snapshot read-ahead limits so they stay consistent for as long as we're open
+    read_ahead_frames_ = read_ahead_frames_limit_.load();
+    read_ahead_memory_ = qint64(read_ahead_memory_limit_.load()) * 1024 * 1024;
+
     // Try open internal
     if (OpenInternal()) {
       return true;
@@ -245,6 +254,38 @@ QString Decoder::GetConformedFilename(const QString& cache_path, const AudioPara
   return index_fn;
 }
 
+QString Decoder::GetProxyFilename(const QString &cache_path, const CodecStream &stream, int divider)
+{
+  QString proxy_fn = QStringLiteral("%1.%2.proxy%3.mov").arg(FileFunctions::GetUniqueFileIdentifier(stream.filename()),
+                                                          QString::number(stream.stream()),
+                                                          QString::number(divider));
+
+  return QDir(cache_path).filePath(proxy_fn);
+}
+
+QString Decoder::FindProxy(const QString &cache_path, const CodecStream &stream, int divider, int *proxy_divider)
+{
+  if (cache_path.isEmpty() || divider <= 1) {
+    return QString();
+  }
+
+  // Iterate from the largest divider down so we decode the least data possible
+  for (int i=VideoParams::kSupportedDividers.size()-1; i>=0; i--) {
+    int d = VideoParams::kSupportedDividers.at(i);
+
+    if (d > 1 && d <= divider && divider % d == 0) {
+      QString proxy_fn = GetProxyFilename(cache_path, stream, d);
+
+      if (QFileInfo::exists(proxy_fn)) {
+        *proxy_divider = d;
+        return proxy_fn;
+      }
+    }
+  }
+
+  return QString();
+}
+
 int64_t Decoder::GetTimeInTimebaseUnits(const rational &time, const rational &timebase, int64_t start_time)
 {
   return Timecode::time_to_timestamp(time, timebase) + start_time;
@@ -309,6 +350,18 @@ FramePtr Decoder::RetrieveVideoInternal(const rational &timecode, const Retrieve
   return nullptr;
 }
 
+void Decoder::SetReadAheadLimits(int frames, int memory_mib)
+{
+  read_ahead_frames_limit_ = frames;
+  read_ahead_memory_limit_ = memory_mib;
+}
+
+int Decoder::GetReducedResolutionLevel(int divider) const
+{
+  Q_UNUSED(divider)
+  return 0;
+}
+
 bool Decoder::ConformAudioInternal(const QString& filename, const AudioParams &params, const QAtomicInt* cancelled)
 {
   Q_UNUSED(filename)
@@ -25,6 +25,7 @@ extern "C" {
 #include <libswresample/swresample.h>
 }
 
+#include <QAtomicInt>
 #include <QFileInfo>
 #include <QMutex>
 #include <QObject>
@@ -79,6 +80,15 @@ public:
   virtual bool SupportsVideo(){return false;}
   virtual bool SupportsAudio(){return false;}
 
+  /**
+   * @brief Whether this decoder can serve every file of an image sequence from one instance
+   *
+   * If TRUE, the decoder is opened once with the sequence's filename and the file to read is
+   * chosen per frame with RetrieveVideoParams::sequence_index. Otherwise, a new decoder must be
+   * opened for each file of the sequence.
+   */
+  virtual bool SupportsImageSequences(){return false;}
+
   class CodecStream
   {
   public:
@@ -150,12 +160,18 @@ public:
       divider = 1;
       src_interlacing = VideoParams::kInterlaceNone;
       dst_interlacing = VideoParams::kInterlaceNone;
+      sequence_index = AV_NOPTS_VALUE;
     }
 
     int divider;
     VideoParams::Interlacing src_interlacing;
     VideoParams::Interlacing dst_interlacing;
 
+    // Index of the file to read for image sequences, AV_NOPTS_VALUE otherwise. Like the timecode,
+    // this selects which frame to retrieve rather than how to decode it, so it's deliberately left
+    // out of the comparison operators.
+    int64_t sequence_index;
+
     void reset()
     {
       *this = RetrieveVideoParams();
@@ -199,6 +215,35 @@ public:
    */
   qint64 GetLastAccessedTime();
 
+  /**
+   * @brief Get the reduced resolution level this decoder would decode at for a divider
+   *
+   * Some decoders (e.g. FFmpeg's lowres) must re-open to switch resolutions, so callers sharing
+   * decoders should keep one instance per level rather than have one instance switch back and forth
+   * between consumers. A level of 0 means the decoder works the same for every divider.
+   *
+   * Sub-classes should override this if they decode differently depending on the divider. It's
+   * called without the decoder's mutex so it doesn't wait on a decode in progress, which means it
+   * may only read state that's fixed once the decoder is open.
+   */
+  virtual int GetReducedResolutionLevel(int divider) const;
+
+  /**
+   * @brief Set how far decoders may read ahead of sequential requests
+   *
+   * Decoders copy these when they open so render threads never read Config directly. A value of 0
+   * for either disables read-ahead.
+   *
+   * @param frames
+   *
+   * Maximum number of frames to read ahead
+   *
+   * @param memory_mib
+   *
+   * Maximum memory in MiB a single decoder may use for frames it read ahead
+   */
+  static void SetReadAheadLimits(int frames, int memory_mib);
+
   /**
    * @brief Generate a Footage object from a file
    *
@@ -236,6 +281,24 @@ public:
 
   static QVector<DecoderPtr> ReceiveListOfAllDecoders();
 
+  /**
+   * @brief Get the filename of a reduced-resolution proxy of a stream
+   *
+   * Proxies live in the cache path and are keyed by the source's unique file identifier, so
+   * they're automatically orphaned if the original file changes.
+   */
+  static QString GetProxyFilename(const QString& cache_path, const CodecStream& stream, int divider);
+
+  /**
+   * @brief Find the most reduced proxy that can be used to render at a certain divider
+   *
+   * Only proxies whose divider divides evenly into `divider` are considered so that the final
+   * frame has exactly the same dimensions as the original decoded at `divider`. If one is found,
+   * its filename is returned and `proxy_divider` is set to its divider. Otherwise, an empty string
+   * is returned.
+   */
+  static QString FindProxy(const QString& cache_path, const CodecStream& stream, int divider, int* proxy_divider);
+
 protected:
   /**
    * @brief Internal open function
@@ -298,6 +361,33 @@ protected:
 
   static int64_t GetTimeInTimebaseUnits(const rational& time, const rational& timebase, int64_t start_time);
 
+  /**
+   * @brief The mutex that RetrieveVideo() and RetrieveAudio() hold while calling sub-classes
+   *
+   * Sub-classes may release it around long operations that touch no decoder state, as long as it's
+   * locked again before they return.
+   */
+  QMutex* mutex()
+  {
+    return &mutex_;
+  }
+
+  /**
+   * @brief Read-ahead frame limit at the time this decoder was opened
+   */
+  int read_ahead_frames() const
+  {
+    return read_ahead_frames_;
+  }
+
+  /**
+   * @brief Read-ahead memory limit in bytes at the time this decoder was opened
+   */
+  qint64 read_ahead_memory() const
+  {
+    return read_ahead_memory_;
+  }
+
   static QMutex currently_conforming_mutex_;
   static QWaitCondition currently_conforming_wait_cond_;
   static QVector<CurrentlyConforming> currently_conforming_;
@@ -320,6 +410,14 @@ private:
 
   qint64 last_accessed_;
 
+  int read_ahead_frames_;
+
+  qint64 read_ahead_memory_;
+
+  static QAtomicInt read_ahead_frames_limit_;
+
+  static QAtomicInt read_ahead_memory_limit_;
+
 };
 
 uint qHash(Decoder::CodecStream stream, uint seed = 0);
@@ -54,10 +54,19 @@ FFmpegDecoder::FFmpegDecoder() :
   buffersrc_ctx_(nullptr),
   buffersink_ctx_(nullptr),
   pool_(QThread::idealThreadCount()*2),
+  max_lowres_(0),
   is_working_(false),
   cache_at_zero_(false),
-  cache_at_eof_(false)
+  cache_at_eof_(false),
+  decoder_at_cache_end_(true),
+  read_ahead_cancelled_(false),
+  access_direction_(kAccessNone),
+  last_target_ts_(AV_NOPTS_VALUE),
+  sequential_count_(0),
+  read_ahead_count_(0)
 {
+  // Each decoder only ever reads ahead on one thread since decoding is sequential anyway
+  read_ahead_pool_.setMaxThreadCount(1);
 }
 
 FFmpegDecoder::~FFmpegDecoder()
@@ -70,9 +79,20 @@ bool FFmpegDecoder::OpenInternal()
   if (instance_.Open(stream().filename().toUtf8(), stream().stream())) {
     AVStream* s = instance_.avstream();
 
+    // Store the codec's lowres limit separately since instance_ is re-opened while decoding
+    max_lowres_ = instance_.max_lowres();
+
     // Store one second in the source's timebase
     second_ts_ = qRound64(av_q2d(av_inv_q(s->time_base)));
 
+    // Store the approximate length of one frame in the source's timebase
+    AVRational frame_rate = av_guess_frame_rate(instance_.fmt_ctx(), s, nullptr);
+    if (frame_rate.num && frame_rate.den) {
+      frame_ts_ = qMax(int64_t(1), av_rescale_q(1, av_inv_q(frame_rate), s->time_base));
+    } else {
+      frame_ts_ = 1;
+    }
+
     if (s->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
       // Get an Olive compatible AVPixelFormat
       ideal_pix_fmt_ = FFmpegUtils::GetCompatiblePixelFormat(static_cast<AVPixelFormat>(s->codecpar->format));
@@ -153,14 +173,20 @@ bool FFmpegDecoder::OpenInternal()
 
 FramePtr FFmpegDecoder::RetrieveVideoInternal(const rational &timecode, const RetrieveVideoParams &params)
 {
-  AVStream* s = instance_.avstream();
+  // The read-ahead worker shares all of our decoding state, so stop it before touching anything
+  StopReadAhead();
 
   // Retrieve frame
   FFmpegFramePool::ElementPtr return_frame = RetrieveFrame(timecode, params);
 
+  FramePtr copy = nullptr;
+
   // We found the frame, we'll return a copy
   if (return_frame) {
-    FramePtr copy = Frame::Create();
+    // Retrieve stream after RetrieveFrame() since the codec may have been re-opened
+    AVStream* s = instance_.avstream();
+
+    copy = Frame::Create();
     copy->set_video_params(VideoParams(s->codecpar->width,
                                        s->codecpar->height,
                                        native_pix_fmt_,
@@ -173,15 +199,24 @@ FramePtr FFmpegDecoder::RetrieveVideoInternal(const rational &timecode, const Re
 
     // This data will already match the frame
     memcpy(copy->data(), return_frame->data(), copy->allocated_size());
+  }
 
-    return copy;
+  if (timecode != kAnyTimecode) {
+    // If we're being accessed sequentially, start decoding upcoming frames in the background
+    UpdateAccessPattern(GetTargetTimestamp(timecode, params));
+
+    if (return_frame && sequential_count_ >= kReadAheadThreshold) {
+      StartReadAhead(params);
+    }
   }
 
-  return nullptr;
+  return copy;
 }
 
 void FFmpegDecoder::CloseInternal()
 {
+  StopReadAhead();
+
   ClearFrameCache();
 
   instance_.Close();
@@ -441,6 +476,7 @@ QString FFmpegDecoder::FFmpegError(int error_code)
 bool FFmpegDecoder::ConformAudioInternal(const QString &filename, const AudioParams &params, const QAtomicInt *cancelled)
 {
   // Iterate through each audio frame and extract the PCM data
+  StopReadAhead();
 
   // Seek to starting point
   instance_.Seek(0);
@@ -645,12 +681,13 @@ void FFmpegDecoder::ClearFrameCache()
   cached_frames_.clear();
   cache_at_eof_ = false;
   cache_at_zero_ = false;
+  decoder_at_cache_end_ = true;
 
   // Filter graph may rely on "continuous" video frames, so we free the scaler here
   FreeScaler();
 }
 
-FFmpegFramePool::ElementPtr FFmpegDecoder::RetrieveFrame(const rational& time, const RetrieveVideoParams &params)
+int64_t FFmpegDecoder::GetTargetTimestamp(const rational &time, const RetrieveVideoParams &params) const
 {
   int64_t target_ts = GetTimeInTimebaseUnits(time, instance_.avstream()->time_base, instance_.avstream()->start_time);
 
@@ -660,13 +697,29 @@ FFmpegFramePool::ElementPtr FFmpegDecoder::RetrieveFrame(const rational& time, c
     target_ts *= 2;
   }
 
+  return target_ts;
+}
+
+FFmpegFramePool::ElementPtr FFmpegDecoder::RetrieveFrame(const rational& time, const RetrieveVideoParams &params)
+{
+  if (!UpdateLowRes(params)) {
+    return nullptr;
+  }
+
+  return RetrieveFrameAtTimestamp(GetTargetTimestamp(time, params), time == kAnyTimecode, params);
+}
+
+FFmpegFramePool::ElementPtr FFmpegDecoder::RetrieveFrameAtTimestamp(int64_t target_ts, bool any_frame, const RetrieveVideoParams &params)
+{
   int64_t seek_ts = target_ts;
   bool still_seeking = false;
 
-  if (time != kAnyTimecode) {
-    // If the frame wasn't in the frame cache, see if this frame cache is too old to use
+  if (!any_frame) {
+    // If the frame wasn't in the frame cache, see if this frame cache is too old to use. If reverse
+    // read-ahead left the codec behind the end of the cache, decoding on won't reach this frame.
     if (cached_frames_.isEmpty()
-        || (target_ts < cached_frames_.first()->timestamp() || target_ts > cached_frames_.last()->timestamp() + 2*second_ts_)) {
+        || (target_ts < cached_frames_.first()->timestamp() || target_ts > cached_frames_.last()->timestamp() + 2*second_ts_)
+        || (!decoder_at_cache_end_ && !cache_at_eof_ && target_ts > cached_frames_.last()->timestamp())) {
       ClearFrameCache();
 
       instance_.Seek(seek_ts);
@@ -737,27 +790,6 @@ FFmpegFramePool::ElementPtr FFmpegDecoder::RetrieveFrame(const rational& time, c
 
     } else {
 
-      // Cut down to thread count - 1 before we acquire a new frame
-      if (cached_frames_.size() == QThread::idealThreadCount()) {
-        RemoveFirstFrame();
-      }
-
-      FFmpegFramePool::ElementPtr cached = pool_.Get();
-
-      if (!cached) {
-        qCritical() << "Frame pool failed to return a valid frame - out of memory?";
-        break;
-      }
-
-      // Store in queue, converting to native format
-      uint8_t* destination_data = cached->data();
-      int destination_linesize = Frame::generate_linesize_bytes(working_frame->width, native_pix_fmt_, native_channel_count_);
-
-      av_image_copy(&destination_data, &destination_linesize, const_cast<const uint8_t**>(working_frame->data), working_frame->linesize, static_cast<AVPixelFormat>(working_frame->format), working_frame->width, working_frame->height);
-
-      // Set timestamp so this frame can be identified later
-      cached->set_timestamp(working_frame->pts);
-
       // Store frame before just in case
       FFmpegFramePool::ElementPtr previous;
       if (cached_frames_.isEmpty()) {
@@ -766,11 +798,14 @@ FFmpegFramePool::ElementPtr FFmpegDecoder::RetrieveFrame(const rational& time, c
         previous = cached_frames_.last();
       }
 
-      // Append this frame and signal to other threads that a new frame has arrived
-      cached_frames_.append(cached);
+      FFmpegFramePool::ElementPtr cached = CacheFilteredFrame(working_frame);
+
+      if (!cached) {
+        break;
+      }
 
       // If this is a valid frame, see if this or the frame before it are the one we need
-      if (cached->timestamp() == target_ts || time == kAnyTimecode) {
+      if (cached->timestamp() == target_ts || any_frame) {
         return_frame = cached;
         break;
       } else if (cached->timestamp() > target_ts) {
@@ -798,8 +833,11 @@ bool FFmpegDecoder::InitScaler(const RetrieveVideoParams& params)
     return true;
   }
 
-  // We need to (re)create the filter, delete current if necessary
-  ClearFrameCache();
+  // We need to (re)create the filter. Cached frames are only invalid if the parameters changed,
+  // the graph alone may have been freed to start fresh after a seek.
+  if (params != filter_params_) {
+    ClearFrameCache();
+  }
 
   // Set our params to this
   filter_params_ = params;
@@ -813,8 +851,9 @@ bool FFmpegDecoder::InitScaler(const RetrieveVideoParams& params)
 
   AVStream* s = instance_.avstream();
 
-  int src_width = s->codecpar->width;
-  int src_height = s->codecpar->height;
+  // If the codec is decoding at a reduced resolution, its frames will be smaller than the stream
+  int src_width = AV_CEIL_RSHIFT(s->codecpar->width, instance_.lowres());
+  int src_height = AV_CEIL_RSHIFT(s->codecpar->height, instance_.lowres());
 
   // Define filter parameters
   static const int kFilterArgSz = 1024;
@@ -849,13 +888,11 @@ bool FFmpegDecoder::InitScaler(const RetrieveVideoParams& params)
   }
 
   // Add scale filter if necessary
-  int dst_width, dst_height;
-  if (filter_params_.divider > 1) {
+  int dst_width = VideoParams::GetScaledDimension(s->codecpar->width, filter_params_.divider);
+  int dst_height = VideoParams::GetScaledDimension(s->codecpar->height, filter_params_.divider);
+  if (dst_width != src_width || dst_height != src_height) {
     AVFilterContext* scale_filter;
 
-    dst_width = VideoParams::GetScaledDimension(src_width, filter_params_.divider);
-    dst_height = VideoParams::GetScaledDimension(src_height, filter_params_.divider);
-
     snprintf(filter_args, kFilterArgSz, "w=%d:h=%d:flags=fast_bilinear:interl=%d",
              dst_width,
              dst_height,
@@ -865,9 +902,6 @@ bool FFmpegDecoder::InitScaler(const RetrieveVideoParams& params)
 
     avfilter_link(last_filter, 0, scale_filter, 0);
     last_filter = scale_filter;
-  } else {
-    dst_width = src_width;
-    dst_height = src_height;
   }
 
   // Add format filter if necessary
@@ -900,6 +934,39 @@ bool FFmpegDecoder::InitScaler(const RetrieveVideoParams& params)
   return true;
 }
 
+int FFmpegDecoder::GetReducedResolutionLevel(int divider) const
+{
+  // Each lowres level halves the resolution, we only use levels that divide evenly into the
+  // divider so any remaining scaling in the filter graph is by a whole number
+  int lowres = 0;
+
+  while (lowres < max_lowres_ && divider % (2 << lowres) == 0) {
+    lowres++;
+  }
+
+  return lowres;
+}
+
+bool FFmpegDecoder::UpdateLowRes(const RetrieveVideoParams &params)
+{
+  int lowres = GetReducedResolutionLevel(params.divider);
+
+  if (lowres == instance_.lowres()) {
+    return true;
+  }
+
+  // lowres can only be set before the codec is opened, so we'll need to re-open it
+  ClearFrameCache();
+  instance_.Close();
+
+  if (!instance_.Open(stream().filename().toUtf8(), stream().stream(), lowres)) {
+    qCritical() << "Failed to re-open codec at lowres" << lowres;
+    return false;
+  }
+
+  return true;
+}
+
 void FFmpegDecoder::FreeScaler()
 {
   if (filter_graph_) {
@@ -945,20 +1012,239 @@ FFmpegFramePool::ElementPtr FFmpegDecoder::GetFrameFromCache(const int64_t &t) c
   return nullptr;
 }
 
+FFmpegFramePool::ElementPtr FFmpegDecoder::CacheFilteredFrame(AVFrame *working_frame)
+{
+  // Cut down to the maximum before we acquire a new frame
+  while (cached_frames_.size() >= GetMaximumCachedFrames()) {
+    RemoveFirstFrame();
+  }
+
+  FFmpegFramePool::ElementPtr cached = CopyFilteredFrame(working_frame);
+
+  if (cached) {
+    cached_frames_.append(cached);
+  }
+
+  return cached;
+}
+
+FFmpegFramePool::ElementPtr FFmpegDecoder::CopyFilteredFrame(AVFrame *working_frame)
+{
+  FFmpegFramePool::ElementPtr cached = pool_.Get();
+
+  if (!cached) {
+    qCritical() << "Frame pool failed to return a valid frame - out of memory?";
+    return nullptr;
+  }
+
+  // Store in queue, converting to native format
+  uint8_t* destination_data = cached->data();
+  int destination_linesize = Frame::generate_linesize_bytes(working_frame->width, native_pix_fmt_, native_channel_count_);
+
+  av_image_copy(&destination_data, &destination_linesize, const_cast<const uint8_t**>(working_frame->data), working_frame->linesize, static_cast<AVPixelFormat>(working_frame->format), working_frame->width, working_frame->height);
+
+  // Set timestamp so this frame can be identified later
+  cached->set_timestamp(working_frame->pts);
+
+  return cached;
+}
+
+int FFmpegDecoder::DecodeNextFrame(const RetrieveVideoParams &params)
+{
+  AVPacket* pkt = av_packet_alloc();
+  AVFrame* working_frame = av_frame_alloc();
+
+  int ret = GetFilteredFrame(pkt, working_frame, params);
+
+  if (ret == AVERROR_EOF) {
+    cache_at_eof_ = true;
+  } else if (ret >= 0 && !CacheFilteredFrame(working_frame)) {
+    ret = AVERROR(ENOMEM);
+  }
+
+  av_frame_free(&working_frame);
+  av_packet_free(&pkt);
+
+  return ret;
+}
+
 void FFmpegDecoder::RemoveFirstFrame()
 {
   cached_frames_.removeFirst();
   cache_at_zero_ = false;
 }
 
+int FFmpegDecoder::GetMaximumCachedFrames() const
+{
+  return QThread::idealThreadCount() + read_ahead_count_;
+}
+
+void FFmpegDecoder::UpdateAccessPattern(int64_t target_ts)
+{
+  AccessDirection direction = kAccessNone;
+
+  // Treat requests within a second of the last one as sequential
+  if (last_target_ts_ != AV_NOPTS_VALUE) {
+    if (target_ts > last_target_ts_ && target_ts - last_target_ts_ <= second_ts_) {
+      direction = kAccessForward;
+    } else if (target_ts < last_target_ts_ && last_target_ts_ - target_ts <= second_ts_) {
+      direction = kAccessReverse;
+    }
+  }
+
+  if (direction == kAccessNone) {
+    sequential_count_ = 0;
+  } else if (direction == access_direction_) {
+    sequential_count_++;
+  } else {
+    sequential_count_ = 1;
+  }
+
+  access_direction_ = direction;
+  last_target_ts_ = target_ts;
+}
+
+int FFmpegDecoder::GetReadAheadCount() const
+{
+  int frames = read_ahead_frames();
+
+  // Limit to memory budget
+  qint64 budget = read_ahead_memory();
+  qint64 frame_sz = VideoParams::GetBufferSize(pool_.width(), pool_.height(), native_pix_fmt_, native_channel_count_);
+
+  if (frame_sz > 0) {
+    frames = qMin(frames, static_cast<int>(budget / frame_sz));
+  }
+
+  return qMax(0, frames);
+}
+
+void FFmpegDecoder::StartReadAhead(const RetrieveVideoParams &params)
+{
+  read_ahead_count_ = GetReadAheadCount();
+
+  if (read_ahead_count_ == 0) {
+    return;
+  }
+
+  read_ahead_cancelled_ = false;
+  read_ahead_future_ = QtConcurrent::run(&read_ahead_pool_, this, &FFmpegDecoder::ReadAhead,
+                                         params, access_direction_, last_target_ts_, read_ahead_count_);
+}
+
+void FFmpegDecoder::StopReadAhead()
+{
+  read_ahead_cancelled_ = true;
+  read_ahead_future_.waitForFinished();
+}
+
+void FFmpegDecoder::ReadAhead(const RetrieveVideoParams &params, AccessDirection direction, int64_t target_ts, int count)
+{
+  if (cached_frames_.isEmpty()) {
+    return;
+  }
+
+  if (direction == kAccessForward) {
+
+    if (!decoder_at_cache_end_) {
+      // The codec isn't positioned after the cache so we can't extend it, the next request past the
+      // end of the cache will seek
+      return;
+    }
+
+    // Decode until we have `count` frames after the last request
+    while (!read_ahead_cancelled_ && !cache_at_eof_) {
+      int frames_ahead = 0;
+
+      for (int i=cached_frames_.size()-1; i>=0 && cached_frames_.at(i)->timestamp() > target_ts; i--) {
+        frames_ahead++;
+      }
+
+      if (frames_ahead >= count || DecodeNextFrame(params) < 0) {
+        break;
+      }
+    }
+
+  } else if (direction == kAccessReverse) {
+
+    int64_t first_ts = cached_frames_.first()->timestamp();
+
+    if (cache_at_zero_ || (target_ts - first_ts) / frame_ts_ >= count) {
+      // We already have enough frames before the last request
+      return;
+    }
+
+    // Codecs can only decode forwards, so seek back `count` frames and decode up to the frames we
+    // already have. These are put in front of the cache rather than replacing it, so frames around
+    // the playhead survive changes of direction.
+    int64_t seek_target = qMax(int64_t(0), first_ts - count * frame_ts_);
+
+    // Start the filter graph fresh since its input is about to jump
+    FreeScaler();
+    instance_.Seek(seek_target);
+    decoder_at_cache_end_ = false;
+
+    QList<FFmpegFramePool::ElementPtr> earlier;
+    AVPacket* pkt = av_packet_alloc();
+    AVFrame* working_frame = av_frame_alloc();
+    bool reached_cache = false;
+
+    while (!read_ahead_cancelled_) {
+      if (GetFilteredFrame(pkt, working_frame, params) < 0) {
+        break;
+      }
+
+      if (working_frame->pts >= first_ts) {
+        reached_cache = true;
+        break;
+      }
+
+      FFmpegFramePool::ElementPtr frame = CopyFilteredFrame(working_frame);
+
+      if (!frame) {
+        break;
+      }
+
+      earlier.append(frame);
+    }
+
+    av_frame_free(&working_frame);
+    av_packet_free(&pkt);
+
+    // Only use these if they run right up to the cache, otherwise there'd be a gap
+    if (!reached_cache || earlier.isEmpty()) {
+      return;
+    }
+
+    // Seeking lands on the keyframe before the target, so there may be more than we asked for
+    bool from_zero = (seek_target == 0);
+    while (earlier.size() > count) {
+      earlier.removeFirst();
+      from_zero = false;
+    }
+
+    cached_frames_ = earlier + cached_frames_;
+    cache_at_zero_ = from_zero;
+
+    // Playback is moving away from the end of the cache, so that's what goes if we're over the limit
+    while (cached_frames_.size() > GetMaximumCachedFrames()) {
+      cached_frames_.removeLast();
+      cache_at_eof_ = false;
+    }
+
+  }
+}
+
 FFmpegDecoder::Instance::Instance() :
   fmt_ctx_(nullptr),
   codec_ctx_(nullptr),
-  opts_(nullptr)
+  opts_(nullptr),
+  lowres_(0),
+  max_lowres_(0)
 {
 }
 
-bool FFmpegDecoder::Instance::Open(const char *filename, int stream_index)
+bool FFmpegDecoder::Instance::Open(const char *filename, int stream_index, int lowres)
 {
   // Open file in a format context
   int error_code = avformat_open_input(&fmt_ctx_, filename, nullptr, nullptr);
@@ -1009,6 +1295,11 @@ bool FFmpegDecoder::Instance::Open(const char *filename, int stream_index)
     return false;
   }
 
+  // Decode at reduced resolution if requested and the codec supports it
+  max_lowres_ = codec->max_lowres;
+  lowres_ = qMin(lowres, max_lowres_);
+  codec_ctx_->lowres = lowres_;
+
   // Set multithreading setting
   error_code = av_dict_set(&opts_, "threads", "auto", 0);
 
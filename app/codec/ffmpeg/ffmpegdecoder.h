@@ -32,6 +32,8 @@ extern "C" {
 }
 
 #include <QAtomicInt>
+#include <QFuture>
+#include <QThreadPool>
 #include <QTimer>
 #include <QVector>
 #include <QWaitCondition>
@@ -62,6 +64,8 @@ public:
 
   virtual FootageDescription Probe(const QString &filename, const QAtomicInt *cancelled) const override;
 
+  virtual int GetReducedResolutionLevel(int divider) const override;
+
 protected:
   virtual bool OpenInternal() override;
   virtual FramePtr RetrieveVideoInternal(const rational &timecode, const RetrieveVideoParams& params) override;
@@ -79,7 +83,7 @@ private:
       Close();
     }
 
-    bool Open(const char* filename, int stream_index);
+    bool Open(const char* filename, int stream_index, int lowres = 0);
 
     void Close();
 
@@ -104,11 +108,29 @@ private:
       return avstream_;
     }
 
+    /**
+     * @brief Power of two the codec is reducing decoded frames by (0 = full resolution)
+     */
+    int lowres() const
+    {
+      return lowres_;
+    }
+
+    /**
+     * @brief Maximum lowres value the codec supports, 0 if it can't decode at reduced resolution
+     */
+    int max_lowres() const
+    {
+      return max_lowres_;
+    }
+
   private:
     AVFormatContext* fmt_ctx_;
     AVCodecContext* codec_ctx_;
     AVStream* avstream_;
     AVDictionary* opts_;
+    int lowres_;
+    int max_lowres_;
 
   };
 
@@ -125,6 +147,15 @@ private:
   static QString FFmpegError(int error_code);
 
   bool InitScaler(const RetrieveVideoParams &params);
+
+  /**
+   * @brief Re-opens the codec if it should decode at a different resolution for these parameters
+   *
+   * Codecs that support it (e.g. MJPEG, JPEG 2000) can decode directly at a power-of-two reduced
+   * resolution which is far cheaper than decoding at full resolution and scaling afterwards. The
+   * renderer keeps a decoder per lowres level, so in practice this only re-opens once.
+   */
+  bool UpdateLowRes(const RetrieveVideoParams &params);
   void FreeScaler();
 
   static VideoParams::Format GetNativePixelFormat(AVPixelFormat pix_fmt);
@@ -138,10 +169,65 @@ private:
 
   void ClearFrameCache();
 
+  int64_t GetTargetTimestamp(const rational &time, const RetrieveVideoParams &params) const;
+
   FFmpegFramePool::ElementPtr RetrieveFrame(const rational &time, const RetrieveVideoParams &params);
 
+  FFmpegFramePool::ElementPtr RetrieveFrameAtTimestamp(int64_t target_ts, bool any_frame, const RetrieveVideoParams &params);
+
+  /**
+   * @brief Copies a frame from the filter graph into the frame cache
+   */
+  FFmpegFramePool::ElementPtr CacheFilteredFrame(AVFrame* working_frame);
+
+  /**
+   * @brief Copies a frame from the filter graph into a frame from the pool without caching it
+   */
+  FFmpegFramePool::ElementPtr CopyFilteredFrame(AVFrame* working_frame);
+
+  /**
+   * @brief Decodes the next frame into the frame cache without searching for any particular time
+   *
+   * @return
+   *
+   * An FFmpeg error code, or >= 0 on success
+   */
+  int DecodeNextFrame(const RetrieveVideoParams &params);
+
   void RemoveFirstFrame();
 
+  int GetMaximumCachedFrames() const;
+
+  enum AccessDirection {
+    kAccessNone,
+    kAccessForward,
+    kAccessReverse
+  };
+
+  void UpdateAccessPattern(int64_t target_ts);
+
+  /**
+   * @brief Number of frames to read ahead, limited by the configured count and memory budget
+   */
+  int GetReadAheadCount() const;
+
+  /**
+   * @brief Start decoding frames in the direction of playback in the background
+   *
+   * The read-ahead worker uses the same decoding state as RetrieveVideoInternal(), so it must
+   * always be stopped with StopReadAhead() before anything else touches it.
+   */
+  void StartReadAhead(const RetrieveVideoParams &params);
+
+  void StopReadAhead();
+
+  void ReadAhead(const RetrieveVideoParams &params, AccessDirection direction, int64_t target_ts, int count);
+
+  /**
+   * @brief Number of consecutive sequential requests before read-ahead starts
+   */
+  static const int kReadAheadThreshold = 2;
+
   RetrieveVideoParams filter_params_;
   AVFilterGraph* filter_graph_;
   AVFilterContext* buffersrc_ctx_;
@@ -152,8 +238,12 @@ private:
 
   FFmpegFramePool pool_;
 
+  int max_lowres_;
+
   int64_t second_ts_;
 
+  int64_t frame_ts_;
+
   QList<FFmpegFramePool::ElementPtr> cached_frames_;
 
   bool is_working_;
@@ -162,8 +252,20 @@ private:
   bool cache_at_zero_;
   bool cache_at_eof_;
 
+  // FALSE if the codec's next frame doesn't follow the last cached frame (after reverse read-ahead)
+  bool decoder_at_cache_end_;
+
   Instance instance_;
 
+  QThreadPool read_ahead_pool_;
+  QFuture<void> read_ahead_future_;
+  QAtomicInt read_ahead_cancelled_;
+
+  AccessDirection access_direction_;
+  int64_t last_target_ts_;
+  int sequential_count_;
+  int read_ahead_count_;
+
 };
 
 }
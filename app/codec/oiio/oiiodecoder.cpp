@@ -25,10 +25,10 @@
 #include <QDir>
 #include <QFileInfo>
 #include <QMessageBox>
+#include <QtConcurrent/QtConcurrent>
 
 #include "common/define.h"
 #include "common/oiioutils.h"
-#include "config/config.h"
 #include "core.h"
 
 namespace olive {
@@ -37,7 +37,10 @@ QStringList OIIODecoder::supported_formats_;
 
 OIIODecoder::OIIODecoder() :
   image_(nullptr),
-  buffer_(nullptr)
+  buffer_(nullptr),
+  buffer_divider_(0),
+  sequence_divider_(0),
+  last_sequence_index_(AV_NOPTS_VALUE)
 {
 }
 
@@ -83,7 +86,7 @@ FootageDescription OIIODecoder::Probe(const QString &filename, const QAtomicInt*
   video_params.set_width(in->spec().width);
   video_params.set_height(in->spec().height);
   video_params.set_format(OIIOUtils::GetFormatFromOIIOBasetype(static_cast<OIIO::TypeDesc::BASETYPE>(in->spec().format.basetype)));
-  video_params.set_channel_count(in->spec().nchannels);
+  video_params.set_channel_count(GetChannelCount(in->spec()));
   video_params.set_pixel_aspect_ratio(OIIOUtils::GetPixelAspectRatioFromOIIO(in->spec()));
   video_params.set_video_type(VideoParams::kVideoTypeStill);
 
@@ -110,18 +113,28 @@ FramePtr OIIODecoder::RetrieveVideoInternal(const rational &timecode, const Retr
 {
   Q_UNUSED(timecode)
 
+  if (divider.sequence_index != AV_NOPTS_VALUE) {
+    return RetrieveImageSequenceFrame(divider.sequence_index, divider.divider);
+  }
+
+  if (!buffer_ || buffer_divider_ != divider.divider) {
+    if (!ReadImage(divider.divider)) {
+      return nullptr;
+    }
+  }
+
   FramePtr frame = Frame::Create();
 
-  frame->set_video_params(VideoParams(buffer_->spec().width,
-                                      buffer_->spec().height,
+  frame->set_video_params(VideoParams(width_,
+                                      height_,
                                       pix_fmt_,
                                       channel_count_,
-                                      OIIOUtils::GetPixelAspectRatioFromOIIO(buffer_->spec()),
+                                      pixel_aspect_ratio_,
                                       VideoParams::kInterlaceNone, // FIXME: Does OIIO deinterlace for us?
                                       divider.divider));
   frame->allocate();
 
-  if (divider.divider == 1) {
+  if (buffer_->spec().width == frame->width() && buffer_->spec().height == frame->height()) {
 
     OIIOUtils::BufferToFrame(buffer_, frame.get());
 
@@ -143,6 +156,7 @@ FramePtr OIIODecoder::RetrieveVideoInternal(const rational &timecode, const Retr
 
 void OIIODecoder::CloseInternal()
 {
+  ClearSequencePrefetch();
   CloseImageHandle();
 }
 
@@ -183,7 +197,7 @@ bool OIIODecoder::OpenImageHandler(const QString &fn)
   const OIIO::ImageSpec& spec = image_->spec();
 
   // Store channel count
-  channel_count_ = spec.nchannels;
+  channel_count_ = GetChannelCount(spec);
 
   // We use RGBA frames because that tends to be the native format of GPUs
   pix_fmt_ = OIIOUtils::GetFormatFromOIIOBasetype(static_cast<OIIO::TypeDesc::BASETYPE>(spec.format.basetype));
@@ -193,17 +207,46 @@ bool OIIODecoder::OpenImageHandler(const QString &fn)
     return false;
   }
 
-  OIIO::TypeDesc::BASETYPE type = OIIOUtils::GetOIIOBaseTypeFromFormat(pix_fmt_);
-
-  if (type == OIIO::TypeDesc::UNKNOWN) {
+  if (OIIOUtils::GetOIIOBaseTypeFromFormat(pix_fmt_) == OIIO::TypeDesc::UNKNOWN) {
     qCritical() << "Failed to determine appropriate OIIO basetype from native format";
     return false;
   }
 
-  buffer_ = new OIIO::ImageBuf(OIIO::ImageSpec(spec.width, spec.height, spec.nchannels, type),
+  // Store full resolution metadata, the pixels themselves are read on demand in ReadImage()
+  width_ = spec.width;
+  height_ = spec.height;
+  pixel_aspect_ratio_ = OIIOUtils::GetPixelAspectRatioFromOIIO(spec);
+
+  return true;
+}
+
+bool OIIODecoder::ReadImage(int divider)
+{
+  int target_width = VideoParams::GetScaledDimension(width_, divider);
+  int target_height = VideoParams::GetScaledDimension(height_, divider);
+
+  int miplevel = FindMipLevel(image_.get(), target_width, target_height);
+
+  if (miplevel < 0) {
+    return false;
+  }
+
+  const OIIO::ImageSpec& spec = image_->spec();
+
+  OIIO::TypeDesc::BASETYPE type = OIIOUtils::GetOIIOBaseTypeFromFormat(pix_fmt_);
+
+  delete buffer_;
+  buffer_ = new OIIO::ImageBuf(OIIO::ImageSpec(spec.width, spec.height, channel_count_, type),
                                OIIO::InitializePixels::No);
 
-  image_->read_image(type, buffer_->localpixels());
+  if (!image_->read_image(0, miplevel, 0, channel_count_, type, buffer_->localpixels())) {
+    qCritical() << "Failed to read image:" << QString::fromStdString(image_->geterror());
+    delete buffer_;
+    buffer_ = nullptr;
+    return false;
+  }
+
+  buffer_divider_ = divider;
 
   return true;
 }
@@ -221,4 +264,183 @@ void OIIODecoder::CloseImageHandle()
   }
 }
 
+int OIIODecoder::GetChannelCount(const OIIO::ImageSpec &spec)
+{
+  // Files like multi-layer EXRs may carry many more channels than we can display, only the
+  // leading RGBA channels are ever read
+  return qMin(spec.nchannels, VideoParams::kRGBAChannelCount);
+}
+
+int OIIODecoder::FindMipLevel(OIIO::ImageInput *image, int target_width, int target_height)
+{
+  // If the image has MIP levels (e.g. tiled EXR or TIFF), read the smallest one that's still at
+  // least as large as the frame we need rather than reading full resolution and downscaling
+  int miplevel = 0;
+  while (image->seek_subimage(0, miplevel + 1)
+         && image->spec().width >= target_width
+         && image->spec().height >= target_height) {
+    miplevel++;
+  }
+
+  if (!image->seek_subimage(0, miplevel)) {
+    qCritical() << "Failed to seek to MIP level" << miplevel;
+    return -1;
+  }
+
+  return miplevel;
+}
+
+FramePtr OIIODecoder::ReadImageSequenceFrame(const QString &filename, int divider)
+{
+  // This opens its own handle and touches no decoder state so it can run on the prefetch pool
+  auto in = OIIO::ImageInput::open(filename.toStdString());
+
+  if (!in) {
+    qWarning() << "Failed to open image sequence file" << filename;
+    return nullptr;
+  }
+
+  // Full resolution metadata has to be taken before we seek to another MIP level
+  int width = in->spec().width;
+  int height = in->spec().height;
+  int channel_count = GetChannelCount(in->spec());
+  rational pixel_aspect_ratio = OIIOUtils::GetPixelAspectRatioFromOIIO(in->spec());
+  VideoParams::Format pix_fmt = OIIOUtils::GetFormatFromOIIOBasetype(static_cast<OIIO::TypeDesc::BASETYPE>(in->spec().format.basetype));
+  OIIO::TypeDesc::BASETYPE type = OIIOUtils::GetOIIOBaseTypeFromFormat(pix_fmt);
+
+  if (type == OIIO::TypeDesc::UNKNOWN) {
+    qWarning() << "Failed to convert OIIO::ImageDesc to native pixel format";
+    return nullptr;
+  }
+
+  FramePtr frame = Frame::Create();
+
+  frame->set_video_params(VideoParams(width,
+                                      height,
+                                      pix_fmt,
+                                      channel_count,
+                                      pixel_aspect_ratio,
+                                      VideoParams::kInterlaceNone,
+                                      divider));
+
+  int miplevel = FindMipLevel(in.get(), frame->width(), frame->height());
+
+  if (miplevel < 0) {
+    return nullptr;
+  }
+
+  const OIIO::ImageSpec& spec = in->spec();
+
+  frame->allocate();
+
+  bool success;
+
+  if (spec.width == frame->width() && spec.height == frame->height()) {
+    // Read straight into the frame, no intermediate buffer necessary
+    success = in->read_image(0, miplevel, 0, channel_count, type, frame->data(),
+                             OIIO::AutoStride, frame->linesize_bytes());
+  } else {
+    OIIO::ImageBuf src(OIIO::ImageSpec(spec.width, spec.height, channel_count, type),
+                       OIIO::InitializePixels::No);
+
+    success = in->read_image(0, miplevel, 0, channel_count, type, src.localpixels());
+
+    if (success) {
+      OIIO::ImageBuf dst(OIIO::ImageSpec(frame->width(), frame->height(), channel_count, type));
+
+      if (!OIIO::ImageBufAlgo::resample(dst, src)) {
+        qWarning() << "OIIO resize failed";
+      }
+
+      OIIOUtils::BufferToFrame(&dst, frame.get());
+    }
+  }
+
+  if (!success) {
+    qCritical() << "Failed to read image:" << QString::fromStdString(in->geterror());
+    return nullptr;
+  }
+
+  in->close();
+
+  return frame;
+}
+
+FramePtr OIIODecoder::RetrieveImageSequenceFrame(int64_t index, int divider)
+{
+  if (divider != sequence_divider_) {
+    // Anything prefetched was read at the wrong resolution
+    ClearSequencePrefetch();
+    sequence_divider_ = divider;
+  }
+
+  int prefetch_count = read_ahead_frames();
+
+  // Consider access sequential if this index is a little ahead of the last one. Render threads
+  // request frames in parallel so they don't necessarily arrive in order.
+  bool sequential = (last_sequence_index_ != AV_NOPTS_VALUE
+                     && index > last_sequence_index_
+                     && index <= last_sequence_index_ + prefetch_count);
+
+  last_sequence_index_ = index;
+
+  QFuture<FramePtr> prefetched = sequence_prefetch_.take(index);
+
+  // Discard reads that have fallen out of the window around the playhead. Any still running will
+  // finish in the background and be freed with the future.
+  for (auto it=sequence_prefetch_.begin(); it!=sequence_prefetch_.end(); ) {
+    if (it.key() < index - prefetch_count || it.key() > index + prefetch_count) {
+      it = sequence_prefetch_.erase(it);
+    } else {
+      it++;
+    }
+  }
+
+  if (sequential) {
+    // Queue up reads of the files we expect to need next
+    for (int64_t i=index+1; i<=index+prefetch_count; i++) {
+      if (sequence_prefetch_.contains(i)) {
+        continue;
+      }
+
+      QString fn = Decoder::TransformImageSequenceFileName(stream().filename(), i);
+
+      if (!QFileInfo::exists(fn)) {
+        // Reached the end of the sequence
+        break;
+      }
+
+      sequence_prefetch_.insert(i, QtConcurrent::run(&sequence_pool_, &OIIODecoder::ReadImageSequenceFrame, fn, divider));
+    }
+  }
+
+  QString filename = Decoder::TransformImageSequenceFileName(stream().filename(), index);
+
+  // Every file gets its own ImageInput, so the read doesn't touch any decoder state. Release the
+  // decoder's lock while it runs so render threads can read other frames of the sequence in
+  // parallel rather than queueing behind this one.
+  mutex()->unlock();
+
+  FramePtr frame;
+
+  if (prefetched.isValid()) {
+    // Waits if the read is still in progress, which is still no slower than starting it now
+    frame = prefetched.result();
+  } else {
+    frame = ReadImageSequenceFrame(filename, divider);
+  }
+
+  mutex()->lock();
+
+  return frame;
+}
+
+void OIIODecoder::ClearSequencePrefetch()
+{
+  // Drop queued reads that haven't started yet, running ones finish on their own
+  sequence_pool_.clear();
+  sequence_prefetch_.clear();
+  last_sequence_index_ = AV_NOPTS_VALUE;
+}
+
 }
@@ -23,6 +23,9 @@
 
 #include <OpenImageIO/imageio.h>
 #include <OpenImageIO/imagebuf.h>
+#include <QFuture>
+#include <QMap>
+#include <QThreadPool>
 
 #include "codec/decoder.h"
 
@@ -40,6 +43,8 @@ public:
 
   virtual bool SupportsVideo() override{return true;}
 
+  virtual bool SupportsImageSequences() override{return true;}
+
   virtual FootageDescription Probe(const QString& filename, const QAtomicInt* cancelled) const override;
 
 protected:
@@ -54,14 +59,42 @@ private:
 
   bool OpenImageHandler(const QString& fn);
 
+  bool ReadImage(int divider);
+
   void CloseImageHandle();
 
+  static int GetChannelCount(const OIIO::ImageSpec& spec);
+
+  static int FindMipLevel(OIIO::ImageInput* image, int target_width, int target_height);
+
+  static FramePtr ReadImageSequenceFrame(const QString& filename, int divider);
+
+  FramePtr RetrieveImageSequenceFrame(int64_t index, int divider);
+
+  void ClearSequencePrefetch();
+
   VideoParams::Format pix_fmt_;
 
   int channel_count_;
 
+  int width_;
+
+  int height_;
+
+  rational pixel_aspect_ratio_;
+
   OIIO::ImageBuf* buffer_;
 
+  int buffer_divider_;
+
+  QThreadPool sequence_pool_;
+
+  QMap<int64_t, QFuture<FramePtr> > sequence_prefetch_;
+
+  int sequence_divider_;
+
+  int64_t last_sequence_index_;
+
   static QStringList supported_formats_;
 
 };
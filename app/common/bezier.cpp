@@ -68,4 +68,75 @@ double Bezier::CubicTtoY(double a, double b, double c, double d, double t)
   return qPow(1.0 - t, 3)*a + 3*qPow(1.0 - t, 2)*t*b + 3*(1.0 - t)*qPow(t, 2)*c + qPow(t, 3)*d;
 }
 
+void Bezier::CubicToCoefficients(double a, double b, double c, double d, double coeffs[4])
+{
+  coeffs[0] = a;
+  coeffs[1] = 3.0*(b - a);
+  coeffs[2] = 3.0*(a - 2.0*b + c);
+  coeffs[3] = d - a + 3.0*(b - c);
+}
+
+double Bezier::CubicCoefficientsTtoY(const double coeffs[4], double t)
+{
+  return ((coeffs[3]*t + coeffs[2])*t + coeffs[1])*t + coeffs[0];
+}
+
+double Bezier::CubicCoefficientsXtoT(double x_target, const double coeffs[4])
+{
+  const double tolerance = 0.0001;
+
+  double start = coeffs[0];
+  double end = CubicCoefficientsTtoY(coeffs, 1.0);
+
+  // Clamp to prevent deadlocks
+  x_target = clamp(x_target, start, end);
+
+  if (qFuzzyCompare(start, end)) {
+    return 0.0;
+  }
+
+  // Newton-Raphson starting from a linear guess usually converges in a couple of iterations
+  double t = (x_target - start) / (end - start);
+
+  for (int i=0; i<8; i++) {
+    double diff = CubicCoefficientsTtoY(coeffs, t) - x_target;
+
+    if (qAbs(diff) <= tolerance) {
+      return t;
+    }
+
+    double derivative = (3.0*coeffs[3]*t + 2.0*coeffs[2])*t + coeffs[1];
+
+    if (qAbs(derivative) < 1e-9) {
+      break;
+    }
+
+    t -= diff / derivative;
+
+    if (t < 0.0 || t > 1.0) {
+      break;
+    }
+  }
+
+  // Fall back to bisection for flat or badly behaved curves
+  double lower = 0.0;
+  double upper = 1.0;
+
+  t = 0.5;
+  double x = CubicCoefficientsTtoY(coeffs, t);
+
+  while (qAbs(x_target - x) > tolerance && upper - lower > 1e-12) {
+    if (x_target > x) {
+      lower = t;
+    } else {
+      upper = t;
+    }
+
+    t = (upper + lower) * 0.5;
+    x = CubicCoefficientsTtoY(coeffs, t);
+  }
+
+  return t;
+}
+
 }
@@ -35,6 +35,19 @@ public:
   static double CubicXtoT(double x_target, double a, double b, double c, double d);
 
   static double CubicTtoY(double a, double b, double c, double d, double t);
+
+  /**
+   * @brief Convert cubic control points into polynomial coefficients
+   *
+   * Fills `coeffs` so that `coeffs[0] + coeffs[1]*t + coeffs[2]*t^2 + coeffs[3]*t^3` is the same
+   * curve as CubicTtoY(a, b, c, d, t). Evaluating and solving the polynomial is much cheaper than
+   * the control point form, so curves that are sampled a lot should be converted once up front.
+   */
+  static void CubicToCoefficients(double a, double b, double c, double d, double coeffs[4]);
+
+  static double CubicCoefficientsTtoY(const double coeffs[4], double t);
+
+  static double CubicCoefficientsXtoT(double x_target, const double coeffs[4]);
 };
 
 }
@@ -97,6 +97,12 @@ void Config::SetDefaults()
   SetEntryInternal(QStringLiteral("UseSliderLadders"), NodeValue::kBoolean, true);
 
   SetEntryInternal(QStringLiteral("AutoCacheDelay"), NodeValue::kInt, 1000);
+  SetEntryInternal(QStringLiteral("InteractiveRenderLatency"), NodeValue::kInt, 40);
+
+  SetEntryInternal(QStringLiteral("DecoderReadAheadFrames"), NodeValue::kInt, 8);
+  SetEntryInternal(QStringLiteral("DecoderReadAheadMemory"), NodeValue::kInt, 512);
+  SetEntryInternal(QStringLiteral("TexturePoolMemory"), NodeValue::kInt, 512);
+  SetEntryInternal(QStringLiteral("FrameTextureCacheMemory"), NodeValue::kInt, 512);
 
   SetEntryInternal(QStringLiteral("CatColor0"), NodeValue::kInt, 0);
   SetEntryInternal(QStringLiteral("CatColor1"), NodeValue::kInt, 1);
@@ -35,6 +35,7 @@
 
 #include "audio/audiomanager.h"
 #include "cli/clitask/clitaskdialog.h"
+#include "codec/decoder.h"
 #include "common/filefunctions.h"
 #include "common/xmlutils.h"
 #include "config/config.h"
@@ -50,9 +51,11 @@
 #include "panel/panelmanager.h"
 #include "panel/project/project.h"
 #include "panel/viewer/viewer.h"
+#include "render/colorprocessorcache.h"
 #include "render/diskmanager.h"
 #include "render/framemanager.h"
 #include "render/rendermanager.h"
+#include "render/renderprofiler.h"
 #ifdef USE_OTIO
 #include "task/project/loadotio/loadotio.h"
 #include "task/project/saveotio/saveotio.h"
@@ -135,6 +138,13 @@ void Core::Start()
   // Set up color manager's default config
   ColorManager::SetUpDefaultConfig();
 
+  // Decoders read ahead on render threads, so give them the limits up front
+  Decoder::SetReadAheadLimits(Config::Current()[QStringLiteral("DecoderReadAheadFrames")].toInt(),
+                              Config::Current()[QStringLiteral("DecoderReadAheadMemory")].toInt());
+
+  // Initialize render profiler before anything that might render
+  RenderProfiler::CreateInstance();
+
   // Initialize task manager
   TaskManager::CreateInstance();
 
@@ -144,6 +154,11 @@ void Core::Start()
   // Initialize FrameManager
   FrameManager::CreateInstance();
 
+  // Start profiling renders for the whole session if a trace was requested
+  if (!core_params_.profile_trace().isEmpty()) {
+    RenderProfiler::instance()->Enable();
+  }
+
   //
   // Start application
   //
@@ -192,6 +207,12 @@ void Core::Stop()
 
   RenderManager::DestroyInstance();
 
+  // All render threads have finished now so every profiled frame has been submitted
+  if (!core_params_.profile_trace().isEmpty()) {
+    RenderProfiler::instance()->WriteChromeTrace(core_params_.profile_trace());
+    RenderProfiler::instance()->Disable();
+  }
+
   MenuShared::DestroyInstance();
 
   TaskManager::DestroyInstance();
@@ -206,6 +227,9 @@ void Core::Stop()
 
   delete main_window_;
   main_window_ = nullptr;
+
+  // Views release their hold on the profiler when they're destroyed with the main window
+  RenderProfiler::DestroyInstance();
 }
 
 MainWindow *Core::main_window()
@@ -463,6 +487,9 @@ bool Core::AddOpenProjectFromTask(Task *task)
   MainWindowLayoutInfo layout = load_task->GetLoadedLayout();
 
   if (ValidateFootageInLoadedProject(project, load_task->GetFilenameProjectWasSavedAs())) {
+    // Have color management ready for the footage before the first frames are requested
+    RenderManager::instance()->WarmColorProcessors(project);
+
     AddOpenProject(project);
     main_window_->LoadLayout(layout);
 
@@ -1408,6 +1435,13 @@ bool Core::CloseProject(Project* p, bool auto_open_new, CloseProjectBehavior &co
       emit ProjectClosed(p);
       open_projects_.removeAt(i);
       delete p;
+
+      // Anything the project's footage needed can be re-created if another project needs it
+      ColorProcessorCache::instance()->Clear();
+
+      if (RenderManager::instance() && RenderManager::instance()->frame_texture_cache()) {
+        RenderManager::instance()->frame_texture_cache()->Clear();
+      }
       break;
     }
   }
@@ -104,6 +104,16 @@ public:
       startup_language_ = s;
     }
 
+    const QString& profile_trace() const
+    {
+      return profile_trace_;
+    }
+
+    void set_profile_trace(const QString& s)
+    {
+      profile_trace_ = s;
+    }
+
   private:
     RunMode mode_;
 
@@ -111,6 +121,8 @@ public:
 
     QString startup_language_;
 
+    QString profile_trace_;
+
     bool run_fullscreen_;
 
   };
@@ -29,8 +29,20 @@
 #include <QScrollBar>
 #include <QVBoxLayout>
 
+#include "render/rendermanager.h"
+
 namespace olive {
 
+// Drops any frames still cached from the footage's old location before pointing it somewhere else
+static void RelinkFootage(Footage* f, const QString& new_fn)
+{
+  if (RenderManager::instance() && RenderManager::instance()->frame_texture_cache()) {
+    RenderManager::instance()->frame_texture_cache()->RemoveFile(f->filename());
+  }
+
+  f->set_filename(new_fn);
+}
+
 FootageRelinkDialog::FootageRelinkDialog(const QVector<Footage *> &footage, QWidget* parent) :
   QDialog(parent),
   footage_(footage)
@@ -112,7 +124,7 @@ void FootageRelinkDialog::BrowseForFootage()
     QDir new_dir = QFileInfo(new_fn).dir();
 
     // Set new filename since this was set manually by the user
-    f->set_filename(new_fn);
+    RelinkFootage(f, new_fn);
 
     // Assume footage is valid here. We could do some decoder probing to ensure it's a usable file
     // but otherwise we assume the user knows what they're doing here.
@@ -135,7 +147,7 @@ void FootageRelinkDialog::BrowseForFootage()
 
         // Check if file exists
         if (QFileInfo::exists(absolute_to_new)) {
-          other_footage->set_filename(absolute_to_new);
+          RelinkFootage(other_footage, absolute_to_new);
           other_footage->SetValid();
           UpdateFootageItem(it);
         }
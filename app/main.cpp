@@ -100,6 +100,12 @@ int main(int argc, char *argv[])
                        true,
                        QCoreApplication::translate("main", "qm-file"));
 
+  auto profile_option =
+      parser.AddOption({QStringLiteral("-profile")},
+                       QCoreApplication::translate("main", "Write a Chrome trace of render timings to file on exit"),
+                       true,
+                       QCoreApplication::translate("main", "file"));
+
   auto project_argument =
       parser.AddPositionalArgument(QStringLiteral("project"),
                                    QCoreApplication::translate("main", "Project to open on startup"));
@@ -148,6 +154,14 @@ int main(int argc, char *argv[])
     }
   }
 
+  if (profile_option->IsSet()) {
+    if (profile_option->GetSetting().isEmpty()) {
+      qWarning() << "--profile was set but no trace file was provided";
+    } else {
+      startup_params.set_profile_trace(profile_option->GetSetting());
+    }
+  }
+
   startup_params.set_fullscreen(fullscreen_option->IsSet());
 
   startup_params.set_startup_project(project_argument->GetSetting());
@@ -74,7 +74,7 @@ NodeValueTable PanNode::Value(const QString &output, NodeValueDatabase &value) c
   NodeValueTable table = value.Merge();
 
   if (job.HasSamples()) {
-    float pan_volume = job.GetValue(kPanningInput).data().toFloat();
+    float pan_volume = job.GetValue(kPanningInput).toFloat();
     if (IsInputStatic(kPanningInput)) {
       if (!qIsNull(pan_volume) && job.samples()->audio_params().channel_count() == 2) {
         if (pan_volume > 0) {
@@ -100,7 +100,7 @@ void PanNode::ProcessSamples(NodeValueDatabase &values, const SampleBufferPtr in
     return;
   }
 
-  float pan_val = values[kPanningInput].Get(NodeValue::kFloat).toFloat();
+  float pan_val = values[kPanningInput].Get<float>(NodeValue::kFloat);
 
   for (int i=0;i<input->audio_params().channel_count();i++) {
     output->data(i)[index] = input->data(i)[index];
@@ -64,6 +64,23 @@ void CrossDissolveTransition::ShaderJobEvent(NodeValueDatabase &value, ShaderJob
   Q_UNUSED(value)
 
   job.SetAlphaChannelRequired(GenerateJob::kAlphaForceOn);
+  job.SetPerPixelInput(kOutBlockInput);
+  job.SetPerPixelInput(kInBlockInput);
+
+  // A mix of the two blocks is transparent wherever both of them are
+  QRectF region;
+  TexturePtr out_tex = job.GetValue(kOutBlockInput).value<TexturePtr>();
+  TexturePtr in_tex = job.GetValue(kInBlockInput).value<TexturePtr>();
+
+  if (out_tex) {
+    region = region.united(out_tex->region());
+  }
+
+  if (in_tex) {
+    region = region.united(in_tex->region());
+  }
+
+  job.SetRegion(region);
 }
 
 void CrossDissolveTransition::SampleJobEvent(SampleBufferPtr from_samples, SampleBufferPtr to_samples, SampleBufferPtr out_samples, double time_in) const
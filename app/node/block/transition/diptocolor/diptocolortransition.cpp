@@ -64,6 +64,8 @@ ShaderCode DipToColorTransition::GetShaderCode(const QString &shader_id) const
 void DipToColorTransition::ShaderJobEvent(NodeValueDatabase &value, ShaderJob &job) const
 {
   job.InsertValue(this, kColorInput, value);
+  job.SetPerPixelInput(kOutBlockInput);
+  job.SetPerPixelInput(kInBlockInput);
 }
 
 }
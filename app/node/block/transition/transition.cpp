@@ -177,7 +177,7 @@ NodeValueTable TransitionBlock::Value(const QString &output, NodeValueDatabase &
 
     job.InsertValue(this, kCurveInput, value);
 
-    double time = value[QStringLiteral("global")].Get(NodeValue::kFloat, QStringLiteral("time_in")).toDouble();
+    double time = value[QStringLiteral("global")].Get<double>(NodeValue::kFloat, QStringLiteral("time_in"));
     InsertTransitionTimes(&job, time);
 
     ShaderJobEvent(value, job);
@@ -186,12 +186,12 @@ NodeValueTable TransitionBlock::Value(const QString &output, NodeValueDatabase &
     push_job = QVariant::fromValue(job);
   } else if (data_type == NodeValue::kSamples) {
     // This must be an audio transition
-    SampleBufferPtr from_samples = out_buffer.data().value<SampleBufferPtr>();
-    SampleBufferPtr to_samples = in_buffer.data().value<SampleBufferPtr>();
+    SampleBufferPtr from_samples = out_buffer.value<SampleBufferPtr>();
+    SampleBufferPtr to_samples = in_buffer.value<SampleBufferPtr>();
 
     if (from_samples || to_samples) {
-      double time_in = value[QStringLiteral("global")].Get(NodeValue::kFloat, QStringLiteral("time_in")).toDouble();
-      double time_out = value[QStringLiteral("global")].Get(NodeValue::kFloat, QStringLiteral("time_out")).toDouble();
+      double time_in = value[QStringLiteral("global")].Get<double>(NodeValue::kFloat, QStringLiteral("time_in"));
+      double time_out = value[QStringLiteral("global")].Get<double>(NodeValue::kFloat, QStringLiteral("time_out"));
 
       const AudioParams& params = (from_samples) ? from_samples->audio_params() : to_samples->audio_params();
 
@@ -27,6 +27,8 @@
 #include "common/filefunctions.h"
 #include "config/config.h"
 #include "core.h"
+#include "render/colorprocessorcache.h"
+#include "render/rendermanager.h"
 
 namespace olive {
 
@@ -300,6 +302,17 @@ ColorManager::SetLocale::~SetLocale()
 
 void ColorManager::SetConfig(OCIO::ConstConfigRcPtr config)
 {
+  if (config_ && strcmp(config_->getCacheID(), config->getCacheID()) != 0) {
+    // Processors are keyed by config so the old ones won't be matched again, but there's no point
+    // keeping them around either
+    ColorProcessorCache::instance()->Remove(config_);
+
+    // The same goes for footage textures color managed with it
+    if (RenderManager::instance() && RenderManager::instance()->frame_texture_cache()) {
+      RenderManager::instance()->frame_texture_cache()->RemoveColorConfig(QString::fromUtf8(config_->getCacheID()));
+    }
+  }
+
   config_ = config;
 
   SetComboBoxStrings(kDefaultColorspaceIn, ListAvailableColorspaces());
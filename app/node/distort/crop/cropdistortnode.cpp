@@ -69,14 +69,32 @@ NodeValueTable CropDistortNode::Value(const QString &output, NodeValueDatabase &
   job.InsertValue(QStringLiteral("resolution_in"),
                   NodeValue(NodeValue::kVec2, value[QStringLiteral("global")].Get(NodeValue::kVec2, QStringLiteral("resolution")), this));
   job.SetAlphaChannelRequired(GenerateJob::kAlphaForceOn);
+  job.SetPerPixelInput(kTextureInput);
 
   NodeValueTable table = value.Merge();
 
-  if (!job.GetValue(kTextureInput).data().isNull()) {
-    if (!qIsNull(job.GetValue(kLeftInput).data().toDouble())
-        || !qIsNull(job.GetValue(kRightInput).data().toDouble())
-        || !qIsNull(job.GetValue(kTopInput).data().toDouble())
-        || !qIsNull(job.GetValue(kBottomInput).data().toDouble())) {
+  if (!job.GetValue(kTextureInput).isNull()) {
+    if (!qIsNull(job.GetValue(kLeftInput).toDouble())
+        || !qIsNull(job.GetValue(kRightInput).toDouble())
+        || !qIsNull(job.GetValue(kTopInput).toDouble())
+        || !qIsNull(job.GetValue(kBottomInput).toDouble())) {
+      // Only the uncropped area (plus the feather) can be visible
+      QVector2D resolution = job.GetValue(QStringLiteral("resolution_in")).value<QVector2D>();
+      double feather = job.GetValue(kFeatherInput).toDouble();
+      double feather_x = (resolution.x() > 0) ? feather / resolution.x() : 0.0;
+      double feather_y = (resolution.y() > 0) ? feather / resolution.y() : 0.0;
+
+      QRectF uncropped;
+      uncropped.setLeft(job.GetValue(kLeftInput).toDouble() - feather_x);
+      uncropped.setTop(job.GetValue(kTopInput).toDouble() - feather_y);
+      uncropped.setRight(1.0 - job.GetValue(kRightInput).toDouble() + feather_x);
+      uncropped.setBottom(1.0 - job.GetValue(kBottomInput).toDouble() + feather_y);
+
+      TexturePtr texture = job.GetValue(kTextureInput).value<TexturePtr>();
+      if (texture) {
+        job.SetRegion(uncropped.intersected(texture->region()));
+      }
+
       table.Push(NodeValue::kShaderJob, QVariant::fromValue(job), this);
     } else {
       table.Push(NodeValue::kTexture, job.GetValue(kTextureInput).data(), this);
@@ -94,16 +112,16 @@ ShaderCode CropDistortNode::GetShaderCode(const QString &shader_id) const
 
 void CropDistortNode::DrawGizmos(NodeValueDatabase &db, QPainter *p)
 {
-  QVector2D resolution = db[QStringLiteral("global")].Get(NodeValue::kVec2, QStringLiteral("resolution")).value<QVector2D>();
+  QVector2D resolution = db[QStringLiteral("global")].Get<QVector2D>(NodeValue::kVec2, QStringLiteral("resolution"));
 
   const double handle_radius = GetGizmoHandleRadius(p->transform());
 
   p->setPen(QPen(Qt::white, 0));
 
-  double left_pt = resolution.x() * db[kLeftInput].Get(NodeValue::kFloat).toDouble();
-  double top_pt = resolution.y() * db[kTopInput].Get(NodeValue::kFloat).toDouble();
-  double right_pt = resolution.x() * (1.0 - db[kRightInput].Get(NodeValue::kFloat).toDouble());
-  double bottom_pt = resolution.y() * (1.0 - db[kBottomInput].Get(NodeValue::kFloat).toDouble());
+  double left_pt = resolution.x() * db[kLeftInput].Get<double>(NodeValue::kFloat);
+  double top_pt = resolution.y() * db[kTopInput].Get<double>(NodeValue::kFloat);
+  double right_pt = resolution.x() * (1.0 - db[kRightInput].Get<double>(NodeValue::kFloat));
+  double bottom_pt = resolution.y() * (1.0 - db[kBottomInput].Get<double>(NodeValue::kFloat));
   double center_x_pt = lerp(left_pt, right_pt, 0.5);
   double center_y_pt = lerp(top_pt, bottom_pt, 0.5);
 
@@ -181,7 +199,7 @@ bool CropDistortNode::GizmoPress(NodeValueDatabase &db, const QPointF &p)
   }
 
   if (gizmo_drag_ > kGizmoNone) {
-    gizmo_res_ = db[QStringLiteral("global")].Get(NodeValue::kVec2, QStringLiteral("resolution")).value<QVector2D>();
+    gizmo_res_ = db[QStringLiteral("global")].Get<QVector2D>(NodeValue::kVec2, QStringLiteral("resolution"));
     gizmo_drag_start_ = p;
 
     return true;
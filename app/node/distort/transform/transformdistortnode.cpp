@@ -20,7 +20,9 @@
 
 #include "transformdistortnode.h"
 
+#include <limits>
 #include <QGuiApplication>
+#include <QVector4D>
 
 #include "common/range.h"
 #include "node/traverser.h"
@@ -63,7 +65,7 @@ NodeValueTable TransformDistortNode::Value(const QString &output, NodeValueDatab
 
   // Pop texture
   NodeValue texture_meta = value[kTextureInput].TakeWithMeta(NodeValue::kTexture);
-  TexturePtr texture = texture_meta.data().value<TexturePtr>();
+  TexturePtr texture = texture_meta.value<TexturePtr>();
 
   // Merge table
   NodeValueTable table = value[kTextureInput];
@@ -81,12 +83,15 @@ NodeValueTable TransformDistortNode::Value(const QString &output, NodeValueDatab
       ShaderJob job;
       job.InsertValue(QStringLiteral("ove_maintex"), NodeValue(NodeValue::kTexture, QVariant::fromValue(texture), this));
       job.InsertValue(QStringLiteral("ove_mvpmat"), NodeValue(NodeValue::kMatrix, real_matrix, this));
-      job.SetInterpolation(QStringLiteral("ove_maintex"), static_cast<Texture::Interpolation>(value[kInterpolationInput].Get(NodeValue::kCombo).toInt()));
+      job.SetInterpolation(QStringLiteral("ove_maintex"), static_cast<Texture::Interpolation>(value[kInterpolationInput].Get<int>(NodeValue::kCombo)));
 
       // FIXME: This should be optimized, we can use matrix math to determine if this operation will
       //        end up with gaps in the screen that will require an alpha channel.
       job.SetAlphaChannelRequired(GenerateJob::kAlphaForceOn);
 
+      // Only where the texture's visible region lands can be visible
+      job.SetRegion(TransformRegion(texture->region(), real_matrix));
+
       table.Push(NodeValue::kShaderJob, QVariant::fromValue(job), this);
     }
   }
@@ -94,6 +99,40 @@ NodeValueTable TransformDistortNode::Value(const QString &output, NodeValueDatab
   return table;
 }
 
+QRectF TransformDistortNode::TransformRegion(const QRectF &region, const QMatrix4x4 &mvp)
+{
+  if (region.isEmpty()) {
+    return QRectF();
+  }
+
+  QPointF corners[] = {region.topLeft(), region.topRight(), region.bottomLeft(), region.bottomRight()};
+
+  double min_x = std::numeric_limits<double>::max();
+  double min_y = min_x;
+  double max_x = std::numeric_limits<double>::lowest();
+  double max_y = max_x;
+
+  for (const QPointF& c : corners) {
+    // Texture coordinate to the vertex position that would have it, then into the destination
+    QVector4D p = mvp * QVector4D(c.x() * 2.0 - 1.0, c.y() * 2.0 - 1.0, 0.0, 1.0);
+
+    if (p.w() <= 0) {
+      // Behind the camera, can't make any assumptions
+      return QRectF(0, 0, 1, 1);
+    }
+
+    double x = (p.x() / p.w() + 1.0) * 0.5;
+    double y = (p.y() / p.w() + 1.0) * 0.5;
+
+    min_x = qMin(min_x, x);
+    min_y = qMin(min_y, y);
+    max_x = qMax(max_x, x);
+    max_y = qMax(max_y, y);
+  }
+
+  return QRectF(QPointF(min_x, min_y), QPointF(max_x, max_y));
+}
+
 ShaderCode TransformDistortNode::GetShaderCode(const QString &shader_id) const
 {
   Q_UNUSED(shader_id);
@@ -104,7 +143,7 @@ ShaderCode TransformDistortNode::GetShaderCode(const QString &shader_id) const
 
 bool TransformDistortNode::GizmoPress(NodeValueDatabase &db, const QPointF &p)
 {
-  TexturePtr tex = db[kTextureInput].Get(NodeValue::kTexture).value<TexturePtr>();
+  TexturePtr tex = db[kTextureInput].Get<TexturePtr>(NodeValue::kTexture);
   if (!tex) {
     return false;
   }
@@ -131,7 +170,7 @@ bool TransformDistortNode::GizmoPress(NodeValueDatabase &db, const QPointF &p)
     gizmo_start_ = {db[kScaleInput].Get(NodeValue::kVec2)};
     gizmo_drag_ = kScaleInput;
 
-    gizmo_scale_uniform_ = db[kUniformScaleInput].Get(NodeValue::kBoolean).toBool();
+    gizmo_scale_uniform_ = db[kUniformScaleInput].Get<bool>(NodeValue::kBoolean);
 
     if (gizmo_scale_active[kGizmoScaleTopLeft] || gizmo_scale_active[kGizmoScaleTopRight]
         || gizmo_scale_active[kGizmoScaleBottomLeft] || gizmo_scale_active[kGizmoScaleBottomRight]) {
@@ -145,7 +184,7 @@ bool TransformDistortNode::GizmoPress(NodeValueDatabase &db, const QPointF &p)
     // Store texture size
     VideoParams texture_params = tex->params();
     QVector2D texture_sz(texture_params.square_pixel_width(), texture_params.height());
-    gizmo_scale_anchor_ = db[kAnchorInput].Get(NodeValue::kVec2).value<QVector2D>() + texture_sz/2;
+    gizmo_scale_anchor_ = db[kAnchorInput].Get<QVector2D>(NodeValue::kVec2) + texture_sz/2;
 
     if (gizmo_scale_active[kGizmoScaleTopRight]
         || gizmo_scale_active[kGizmoScaleBottomRight]
@@ -327,7 +366,7 @@ void TransformDistortNode::Hash(const QString &output, QCryptographicHash &hash,
   traverser.SetCacheVideoParams(video_params);
 
   NodeValueDatabase db = traverser.GenerateDatabase(this, output, TimeRange(time, time + video_params.frame_rate_as_time_base()));
-  TexturePtr tex = db[kTextureInput].Get(NodeValue::kTexture).value<TexturePtr>();
+  TexturePtr tex = db[kTextureInput].Get<TexturePtr>(NodeValue::kTexture);
   if (tex) {
     VideoParams tex_params = tex->params();
     QMatrix4x4 matrix = GenerateMatrix(db, true, false, false, false);
@@ -395,9 +434,9 @@ QPointF TransformDistortNode::CreateScalePoint(double x, double y, const QPointF
 
 QMatrix4x4 TransformDistortNode::GenerateAutoScaledMatrix(const QMatrix4x4& generated_matrix, NodeValueDatabase& value, const VideoParams& texture_params) const
 {
-  QVector2D sequence_res = value[QStringLiteral("global")].Get(NodeValue::kVec2, QStringLiteral("resolution")).value<QVector2D>();
+  QVector2D sequence_res = value[QStringLiteral("global")].Get<QVector2D>(NodeValue::kVec2, QStringLiteral("resolution"));
   QVector2D texture_res(texture_params.square_pixel_width(), texture_params.height());
-  AutoScaleType autoscale = static_cast<AutoScaleType>(value[kAutoscaleInput].Get(NodeValue::kCombo).toInt());
+  AutoScaleType autoscale = static_cast<AutoScaleType>(value[kAutoscaleInput].Get<int>(NodeValue::kCombo));
 
   return AdjustMatrixByResolutions(generated_matrix,
                                    sequence_res,
@@ -407,7 +446,7 @@ QMatrix4x4 TransformDistortNode::GenerateAutoScaledMatrix(const QMatrix4x4& gene
 
 void TransformDistortNode::DrawGizmos(NodeValueDatabase &db, QPainter *p)
 {
-  TexturePtr tex = db[kTextureInput].Get(NodeValue::kTexture).value<TexturePtr>();
+  TexturePtr tex = db[kTextureInput].Get<TexturePtr>(NodeValue::kTexture);
   if (!tex) {
     return;
   }
@@ -416,7 +455,7 @@ void TransformDistortNode::DrawGizmos(NodeValueDatabase &db, QPainter *p)
   p->setPen(QPen(Qt::white, 0));
 
   // Get the sequence resolution
-  QVector2D sequence_res = db[QStringLiteral("global")].Get(NodeValue::kVec2, QStringLiteral("resolution")).value<QVector2D>();
+  QVector2D sequence_res = db[QStringLiteral("global")].Get<QVector2D>(NodeValue::kVec2, QStringLiteral("resolution"));
   QVector2D sequence_half_res = sequence_res/2;
   QPointF sequence_half_res_pt = sequence_half_res.toPointF();
 
@@ -425,7 +464,7 @@ void TransformDistortNode::DrawGizmos(NodeValueDatabase &db, QPainter *p)
   QVector2D tex_sz(tex_params.square_pixel_width(), tex_params.height());
 
   // Retrieve autoscale value
-  AutoScaleType autoscale = static_cast<AutoScaleType>(db[kAutoscaleInput].Get(NodeValue::kCombo).toInt());
+  AutoScaleType autoscale = static_cast<AutoScaleType>(db[kAutoscaleInput].Get<int>(NodeValue::kCombo));
 
   // Fold values into a matrix for the rectangle
   QMatrix4x4 rectangle_matrix;
@@ -101,6 +101,11 @@ public:
 private:
   static QPointF CreateScalePoint(double x, double y, const QPointF& half_res, const QMatrix4x4& mat);
 
+  /**
+   * @brief Bounding box of where a region of the source texture ends up after this matrix
+   */
+  static QRectF TransformRegion(const QRectF& region, const QMatrix4x4& mvp);
+
   QMatrix4x4 GenerateAutoScaledMatrix(const QMatrix4x4 &generated_matrix, NodeValueDatabase &db, const VideoParams &texture_params) const;
 
   // Gizmo variables
@@ -20,6 +20,8 @@
 
 #include "blur.h"
 
+#include <QtMath>
+
 namespace olive {
 
 const QString BlurFilterNode::kTextureInput = QStringLiteral("tex_in");
@@ -29,6 +31,11 @@ const QString BlurFilterNode::kHorizInput = QStringLiteral("horiz_in");
 const QString BlurFilterNode::kVertInput = QStringLiteral("vert_in");
 const QString BlurFilterNode::kRepeatEdgePixelsInput = QStringLiteral("repeat_edge_pixels_in");
 
+const int BlurFilterNode::kMaximumDirectTaps = 16;
+const int BlurFilterNode::kMaximumPassTaps = 12;
+const int BlurFilterNode::kMaximumPassesPerBox = 2;
+const int BlurFilterNode::kMaximumDivider = 8;
+
 BlurFilterNode::BlurFilterNode()
 {
   AddInput(kTextureInput, NodeValue::kTexture, InputFlags(kInputFlagNotKeyframable));
@@ -105,19 +112,37 @@ NodeValueTable BlurFilterNode::Value(const QString &output, NodeValueDatabase &v
   NodeValueTable table = value.Merge();
 
   // If there's no texture, no need to run an operation
-  if (!job.GetValue(kTextureInput).data().isNull()) {
+  if (!job.GetValue(kTextureInput).isNull()) {
+
+    bool horiz = job.GetValue(kHorizInput).toBool();
+    bool vert = job.GetValue(kVertInput).toBool();
 
     // Check if radius > 0, and both "horiz" and/or "vert" are enabled
-    if ((job.GetValue(kHorizInput).data().toBool() || job.GetValue(kVertInput).data().toBool())
-        && job.GetValue(kRadiusInput).data().toDouble() > 0.0) {
+    if ((horiz || vert) && job.GetValue(kRadiusInput).toDouble() > 0.0) {
+
+      Plan plan = PlanBlur(static_cast<Method>(job.GetValue(kMethodInput).toInt()),
+                           job.GetValue(kRadiusInput).toDouble(),
+                           horiz && vert);
+
+      job.InsertValue(QStringLiteral("blur_boxes_in"), NodeValue(NodeValue::kInt, plan.boxes, this));
+      job.InsertValue(QStringLiteral("blur_box_width_in"), NodeValue(NodeValue::kInt, plan.box_width, this));
+      job.InsertValue(QStringLiteral("blur_taps_in"), NodeValue(NodeValue::kInt, plan.taps, this));
+      job.InsertValue(QStringLiteral("blur_passes_in"), NodeValue(NodeValue::kInt, plan.passes, this));
 
-      // Set iteration count to 2 if we're blurring both horizontally and vertically
-      if (job.GetValue(kHorizInput).data().toBool() && job.GetValue(kVertInput).data().toBool()) {
-        job.SetIterations(2, kTextureInput);
+      // Run every pass of every axis we're blurring, each one feeding into the next
+      int axes = (horiz && vert) ? 2 : 1;
+
+      int iterations = axes * plan.GetPassesPerAxis();
+      if (iterations > 1) {
+        job.SetIterations(iterations, kTextureInput);
+        job.SetIterationDivider(plan.divider);
       }
 
+      // We always sample at the input's own resolution, so don't regenerate mipmaps every pass
+      job.SetInterpolation(kTextureInput, Texture::kLinear);
+
       // If we're not repeating pixels, expect an alpha channel to appear
-      if (!job.GetValue(kRepeatEdgePixelsInput).data().toBool()) {
+      if (!job.GetValue(kRepeatEdgePixelsInput).toBool()) {
         job.SetAlphaChannelRequired(GenerateJob::kAlphaForceOn);
       }
 
@@ -133,4 +158,83 @@ NodeValueTable BlurFilterNode::Value(const QString &output, NodeValueDatabase &v
   return table;
 }
 
+BlurFilterNode::Plan BlurFilterNode::PlanBlur(Method method, double radius, bool both_axes)
+{
+  Plan plan;
+
+  plan.divider = 1;
+
+  // We only sample on hard pixels, so we don't accept decimal radii (matches blur.frag)
+  int real_radius = qMax(1, qCeil(radius));
+
+  // blur.frag samples between two pixels per tap, and gaussian covers 3 standard deviations
+  plan.direct_taps = (method == kMethodGaussian) ? real_radius * 3 : real_radius;
+
+  if (plan.direct_taps <= kMaximumDirectTaps) {
+    plan.boxes = 0;
+    plan.box_width = 0;
+    plan.taps = 0;
+    plan.passes = 0;
+    return plan;
+  }
+
+  if (method == kMethodGaussian) {
+    // Three successive boxes are a close approximation of a gaussian, each with a width chosen so
+    // their combined variance matches sigma (the radius)
+    plan.boxes = 3;
+    plan.box_width = qMax(1, qRound(std::sqrt(12.0 * real_radius * real_radius / plan.boxes + 1.0)));
+  } else {
+    plan.boxes = 1;
+    plan.box_width = real_radius * 2;
+  }
+
+  // Use as few passes as possible while keeping each one under the tap limit, but never more than
+  // kMaximumPassesPerBox, past that each pass takes more taps instead
+  plan.passes = 1;
+  int reach = kMaximumPassTaps;
+  while (reach < plan.box_width && plan.passes < kMaximumPassesPerBox) {
+    reach *= kMaximumPassTaps;
+    plan.passes++;
+  }
+
+  plan.taps = qMax(2, qCeil(std::pow(double(plan.box_width), 1.0 / plan.passes) - 1e-9));
+
+  if (method == kMethodGaussian && both_axes && plan.passes > 1) {
+    // The first pass is a box of `taps` pixels, which is enough of a prefilter to drop to
+    // 1/divider as long as divider <= taps. Sigma also has to stay at least 4 pixels at that size,
+    // or upsampling it in the last pass starts to show. Blurring one axis keeps full resolution
+    // since the other axis would otherwise lose detail it never gets blurred over.
+    int limit = qMin(kMaximumDivider, qMin(plan.taps, real_radius / 4));
+    while (plan.divider * 2 <= limit) {
+      plan.divider *= 2;
+    }
+  }
+
+  return plan;
+}
+
+int BlurFilterNode::Plan::GetLastPassTaps() const
+{
+  if (!boxes) {
+    return direct_taps;
+  }
+
+  // The final pass is sized so the combined box comes as close to box_width as possible
+  int stride = 1;
+  for (int i=1; i<passes; i++) {
+    stride *= taps;
+  }
+
+  return qMax(1, qRound(double(box_width) / double(stride)));
+}
+
+int BlurFilterNode::Plan::GetTapsPerPixel() const
+{
+  if (!boxes) {
+    return direct_taps;
+  }
+
+  return boxes * ((passes - 1) * taps + GetLastPassTaps());
+}
+
 }
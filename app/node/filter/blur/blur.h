@@ -31,6 +31,49 @@ class BlurFilterNode : public Node
 public:
   BlurFilterNode();
 
+  enum Method {
+    kMethodBox,
+    kMethodGaussian
+  };
+
+  /**
+   * @brief How blur.frag will be run for a given method and radius
+   *
+   * Small radii are sampled directly. Large radii are approximated with one (box) or three
+   * (gaussian) box filters of `box_width` pixels, each split into at most kMaximumPassesPerBox
+   * sparse passes of `taps` samples at strides of 1, taps, etc. The number of passes is therefore
+   * bounded, but past kMaximumPassTaps^kMaximumPassesPerBox pixels the taps per pass grow with the
+   * square root of the box width.
+   *
+   * Large gaussians blurred along both axes also run every pass but the last at 1/`divider` of the
+   * output's resolution.
+   */
+  struct Plan {
+    // Number of box filters per axis, or 0 if blur.frag samples the whole radius in one pass
+    int boxes;
+
+    int box_width;
+    int taps;
+    int passes;
+
+    // Every pass but the last is drawn at 1/divider of the output's resolution
+    int divider;
+
+    // Samples taken in one axis using the direct path
+    int direct_taps;
+
+    int GetPassesPerAxis() const
+    {
+      return boxes ? boxes * passes : 1;
+    }
+
+    int GetLastPassTaps() const;
+
+    int GetTapsPerPixel() const;
+  };
+
+  static Plan PlanBlur(Method method, double radius, bool both_axes);
+
   NODE_DEFAULT_DESTRUCTOR(BlurFilterNode)
 
   virtual Node* copy() const override;
@@ -52,6 +95,11 @@ public:
   static const QString kVertInput;
   static const QString kRepeatEdgePixelsInput;
 
+  static const int kMaximumDirectTaps;
+  static const int kMaximumPassTaps;
+  static const int kMaximumPassesPerBox;
+  static const int kMaximumDivider;
+
 };
 
 }
@@ -20,6 +20,8 @@
 
 #include "mosaicfilternode.h"
 
+#include <QtMath>
+
 namespace olive {
 
 const QString MosaicFilterNode::kTextureInput = QStringLiteral("tex_in");
@@ -59,12 +61,30 @@ NodeValueTable MosaicFilterNode::Value(const QString &output, NodeValueDatabase
 
   NodeValueTable table = value.Merge();
 
-  if (!job.GetValue(kTextureInput).data().isNull()) {
-    TexturePtr texture = job.GetValue(kTextureInput).data().value<TexturePtr>();
+  if (!job.GetValue(kTextureInput).isNull()) {
+    TexturePtr texture = job.GetValue(kTextureInput).value<TexturePtr>();
 
     if (texture
-        && job.GetValue(kHorizInput).data().toInt() != texture->width()
-        && job.GetValue(kVertInput).data().toInt() != texture->height()) {
+        && job.GetValue(kHorizInput).toInt() != texture->width()
+        && job.GetValue(kVertInput).toInt() != texture->height()) {
+      // Each block takes the color at its corner, so the output covers every block that starts
+      // inside the input's visible region
+      QRectF region = texture->region();
+      int horiz = job.GetValue(kHorizInput).toInt();
+      int vert = job.GetValue(kVertInput).toInt();
+
+      if (horiz > 0) {
+        region.setLeft(qFloor(region.left() * horiz) / double(horiz));
+        region.setRight((qFloor(region.right() * horiz) + 1) / double(horiz));
+      }
+
+      if (vert > 0) {
+        region.setTop(qFloor(region.top() * vert) / double(vert));
+        region.setBottom((qFloor(region.bottom() * vert) + 1) / double(vert));
+      }
+
+      job.SetRegion(region);
+
       table.Push(NodeValue::kShaderJob, QVariant::fromValue(job), this);
     } else {
       table.Push(job.GetValue(kTextureInput));
@@ -98,9 +98,9 @@ NodeValueTable StrokeFilterNode::Value(const QString &output, NodeValueDatabase
 
   NodeValueTable table = value.Merge();
 
-  if (!job.GetValue(kTextureInput).data().isNull()) {
-    if (job.GetValue(kRadiusInput).data().toDouble() > 0.0
-        && job.GetValue(kOpacityInput).data().toDouble() > 0.0) {
+  if (!job.GetValue(kTextureInput).isNull()) {
+    if (job.GetValue(kRadiusInput).toDouble() > 0.0
+        && job.GetValue(kOpacityInput).toDouble() > 0.0) {
       table.Push(NodeValue::kShaderJob, QVariant::fromValue(job), this);
     } else {
       table.Push(job.GetValue(kTextureInput));
@@ -108,47 +108,47 @@ QMatrix4x4 MatrixGenerator::GenerateMatrix(NodeValueDatabase &value, bool take,
   if (!ignore_anchor) {
     if (take) {
       // Take and store
-      anchor = value[kAnchorInput].Take(NodeValue::kVec2).value<QVector2D>();
+      anchor = value[kAnchorInput].Take<QVector2D>(NodeValue::kVec2);
     } else {
       // Get and store
-      anchor = value[kAnchorInput].Get(NodeValue::kVec2).value<QVector2D>();
+      anchor = value[kAnchorInput].Get<QVector2D>(NodeValue::kVec2);
     }
   } else if (take) {
     // Just take
-    value[kAnchorInput].Take(NodeValue::kVec2).value<QVector2D>();
+    value[kAnchorInput].Take<QVector2D>(NodeValue::kVec2);
   }
 
   if (!ignore_scale) {
     if (take) {
-      scale = value[kScaleInput].Take(NodeValue::kVec2).value<QVector2D>();
+      scale = value[kScaleInput].Take<QVector2D>(NodeValue::kVec2);
     } else {
-      scale = value[kScaleInput].Get(NodeValue::kVec2).value<QVector2D>();
+      scale = value[kScaleInput].Get<QVector2D>(NodeValue::kVec2);
     }
   } else if (take) {
-    value[kScaleInput].Take(NodeValue::kVec2).value<QVector2D>();
+    value[kScaleInput].Take<QVector2D>(NodeValue::kVec2);
   }
 
   if (!ignore_position) {
     if (take) {
-      position = value[kPositionInput].Take(NodeValue::kVec2).value<QVector2D>();
+      position = value[kPositionInput].Take<QVector2D>(NodeValue::kVec2);
     } else {
-      position = value[kPositionInput].Get(NodeValue::kVec2).value<QVector2D>();
+      position = value[kPositionInput].Get<QVector2D>(NodeValue::kVec2);
     }
   } else if (take) {
-    value[kPositionInput].Take(NodeValue::kVec2).value<QVector2D>();
+    value[kPositionInput].Take<QVector2D>(NodeValue::kVec2);
   }
 
   if (take) {
     return GenerateMatrix(position,
-                          value[kRotationInput].Take(NodeValue::kFloat).toFloat(),
+                          value[kRotationInput].Take<float>(NodeValue::kFloat),
                           scale,
-                          value[kUniformScaleInput].Take(NodeValue::kBoolean).toBool(),
+                          value[kUniformScaleInput].Take<bool>(NodeValue::kBoolean),
                           anchor);
   } else {
     return GenerateMatrix(position,
-                          value[kRotationInput].Get(NodeValue::kFloat).toFloat(),
+                          value[kRotationInput].Get<float>(NodeValue::kFloat),
                           scale,
-                          value[kUniformScaleInput].Get(NodeValue::kBoolean).toBool(),
+                          value[kUniformScaleInput].Get<bool>(NodeValue::kBoolean),
                           anchor);
 
   }
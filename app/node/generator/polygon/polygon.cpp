@@ -97,6 +97,24 @@ NodeValueTable PolygonGenerator::Value(const QString &output, NodeValueDatabase
   job.InsertValue(QStringLiteral("resolution_in"), value[QStringLiteral("global")].GetWithMeta(NodeValue::kVec2, QStringLiteral("resolution")));
   job.SetAlphaChannelRequired(GenerateJob::kAlphaForceOn);
 
+  // Nothing outside of the points' bounding box can be filled
+  QVector2D resolution = job.GetValue(QStringLiteral("resolution_in")).value<QVector2D>();
+  QVector<NodeValueTable> points = job.GetValue(kPointsInput).value< QVector<NodeValueTable> >();
+
+  if (resolution.x() > 0 && resolution.y() > 0) {
+    QRectF bounds;
+
+    for (int i=0; i<points.size(); i++) {
+      QVector2D p = points.at(i).Get<QVector2D>(NodeValue::kVec2);
+      QRectF pixel(p.x() - 1.0, p.y() - 1.0, 2.0, 2.0);
+
+      bounds = (i == 0) ? pixel : bounds.united(pixel);
+    }
+
+    job.SetRegion(QRectF(bounds.x() / resolution.x(), bounds.y() / resolution.y(),
+                         bounds.width() / resolution.x(), bounds.height() / resolution.y()));
+  }
+
   NodeValueTable table = value.Merge();
   table.Push(NodeValue::kShaderJob, QVariant::fromValue(job), this);
   return table;
@@ -176,7 +194,7 @@ QVector<QPointF> PolygonGenerator::GetGizmoCoordinates(NodeValueDatabase &db, co
   QVector<QPointF> points(array_tbl.size());
 
   for (int i=0;i<array_tbl.size();i++) {
-    QVector2D v = array_tbl.at(i).Get(NodeValue::kVec2).value<QVector2D>();
+    QVector2D v = array_tbl.at(i).Get<QVector2D>(NodeValue::kVec2);
 
     v *= scale;
 
@@ -21,8 +21,11 @@
 #include "text.h"
 
 #include <QAbstractTextDocumentLayout>
+#include <QMutex>
 #include <QTextDocument>
 
+#include "common/oiioutils.h"
+
 namespace olive {
 
 enum TextVerticalAlign {
@@ -31,6 +34,92 @@ enum TextVerticalAlign {
   kVerticalAlignBottom,
 };
 
+namespace {
+
+/**
+ * @brief Text coverage (alpha) rasterized for one frame size
+ *
+ * Only the area the document was laid out in is rasterized, `bounds` is where that area sits in
+ * the frame. Everything outside of it is transparent.
+ */
+struct TextRaster {
+  QImage coverage;
+  QRect bounds;
+};
+
+using TextRasterPtr = std::shared_ptr<const TextRaster>;
+
+/**
+ * @brief Rasterized text shared by every TextGenerator and render thread
+ *
+ * Laying out and painting a document is by far the most expensive part of generating text, and
+ * most titles don't change from frame to frame, so rasters are cached by everything that affects
+ * their coverage (color is applied afterwards). Least recently used entries are dropped once the
+ * cache grows past kMaximumBytes.
+ */
+class TextRasterCache {
+public:
+  static TextRasterPtr Get(const QString& key)
+  {
+    QMutexLocker locker(&lock_);
+
+    for (int i=entries_.size()-1; i>=0; i--) {
+      if (entries_.at(i).first == key) {
+        // Move to back, i.e. most recently used
+        entries_.append(entries_.takeAt(i));
+        return entries_.last().second;
+      }
+    }
+
+    return nullptr;
+  }
+
+  static void Insert(const QString& key, TextRasterPtr raster)
+  {
+    QMutexLocker locker(&lock_);
+
+    entries_.append({key, raster});
+    bytes_ += EntrySize(raster);
+
+    while (bytes_ > kMaximumBytes && entries_.size() > 1) {
+      bytes_ -= EntrySize(entries_.takeFirst().second);
+    }
+  }
+
+private:
+  static qint64 EntrySize(TextRasterPtr raster)
+  {
+    return qint64(raster->coverage.bytesPerLine()) * raster->coverage.height();
+  }
+
+  static const qint64 kMaximumBytes;
+
+  static QMutex lock_;
+
+  static QList<QPair<QString, TextRasterPtr> > entries_;
+
+  static qint64 bytes_;
+
+};
+
+const qint64 TextRasterCache::kMaximumBytes = 67108864;
+QMutex TextRasterCache::lock_;
+QList<QPair<QString, TextRasterPtr> > TextRasterCache::entries_;
+qint64 TextRasterCache::bytes_ = 0;
+
+template <int BytesPerPixel>
+void FillRowFromLUT(char* dst, const uchar* coverage, int width, const char* lut, int bytes_per_pixel)
+{
+  // Constant sizes let the compiler turn each copy into a single (vector) move
+  int sz = BytesPerPixel ? BytesPerPixel : bytes_per_pixel;
+
+  for (int x=0; x<width; x++) {
+    memcpy(dst + x * sz, lut + coverage[x] * sz, sz);
+  }
+}
+
+}
+
 const QString TextGenerator::kTextInput = QStringLiteral("text_in");
 const QString TextGenerator::kColorInput = QStringLiteral("color_in");
 const QString TextGenerator::kVAlignInput = QStringLiteral("valign_in");
@@ -99,76 +188,154 @@ NodeValueTable TextGenerator::Value(const QString &output, NodeValueDatabase &va
 
   NodeValueTable table = value.Merge();
 
-  if (!job.GetValue(kTextInput).data().toString().isEmpty()) {
+  if (!job.GetValue(kTextInput).toString().isEmpty()) {
     table.Push(NodeValue::kGenerateJob, QVariant::fromValue(job), this);
   }
 
   return table;
 }
 
-void TextGenerator::GenerateFrame(FramePtr frame, const GenerateJob& job) const
+namespace {
+
+TextRasterPtr RasterizeText(const GenerateJob& job, const VideoParams& params)
 {
-  // This could probably be more optimized, but for now we use Qt to draw to a QImage.
-  // QImages only support integer pixels and we use float pixels, so what we do here is draw onto
-  // a single-channel QImage (alpha only) and then transplant that alpha channel to our float buffer
-  // with correct float RGB.
-  QImage img(frame->width(), frame->height(), QImage::Format_Grayscale8);
-  img.fill(0);
+  std::shared_ptr<TextRaster> raster = std::make_shared<TextRaster>();
 
   QTextDocument text_doc;
 
   // Set default font
   QFont default_font;
-  default_font.setFamily(job.GetValue(kFontInput).data().toString());
-  default_font.setPointSizeF(job.GetValue(kFontSizeInput).data().toFloat());
+  default_font.setFamily(job.GetValue(TextGenerator::kFontInput).toString());
+  default_font.setPointSizeF(job.GetValue(TextGenerator::kFontSizeInput).toFloat());
   text_doc.setDefaultFont(default_font);
 
   // Center by default
   text_doc.setDefaultTextOption(QTextOption(Qt::AlignCenter));
 
-  text_doc.setHtml(job.GetValue(kTextInput).data().toString());
+  text_doc.setHtml(job.GetValue(TextGenerator::kTextInput).toString());
 
   // Align to 80% width because that's considered the "title safe" area
-  int tenth_of_width = frame->video_params().width() / 10;
+  int tenth_of_width = params.width() / 10;
   text_doc.setTextWidth(tenth_of_width * 8);
 
-  // Draw rich text onto image
-  QPainter p(&img);
-  p.scale(1.0 / frame->video_params().divider(), 1.0 / frame->video_params().divider());
-
-  // Push 10% inwards to compensate for title safe area
-  p.translate(tenth_of_width, 0);
-
-  TextVerticalAlign valign = static_cast<TextVerticalAlign>(job.GetValue(kVAlignInput).data().toInt());
+  TextVerticalAlign valign = static_cast<TextVerticalAlign>(job.GetValue(TextGenerator::kVAlignInput).toInt());
   int doc_height = text_doc.size().height();
+  int doc_top = 0;
 
   switch (valign) {
   case kVerticalAlignTop:
     // Push 10% inwards for title safe area
-    p.translate(0, frame->video_params().height() / 10);
+    doc_top = params.height() / 10;
     break;
   case kVerticalAlignCenter:
     // Center align
-    p.translate(0, frame->video_params().height() / 2 - doc_height / 2);
+    doc_top = params.height() / 2 - doc_height / 2;
     break;
   case kVerticalAlignBottom:
     // Push 10% inwards for title safe area
-    p.translate(0, frame->video_params().height() - doc_height - frame->video_params().height() / 10);
+    doc_top = params.height() - doc_height - params.height() / 10;
     break;
   }
 
+  // Only rasterize where the document is, plus a pixel for antialiasing, in frame pixels (which
+  // are smaller than sequence pixels when a divider is set)
+  double divider = params.divider();
+  // Use the laid out size rather than the text width, words that can't be wrapped run past it
+  QRectF doc_rect(QPointF(tenth_of_width, doc_top), text_doc.size());
+  raster->bounds = QRectF(doc_rect.topLeft() / divider, doc_rect.size() / divider).toAlignedRect().adjusted(-1, -1, 1, 1);
+  raster->bounds &= QRect(0, 0, params.effective_width(), params.effective_height());
+
+  if (raster->bounds.isEmpty()) {
+    return raster;
+  }
+
+  // QImages only support integer pixels and we use float pixels, so we draw onto a single-channel
+  // QImage (alpha only) and then fill our buffer from it with the correct RGB
+  raster->coverage = QImage(raster->bounds.size(), QImage::Format_Grayscale8);
+  raster->coverage.fill(0);
+
+  // Draw rich text onto image
+  QPainter p(&raster->coverage);
+  p.translate(-raster->bounds.x(), -raster->bounds.y());
+  p.scale(1.0 / divider, 1.0 / divider);
+  p.translate(tenth_of_width, doc_top);
+
   QAbstractTextDocumentLayout::PaintContext ctx;
   ctx.palette.setColor(QPalette::Text, Qt::white);
   text_doc.documentLayout()->draw(&p, ctx);
 
-  // Transplant alpha channel to frame
-  Color rgb = job.GetValue(kColorInput).data().value<Color>();
-  for (int x=0; x<frame->width(); x++) {
-    for (int y=0; y<frame->height(); y++) {
-      uchar src_alpha = img.bits()[img.bytesPerLine() * y + x];
-      float alpha = float(src_alpha) / 255.0f;
+  return raster;
+}
+
+}
+
+void TextGenerator::GenerateFrame(FramePtr frame, const GenerateJob& job) const
+{
+  const VideoParams& params = frame->video_params();
+
+  QString key = QStringLiteral("%1\n%2\n%3\n%4\n%5").arg(job.GetValue(kTextInput).toString(),
+                                                          job.GetValue(kFontInput).toString(),
+                                                          QString::number(job.GetValue(kFontSizeInput).toFloat()),
+                                                          QString::number(job.GetValue(kVAlignInput).toInt()),
+                                                          QStringLiteral("%1x%2/%3").arg(QString::number(params.width()),
+                                                                                         QString::number(params.height()),
+                                                                                         QString::number(params.divider())));
+
+  TextRasterPtr raster = TextRasterCache::Get(key);
+
+  if (!raster) {
+    raster = RasterizeText(job, params);
+    TextRasterCache::Insert(key, raster);
+  }
+
+  // Everything outside of the text is transparent, and zero is zero in every format
+  memset(frame->data(), 0, frame->allocated_size());
+
+  if (raster->bounds.isEmpty()) {
+    return;
+  }
+
+  // Build the premultiplied color for every coverage value directly in the frame's format, so
+  // filling is just a copy per pixel
+  Color rgb = job.GetValue(kColorInput).value<Color>();
+  int channels = frame->channel_count();
+  int bytes_per_pixel = params.GetBytesPerPixel();
+
+  QVector<float> lut_float(256 * channels);
+  for (int i=0; i<256; i++) {
+    float alpha = float(i) / 255.0f;
+    float pixel[VideoParams::kRGBAChannelCount] = {float(rgb.red()) * alpha,
+                                                   float(rgb.green()) * alpha,
+                                                   float(rgb.blue()) * alpha,
+                                                   alpha};
+
+    memcpy(lut_float.data() + i * channels, pixel, qMin(channels, int(VideoParams::kRGBAChannelCount)) * sizeof(float));
+  }
 
-      frame->set_pixel(x, y, Color(rgb.red() * alpha, rgb.green() * alpha, rgb.blue() * alpha, alpha));
+  QByteArray lut(256 * bytes_per_pixel, Qt::Uninitialized);
+  OIIO::convert_pixel_values(OIIO::TypeDesc::FLOAT, lut_float.constData(),
+                             OIIOUtils::GetOIIOBaseTypeFromFormat(frame->format()), lut.data(),
+                             256 * channels);
+
+  // Fill row by row, so both the coverage and the frame are read in memory order
+  for (int y=raster->bounds.top(); y<=raster->bounds.bottom(); y++) {
+    char* dst = frame->data() + y * frame->linesize_bytes() + raster->bounds.x() * bytes_per_pixel;
+    const uchar* src = raster->coverage.constScanLine(y - raster->bounds.y());
+    int width = raster->bounds.width();
+
+    switch (bytes_per_pixel) {
+    case 16:
+      FillRowFromLUT<16>(dst, src, width, lut.constData(), bytes_per_pixel);
+      break;
+    case 8:
+      FillRowFromLUT<8>(dst, src, width, lut.constData(), bytes_per_pixel);
+      break;
+    case 4:
+      FillRowFromLUT<4>(dst, src, width, lut.constData(), bytes_per_pixel);
+      break;
+    default:
+      FillRowFromLUT<0>(dst, src, width, lut.constData(), bytes_per_pixel);
+      break;
     }
   }
 }
@@ -28,6 +28,7 @@ namespace olive {
 
 NodeInputImmediate::NodeInputImmediate(NodeValue::Type type, const SplitValue &default_val) :
   default_value_(default_val),
+  type_(type),
   keyframing_(false)
 {
   set_data_type(type);
@@ -36,6 +37,8 @@ NodeInputImmediate::NodeInputImmediate(NodeValue::Type type, const SplitValue &d
 void NodeInputImmediate::set_standard_value_on_track(const QVariant &value, int track)
 {
   standard_value_.replace(track, value);
+
+  update_combined_standard_value();
 }
 
 void NodeInputImmediate::set_split_standard_value(const SplitValue &value)
@@ -43,6 +46,8 @@ void NodeInputImmediate::set_split_standard_value(const SplitValue &value)
   for (int i=0; i<value.size() && i<standard_value_.size(); i++) {
     standard_value_[i] = value[i];
   }
+
+  update_combined_standard_value();
 }
 
 QVector<NodeKeyframe*> NodeInputImmediate::get_keyframe_at_time(const rational &time) const
@@ -177,12 +182,26 @@ bool NodeInputImmediate::has_keyframe_at_time(const rational &time) const
 
 void NodeInputImmediate::set_data_type(NodeValue::Type type)
 {
+  type_ = type;
+
   int track_size = NodeValue::get_number_of_keyframe_tracks(type);
 
   keyframe_tracks_.resize(track_size);
   standard_value_.resize(track_size);
 
   set_split_standard_value(default_value_);
+
+  // Values are converted differently depending on the type, so precomputed segments are stale
+  foreach (const NodeKeyframeTrack& track, keyframe_tracks_) {
+    foreach (NodeKeyframe* key, track) {
+      key->update_segment();
+    }
+  }
+}
+
+void NodeInputImmediate::update_combined_standard_value()
+{
+  combined_standard_value_ = NodeValue::combine_track_values_into_normal_value(type_, standard_value_);
 }
 
 NodeKeyframe *NodeInputImmediate::get_earliest_keyframe() const
@@ -254,12 +273,19 @@ void NodeInputImmediate::insert_keyframe(NodeKeyframe* key)
   if (next) {
     next->set_previous(key);
   }
+
+  key->update_segment();
+
+  if (previous) {
+    previous->update_segment();
+  }
 }
 
 void NodeInputImmediate::remove_keyframe(NodeKeyframe *key)
 {
   if (key->previous()) {
     key->previous()->set_next(key->next());
+    key->previous()->update_segment();
   }
 
   if (key->next()) {
@@ -268,6 +294,7 @@ void NodeInputImmediate::remove_keyframe(NodeKeyframe *key)
 
   key->set_previous(nullptr);
   key->set_next(nullptr);
+  key->update_segment();
 
   keyframe_tracks_[key->track()].removeOne(key);
 }
@@ -58,6 +58,17 @@ public:
     return standard_value_.at(track);
   }
 
+  /**
+   * @brief Get non-keyframed value combined into its normal type
+   *
+   * Kept up to date whenever the standard value changes so lookups don't need to recombine the
+   * split value every time.
+   */
+  const QVariant& get_standard_value() const
+  {
+    return combined_standard_value_;
+  }
+
   void set_standard_value_on_track(const QVariant &value, int track);
 
   void set_split_standard_value(const SplitValue& value);
@@ -151,19 +162,76 @@ public:
     return (!is_keyframing() || keyframe_tracks_.at(track).isEmpty());
   }
 
+  /**
+   * @brief Return whether every track is using its standard value
+   */
+  bool is_using_standard_value() const
+  {
+    if (!is_keyframing()) {
+      return true;
+    }
+
+    foreach (const NodeKeyframeTrack& track, keyframe_tracks_) {
+      if (!track.isEmpty()) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
   void set_data_type(NodeValue::Type type);
 
+  /**
+   * @brief Keyframed value sampled once per frame, between the earliest and latest keyframe
+   */
+  struct BakedValues
+  {
+    rational timebase;
+    int64_t start = 0;
+    QVector<QVariant> values;
+  };
+
+  const BakedValues& baked_values() const
+  {
+    return baked_;
+  }
+
+  bool has_baked_values() const
+  {
+    return !baked_.values.isEmpty();
+  }
+
+  void set_baked_values(const BakedValues& values)
+  {
+    baked_ = values;
+  }
+
+  void clear_baked_values()
+  {
+    baked_ = BakedValues();
+  }
+
 private:
+  void update_combined_standard_value();
+
   /**
    * @brief Non-keyframed value
    */
   SplitValue standard_value_;
 
+  /**
+   * @brief Non-keyframed value combined into its normal type
+   */
+  QVariant combined_standard_value_;
+
   /**
    * @brief Default value
    */
   SplitValue default_value_;
 
+  NodeValue::Type type_;
+
   /**
    * @brief Internal keyframe array
    *
@@ -176,6 +244,11 @@ private:
    */
   bool keyframing_;
 
+  /**
+   * @brief Baked keyframe values, empty unless Node::BakeKeyframes() has been called
+   */
+  BakedValues baked_;
+
 };
 
 }
@@ -0,0 +1,171 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2021 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "invalidationbatcher.h"
+
+#include "node/node.h"
+
+namespace olive {
+
+thread_local InvalidationBatcher::State InvalidationBatcher::state_;
+QAtomicInteger<qint64> InvalidationBatcher::issued_count_ = 0;
+QAtomicInteger<qint64> InvalidationBatcher::delivered_count_ = 0;
+
+void InvalidationBatcher::Begin()
+{
+  state_.depth++;
+}
+
+void InvalidationBatcher::End()
+{
+  state_.depth--;
+
+  if (state_.depth == 0 && !state_.flushing) {
+    Flush();
+  }
+}
+
+void InvalidationBatcher::Invalidate(Node *node, const QString &input, int element, const TimeRange &range, qint64 job_time)
+{
+  if (state_.depth == 0 && !state_.flushing) {
+    // No batch, deliver immediately
+    node->InvalidateCache(range, input, element, job_time);
+    return;
+  }
+
+  issued_count_.fetchAndAddRelaxed(1);
+
+  Pending& p = state_.pending[node][InputKey(input, element)];
+
+  if (p.ranges.isEmpty()) {
+    p.job_time = job_time;
+  } else {
+    p.job_time = qMax(p.job_time, job_time);
+  }
+
+  p.ranges.insert(range);
+}
+
+void InvalidationBatcher::RemoveNode(Node *node)
+{
+  state_.pending.remove(node);
+}
+
+void InvalidationBatcher::Flush()
+{
+  state_.flushing = true;
+
+  // Delivering can queue more invalidations outside the part of the graph we sorted (e.g. a
+  // ViewerOutput's length changing causes another value to change), so keep going until nothing's
+  // left
+  while (!state_.pending.isEmpty()) {
+    // Find everything downstream of the queued nodes
+    QHash<Node*, int> in_degree;
+    QVector<Node*> stack;
+
+    for (auto it=state_.pending.cbegin(); it!=state_.pending.cend(); it++) {
+      if (!in_degree.contains(it.key())) {
+        in_degree.insert(it.key(), 0);
+        stack.append(it.key());
+      }
+    }
+
+    while (!stack.isEmpty()) {
+      Node* n = stack.takeLast();
+
+      for (const Node::OutputConnection& conn : n->output_connections()) {
+        Node* downstream = conn.second.node();
+
+        if (!in_degree.contains(downstream)) {
+          in_degree.insert(downstream, 0);
+          stack.append(downstream);
+        }
+      }
+    }
+
+    // Count edges within that subgraph (parallel edges are counted individually)
+    for (auto it=in_degree.cbegin(); it!=in_degree.cend(); it++) {
+      for (const Node::OutputConnection& conn : it.key()->output_connections()) {
+        in_degree[conn.second.node()]++;
+      }
+    }
+
+    // Deliver in topological order so every node has received everything from upstream before it
+    // passes its merged ranges on
+    QVector<Node*> ready;
+
+    for (auto it=in_degree.cbegin(); it!=in_degree.cend(); it++) {
+      if (it.value() == 0) {
+        ready.append(it.key());
+      }
+    }
+
+    while (!ready.isEmpty()) {
+      Node* n = ready.takeLast();
+
+      // Copy connections in case delivering changes them
+      std::vector<Node::OutputConnection> connections = n->output_connections();
+
+      Deliver(n);
+
+      for (const Node::OutputConnection& conn : connections) {
+        auto it = in_degree.find(conn.second.node());
+
+        if (it != in_degree.end() && --it.value() == 0) {
+          ready.append(it.key());
+        }
+      }
+    }
+
+    // Anything that's still queued for a node we already sorted never became ready (e.g. its edges
+    // changed during delivery), so deliver it directly rather than looping forever. Nodes queued
+    // for the first time during delivery are picked up by the next pass.
+    QList<Node*> remaining = state_.pending.keys();
+    foreach (Node* n, remaining) {
+      if (in_degree.contains(n)) {
+        Deliver(n);
+      }
+    }
+  }
+
+  state_.flushing = false;
+}
+
+void InvalidationBatcher::Deliver(Node *node)
+{
+  auto it = state_.pending.find(node);
+
+  if (it == state_.pending.end()) {
+    return;
+  }
+
+  QMap<InputKey, Pending> inputs = it.value();
+  state_.pending.erase(it);
+
+  for (auto jt=inputs.cbegin(); jt!=inputs.cend(); jt++) {
+    foreach (const TimeRange& r, jt.value().ranges) {
+      delivered_count_.fetchAndAddRelaxed(1);
+
+      node->InvalidateCache(r, jt.key().first, jt.key().second, jt.value().job_time);
+    }
+  }
+}
+
+}
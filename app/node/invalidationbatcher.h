@@ -0,0 +1,125 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2021 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#ifndef INVALIDATIONBATCHER_H
+#define INVALIDATIONBATCHER_H
+
+#include <QAtomicInteger>
+#include <QHash>
+#include <QMap>
+
+#include "common/timerange.h"
+
+namespace olive {
+
+class Node;
+
+/**
+ * @brief Collects cache invalidations so each downstream path is only walked once
+ *
+ * Without batching, every individual change calls Node::InvalidateCache() on each downstream node
+ * synchronously, so an edit that changes several values (or a graph with a lot of fan-out) walks
+ * the same paths again and again and hands ViewerOutputs many overlapping ranges.
+ *
+ * Between Begin() and End(), invalidations are queued per (node, input, element) with their
+ * ranges merged. When the outermost End() is reached, the affected part of the graph is walked
+ * once in topological order so every node (and therefore every ViewerOutput and its caches)
+ * receives one merged invalidation per input.
+ *
+ * Batches are per-thread and may be nested.
+ */
+class InvalidationBatcher
+{
+public:
+  static void Begin();
+
+  static void End();
+
+  /**
+   * @brief Invalidate `range` of `input` on `node`, either now or at the end of the batch
+   */
+  static void Invalidate(Node* node, const QString& input, int element, const TimeRange& range, qint64 job_time);
+
+  /**
+   * @brief Drop anything queued for a node that's being destroyed
+   */
+  static void RemoveNode(Node* node);
+
+  /**
+   * @brief Number of invalidations that were queued into a batch
+   */
+  static qint64 GetIssuedCount()
+  {
+    return issued_count_.loadAcquire();
+  }
+
+  /**
+   * @brief Number of invalidations actually delivered to nodes after merging
+   */
+  static qint64 GetDeliveredCount()
+  {
+    return delivered_count_.loadAcquire();
+  }
+
+  static void ResetCounters()
+  {
+    issued_count_.storeRelease(0);
+    delivered_count_.storeRelease(0);
+  }
+
+private:
+  struct Pending
+  {
+    TimeRangeList ranges;
+    qint64 job_time;
+  };
+
+  using InputKey = QPair<QString, int>;
+
+  struct State
+  {
+    State() :
+      depth(0),
+      flushing(false)
+    {
+    }
+
+    int depth;
+
+    bool flushing;
+
+    QHash<Node*, QMap<InputKey, Pending> > pending;
+  };
+
+  static void Flush();
+
+  static void Deliver(Node* node);
+
+  static thread_local State state_;
+
+  static QAtomicInteger<qint64> issued_count_;
+
+  static QAtomicInteger<qint64> delivered_count_;
+
+};
+
+}
+
+#endif // INVALIDATIONBATCHER_H
@@ -20,12 +20,81 @@
 
 #include "keyframe.h"
 
+#include "common/bezier.h"
+#include "common/lerp.h"
 #include "node.h"
 
 namespace olive {
 
 const NodeKeyframe::Type NodeKeyframe::kDefaultType = kLinear;
 
+NodeKeyframeSegment::NodeKeyframeSegment() :
+  mode_(kInvalid)
+{
+}
+
+NodeKeyframeSegment::NodeKeyframeSegment(const NodeKeyframe *before, const NodeKeyframe *after, NodeValue::Type type) :
+  mode_(kInvalid)
+{
+  if (!before || !after || !NodeValue::type_can_be_interpolated(type)) {
+    return;
+  }
+
+  in_time_ = before->time().toDouble();
+  out_time_ = after->time().toDouble();
+
+  if (type == NodeValue::kRational) {
+    in_value_ = before->value().value<rational>().toDouble();
+    out_value_ = after->value().value<rational>().toDouble();
+  } else {
+    in_value_ = before->value().toDouble();
+    out_value_ = after->value().toDouble();
+  }
+
+  if (before->type() == NodeKeyframe::kBezier && after->type() == NodeKeyframe::kBezier) {
+    // Cubic bezier with two control points
+    QPointF control_out = before->valid_bezier_control_out();
+    QPointF control_in = after->valid_bezier_control_in();
+
+    Bezier::CubicToCoefficients(in_time_, in_time_ + control_out.x(), out_time_ + control_in.x(), out_time_, time_coeffs_);
+    Bezier::CubicToCoefficients(in_value_, in_value_ + control_out.y(), out_value_ + control_in.y(), out_value_, value_coeffs_);
+
+    mode_ = kCubic;
+  } else if (before->type() == NodeKeyframe::kBezier || after->type() == NodeKeyframe::kBezier) {
+    // Quadratic bezier with only one control point
+    if (before->type() == NodeKeyframe::kBezier) {
+      QPointF control_point = before->valid_bezier_control_out();
+      control_time_ = in_time_ + control_point.x();
+      control_value_ = in_value_ + control_point.y();
+    } else {
+      QPointF control_point = after->valid_bezier_control_in();
+      control_time_ = out_time_ + control_point.x();
+      control_value_ = out_value_ + control_point.y();
+    }
+
+    mode_ = kQuadratic;
+  } else {
+    mode_ = kLinear;
+  }
+}
+
+double NodeKeyframeSegment::Interpolate(double time) const
+{
+  switch (mode_) {
+  case kCubic:
+    return Bezier::CubicCoefficientsTtoY(value_coeffs_, Bezier::CubicCoefficientsXtoT(time, time_coeffs_));
+  case kQuadratic:
+    return Bezier::QuadraticTtoY(in_value_, control_value_, out_value_,
+                                 Bezier::QuadraticXtoT(time, in_time_, control_time_, out_time_));
+  case kLinear:
+    return lerp(in_value_, out_value_, (time - in_time_) / (out_time_ - in_time_));
+  case kInvalid:
+    break;
+  }
+
+  return 0.0;
+}
+
 NodeKeyframe::NodeKeyframe(const rational &time, const QVariant &value, Type type, int track, int element, const QString &input, QObject *parent) :
   time_(time),
   value_(value),
@@ -72,6 +141,7 @@ const rational &NodeKeyframe::time() const
 void NodeKeyframe::set_time(const rational &time)
 {
   time_ = time;
+  update_adjacent_segments();
   emit TimeChanged(time_);
 }
 
@@ -83,6 +153,7 @@ const QVariant &NodeKeyframe::value() const
 void NodeKeyframe::set_value(const QVariant &value)
 {
   value_ = value;
+  update_adjacent_segments();
   emit ValueChanged(value_);
 }
 
@@ -116,6 +187,7 @@ void NodeKeyframe::set_type(const NodeKeyframe::Type &type)
       }
     }
 
+    update_adjacent_segments();
     emit TypeChanged(type_);
   }
 }
@@ -128,6 +200,7 @@ const QPointF &NodeKeyframe::bezier_control_in() const
 void NodeKeyframe::set_bezier_control_in(const QPointF &control)
 {
   bezier_control_in_ = control;
+  update_adjacent_segments();
   emit BezierControlInChanged(bezier_control_in_);
 }
 
@@ -139,6 +212,7 @@ const QPointF &NodeKeyframe::bezier_control_out() const
 void NodeKeyframe::set_bezier_control_out(const QPointF &control)
 {
   bezier_control_out_ = control;
+  update_adjacent_segments();
   emit BezierControlOutChanged(bezier_control_out_);
 }
 
@@ -186,6 +260,25 @@ void NodeKeyframe::set_bezier_control(NodeKeyframe::BezierType type, const QPoin
   }
 }
 
+void NodeKeyframe::update_segment()
+{
+  if (next_ && parent()) {
+    segment_ = NodeKeyframeSegment(this, next_, parent()->GetInputDataType(input_));
+  } else {
+    segment_ = NodeKeyframeSegment();
+  }
+}
+
+void NodeKeyframe::update_adjacent_segments()
+{
+  // The segment leading into this keyframe belongs to the previous one
+  update_segment();
+
+  if (previous_) {
+    previous_->update_segment();
+  }
+}
+
 NodeKeyframe::BezierType NodeKeyframe::get_opposing_bezier_type(NodeKeyframe::BezierType type)
 {
   if (type == kInHandle) {
@@ -31,6 +31,58 @@
 namespace olive {
 
 class Node;
+class NodeKeyframe;
+
+/**
+ * @brief Interpolation data for the span between two adjacent keyframes
+ *
+ * Converting keyframe values and bezier handles to doubles (and curves into polynomial form) is
+ * done once whenever either keyframe changes, so evaluating the span at a given time is cheap.
+ */
+class NodeKeyframeSegment
+{
+public:
+  NodeKeyframeSegment();
+
+  NodeKeyframeSegment(const NodeKeyframe* before, const NodeKeyframe* after, NodeValue::Type type);
+
+  bool IsValid() const
+  {
+    return mode_ != kInvalid;
+  }
+
+  /**
+   * @brief Get the interpolated value at a time between the two keyframes
+   */
+  double Interpolate(double time) const;
+
+private:
+  enum Mode {
+    kInvalid,
+    kLinear,
+    kQuadratic,
+    kCubic
+  };
+
+  Mode mode_;
+
+  double in_time_;
+
+  double out_time_;
+
+  double in_value_;
+
+  double out_value_;
+
+  double control_time_;
+
+  double control_value_;
+
+  double time_coeffs_[4];
+
+  double value_coeffs_[4];
+
+};
 
 /**
  * @brief A point of data to be used at a certain time and interpolated with other data
@@ -166,6 +218,21 @@ public:
     next_ = keyframe;
   }
 
+  /**
+   * @brief Precomputed interpolation between this keyframe and next()
+   *
+   * Invalid if there is no next keyframe or the input's type can't be interpolated.
+   */
+  const NodeKeyframeSegment& segment() const
+  {
+    return segment_;
+  }
+
+  /**
+   * @brief Recompute segment(), called whenever this keyframe or its neighbors change
+   */
+  void update_segment();
+
 signals:
   /**
    * @brief Signal emitted when this keyframe's time is changed
@@ -193,6 +260,8 @@ signals:
   void BezierControlOutChanged(const QPointF& d);
 
 private:
+  void update_adjacent_segments();
+
   rational time_;
 
   QVariant value_;
@@ -213,6 +282,8 @@ private:
 
   NodeKeyframe* next_;
 
+  NodeKeyframeSegment segment_;
+
 };
 
 using NodeKeyframeTrack = QVector<NodeKeyframe*>;
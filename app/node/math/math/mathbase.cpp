@@ -139,12 +139,12 @@ QVector4D MathNodeBase::RetrieveVector(const NodeValue &val)
   // QVariant doesn't know that QVector*D can convert themselves so we do it here
   switch (val.type()) {
   case NodeValue::kVec2:
-    return val.data().value<QVector2D>();
+    return val.value<QVector2D>();
   case NodeValue::kVec3:
-    return val.data().value<QVector3D>();
+    return val.value<QVector3D>();
   case NodeValue::kVec4:
   default:
-    return val.data().value<QVector4D>();
+    return val.value<QVector4D>();
   }
 }
 
@@ -176,7 +176,7 @@ NodeValueTable MathNodeBase::ValueInternal(NodeValueDatabase &value, Operation o
     if (val_a.type() == NodeValue::kRational && val_b.type() == NodeValue::kRational && operation != kOpPower) {
       // Preserve rationals
       output.Push(NodeValue::kRational,
-                  QVariant::fromValue(PerformAddSubMultDiv<rational, rational>(operation, val_a.data().value<rational>(), val_b.data().value<rational>())),
+                  QVariant::fromValue(PerformAddSubMultDiv<rational, rational>(operation, val_a.value<rational>(), val_b.value<rational>())),
                   this);
     } else {
       output.Push(NodeValue::kFloat,
@@ -198,7 +198,7 @@ NodeValueTable MathNodeBase::ValueInternal(NodeValueDatabase &value, Operation o
 
   case kPairMatrixVec:
   {
-    QMatrix4x4 matrix = (val_a.type() == NodeValue::kMatrix) ? val_a.data().value<QMatrix4x4>() : val_b.data().value<QMatrix4x4>();
+    QMatrix4x4 matrix = (val_a.type() == NodeValue::kMatrix) ? val_a.value<QMatrix4x4>() : val_b.value<QMatrix4x4>();
     QVector4D vec = (val_a.type() == NodeValue::kMatrix) ? RetrieveVector(val_b) : RetrieveVector(val_a);
 
     // Only valid operation is multiply
@@ -220,16 +220,16 @@ NodeValueTable MathNodeBase::ValueInternal(NodeValueDatabase &value, Operation o
 
   case kPairMatrixMatrix:
   {
-    QMatrix4x4 mat_a = val_a.data().value<QMatrix4x4>();
-    QMatrix4x4 mat_b = val_b.data().value<QMatrix4x4>();
+    QMatrix4x4 mat_a = val_a.value<QMatrix4x4>();
+    QMatrix4x4 mat_b = val_b.value<QMatrix4x4>();
     output.Push(NodeValue::kMatrix, PerformAddSubMult<QMatrix4x4, QMatrix4x4>(operation, mat_a, mat_b), this);
     break;
   }
 
   case kPairColorColor:
   {
-    Color col_a = val_a.data().value<Color>();
-    Color col_b = val_b.data().value<Color>();
+    Color col_a = val_a.value<Color>();
+    Color col_b = val_b.value<Color>();
 
     // Only add and subtract are valid operations
     output.Push(NodeValue::kColor, QVariant::fromValue(PerformAddSub<Color, Color>(operation, col_a, col_b)), this);
@@ -239,8 +239,8 @@ NodeValueTable MathNodeBase::ValueInternal(NodeValueDatabase &value, Operation o
 
   case kPairNumberColor:
   {
-    Color col = (val_a.type() == NodeValue::kColor) ? val_a.data().value<Color>() : val_b.data().value<Color>();
-    float num = (val_a.type() == NodeValue::kColor) ? val_b.data().toFloat() : val_a.data().toFloat();
+    Color col = (val_a.type() == NodeValue::kColor) ? val_a.value<Color>() : val_b.value<Color>();
+    float num = (val_a.type() == NodeValue::kColor) ? val_b.toFloat() : val_a.toFloat();
 
     // Only multiply and divide are valid operations
     output.Push(NodeValue::kColor, QVariant::fromValue(PerformMult<Color, float>(operation, col, num)), this);
@@ -249,8 +249,8 @@ NodeValueTable MathNodeBase::ValueInternal(NodeValueDatabase &value, Operation o
 
   case kPairSampleSample:
   {
-    SampleBufferPtr samples_a = val_a.data().value<SampleBufferPtr>();
-    SampleBufferPtr samples_b = val_b.data().value<SampleBufferPtr>();
+    SampleBufferPtr samples_a = val_a.value<SampleBufferPtr>();
+    SampleBufferPtr samples_b = val_b.value<SampleBufferPtr>();
 
     int max_samples = qMax(samples_a->sample_count(), samples_b->sample_count());
     int min_samples = qMin(samples_a->sample_count(), samples_b->sample_count());
@@ -299,7 +299,7 @@ NodeValueTable MathNodeBase::ValueInternal(NodeValueDatabase &value, Operation o
 
     const NodeValue& number_val = val_a.type() == NodeValue::kTexture ? val_b : val_a;
     const NodeValue& texture_val = val_a.type() == NodeValue::kTexture ? val_a : val_b;
-    TexturePtr texture = texture_val.data().value<TexturePtr>();
+    TexturePtr texture = texture_val.value<TexturePtr>();
 
     if (!texture) {
       operation_is_noop = true;
@@ -309,10 +309,10 @@ NodeValueTable MathNodeBase::ValueInternal(NodeValueDatabase &value, Operation o
       }
     } else if (pairing == kPairTextureMatrix) {
       // Only allow matrix multiplication
-      QVector2D sequence_res = value[QStringLiteral("global")].Get(NodeValue::kVec2, QStringLiteral("resolution")).value<QVector2D>();
+      QVector2D sequence_res = value[QStringLiteral("global")].Get<QVector2D>(NodeValue::kVec2, QStringLiteral("resolution"));
       QVector2D texture_res(texture->params().width() * texture->pixel_aspect_ratio().toDouble(), texture->params().height());
 
-      QMatrix4x4 adjusted_matrix = TransformDistortNode::AdjustMatrixByResolutions(number_val.data().value<QMatrix4x4>(),
+      QMatrix4x4 adjusted_matrix = TransformDistortNode::AdjustMatrixByResolutions(number_val.value<QMatrix4x4>(),
                                                                                    sequence_res,
                                                                                    texture_res);
 
@@ -398,9 +398,9 @@ void MathNodeBase::ProcessSamplesInternal(NodeValueDatabase &values, MathNodeBas
 float MathNodeBase::RetrieveNumber(const NodeValue &val)
 {
   if (val.type() == NodeValue::kRational) {
-    return val.data().value<rational>().toDouble();
+    return val.value<rational>().toDouble();
   } else {
-    return val.data().toFloat();
+    return val.toFloat();
   }
 }
 
@@ -83,8 +83,8 @@ NodeValueTable MergeNode::Value(const QString &output, NodeValueDatabase &value)
 
   NodeValueTable table = value.Merge();
 
-  TexturePtr base_tex = job.GetValue(kBaseIn).data().value<TexturePtr>();
-  TexturePtr blend_tex = job.GetValue(kBlendIn).data().value<TexturePtr>();
+  TexturePtr base_tex = job.GetValue(kBaseIn).value<TexturePtr>();
+  TexturePtr blend_tex = job.GetValue(kBlendIn).value<TexturePtr>();
 
   if (base_tex || blend_tex) {
     if (!base_tex || (blend_tex && blend_tex->channel_count() < VideoParams::kRGBAChannelCount)) {
@@ -100,6 +100,11 @@ NodeValueTable MergeNode::Value(const QString &output, NodeValueDatabase &value)
         job.SetAlphaChannelRequired(GenerateJob::kAlphaForceOff);
       }
 
+      if (base_tex->channel_count() == VideoParams::kRGBAChannelCount) {
+        // Alpha over is transparent wherever both inputs are
+        job.SetRegion(base_tex->region().united(blend_tex->region()));
+      }
+
       table.Push(NodeValue::kShaderJob, QVariant::fromValue(job), this);
     }
   }
@@ -114,8 +119,8 @@ void MergeNode::Hash(const QString &output, QCryptographicHash &hash, const rati
 
   NodeValueDatabase db = traverser.GenerateDatabase(this, output, TimeRange(time, time+video_params.frame_rate_as_time_base()));
 
-  TexturePtr base_tex = db[kBaseIn].Get(NodeValue::kTexture).value<TexturePtr>();
-  TexturePtr blend_tex = db[kBlendIn].Get(NodeValue::kTexture).value<TexturePtr>();
+  TexturePtr base_tex = db[kBaseIn].Get<TexturePtr>(NodeValue::kTexture);
+  TexturePtr blend_tex = db[kBlendIn].Get<TexturePtr>(NodeValue::kTexture);
 
   if (base_tex || blend_tex) {
     bool passthrough_base = !blend_tex;
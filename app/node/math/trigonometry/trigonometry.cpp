@@ -80,7 +80,7 @@ NodeValueTable TrigonometryNode::Value(const QString &output, NodeValueDatabase
 {
   Q_UNUSED(output)
 
-  float x = value[kXIn].Take(NodeValue::kFloat).toFloat();
+  float x = value[kXIn].Take<float>(NodeValue::kFloat);
 
   NodeValueTable table = value.Merge();
 
@@ -31,8 +31,10 @@
 #include "common/xmlutils.h"
 #include "core.h"
 #include "config/config.h"
+#include "node/invalidationbatcher.h"
 #include "node/project/footage/footage.h"
 #include "project/project.h"
+#include "render/renderprofiler.h"
 #include "ui/colorcoding.h"
 #include "ui/icons/icons.h"
 #include "widget/nodeview/nodeviewundo.h"
@@ -73,6 +75,14 @@ Node::~Node()
       delete i;
     }
   }
+
+  // Drop any invalidations still queued for us (including ones caused by disconnecting above)
+  InvalidationBatcher::RemoveNode(this);
+
+  // Don't let any recorded render costs outlive us
+  if (RenderProfiler::instance()) {
+    RenderProfiler::instance()->RemoveNode(this);
+  }
 }
 
 NodeGraph *Node::parent() const
@@ -456,6 +466,7 @@ void Node::SetInputIsKeyframing(const QString &input, bool e, int element)
 
   if (imm) {
     imm->set_is_keyframing(e);
+    imm->clear_baked_values();
 
     emit KeyframeEnableChanged(NodeInput(this, input, element), e);
   } else {
@@ -513,6 +524,7 @@ void Node::SetInputDataType(const QString &id, const NodeValue::Type &type)
     int array_sz = InputArraySize(id);
     for (int i=-1; i<array_sz; i++) {
       GetImmediate(id, i)->set_data_type(type);
+      GetImmediate(id, i)->clear_baked_values();
     }
 
     emit InputDataTypeChanged(id, type);
@@ -570,6 +582,26 @@ void Node::SetInputProperty(const QString &id, const QString &name, const QVaria
   }
 }
 
+QVariant Node::GetValueAtTime(const QString &input, const rational &time, int element) const
+{
+  NodeInputImmediate* imm = GetImmediate(input, element);
+
+  if (imm && imm->is_using_standard_value()) {
+    // Most inputs aren't keyframed, return the already combined value rather than splitting and
+    // recombining it on every lookup
+    return imm->get_standard_value();
+  }
+
+  QVariant baked;
+  if (GetBakedValueAtTime(input, time, element, &baked)) {
+    return baked;
+  }
+
+  NodeValue::Type type = GetInputDataType(input);
+
+  return NodeValue::combine_track_values_into_normal_value(type, GetSplitValueAtTime(input, time, element));
+}
+
 SplitValue Node::GetSplitValueAtTime(const QString &input, const rational &time, int element) const
 {
   SplitValue vals;
@@ -604,94 +636,203 @@ QVariant Node::GetSplitValueAtTimeOnTrack(const QString &input, const rational &
 
     NodeValue::Type type = GetInputDataType(input);
 
+    if (!NodeValue::type_can_be_interpolated(type)) {
+      // Types that can't be interpolated have always held the first keyframe's value
+      return key_track.first()->value();
+    }
+
     // If we're here, the time must be somewhere in between the keyframes
-    for (int i=0;i<key_track.size()-1;i++) {
-      NodeKeyframe* before = key_track.at(i);
-      NodeKeyframe* after = key_track.at(i+1);
+    int segment_index = GetKeyframeSegmentIndex(key_track, time);
+    NodeKeyframe* before = key_track.at(segment_index);
 
-      if (before->time() == time
-          || !NodeValue::type_can_be_interpolated(type)
-          || (before->type() == NodeKeyframe::kHold && after->time() > time)) {
+    if (before->time() == time
+        || before->type() == NodeKeyframe::kHold) {
+      // Time == keyframe time, so value is precise
+      return before->value();
+    }
 
-        // Time == keyframe time, so value is precise
-        return before->value();
+    // We must interpolate between these keyframes. Segments are normally computed when keyframes
+    // change, but compute one here if the keyframe hasn't been set up yet.
+    double interpolated;
 
-      } else if (after->time() == time) {
+    if (before->segment().IsValid()) {
+      interpolated = before->segment().Interpolate(time.toDouble());
+    } else {
+      interpolated = NodeKeyframeSegment(before, key_track.at(segment_index + 1), type).Interpolate(time.toDouble());
+    }
 
-        // Time == keyframe time, so value is precise
-        return after->value();
+    if (type == NodeValue::kRational) {
+      return QVariant::fromValue(rational::fromDouble(interpolated));
+    } else {
+      return interpolated;
+    }
+  }
 
-      } else if (before->time() < time && after->time() > time) {
-        // We must interpolate between these keyframes
+  return GetSplitStandardValueOnTrack(input, track, element);
+}
 
-        double before_val, after_val, interpolated;
-        if (type == NodeValue::kRational) {
-          before_val = before->value().value<rational>().toDouble();
-          after_val = after->value().value<rational>().toDouble();
-        } else {
-          before_val = before->value().toDouble();
-          after_val = after->value().toDouble();
-        }
+int Node::GetKeyframeSegmentIndex(const NodeKeyframeTrack &track, const rational &time)
+{
+  // Renders usually walk forward through time, so each thread remembers the last segment it used
+  // on a handful of tracks and checks it (and the one after it) before doing a binary search
+  struct SegmentHint {
+    const NodeKeyframeTrack* track;
+    int index;
+  };
 
-        if (before->type() == NodeKeyframe::kBezier && after->type() == NodeKeyframe::kBezier) {
-          // Perform a cubic bezier with two control points
+  static const int kHintCount = 64;
+  static thread_local SegmentHint hints[kHintCount] = {};
 
-          double t = Bezier::CubicXtoT(time.toDouble(),
-                                       before->time().toDouble(),
-                                       before->time().toDouble() + before->valid_bezier_control_out().x(),
-                                       after->time().toDouble() + after->valid_bezier_control_in().x(),
-                                       after->time().toDouble());
+  SegmentHint& hint = hints[(reinterpret_cast<quintptr>(&track) / sizeof(NodeKeyframeTrack)) % kHintCount];
 
-          double y = Bezier::CubicTtoY(before_val,
-                                       before_val + before->valid_bezier_control_out().y(),
-                                       after_val + after->valid_bezier_control_in().y(),
-                                       after_val,
-                                       t);
+  if (hint.track == &track) {
+    for (int i=hint.index; i<=hint.index+1 && i<track.size()-1; i++) {
+      if (track.at(i)->time() <= time && track.at(i+1)->time() > time) {
+        hint.index = i;
+        return i;
+      }
+    }
+  }
 
-          interpolated = y;
+  auto it = std::upper_bound(track.cbegin(), track.cend(), time, [](const rational& t, NodeKeyframe* key){
+    return t < key->time();
+  });
 
-        } else if (before->type() == NodeKeyframe::kBezier || after->type() == NodeKeyframe::kBezier) {
-          // Perform a quadratic bezier with only one control point
+  int index = qMax(0, int(it - track.cbegin()) - 1);
 
-          QPointF control_point;
-          double control_point_time;
-          double control_point_value;
+  hint.track = &track;
+  hint.index = index;
 
-          if (before->type() == NodeKeyframe::kBezier) {
-            control_point = before->valid_bezier_control_out();
-            control_point_time = before->time().toDouble() + control_point.x();
-            control_point_value = before_val + control_point.y();
-          } else {
-            control_point = after->valid_bezier_control_in();
-            control_point_time = after->time().toDouble() + control_point.x();
-            control_point_value = after_val + control_point.y();
-          }
+  return index;
+}
 
-          // Generate T from time values - used to determine bezier progress
-          double t = Bezier::QuadraticXtoT(time.toDouble(), before->time().toDouble(), control_point_time, after->time().toDouble());
+void Node::BakeKeyframes(const rational &timebase)
+{
+  for (auto it=standard_immediates_.cbegin(); it!=standard_immediates_.cend(); it++) {
+    BakeImmediate(it.value(), it.key(), -1, timebase);
+  }
 
-          // Generate value using T
-          double y = Bezier::QuadraticTtoY(before_val, control_point_value, after_val, t);
+  for (auto it=array_immediates_.cbegin(); it!=array_immediates_.cend(); it++) {
+    for (int i=0; i<it.value().size(); i++) {
+      BakeImmediate(it.value().at(i), it.key(), i, timebase);
+    }
+  }
+}
 
-          interpolated = y;
+void Node::CopyBakedKeyframes(const Node *src, Node *dst)
+{
+  for (auto it=src->standard_immediates_.cbegin(); it!=src->standard_immediates_.cend(); it++) {
+    NodeInputImmediate* dst_imm = dst->GetImmediate(it.key(), -1);
 
-        } else {
-          // To have arrived here, the keyframes must both be linear
-          qreal period_progress = (time.toDouble() - before->time().toDouble()) / (after->time().toDouble() - before->time().toDouble());
+    if (dst_imm) {
+      dst_imm->set_baked_values(it.value()->baked_values());
+    }
+  }
 
-          interpolated = lerp(before_val, after_val, period_progress);
-        }
+  for (auto it=src->array_immediates_.cbegin(); it!=src->array_immediates_.cend(); it++) {
+    for (int i=0; i<it.value().size(); i++) {
+      NodeInputImmediate* dst_imm = dst->GetImmediate(it.key(), i);
 
-        if (type == NodeValue::kRational) {
-          return QVariant::fromValue(rational::fromDouble(interpolated));
-        } else {
-          return interpolated;
-        }
+      if (dst_imm) {
+        dst_imm->set_baked_values(it.value().at(i)->baked_values());
       }
     }
   }
+}
 
-  return GetSplitStandardValueOnTrack(input, track, element);
+void Node::ClearBakedKeyframes(const QString &input, int element)
+{
+  NodeInputImmediate* imm = GetImmediate(input, element);
+
+  if (imm) {
+    imm->clear_baked_values();
+  }
+}
+
+void Node::ClearBakedKeyframes()
+{
+  for (auto it=standard_immediates_.cbegin(); it!=standard_immediates_.cend(); it++) {
+    it.value()->clear_baked_values();
+  }
+
+  for (auto it=array_immediates_.cbegin(); it!=array_immediates_.cend(); it++) {
+    foreach (NodeInputImmediate* imm, it.value()) {
+      imm->clear_baked_values();
+    }
+  }
+}
+
+bool Node::GetBakedValueAtTime(const QString &input, const rational &time, int element, QVariant *value) const
+{
+  NodeInputImmediate* imm = GetImmediate(input, element);
+
+  if (!imm || !imm->is_keyframing() || !imm->has_baked_values()) {
+    return false;
+  }
+
+  const NodeInputImmediate::BakedValues& baked = imm->baked_values();
+
+  int64_t ts = Timecode::time_to_timestamp(time, baked.timebase);
+
+  if (Timecode::timestamp_to_time(ts, baked.timebase) != time) {
+    // Not on a frame, evaluate keyframes instead
+    return false;
+  }
+
+  int64_t index = ts - baked.start;
+
+  if (index < 0 || index >= baked.values.size()) {
+    return false;
+  }
+
+  *value = baked.values.at(index);
+  return true;
+}
+
+void Node::BakeImmediate(NodeInputImmediate *immediate, const QString &input, int element, const rational &timebase)
+{
+  // Prevent runaway tables from keyframes placed very far apart
+  static const int64_t kMaximumBakedFrames = 1 << 18;
+
+  if (!immediate->is_keyframing()) {
+    immediate->clear_baked_values();
+    return;
+  }
+
+  if (immediate->has_baked_values() && immediate->baked_values().timebase == timebase) {
+    // Already baked and nothing has changed since
+    return;
+  }
+
+  NodeKeyframe* earliest = immediate->get_earliest_keyframe();
+  NodeKeyframe* latest = immediate->get_latest_keyframe();
+
+  if (!earliest || !latest) {
+    immediate->clear_baked_values();
+    return;
+  }
+
+  int64_t start = Timecode::time_to_timestamp(earliest->time(), timebase);
+  int64_t end = Timecode::time_to_timestamp(latest->time(), timebase);
+
+  if (end - start + 1 > kMaximumBakedFrames) {
+    immediate->clear_baked_values();
+    return;
+  }
+
+  // Make sure we evaluate keyframes rather than reading a stale table
+  immediate->clear_baked_values();
+
+  NodeInputImmediate::BakedValues baked;
+  baked.timebase = timebase;
+  baked.start = start;
+  baked.values.resize(end - start + 1);
+
+  for (int64_t i=start; i<=end; i++) {
+    baked.values[i - start] = GetValueAtTime(input, Timecode::timestamp_to_time(i, timebase), element);
+  }
+
+  immediate->set_baked_values(baked);
 }
 
 QVariant Node::GetDefaultValue(const QString &input) const
@@ -1207,7 +1348,7 @@ void Node::SendInvalidateCache(const TimeRange &range, qint64 job_time)
       // Send clear cache signal to the Node
       const NodeInput& in = conn.second;
 
-      in.node()->InvalidateCache(range, in.input(), in.element(), job_time);
+      InvalidationBatcher::Invalidate(in.node(), in.input(), in.element(), range, job_time);
     }
   }
 }
@@ -1859,6 +2000,9 @@ void Node::ParameterValueChanged(const QString& input, int element, const TimeRa
 {
   UpdateLastChangedTime();
 
+  // Any baked keyframe values for this input are stale now
+  ClearBakedKeyframes(input, element);
+
   InputValueChangedEvent(input, element);
 
   emit ValueChanged(NodeInput(this, input, element), range);
@@ -1867,7 +2011,7 @@ void Node::ParameterValueChanged(const QString& input, int element, const TimeRa
     return;
   }
 
-  InvalidateCache(range, input, element);
+  InvalidationBatcher::Invalidate(this, input, element, range, last_change_time_);
 }
 
 void Node::LoadImmediate(QXmlStreamReader *reader, const QString& input, int element, XMLNodeData &xml_node_data, const QAtomicInt *cancelled)
@@ -2259,9 +2403,11 @@ void Node::InvalidateFromKeyframeTimeChange()
 
   // Invalidate entire area surrounding the keyframe (either where it currently is, or where it used to be before it
   // was resorted in the if block above)
+  InvalidationBatcher::Begin();
   foreach (const TimeRange& r, invalidate_range) {
     ParameterValueChanged(key->key_track_ref().input(), r);
   }
+  InvalidationBatcher::End();
 }
 
 void Node::InvalidateFromKeyframeValueChange()
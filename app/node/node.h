@@ -313,12 +313,7 @@ public:
   QVariant GetInputProperty(const QString& id, const QString& name) const;
   void SetInputProperty(const QString& id, const QString& name, const QVariant& value);
 
-  QVariant GetValueAtTime(const QString& input, const rational& time, int element = -1) const
-  {
-    NodeValue::Type type = GetInputDataType(input);
-
-    return NodeValue::combine_track_values_into_normal_value(type, GetSplitValueAtTime(input, time, element));
-  }
+  QVariant GetValueAtTime(const QString& input, const rational& time, int element = -1) const;
 
   QVariant GetValueAtTime(const NodeInput& input, const rational& time)
   {
@@ -338,6 +333,30 @@ public:
     return GetSplitValueAtTimeOnTrack(input.input(), time, track, input.element());
   }
 
+  /**
+   * @brief Sample every keyframed input once per frame so renders read values from a flat table
+   *
+   * GetValueAtTime() uses the table for any time that lands exactly on a frame of `timebase`
+   * between the first and last keyframes, and evaluates keyframes as usual otherwise. An input's
+   * table is dropped whenever its value changes. Inputs already baked at `timebase` are skipped,
+   * so this is cheap to call again after a few values have changed.
+   *
+   * Renderers read tables without locking, so only call this on a graph no render job is using.
+   */
+  void BakeKeyframes(const rational& timebase);
+
+  /**
+   * @brief Copy baked keyframe tables between nodes of the same type (shallow copies)
+   */
+  static void CopyBakedKeyframes(const Node* src, Node* dst);
+
+  void ClearBakedKeyframes(const QString& input, int element = -1);
+
+  /**
+   * @brief Drop every baked keyframe table on this node
+   */
+  void ClearBakedKeyframes();
+
   QVariant GetSplitValueAtTimeOnTrack(const NodeKeyframeTrackReference& input, const rational& time) const
   {
     return GetSplitValueAtTimeOnTrack(input.input(), time, input.track());
@@ -1169,6 +1188,17 @@ private:
    */
   TimeRange GetRangeAroundIndex(const QString& input, int index, int track, int element) const;
 
+  /**
+   * @brief Find the index of the keyframe that starts the segment containing `time`
+   *
+   * `time` must be after the first keyframe and before the last one.
+   */
+  static int GetKeyframeSegmentIndex(const NodeKeyframeTrack& track, const rational& time);
+
+  bool GetBakedValueAtTime(const QString& input, const rational& time, int element, QVariant* value) const;
+
+  void BakeImmediate(NodeInputImmediate* immediate, const QString& input, int element, const rational& timebase);
+
   void ClearElement(const QString &input, int index);
 
   QVector<QString> ignore_connections_;
@@ -345,7 +345,7 @@ rational ViewerOutput::VerifyLengthInternal(Track::Type type) const
   case Track::kVideo:
     if (IsInputConnected(kTextureInput)) {
       NodeValueTable t = traverser.GenerateTable(GetConnectedOutput(kTextureInput), TimeRange(0, 0));
-      rational r = t.Get(NodeValue::kRational, QStringLiteral("length")).value<rational>();
+      rational r = t.Get<rational>(NodeValue::kRational, QStringLiteral("length"));
       if (!r.isNaN()) {
         return r;
       }
@@ -354,7 +354,7 @@ rational ViewerOutput::VerifyLengthInternal(Track::Type type) const
   case Track::kAudio:
     if (IsInputConnected(kSamplesInput)) {
       NodeValueTable t = traverser.GenerateTable(GetConnectedOutput(kSamplesInput), TimeRange(0, 0));
-      rational r = t.Get(NodeValue::kRational, QStringLiteral("length")).value<rational>();;
+      rational r = t.Get<rational>(NodeValue::kRational, QStringLiteral("length"));;
       if (!r.isNaN()) {
         return r;
       }
@@ -31,6 +31,7 @@
 #include "config/config.h"
 #include "core.h"
 #include "render/job/footagejob.h"
+#include "render/rendermanager.h"
 #include "ui/icons/icons.h"
 #include "widget/videoparamedit/videoparamedit.h"
 
@@ -373,9 +374,9 @@ NodeValueTable Footage::Value(const QString &output, NodeValueDatabase &value) c
   Track::Reference ref = Track::Reference::FromString(output);
 
   // Pop filename from table
-  QString file = value[kFilenameInput].Take(NodeValue::kFile).toString();
+  QString file = value[kFilenameInput].Take<QString>(NodeValue::kFile);
 
-  LoopMode loop_mode = static_cast<LoopMode>(value[kLoopModeInput].Take(NodeValue::kCombo).toInt());
+  LoopMode loop_mode = static_cast<LoopMode>(value[kLoopModeInput].Take<int>(NodeValue::kCombo));
 
   // Merge table
   NodeValueTable table = value.Merge();
@@ -394,9 +395,11 @@ NodeValueTable Footage::Value(const QString &output, NodeValueDatabase &value) c
     } else {
       AudioParams ap = GetAudioParams(ref.index());
       job.set_audio_params(ap);
-      job.set_cache_path(project()->cache_path());
     }
 
+    // Used for audio conforms and video proxies
+    job.set_cache_path(project()->cache_path());
+
     table.Push(NodeValue::kRational, QVariant::fromValue(GetLength()), this, false, QStringLiteral("length"));
     table.Push(NodeValue::kFootageJob, QVariant::fromValue(job), this);
   }
@@ -521,6 +524,12 @@ void Footage::CheckFootage()
     if (current_file_timestamp != timestamp()) {
       // File has changed!
       set_timestamp(current_file_timestamp);
+
+      // Any frames decoded from the old file are stale now
+      if (RenderManager::instance() && RenderManager::instance()->frame_texture_cache()) {
+        RenderManager::instance()->frame_texture_cache()->RemoveFile(fn);
+      }
+
       InvalidateAll(kFilenameInput);
     }
   }
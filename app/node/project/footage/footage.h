@@ -193,6 +193,11 @@ public:
 
   static rational AdjustTimeByLoopMode(rational time, LoopMode loop_mode, const rational& length, VideoParams::Type type, const rational &timebase);
 
+  /**
+   * @brief Get the colorspace of a stream, falling back to the project's default if it's unset
+   */
+  QString GetColorspaceToUse(const VideoParams& params) const;
+
   static const QString kFilenameInput;
   static const QString kLoopModeInput;
 
@@ -212,8 +217,6 @@ protected:
   virtual rational VerifyLengthInternal(Track::Type type) const override;
 
 private:
-  QString GetColorspaceToUse(const VideoParams& params) const;
-
   /**
    * @brief Update the icon based on the Footage status
    *
@@ -20,7 +20,9 @@
 
 #include "traverser.h"
 
+#include "common/timecodefunctions.h"
 #include "node.h"
+#include "node/project/sequence/sequence.h"
 #include "render/job/footagejob.h"
 #include "render/rendermanager.h"
 
@@ -55,7 +57,7 @@ int NodeTraverser::GetChannelCountFromJob(const GenerateJob &job)
   case GenerateJob::kAlphaAuto:
     for (auto it=job.GetValues().cbegin(); it!=job.GetValues().cend(); it++) {
       if (it.value().type() == NodeValue::kTexture) {
-        TexturePtr tex = it.value().data().value<TexturePtr>();
+        TexturePtr tex = it.value().value<TexturePtr>();
         if (tex && tex->channel_count() == VideoParams::kRGBAChannelCount) {
           // An input texture has an alpha channel so assume we need one too
           return VideoParams::kRGBAChannelCount;
@@ -123,6 +125,32 @@ NodeValueTable NodeTraverser::ProcessInput(const Node* node, const QString& inpu
 }
 
 NodeValueTable NodeTraverser::GenerateTable(const Node *n, const QString& output, const TimeRange& range)
+{
+  if (!profile_) {
+    return GenerateTableInternal(n, output, range);
+  }
+
+  profile_child_time_.append(0);
+
+  qint64 start = RenderProfiler::Now();
+
+  NodeValueTable table = GenerateTableInternal(n, output, range);
+
+  qint64 end = RenderProfiler::Now();
+
+  qint64 inclusive = end - start;
+  qint64 self = inclusive - profile_child_time_.takeLast();
+
+  if (!profile_child_time_.isEmpty()) {
+    profile_child_time_.last() += inclusive;
+  }
+
+  profile_->AddEvent(RenderProfiler::kCategoryNode, n, GetProfileName(n), start, end, self);
+
+  return table;
+}
+
+NodeValueTable NodeTraverser::GenerateTableInternal(const Node *n, const QString& output, const TimeRange& range)
 {
   const Track* track = dynamic_cast<const Track*>(n);
   if (track) {
@@ -130,6 +158,11 @@ NodeValueTable NodeTraverser::GenerateTable(const Node *n, const QString& output
     return GenerateBlockTable(track, range);
   }
 
+  const Sequence* nested = dynamic_cast<const Sequence*>(n);
+  if (nested && CanCacheFrames()) {
+    return GenerateNestedTable(nested, output, range);
+  }
+
   // FIXME: Cache certain values here if we've already processed them before
 
   // Generate database of input values of node
@@ -143,6 +176,55 @@ NodeValueTable NodeTraverser::GenerateTable(const Node *n, const QString& output
   return table;
 }
 
+NodeValueTable NodeTraverser::GenerateNestedTable(const Sequence *sequence, const QString &output, const TimeRange &range)
+{
+  NodeOutput texture_output = sequence->GetConnectedOutput(ViewerOutput::kTextureInput);
+
+  // The sequence's cache is rendered at its own parameters, so we can only share frames with it if
+  // those are what we'd render it at here anyway
+  VideoParams nested_params = sequence->GetVideoParams();
+  nested_params.set_divider(video_params_.divider());
+
+  bool shares_cache = texture_output.IsValid()
+      && nested_params.effective_width() == video_params_.effective_width()
+      && nested_params.effective_height() == video_params_.effective_height()
+      && nested_params.format() == video_params_.format()
+      && nested_params.interlacing() == video_params_.interlacing()
+      && nested_params.pixel_aspect_ratio() == video_params_.pixel_aspect_ratio();
+
+  // The cache only holds the sequence's own frames, so a time between them (e.g. from a parent at a
+  // different frame rate) has to be rendered exactly rather than snapped to one
+  if (shares_cache) {
+    rational frame_time = Timecode::snap_time_to_timebase(range.in(), nested_params.frame_rate_as_time_base());
+    shares_cache = (frame_time == range.in());
+  }
+
+  QByteArray hash;
+
+  if (shares_cache) {
+    hash = RenderManager::Hash(texture_output, video_params_, range.in());
+
+    QVariant cached_frame = GetCachedTexture(hash);
+    if (!cached_frame.isNull()) {
+      NodeValueTable table;
+      table.Push(NodeValue::kTexture, cached_frame, sequence);
+      return table;
+    }
+  }
+
+  NodeValueDatabase database = GenerateDatabase(sequence, output, range);
+
+  NodeValueTable table = sequence->Value(output, database);
+
+  PostProcessTable(sequence, output, range, table);
+
+  if (shares_cache && !IsCancelled()) {
+    SaveNestedTexture(hash, table.Get(NodeValue::kTexture));
+  }
+
+  return table;
+}
+
 NodeValueTable NodeTraverser::GenerateBlockTable(const Track *track, const TimeRange &range)
 {
   // By default, just follow the in point
@@ -157,8 +239,9 @@ NodeValueTable NodeTraverser::GenerateBlockTable(const Track *track, const TimeR
   return table;
 }
 
-QVariant NodeTraverser::ProcessVideoFootage(const FootageJob &stream, const rational &input_time)
+QVariant NodeTraverser::ProcessVideoFootage(const Node *node, const FootageJob &stream, const rational &input_time)
 {
+  Q_UNUSED(node)
   Q_UNUSED(input_time)
 
   // Create dummy texture with footage params
@@ -182,7 +265,9 @@ QVariant NodeTraverser::ProcessShader(const Node *node, const TimeRange &range,
   // Create dummy texture with sequence params
   VideoParams tex_params = video_params_;
   tex_params.set_channel_count(GetChannelCountFromJob(job));
-  return QVariant::fromValue(std::make_shared<Texture>(tex_params));
+  TexturePtr texture = std::make_shared<Texture>(tex_params);
+  texture->set_region(job.GetRegion());
+  return QVariant::fromValue(texture);
 }
 
 QVariant NodeTraverser::ProcessSamples(const Node *node, const TimeRange &range, const SampleJob &job)
@@ -205,12 +290,31 @@ QVariant NodeTraverser::ProcessFrameGeneration(const Node *node, const GenerateJ
   return QVariant::fromValue(std::make_shared<Texture>(tex_params));
 }
 
+void NodeTraverser::GetJobTextures(const GenerateJob &job, QVector<Texture *> *textures)
+{
+  for (auto it=job.GetValues().cbegin(); it!=job.GetValues().cend(); it++) {
+    if (it.value().type() == NodeValue::kTexture && !it.value().array()) {
+      Texture* t = it.value().value<TexturePtr>().get();
+
+      if (t) {
+        textures->append(t);
+      }
+    }
+  }
+}
+
 void NodeTraverser::SaveCachedTexture(const QByteArray &hash, const QVariant &texture)
 {
   Q_UNUSED(hash)
   Q_UNUSED(texture)
 }
 
+void NodeTraverser::SaveNestedTexture(const QByteArray &hash, const QVariant &texture)
+{
+  Q_UNUSED(hash)
+  Q_UNUSED(texture)
+}
+
 QVariant NodeTraverser::GetCachedTexture(const QByteArray& hash)
 {
   Q_UNUSED(hash)
@@ -218,6 +322,30 @@ QVariant NodeTraverser::GetCachedTexture(const QByteArray& hash)
   return QVariant();
 }
 
+void NodeTraverser::AddProfileEvent(RenderProfiler::Category category, const Node *node, const QString &name, qint64 start, qint64 end)
+{
+  if (!profile_) {
+    return;
+  }
+
+  profile_->AddEvent(category, node, name, start, end);
+
+  if (category == RenderProfiler::kCategoryShader && !profile_child_time_.isEmpty()) {
+    profile_child_time_.last() += end - start;
+  }
+}
+
+QString NodeTraverser::GetProfileName(const Node *node)
+{
+  if (!node) {
+    return QString();
+  }
+
+  QString label = node->GetLabel();
+
+  return label.isEmpty() ? node->Name() : label;
+}
+
 void NodeTraverser::AddGlobalsToDatabase(NodeValueDatabase &db, const TimeRange& range) const
 {
   // Insert global variables
@@ -283,13 +411,13 @@ void NodeTraverser::PostProcessTable(const Node *node, const QString& output, co
     // Retrieve video frames
     foreach (const NodeValue& v, footage_jobs_to_run) {
       // Assume this is a VideoStream, we did a type check earlier in the function
-      FootageJob job = v.data().value<FootageJob>();
+      FootageJob job = v.value<FootageJob>();
 
       if (job.type() == Track::kVideo) {
         rational footage_time = Footage::AdjustTimeByLoopMode(range.in(), job.loop_mode(), job.length(), job.video_params().video_type(), job.video_params().frame_rate_as_time_base());
 
         if (!footage_time.isNaN()) {
-          QVariant value = ProcessVideoFootage(job, footage_time);
+          QVariant value = ProcessVideoFootage(node, job, footage_time);
 
           if (!value.isNull()) {
             output_params.Push(NodeValue::kTexture, value, node);
@@ -298,29 +426,52 @@ void NodeTraverser::PostProcessTable(const Node *node, const QString& output, co
       }
     }
 
+    // Textures that a job has turned into a new texture, see below
+    QVector<Texture*> consumed_textures;
+
     // Run shaders
     foreach (const NodeValue& v, shader_jobs_to_run) {
-      QVariant value = ProcessShader(node, range, v.data().value<ShaderJob>());
+      ShaderJob job = v.value<ShaderJob>();
+      QVariant value = ProcessShader(node, range, job);
 
       if (!value.isNull()) {
+        GetJobTextures(job, &consumed_textures);
         output_params.Push(NodeValue::kTexture, value, node);
       }
     }
 
     // Run generate jobs
     foreach (const NodeValue& v, generate_jobs_to_run) {
-      QVariant value = ProcessFrameGeneration(node, v.data().value<GenerateJob>());
+      GenerateJob job = v.value<GenerateJob>();
+      QVariant value = ProcessFrameGeneration(node, job);
 
       if (!value.isNull()) {
+        GetJobTextures(job, &consumed_textures);
         output_params.Push(NodeValue::kTexture, value, node);
       }
     }
+
+    // Most nodes merge their inputs into their output table, which would otherwise keep every
+    // intermediate texture in the graph alive until the whole frame is done. Anything a job has
+    // consumed has been superseded by its output, so drop our reference now and let the texture
+    // go back to the renderer's pool as soon as nothing else needs it.
+    if (!consumed_textures.isEmpty()) {
+      for (int i=0; i<output_params.Count(); i++) {
+        const NodeValue& v = output_params.at(i);
+
+        if (v.type() == NodeValue::kTexture && !v.array()
+            && consumed_textures.contains(v.value<TexturePtr>().get())) {
+          output_params.TakeAt(i);
+          i--;
+        }
+      }
+    }
   }
 
   // Retrieve audio samples
   foreach (const NodeValue& v, footage_jobs_to_run) {
     // Assume this is an AudioStream, we did a type check earlier in the function
-    FootageJob job = v.data().value<FootageJob>();
+    FootageJob job = v.value<FootageJob>();
 
     if (job.type() == Track::kAudio) {
       QVariant value = ProcessAudioFootage(job, range);
@@ -333,7 +484,7 @@ void NodeTraverser::PostProcessTable(const Node *node, const QString& output, co
 
   // Run any accelerated shader jobs
   foreach (const NodeValue& v, sample_jobs_to_run) {
-    QVariant value = ProcessSamples(node, range, v.data().value<SampleJob>());
+    QVariant value = ProcessSamples(node, range, v.value<SampleJob>());
 
     if (!value.isNull()) {
       output_params.Push(NodeValue::kSamples, value, node);
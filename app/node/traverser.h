@@ -27,10 +27,13 @@
 #include "common/cancelableobject.h"
 #include "node/output/track/track.h"
 #include "render/job/footagejob.h"
+#include "render/renderprofiler.h"
 #include "value.h"
 
 namespace olive {
 
+class Sequence;
+
 class NodeTraverser : public CancelableObject
 {
 public:
@@ -56,12 +59,20 @@ public:
 
   static int GetChannelCountFromJob(const GenerateJob& job);
 
+  /**
+   * @brief Record the time each node takes into this profile, or nullptr to stop recording
+   */
+  void SetProfile(RenderProfiler::Recorder* profile)
+  {
+    profile_ = profile;
+  }
+
 protected:
   NodeValueTable ProcessInput(const Node *node, const QString &input, const TimeRange &range);
 
   virtual NodeValueTable GenerateBlockTable(const Track *track, const TimeRange& range);
 
-  virtual QVariant ProcessVideoFootage(const FootageJob &stream, const rational &input_time);
+  virtual QVariant ProcessVideoFootage(const Node *node, const FootageJob &stream, const rational &input_time);
 
   virtual QVariant ProcessAudioFootage(const FootageJob &stream, const TimeRange &input_time);
 
@@ -75,6 +86,13 @@ protected:
 
   virtual void SaveCachedTexture(const QByteArray& hash, const QVariant& texture);
 
+  /**
+   * @brief Store a frame of a nested sequence that had to be rendered in its own frame cache
+   *
+   * Implementations may skip this, e.g. if saving would hold up a render that needs to be fast.
+   */
+  virtual void SaveNestedTexture(const QByteArray& hash, const QVariant& texture);
+
   virtual bool CanCacheFrames()
   {
     return false;
@@ -82,13 +100,48 @@ protected:
 
   void AddGlobalsToDatabase(NodeValueDatabase& db, const TimeRange &range) const;
 
+  RenderProfiler::Recorder* profile() const
+  {
+    return profile_;
+  }
+
+  /**
+   * @brief Record work done on behalf of a node, if profiling
+   *
+   * Shaders are often rendered later than the node that created them (e.g. when fused into a
+   * downstream node), so their time is attributed to their own node and taken out of whichever
+   * node is being traversed at the time.
+   */
+  void AddProfileEvent(RenderProfiler::Category category, const Node* node, const QString& name, qint64 start, qint64 end);
+
+  static QString GetProfileName(const Node* node);
+
+  static void GetJobTextures(const GenerateJob& job, QVector<Texture*>* textures);
+
   QVector2D GenerateResolution() const;
 
 private:
+  NodeValueTable GenerateTableInternal(const Node *n, const QString &output, const TimeRange &range);
+
+  /**
+   * @brief Generate the table for a sequence used inside another one
+   *
+   * If the nested sequence is rendered at the same parameters as this traversal and the time falls
+   * exactly on one of its frames, that frame is interchangeable with the one in its own
+   * FrameHashCache, so it's loaded from there by hash rather than traversing its graph again.
+   * Frames that aren't cached yet are rendered normally and may be saved for next time.
+   */
+  NodeValueTable GenerateNestedTable(const Sequence* sequence, const QString& output, const TimeRange& range);
+
   void PostProcessTable(const Node *node, const QString &output, const TimeRange &range, NodeValueTable &output_params);
 
   VideoParams video_params_;
 
+  RenderProfiler::Recorder* profile_ = nullptr;
+
+  // Time spent upstream of (or in shaders during) each node currently being traversed
+  QVector<qint64> profile_child_time_;
+
 };
 
 }
@@ -26,6 +26,7 @@
 #include <QVector3D>
 #include <QVector4D>
 
+#include "common/rational.h"
 #include "common/tohex.h"
 #include "render/audioparams.h"
 #include "render/videoparams.h"
@@ -37,6 +38,344 @@ const QVector<NodeValue::Type> NodeValue::kNumber = {kFloat, kInt, kRational};
 const QVector<NodeValue::Type> NodeValue::kBuffer = {kTexture, kSamples};
 const QVector<NodeValue::Type> NodeValue::kVector = {kVec2, kVec3, kVec4, kColor};
 
+NodeValue::NodeValue(Type type, const QVector2D &data, const Node *from, bool array, const QString &tag) :
+  type_(type),
+  storage_(kStorageVec2),
+  from_(from),
+  tag_(tag),
+  array_(array)
+{
+  inline_.v[0] = data.x();
+  inline_.v[1] = data.y();
+}
+
+NodeValue::NodeValue(Type type, const QVector3D &data, const Node *from, bool array, const QString &tag) :
+  type_(type),
+  storage_(kStorageVec3),
+  from_(from),
+  tag_(tag),
+  array_(array)
+{
+  inline_.v[0] = data.x();
+  inline_.v[1] = data.y();
+  inline_.v[2] = data.z();
+}
+
+NodeValue::NodeValue(Type type, const QVector4D &data, const Node *from, bool array, const QString &tag) :
+  type_(type),
+  storage_(kStorageVec4),
+  from_(from),
+  tag_(tag),
+  array_(array)
+{
+  inline_.v[0] = data.x();
+  inline_.v[1] = data.y();
+  inline_.v[2] = data.z();
+  inline_.v[3] = data.w();
+}
+
+NodeValue::NodeValue(Type type, const QMatrix4x4 &data, const Node *from, bool array, const QString &tag) :
+  type_(type),
+  storage_(kStorageMatrix),
+  from_(from),
+  tag_(tag),
+  array_(array)
+{
+  data.copyDataTo(inline_.m);
+}
+
+QVariant NodeValue::data() const
+{
+  switch (storage_) {
+  case kStorageVariant:
+    break;
+  case kStorageInt:
+    return QVariant::fromValue(static_cast<int>(inline_.i));
+  case kStorageLong:
+    return QVariant::fromValue(static_cast<long>(inline_.i));
+  case kStorageLongLong:
+    return QVariant::fromValue(static_cast<qlonglong>(inline_.i));
+  case kStorageFloat:
+    return QVariant::fromValue(static_cast<float>(inline_.d));
+  case kStorageDouble:
+    return QVariant::fromValue(inline_.d);
+  case kStorageBool:
+    return QVariant::fromValue(inline_.b);
+  case kStorageRational:
+    return QVariant::fromValue(value<rational>());
+  case kStorageVec2:
+    return QVariant::fromValue(value<QVector2D>());
+  case kStorageVec3:
+    return QVariant::fromValue(value<QVector3D>());
+  case kStorageVec4:
+    return QVariant::fromValue(value<QVector4D>());
+  case kStorageColor:
+    return QVariant::fromValue(value<Color>());
+  case kStorageMatrix:
+    return QVariant::fromValue(value<QMatrix4x4>());
+  }
+
+  return data_;
+}
+
+template<>
+double NodeValue::value<double>() const
+{
+  if (storage_ == kStorageDouble || storage_ == kStorageFloat) {
+    return inline_.d;
+  }
+
+  return data().value<double>();
+}
+
+template<>
+float NodeValue::value<float>() const
+{
+  if (storage_ == kStorageDouble || storage_ == kStorageFloat) {
+    return static_cast<float>(inline_.d);
+  }
+
+  return data().value<float>();
+}
+
+template<>
+int NodeValue::value<int>() const
+{
+  if (storage_ == kStorageInt || storage_ == kStorageLong || storage_ == kStorageLongLong) {
+    return static_cast<int>(inline_.i);
+  }
+
+  return data().value<int>();
+}
+
+template<>
+int64_t NodeValue::value<int64_t>() const
+{
+  if (storage_ == kStorageInt || storage_ == kStorageLong || storage_ == kStorageLongLong) {
+    return inline_.i;
+  }
+
+  return data().value<int64_t>();
+}
+
+template<>
+bool NodeValue::value<bool>() const
+{
+  if (storage_ == kStorageBool) {
+    return inline_.b;
+  }
+
+  return data().value<bool>();
+}
+
+template<>
+rational NodeValue::value<rational>() const
+{
+  if (storage_ == kStorageRational) {
+    // Stored already reduced, so this gives back the same numerator and denominator
+    return rational(inline_.r[0], inline_.r[1]);
+  }
+
+  return data().value<rational>();
+}
+
+template<>
+QVector2D NodeValue::value<QVector2D>() const
+{
+  if (storage_ == kStorageVec2) {
+    return QVector2D(inline_.v[0], inline_.v[1]);
+  }
+
+  return data().value<QVector2D>();
+}
+
+template<>
+QVector3D NodeValue::value<QVector3D>() const
+{
+  if (storage_ == kStorageVec3) {
+    return QVector3D(inline_.v[0], inline_.v[1], inline_.v[2]);
+  }
+
+  return data().value<QVector3D>();
+}
+
+template<>
+QVector4D NodeValue::value<QVector4D>() const
+{
+  if (storage_ == kStorageVec4) {
+    return QVector4D(inline_.v[0], inline_.v[1], inline_.v[2], inline_.v[3]);
+  }
+
+  return data().value<QVector4D>();
+}
+
+template<>
+Color NodeValue::value<Color>() const
+{
+  if (storage_ == kStorageColor) {
+    return Color(inline_.c[0], inline_.c[1], inline_.c[2], inline_.c[3]);
+  }
+
+  return data().value<Color>();
+}
+
+template<>
+QMatrix4x4 NodeValue::value<QMatrix4x4>() const
+{
+  if (storage_ == kStorageMatrix) {
+    QMatrix4x4 m(inline_.m);
+
+    // Restore the identity/translation flags that QMatrix4x4 uses to skip work when multiplying
+    m.optimize();
+
+    return m;
+  }
+
+  return data().value<QMatrix4x4>();
+}
+
+double NodeValue::toDouble() const
+{
+  return value<double>();
+}
+
+float NodeValue::toFloat() const
+{
+  return value<float>();
+}
+
+int NodeValue::toInt() const
+{
+  return value<int>();
+}
+
+bool NodeValue::toBool() const
+{
+  return value<bool>();
+}
+
+QString NodeValue::toString() const
+{
+  return data().toString();
+}
+
+bool NodeValue::isNull() const
+{
+  if (storage_ == kStorageVariant) {
+    return data_.isNull();
+  }
+
+  // QVariant treats some values (e.g. zero-length vectors) as null, so leave it to decide
+  return data().isNull();
+}
+
+void NodeValue::SetData(const QVariant &data)
+{
+  int type = data.userType();
+
+  switch (type) {
+  case QMetaType::Int:
+    storage_ = kStorageInt;
+    inline_.i = data.value<int>();
+    return;
+  case QMetaType::Long:
+    storage_ = kStorageLong;
+    inline_.i = data.value<long>();
+    return;
+  case QMetaType::LongLong:
+    storage_ = kStorageLongLong;
+    inline_.i = data.value<qlonglong>();
+    return;
+  case QMetaType::Float:
+    storage_ = kStorageFloat;
+    inline_.d = data.value<float>();
+    return;
+  case QMetaType::Double:
+    storage_ = kStorageDouble;
+    inline_.d = data.value<double>();
+    return;
+  case QMetaType::Bool:
+    storage_ = kStorageBool;
+    inline_.b = data.value<bool>();
+    return;
+  case QMetaType::QVector2D:
+  {
+    QVector2D vec = data.value<QVector2D>();
+    storage_ = kStorageVec2;
+    inline_.v[0] = vec.x();
+    inline_.v[1] = vec.y();
+    return;
+  }
+  case QMetaType::QVector3D:
+  {
+    QVector3D vec = data.value<QVector3D>();
+    storage_ = kStorageVec3;
+    inline_.v[0] = vec.x();
+    inline_.v[1] = vec.y();
+    inline_.v[2] = vec.z();
+    return;
+  }
+  case QMetaType::QVector4D:
+  {
+    QVector4D vec = data.value<QVector4D>();
+    storage_ = kStorageVec4;
+    inline_.v[0] = vec.x();
+    inline_.v[1] = vec.y();
+    inline_.v[2] = vec.z();
+    inline_.v[3] = vec.w();
+    return;
+  }
+  case QMetaType::QMatrix4x4:
+    storage_ = kStorageMatrix;
+    data.value<QMatrix4x4>().copyDataTo(inline_.m);
+    return;
+  }
+
+  if (type == qMetaTypeId<rational>()) {
+    rational r = data.value<rational>();
+    storage_ = kStorageRational;
+    inline_.r[0] = r.numerator();
+    inline_.r[1] = r.denominator();
+  } else if (type == qMetaTypeId<Color>()) {
+    Color c = data.value<Color>();
+    storage_ = kStorageColor;
+    memcpy(inline_.c, c.data(), sizeof(inline_.c));
+  } else {
+    storage_ = kStorageVariant;
+    data_ = data;
+  }
+}
+
+bool NodeValue::DataEquals(const NodeValue &rhs) const
+{
+  if (storage_ == kStorageVariant && rhs.storage_ == kStorageVariant) {
+    return data_ == rhs.data_;
+  }
+
+  if (storage_ == rhs.storage_) {
+    // Compare the same way QVariant would have, without boxing either side
+    switch (storage_) {
+    case kStorageRational:
+      return value<rational>() == rhs.value<rational>();
+    case kStorageVec2:
+      return value<QVector2D>() == rhs.value<QVector2D>();
+    case kStorageVec3:
+      return value<QVector3D>() == rhs.value<QVector3D>();
+    case kStorageVec4:
+      return value<QVector4D>() == rhs.value<QVector4D>();
+    case kStorageColor:
+      return !memcmp(inline_.c, rhs.inline_.c, sizeof(inline_.c));
+    case kStorageMatrix:
+      return value<QMatrix4x4>() == rhs.value<QMatrix4x4>();
+    default:
+      break;
+    }
+  }
+
+  // Scalars box without allocating, and comparing between storages needs QVariant's conversions
+  return data() == rhs.data();
+}
+
 QString NodeValue::ValueToString(Type data_type, const QVariant &value, bool value_is_a_key_track)
 {
   if (!value_is_a_key_track && data_type == kVec2) {
@@ -324,6 +663,28 @@ QString NodeValue::GetPrettyDataTypeName(Type type)
   return QCoreApplication::translate("NodeValue",  "Unknown");
 }
 
+NodeValue NodeValueTable::GetWithMeta(NodeValue::Type type, const QString &tag) const
+{
+  int value_index = GetInternal(type, tag);
+
+  if (value_index >= 0) {
+    return values_.at(value_index);
+  }
+
+  return NodeValue();
+}
+
+NodeValue NodeValueTable::TakeWithMeta(NodeValue::Type type, const QString &tag)
+{
+  int value_index = GetInternal(type, tag);
+
+  if (value_index >= 0) {
+    return values_.takeAt(value_index);
+  }
+
+  return NodeValue();
+}
+
 NodeValue NodeValueTable::GetWithMeta(const QVector<NodeValue::Type> &type, const QString &tag) const
 {
   int value_index = GetInternal(type, tag);
@@ -407,23 +768,4 @@ NodeValueTable NodeValueTable::Merge(QList<NodeValueTable> tables)
   return merged_table;
 }
 
-int NodeValueTable::GetInternal(const QVector<NodeValue::Type>& types, const QString &tag) const
-{
-  int index = -1;
-
-  for (int i=values_.size() - 1;i>=0;i--) {
-    const NodeValue& v = values_.at(i);
-
-    if (types.contains(v.type())) {
-      index = i;
-
-      if (tag.isEmpty() || tag == v.tag()) {
-        break;
-      }
-    }
-  }
-
-  return index;
-}
-
 }
@@ -24,10 +24,18 @@
 #include <QString>
 #include <QVariant>
 #include <QVector>
+#include <stdint.h>
+
+class QMatrix4x4;
+class QVector2D;
+class QVector3D;
+class QVector4D;
 
 namespace olive {
 
+class Color;
 class Node;
+class rational;
 
 class NodeValue
 {
@@ -206,6 +214,7 @@ public:
 
   NodeValue() :
     type_(kNone),
+    storage_(kStorageVariant),
     from_(nullptr),
     array_(false)
   {
@@ -213,23 +222,52 @@ public:
 
   NodeValue(Type type, const QVariant& data, const Node* from = nullptr, bool array = false, const QString& tag = QString()) :
     type_(type),
-    data_(data),
     from_(from),
     tag_(tag),
     array_(array)
   {
+    SetData(data);
   }
 
+  NodeValue(Type type, const QVector2D& data, const Node* from = nullptr, bool array = false, const QString& tag = QString());
+  NodeValue(Type type, const QVector3D& data, const Node* from = nullptr, bool array = false, const QString& tag = QString());
+  NodeValue(Type type, const QVector4D& data, const Node* from = nullptr, bool array = false, const QString& tag = QString());
+  NodeValue(Type type, const QMatrix4x4& data, const Node* from = nullptr, bool array = false, const QString& tag = QString());
+
   Type type() const
   {
     return type_;
   }
 
-  const QVariant& data() const
+  /**
+   * @brief Returns this value boxed in a QVariant
+   *
+   * Numbers, vectors, colors and matrices are held unboxed and have to be boxed again on every
+   * call, which allocates for anything larger than a double. Prefer value() or one of the toX()
+   * functions when the type is known.
+   */
+  QVariant data() const;
+
+  /**
+   * @brief Returns this value as `T` without going through a QVariant where possible
+   *
+   * Specialized below for every type that's held unboxed. Any other `T`, or a `T` that doesn't
+   * match what's held, falls back to QVariant::value() so conversions behave exactly as before.
+   */
+  template <typename T>
+  T value() const
   {
-    return data_;
+    return data().value<T>();
   }
 
+  double toDouble() const;
+  float toFloat() const;
+  int toInt() const;
+  bool toBool() const;
+  QString toString() const;
+
+  bool isNull() const;
+
   const QString& tag() const
   {
     return tag_;
@@ -247,7 +285,7 @@ public:
 
   bool operator==(const NodeValue& rhs) const
   {
-    return type_ == rhs.type_ && tag_ == rhs.tag_ && data_ == rhs.data_;
+    return type_ == rhs.type_ && tag_ == rhs.tag_ && DataEquals(rhs);
   }
 
   static QString GetPrettyDataTypeName(Type type);
@@ -293,7 +331,49 @@ public:
   static void ValidateVectorString(QStringList* list, int count);
 
 private:
+  /**
+   * @brief How this value's data is held
+   *
+   * Everything other than kStorageVariant is held in `inline_` and `data_` is left null. The
+   * storage follows the QVariant type the value came in as rather than `type_`, so boxing it
+   * again in data() gives back exactly what was passed in.
+   */
+  enum Storage {
+    kStorageVariant,
+    kStorageInt,
+    kStorageLong,
+    kStorageLongLong,
+    kStorageFloat,
+    kStorageDouble,
+    kStorageBool,
+    kStorageRational,
+    kStorageVec2,
+    kStorageVec3,
+    kStorageVec4,
+    kStorageColor,
+    kStorageMatrix
+  };
+
+  void SetData(const QVariant& data);
+
+  bool DataEquals(const NodeValue& rhs) const;
+
   Type type_;
+
+  Storage storage_;
+
+  union {
+    int64_t i;
+    double d;
+    bool b;
+    int64_t r[2];
+    float v[4];
+    double c[4];
+
+    // Row-major, as QMatrix4x4::copyDataTo() gives it
+    float m[16];
+  } inline_;
+
   QVariant data_;
   const Node* from_;
   QString tag_;
@@ -301,6 +381,18 @@ private:
 
 };
 
+template<> double NodeValue::value<double>() const;
+template<> float NodeValue::value<float>() const;
+template<> int NodeValue::value<int>() const;
+template<> int64_t NodeValue::value<int64_t>() const;
+template<> bool NodeValue::value<bool>() const;
+template<> rational NodeValue::value<rational>() const;
+template<> QVector2D NodeValue::value<QVector2D>() const;
+template<> QVector3D NodeValue::value<QVector3D>() const;
+template<> QVector4D NodeValue::value<QVector4D>() const;
+template<> Color NodeValue::value<Color>() const;
+template<> QMatrix4x4 NodeValue::value<QMatrix4x4>() const;
+
 class NodeValueTable
 {
 public:
@@ -308,27 +400,33 @@ public:
 
   QVariant Get(NodeValue::Type type, const QString& tag = QString()) const
   {
-    QVector<NodeValue::Type> types = {type};
-    return Get(types, tag);
+    int index = GetInternal(type, tag);
+    return (index >= 0) ? values_.at(index).data() : QVariant();
   }
 
   QVariant Get(const QVector<NodeValue::Type>& type, const QString& tag = QString()) const
   {
-    return GetWithMeta(type, tag).data();
+    int index = GetInternal(type, tag);
+    return (index >= 0) ? values_.at(index).data() : QVariant();
   }
 
-  NodeValue GetWithMeta(NodeValue::Type type, const QString& tag = QString()) const
+  /**
+   * @brief Typed lookup that returns the value as `T` without boxing it in a QVariant
+   */
+  template <typename T>
+  T Get(NodeValue::Type type, const QString& tag = QString()) const
   {
-    QVector<NodeValue::Type> types = {type};
-    return GetWithMeta(types, tag);
+    int index = GetInternal(type, tag);
+    return (index >= 0) ? values_.at(index).value<T>() : T();
   }
 
+  NodeValue GetWithMeta(NodeValue::Type type, const QString& tag = QString()) const;
+
   NodeValue GetWithMeta(const QVector<NodeValue::Type>& type, const QString& tag = QString()) const;
 
   QVariant Take(NodeValue::Type type, const QString& tag = QString())
   {
-    QVector<NodeValue::Type> types = {type};
-    return Take(types, tag);
+    return TakeWithMeta(type, tag).data();
   }
 
   QVariant Take(const QVector<NodeValue::Type>& type, const QString& tag = QString())
@@ -336,12 +434,15 @@ public:
     return TakeWithMeta(type, tag).data();
   }
 
-  NodeValue TakeWithMeta(NodeValue::Type type, const QString& tag = QString())
+  template <typename T>
+  T Take(NodeValue::Type type, const QString& tag = QString())
   {
-    QVector<NodeValue::Type> types = {type};
-    return TakeWithMeta(types, tag);
+    int index = GetInternal(type, tag);
+    return (index >= 0) ? values_.takeAt(index).value<T>() : T();
   }
 
+  NodeValue TakeWithMeta(NodeValue::Type type, const QString& tag = QString());
+
   NodeValue TakeWithMeta(const QVector<NodeValue::Type>& type, const QString& tag = QString());
 
   void Push(const NodeValue& value)
@@ -349,7 +450,8 @@ public:
     values_.append(value);
   }
 
-  void Push(NodeValue::Type type, const QVariant& data, const Node *from, bool array = false, const QString& tag = QString())
+  template <typename T>
+  void Push(NodeValue::Type type, const T& data, const Node *from, bool array = false, const QString& tag = QString())
   {
     Push(NodeValue(type, data, from, array, tag));
   }
@@ -359,7 +461,8 @@ public:
     values_.prepend(value);
   }
 
-  void Prepend(NodeValue::Type type, const QVariant& data, const Node *from, bool array = false, const QString& tag = QString())
+  template <typename T>
+  void Prepend(NodeValue::Type type, const T& data, const Node *from, bool array = false, const QString& tag = QString())
   {
     Prepend(NodeValue(type, data, from, array, tag));
   }
@@ -389,7 +492,40 @@ public:
   static NodeValueTable Merge(QList<NodeValueTable> tables);
 
 private:
-  int GetInternal(const QVector<NodeValue::Type> &type, const QString& tag) const;
+  int GetInternal(NodeValue::Type type, const QString& tag) const
+  {
+    return GetInternal([type](NodeValue::Type t){ return t == type; }, tag);
+  }
+
+  int GetInternal(const QVector<NodeValue::Type> &type, const QString& tag) const
+  {
+    return GetInternal([&type](NodeValue::Type t){ return type.contains(t); }, tag);
+  }
+
+  /**
+   * @brief Find the most recently pushed value whose type matches, preferring one with `tag`
+   *
+   * Templated on the matcher so single type lookups don't need to allocate a list of types.
+   */
+  template <typename Matcher>
+  int GetInternal(Matcher matches, const QString& tag) const
+  {
+    int index = -1;
+
+    for (int i=values_.size() - 1;i>=0;i--) {
+      const NodeValue& v = values_.at(i);
+
+      if (matches(v.type())) {
+        index = i;
+
+        if (tag.isEmpty() || tag == v.tag()) {
+          break;
+        }
+      }
+    }
+
+    return index;
+  }
 
   QVector<NodeValue> values_;
 
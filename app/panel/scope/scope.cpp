@@ -56,10 +56,19 @@ ScopePanel::ScopePanel(QWidget* parent) :
   waveform_view_ = new WaveformScope();
   stack_->addWidget(waveform_view_);
 
+  // Create parade view
+  parade_view_ = new WaveformScope();
+  parade_view_->SetParade(true);
+  stack_->addWidget(parade_view_);
+
   // Create histogram
   histogram_ = new HistogramScope();
   stack_->addWidget(histogram_);
 
+  // Create vectorscope
+  vectorscope_ = new VectorScope();
+  stack_->addWidget(vectorscope_);
+
   connect(scope_type_combobox_, static_cast<void(QComboBox::*)(int)>(&QComboBox::currentIndexChanged), stack_, &QStackedWidget::setCurrentIndex);
 
   Retranslate();
@@ -75,8 +84,12 @@ QString ScopePanel::TypeToName(ScopePanel::Type t)
   switch (t) {
   case kTypeWaveform:
     return tr("Waveform");
+  case kTypeParade:
+    return tr("RGB Parade");
   case kTypeHistogram:
     return tr("Histogram");
+  case kTypeVectorscope:
+    return tr("Vectorscope");
   case kTypeCount:
     break;
   }
@@ -84,16 +97,21 @@ QString ScopePanel::TypeToName(ScopePanel::Type t)
   return QString();
 }
 
-void ScopePanel::SetReferenceBuffer(Frame *frame)
+void ScopePanel::SetReferenceBuffer(FramePtr frame)
 {
+  // Only the visible scope analyzes the frame, the rest catch up when they're shown
   histogram_->SetBuffer(frame);
   waveform_view_->SetBuffer(frame);
+  parade_view_->SetBuffer(frame);
+  vectorscope_->SetBuffer(frame);
 }
 
 void ScopePanel::SetColorManager(ColorManager *manager)
 {
   histogram_->ConnectColorManager(manager);
   waveform_view_->ConnectColorManager(manager);
+  parade_view_->ConnectColorManager(manager);
+  vectorscope_->ConnectColorManager(manager);
 }
 
 void ScopePanel::Retranslate()
@@ -26,6 +26,7 @@
 
 #include "widget/panel/panel.h"
 #include "widget/scope/histogram/histogram.h"
+#include "widget/scope/vectorscope/vectorscope.h"
 #include "widget/scope/waveform/waveform.h"
 
 namespace olive {
@@ -38,7 +39,9 @@ class ScopePanel : public PanelWidget
 public:
   enum Type {
     kTypeWaveform,
+    kTypeParade,
     kTypeHistogram,
+    kTypeVectorscope,
 
     kTypeCount
   };
@@ -50,7 +53,7 @@ public:
   static QString TypeToName(Type t);
 
 public slots:
-  void SetReferenceBuffer(Frame* frame);
+  void SetReferenceBuffer(FramePtr frame);
 
   void SetColorManager(ColorManager* manager);
 
@@ -66,8 +69,12 @@ private:
 
   WaveformScope* waveform_view_;
 
+  WaveformScope* parade_view_;
+
   HistogramScope* histogram_;
 
+  VectorScope* vectorscope_;
+
 };
 
 }
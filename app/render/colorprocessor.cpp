@@ -111,11 +111,14 @@ Color ColorProcessor::ConvertColor(const Color& in)
 
 QString ColorProcessor::GenerateID(ColorManager *config, const QString &input, const ColorTransform &transform)
 {
-  return QStringLiteral("%1:%2:%3:%4:%5").arg(config->GetConfigFilename(),
-                                              input,
-                                              transform.display(),
-                                              transform.view(),
-                                              transform.look());
+  // A display and a colorspace may share a name, so the transform type is part of the ID too. The
+  // config's cache ID changes with its contents, so re-loading an edited file won't match old IDs.
+  return QStringLiteral("%1:%2:%3:%4:%5:%6").arg(QString::fromUtf8(config->GetConfig()->getCacheID()),
+                                                 input,
+                                                 transform.is_display() ? QStringLiteral("d") : QStringLiteral("c"),
+                                                 transform.display(),
+                                                 transform.view(),
+                                                 transform.look());
 }
 
 ColorProcessorPtr ColorProcessor::Create(ColorManager *config, const QString& input, const ColorTransform &transform)
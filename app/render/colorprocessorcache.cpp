@@ -0,0 +1,104 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2021 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "colorprocessorcache.h"
+
+namespace olive {
+
+ColorProcessorCache ColorProcessorCache::instance_;
+
+// Enough for every footage colorspace in a large project to each have a few destinations
+const int ColorProcessorCache::kMaximumProcessors = 256;
+
+ColorProcessorPtr ColorProcessorCache::Get(ColorManager *config, const QString &input, const ColorTransform &dest_space)
+{
+  QString id = ColorProcessor::GenerateID(config, input, dest_space);
+
+  {
+    QMutexLocker locker(&mutex_);
+
+    ColorProcessorPtr existing = processors_.value(id);
+
+    if (existing) {
+      Touch(id);
+      return existing;
+    }
+  }
+
+  // Create outside of the lock so a slow config doesn't hold up lookups for other conversions
+  ColorProcessorPtr processor = ColorProcessor::Create(config, input, dest_space);
+
+  QMutexLocker locker(&mutex_);
+
+  // Another thread may have beaten us to it, in which case we prefer theirs so everyone shares
+  // one instance
+  ColorProcessorPtr existing = processors_.value(id);
+
+  if (existing) {
+    Touch(id);
+    return existing;
+  }
+
+  processors_.insert(id, processor);
+  lru_.append(id);
+
+  // Anyone still using an evicted processor keeps it alive through their own reference
+  while (lru_.size() > kMaximumProcessors) {
+    processors_.remove(lru_.takeFirst());
+  }
+
+  return processor;
+}
+
+void ColorProcessorCache::Remove(OCIO::ConstConfigRcPtr config)
+{
+  // IDs start with the config's cache ID, see ColorProcessor::GenerateID()
+  QString prefix = QStringLiteral("%1:").arg(QString::fromUtf8(config->getCacheID()));
+
+  QMutexLocker locker(&mutex_);
+
+  for (auto it=lru_.begin(); it!=lru_.end(); ) {
+    if (it->startsWith(prefix)) {
+      processors_.remove(*it);
+      it = lru_.erase(it);
+    } else {
+      it++;
+    }
+  }
+}
+
+void ColorProcessorCache::Clear()
+{
+  QMutexLocker locker(&mutex_);
+
+  processors_.clear();
+  lru_.clear();
+}
+
+void ColorProcessorCache::Touch(const QString &id)
+{
+  // Move to the most recently used end, which is usually already where it is
+  if (lru_.last() != id) {
+    lru_.removeOne(id);
+    lru_.append(id);
+  }
+}
+
+}
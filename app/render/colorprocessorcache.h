@@ -21,11 +21,67 @@
 #ifndef COLORPROCESSORCACHE_H
 #define COLORPROCESSORCACHE_H
 
+#include <QHash>
+#include <QMutex>
+
 #include "render/colorprocessor.h"
 
 namespace olive {
 
-using ColorProcessorCache = QHash<QString, ColorProcessorPtr>;
+/**
+ * @brief Process-wide cache of ColorProcessors
+ *
+ * Building an OCIO processor (and its CPU processor) is expensive, and the render path would
+ * otherwise do it for every frame of footage it decodes. Processors are immutable once
+ * constructed, so a single instance can be shared by every thread that needs the same
+ * conversion.
+ *
+ * Entries are keyed by ColorProcessor::GenerateID(), i.e. the config's cache ID, the input
+ * colorspace, and the destination transform. The least recently used processors are dropped once
+ * there are more than kMaximumProcessors, and ColorManager removes the processors of its old config
+ * when its config changes.
+ *
+ * This class is thread safe.
+ */
+class ColorProcessorCache
+{
+public:
+  ColorProcessorCache() = default;
+
+  DISABLE_COPY_MOVE(ColorProcessorCache)
+
+  static ColorProcessorCache* instance()
+  {
+    return &instance_;
+  }
+
+  /**
+   * @brief Retrieve a processor for this conversion, creating it if it doesn't exist yet
+   */
+  ColorProcessorPtr Get(ColorManager* config, const QString& input, const ColorTransform& dest_space);
+
+  /**
+   * @brief Drop every processor created from this config
+   */
+  void Remove(OCIO::ConstConfigRcPtr config);
+
+  void Clear();
+
+  static const int kMaximumProcessors;
+
+private:
+  void Touch(const QString& id);
+
+  QMutex mutex_;
+
+  QHash<QString, ColorProcessorPtr> processors_;
+
+  // Processor IDs from least to most recently used
+  QList<QString> lru_;
+
+  static ColorProcessorCache instance_;
+
+};
 
 }
 
@@ -0,0 +1,288 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2021 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#include "frametexturecache.h"
+
+namespace olive {
+
+const qint64 FrameTextureCache::kDefaultBudget = 512LL * 1024LL * 1024LL;
+
+FrameTextureCache::FrameTextureCache() :
+  budget_(kDefaultBudget),
+  cached_bytes_(0),
+  clock_(0)
+{
+}
+
+TexturePtr FrameTextureCache::Acquire(const Key &key)
+{
+  Shard& shard = GetShard(key);
+
+  QMutexLocker locker(&shard.mutex);
+
+  forever {
+    auto it = shard.entries.find(key);
+
+    if (it == shard.entries.end()) {
+      // Nobody has this texture, claim it for the caller
+      Entry e;
+      e.size = 0;
+      e.last_used = 0;
+      e.working = true;
+      shard.entries.insert(key, e);
+
+      shard.stats.misses++;
+
+      return nullptr;
+    }
+
+    if (!it->working) {
+      Touch(shard, *it);
+
+      shard.stats.hits++;
+
+      return it->texture;
+    }
+
+    // Another thread is creating this texture, wait for it and look again since it may have been
+    // abandoned or evicted in the meantime
+    shard.wait_cond.wait(&shard.mutex);
+  }
+}
+
+void FrameTextureCache::Fulfill(const Key &key, TexturePtr texture)
+{
+  Shard& shard = GetShard(key);
+
+  {
+    QMutexLocker locker(&shard.mutex);
+
+    Entry& e = shard.entries[key];
+
+    const VideoParams& p = texture->params();
+    e.texture = texture;
+    e.size = qint64(p.effective_width()) * qint64(p.effective_height()) * VideoParams::GetBytesPerPixel(p.format(), p.channel_count());
+    e.working = false;
+    e.lru = shard.lru.insert(shard.lru.end(), key);
+    e.last_used = ++clock_;
+
+    shard.stats.cached_bytes += e.size;
+    shard.stats.cached_count++;
+    cached_bytes_.fetchAndAddOrdered(e.size);
+
+    shard.wait_cond.wakeAll();
+  }
+
+  EvictToBudget();
+}
+
+void FrameTextureCache::Abandon(const Key &key)
+{
+  Shard& shard = GetShard(key);
+
+  QMutexLocker locker(&shard.mutex);
+
+  auto it = shard.entries.find(key);
+
+  if (it != shard.entries.end() && it->working) {
+    shard.entries.erase(it);
+    shard.wait_cond.wakeAll();
+  }
+}
+
+bool FrameTextureCache::Contains(const Key &key) const
+{
+  const Shard& shard = GetShard(key);
+
+  QMutexLocker locker(&shard.mutex);
+
+  return shard.entries.contains(key);
+}
+
+void FrameTextureCache::Clear()
+{
+  RemoveIf([](const Key&){
+    return true;
+  });
+}
+
+void FrameTextureCache::RemoveFile(const QString &filename)
+{
+  RemoveIf([filename](const Key& k){
+    return k.stream.filename() == filename;
+  });
+}
+
+void FrameTextureCache::RemoveColorConfig(const QString &cache_id)
+{
+  // Colorspace IDs start with the config's cache ID, see ColorProcessor::GenerateID()
+  QString prefix = QStringLiteral("%1:").arg(cache_id);
+
+  RemoveIf([prefix](const Key& k){
+    return k.colorspace.startsWith(prefix);
+  });
+}
+
+void FrameTextureCache::SetBudget(qint64 bytes)
+{
+  budget_.storeRelease(bytes);
+
+  EvictToBudget();
+}
+
+FrameTextureCache::Stats FrameTextureCache::GetStats() const
+{
+  Stats total;
+
+  for (int i=0; i<kShardCount; i++) {
+    const Shard& shard = shards_[i];
+
+    QMutexLocker locker(&shard.mutex);
+
+    total.hits += shard.stats.hits;
+    total.misses += shard.stats.misses;
+    total.evictions += shard.stats.evictions;
+    total.cached_bytes += shard.stats.cached_bytes;
+    total.cached_count += shard.stats.cached_count;
+  }
+
+  return total;
+}
+
+FrameTextureCache::Shard &FrameTextureCache::GetShard(const Key &key)
+{
+  return shards_[qHash(key) % kShardCount];
+}
+
+const FrameTextureCache::Shard &FrameTextureCache::GetShard(const Key &key) const
+{
+  return shards_[qHash(key) % kShardCount];
+}
+
+void FrameTextureCache::Touch(Shard &shard, Entry &entry)
+{
+  shard.lru.splice(shard.lru.end(), shard.lru, entry.lru);
+  entry.last_used = ++clock_;
+}
+
+void FrameTextureCache::RemoveIf(const std::function<bool (const Key &)> &predicate)
+{
+  for (int i=0; i<kShardCount; i++) {
+    Shard& shard = shards_[i];
+
+    // Release textures outside the lock, destroying them may have to wait on the renderer
+    QVector<TexturePtr> released;
+
+    {
+      QMutexLocker locker(&shard.mutex);
+
+      // Entries still being created aren't in the LRU list, whoever claimed them will fulfill or
+      // abandon them as usual
+      for (auto k=shard.lru.begin(); k!=shard.lru.end(); ) {
+        if (predicate(*k)) {
+          auto it = shard.entries.find(*k);
+
+          released.append(it->texture);
+
+          shard.stats.cached_bytes -= it->size;
+          shard.stats.cached_count--;
+          cached_bytes_.fetchAndSubOrdered(it->size);
+
+          shard.entries.erase(it);
+          k = shard.lru.erase(k);
+        } else {
+          k++;
+        }
+      }
+    }
+  }
+}
+
+void FrameTextureCache::EvictToBudget()
+{
+  while (cached_bytes_.loadAcquire() > budget_.loadAcquire()) {
+    // Find the shard holding the least recently used texture. Only one shard is ever locked at a
+    // time, so this can't deadlock with other threads doing the same.
+    int oldest_shard = -1;
+    quint64 oldest_time = 0;
+
+    for (int i=0; i<kShardCount; i++) {
+      Shard& shard = shards_[i];
+
+      QMutexLocker locker(&shard.mutex);
+
+      if (!shard.lru.empty()) {
+        quint64 t = shard.entries.value(shard.lru.front()).last_used;
+
+        if (oldest_shard == -1 || t < oldest_time) {
+          oldest_shard = i;
+          oldest_time = t;
+        }
+      }
+    }
+
+    if (oldest_shard == -1) {
+      // Nothing left that can be evicted
+      break;
+    }
+
+    TexturePtr released;
+
+    {
+      Shard& shard = shards_[oldest_shard];
+
+      QMutexLocker locker(&shard.mutex);
+
+      // Something may have been touched or evicted since we looked, in which case we'll just evict
+      // whatever's oldest in this shard now
+      if (shard.lru.empty()) {
+        continue;
+      }
+
+      auto it = shard.entries.find(shard.lru.front());
+      shard.lru.pop_front();
+
+      released = it->texture;
+
+      shard.stats.cached_bytes -= it->size;
+      shard.stats.cached_count--;
+      shard.stats.evictions++;
+      cached_bytes_.fetchAndSubOrdered(it->size);
+
+      shard.entries.erase(it);
+    }
+
+    // Released here, outside the lock, in case this is the last reference
+  }
+}
+
+uint qHash(const FrameTextureCache::Key &key, uint seed)
+{
+  return qHash(key.stream, seed)
+      ^ qHash(key.colorspace, seed)
+      ^ qHash(key.divider, seed)
+      ^ (uint(key.format) << 8)
+      ^ qHash(qint64(key.timestamp), seed)
+      ^ uint(key.alpha_is_associated)
+      ^ (uint(key.allow_proxy) << 1)
+      ^ (uint(key.src_interlacing) << 12)
+      ^ (uint(key.dst_interlacing) << 16);
+}
+
+}
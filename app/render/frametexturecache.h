@@ -0,0 +1,209 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2021 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#ifndef FRAMETEXTURECACHE_H
+#define FRAMETEXTURECACHE_H
+
+#include <functional>
+#include <list>
+#include <QHash>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include "codec/decoder.h"
+#include "common/define.h"
+#include "render/texture.h"
+
+namespace olive {
+
+/**
+ * @brief Shares decoded, color managed footage textures between render jobs
+ *
+ * Uploading and color managing a frame is expensive, especially for high resolution footage, and
+ * the same source frame is often needed several times (a still image on every frame, the same clip
+ * in multiple multicam angles or nested sequences, a duplicated layer). Textures are kept here in
+ * the reference color space, keyed by everything that affects their contents, so any render job
+ * can reuse them.
+ *
+ * Entries are spread over several independently locked shards so render threads rarely contend.
+ * The least recently used textures are evicted across all shards once their total size exceeds
+ * the budget.
+ *
+ * To avoid two threads decoding the same frame, Acquire() lets the first thread to miss claim the
+ * entry. Other threads wanting that entry wait until the claiming thread calls Fulfill() or
+ * Abandon().
+ *
+ * This class is thread safe.
+ */
+class FrameTextureCache
+{
+public:
+  FrameTextureCache();
+
+  DISABLE_COPY_MOVE(FrameTextureCache)
+
+  struct Key {
+    Decoder::CodecStream stream;
+
+    // ColorProcessor ID of the conversion to the reference space
+    QString colorspace;
+
+    bool alpha_is_associated;
+    int divider;
+
+    // Pixel format the texture is rendered in, which differs between online and offline renders
+    VideoParams::Format format;
+
+    // Whether a proxy may have been decoded in place of the original footage
+    bool allow_proxy;
+
+    // The footage's interlacing and the one it's rendered for, since the decoder deinterlaces
+    // when they differ
+    VideoParams::Interlacing src_interlacing;
+    VideoParams::Interlacing dst_interlacing;
+
+    // Timestamp in the stream's time base (always 0 for stills)
+    int64_t timestamp;
+
+    bool operator==(const Key& rhs) const
+    {
+      return stream == rhs.stream
+          && colorspace == rhs.colorspace
+          && alpha_is_associated == rhs.alpha_is_associated
+          && divider == rhs.divider
+          && format == rhs.format
+          && allow_proxy == rhs.allow_proxy
+          && src_interlacing == rhs.src_interlacing
+          && dst_interlacing == rhs.dst_interlacing
+          && timestamp == rhs.timestamp;
+    }
+  };
+
+  struct Stats {
+    qint64 hits = 0;
+    qint64 misses = 0;
+    qint64 evictions = 0;
+    qint64 cached_bytes = 0;
+    int cached_count = 0;
+  };
+
+  /**
+   * @brief Get the texture for this key
+   *
+   * If the texture is being created by another thread, this waits for it. If it's not in the cache
+   * at all, this returns nullptr and the calling thread is responsible for creating it and must
+   * call either Fulfill() or Abandon() with the same key.
+   */
+  TexturePtr Acquire(const Key& key);
+
+  /**
+   * @brief Store the texture for a key previously claimed through Acquire()
+   */
+  void Fulfill(const Key& key, TexturePtr texture);
+
+  /**
+   * @brief Give up a key previously claimed through Acquire(), e.g. if decoding failed
+   *
+   * Any thread waiting for it will claim it for itself instead.
+   */
+  void Abandon(const Key& key);
+
+  /**
+   * @brief Returns whether a texture for this key is cached or being created, without waiting
+   */
+  bool Contains(const Key& key) const;
+
+  /**
+   * @brief Drop every cached texture (textures still in use elsewhere stay alive until released)
+   */
+  void Clear();
+
+  /**
+   * @brief Drop every texture decoded from this file, e.g. because it changed on disk
+   */
+  void RemoveFile(const QString& filename);
+
+  /**
+   * @brief Drop every texture color managed with this OCIO config, identified by its cache ID
+   */
+  void RemoveColorConfig(const QString& cache_id);
+
+  qint64 GetBudget() const
+  {
+    return budget_.load();
+  }
+
+  void SetBudget(qint64 bytes);
+
+  Stats GetStats() const;
+
+  static const qint64 kDefaultBudget;
+
+private:
+  using LRUList = std::list<Key>;
+
+  struct Entry {
+    TexturePtr texture;
+    qint64 size;
+    quint64 last_used;
+
+    // Position in the shard's LRU list, only valid for entries that aren't working
+    LRUList::iterator lru;
+
+    bool working;
+  };
+
+  struct Shard {
+    mutable QMutex mutex;
+    QWaitCondition wait_cond;
+
+    QHash<Key, Entry> entries;
+
+    // Ready entries from least to most recently used
+    LRUList lru;
+
+    Stats stats;
+  };
+
+  static const int kShardCount = 16;
+
+  Shard& GetShard(const Key& key);
+  const Shard& GetShard(const Key& key) const;
+
+  void Touch(Shard& shard, Entry& entry);
+
+  void RemoveIf(const std::function<bool(const Key&)>& predicate);
+
+  void EvictToBudget();
+
+  Shard shards_[kShardCount];
+
+  QAtomicInteger<qint64> budget_;
+
+  QAtomicInteger<qint64> cached_bytes_;
+
+  QAtomicInteger<quint64> clock_;
+
+};
+
+uint qHash(const FrameTextureCache::Key& key, uint seed = 0);
+
+}
+
+#endif // FRAMETEXTURECACHE_H
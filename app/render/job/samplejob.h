@@ -35,12 +35,12 @@ public:
 
   SampleJob(const NodeValue& value)
   {
-    samples_ = value.data().value<SampleBufferPtr>();
+    samples_ = value.value<SampleBufferPtr>();
   }
 
   SampleJob(const QString& from, NodeValueDatabase& db)
   {
-    samples_ = db[from].Take(NodeValue::kSamples).value<SampleBufferPtr>();
+    samples_ = db[from].Take<SampleBufferPtr>(NodeValue::kSamples);
   }
 
   SampleBufferPtr samples() const
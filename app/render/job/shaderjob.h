@@ -22,6 +22,7 @@
 #define SHADERJOB_H
 
 #include <QMatrix4x4>
+#include <QRectF>
 
 #include "generatejob.h"
 #include "render/texture.h"
@@ -34,6 +35,8 @@ public:
   {
     iterations_ = 1;
     iterative_input_ = nullptr;
+    iteration_divider_ = 1;
+    has_region_ = false;
   }
 
   const QString& GetShaderID() const
@@ -67,6 +70,24 @@ public:
     return iterative_input_;
   }
 
+  /**
+   * @brief Run every iteration but the last at 1/divider of the destination's resolution
+   *
+   * Only worthwhile for shaders whose intermediate results are smooth enough to lose nothing at a
+   * lower resolution, such as large blurs. The first iteration still reads the full size input and
+   * the last still draws the full size output, so the shader does the downsampling and upsampling
+   * itself by sampling the iterative input (which should use linear interpolation).
+   */
+  void SetIterationDivider(int divider)
+  {
+    iteration_divider_ = divider;
+  }
+
+  int GetIterationDivider() const
+  {
+    return iteration_divider_;
+  }
+
   Texture::Interpolation GetInterpolation(const QString& id) const
   {
     return interpolation_.value(id, Texture::kDefaultInterpolation);
@@ -82,6 +103,60 @@ public:
     interpolation_.insert(id, interp);
   }
 
+  /**
+   * @brief Mark a texture input that the shader samples once, exactly at the fragment's own coordinate
+   *
+   * If the texture connected here was produced by another shader, the renderer may compute it
+   * inline in this shader rather than rendering it to an intermediate texture first. Inputs that
+   * are resampled (e.g. through a matrix or at block corners) mustn't be marked, an inlined stage
+   * can't reproduce the filtering that sampling a real texture would do.
+   */
+  void SetPerPixelInput(const NodeInput& input)
+  {
+    SetPerPixelInput(input.input());
+  }
+
+  void SetPerPixelInput(const QString& id)
+  {
+    if (!per_pixel_inputs_.contains(id)) {
+      per_pixel_inputs_.append(id);
+    }
+  }
+
+  const QStringList& GetPerPixelInputs() const
+  {
+    return per_pixel_inputs_;
+  }
+
+  /**
+   * @brief Only render the part of the destination inside this rectangle
+   *
+   * Nodes whose output is transparent outside of some area (e.g. a crop, a small shape, or
+   * anything made only from textures with a small Texture::region()) can set this so the shader
+   * isn't run over the whole frame. The rectangle is in normalized texture coordinates and the
+   * output's Texture::region() will be set to it. An empty rectangle renders nothing.
+   */
+  void SetRegion(const QRectF& r)
+  {
+    region_ = r;
+    has_region_ = true;
+  }
+
+  bool HasRegion() const
+  {
+    return has_region_;
+  }
+
+  /**
+   * @brief Returns the region that will actually be rendered, i.e. the region clipped to the frame
+   */
+  QRectF GetRegion() const
+  {
+    QRectF full(0, 0, 1, 1);
+
+    return has_region_ ? region_.intersected(full) : full;
+  }
+
 private:
   QString shader_id_;
 
@@ -89,8 +164,16 @@ private:
 
   QString iterative_input_;
 
+  int iteration_divider_;
+
   QHash<QString, Texture::Interpolation> interpolation_;
 
+  QStringList per_pixel_inputs_;
+
+  QRectF region_;
+
+  bool has_region_;
+
 };
 
 }
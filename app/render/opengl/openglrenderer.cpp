@@ -22,6 +22,7 @@
 
 #include <QDebug>
 #include <QOpenGLExtraFunctions>
+#include <QtMath>
 
 namespace olive {
 
@@ -376,40 +377,40 @@ void OpenGLRenderer::Blit(QVariant s, ShaderJob job, Texture *destination, Video
     case NodeValue::kInt:
       // kInt technically specifies a LongLong, but OpenGL doesn't support those. This may lead to
       // over/underflows if the number is large enough, but the likelihood of that is quite low.
-      shader->setUniformValue(variable_location, value.data().toInt());
+      shader->setUniformValue(variable_location, value.toInt());
       break;
     case NodeValue::kFloat:
       // kFloat technically specifies a double but as above, OpenGL doesn't support those.
-      shader->setUniformValue(variable_location, value.data().toFloat());
+      shader->setUniformValue(variable_location, value.toFloat());
       break;
     case NodeValue::kVec2:
-      shader->setUniformValue(variable_location, value.data().value<QVector2D>());
+      shader->setUniformValue(variable_location, value.value<QVector2D>());
       break;
     case NodeValue::kVec3:
-      shader->setUniformValue(variable_location, value.data().value<QVector3D>());
+      shader->setUniformValue(variable_location, value.value<QVector3D>());
       break;
     case NodeValue::kVec4:
-      shader->setUniformValue(variable_location, value.data().value<QVector4D>());
+      shader->setUniformValue(variable_location, value.value<QVector4D>());
       break;
     case NodeValue::kMatrix:
-      shader->setUniformValue(variable_location, value.data().value<QMatrix4x4>());
+      shader->setUniformValue(variable_location, value.value<QMatrix4x4>());
       break;
     case NodeValue::kCombo:
-      shader->setUniformValue(variable_location, value.data().value<int>());
+      shader->setUniformValue(variable_location, value.value<int>());
       break;
     case NodeValue::kColor:
     {
-      Color color = value.data().value<Color>();
+      Color color = value.value<Color>();
       shader->setUniformValue(variable_location,
                               color.red(), color.green(), color.blue(), color.alpha());
       break;
     }
     case NodeValue::kBoolean:
-      shader->setUniformValue(variable_location, value.data().toBool());
+      shader->setUniformValue(variable_location, value.toBool());
       break;
     case NodeValue::kTexture:
     {
-      TexturePtr texture = value.data().value<TexturePtr>();
+      TexturePtr texture = value.value<TexturePtr>();
 
       // Set value to bound texture
       shader->setUniformValue(variable_location, textures_to_bind.size());
@@ -464,12 +465,7 @@ void OpenGLRenderer::Blit(QVariant s, ShaderJob job, Texture *destination, Video
 
   // Ensure matrix is set, at least to identity
   shader->setUniformValue("ove_mvpmat",
-                          job.GetValue(QStringLiteral("ove_mvpmat")).data().value<QMatrix4x4>());
-
-  // Set the viewport to the "physical" resolution of the destination
-  functions_->glViewport(0, 0,
-                         destination_params.effective_width(),
-                         destination_params.effective_height());
+                          job.GetValue(QStringLiteral("ove_mvpmat")).value<QMatrix4x4>());
 
   // Bind vertex array object
   QOpenGLVertexArrayObject vao_;
@@ -518,14 +514,20 @@ void OpenGLRenderer::Blit(QVariant s, ShaderJob job, Texture *destination, Video
     real_iteration_count = 1;
   }
 
+  // Iterations before the last may be drawn at a lower resolution
+  VideoParams iteration_params = destination_params;
+  if (real_iteration_count > 1 && job.GetIterationDivider() > 1) {
+    iteration_params.set_divider(destination_params.divider() * job.GetIterationDivider());
+  }
+
   TexturePtr output_tex, input_tex;
   if (real_iteration_count > 1) {
     // Create one texture to bounce off
-    output_tex = CreateTexture(destination_params);
+    output_tex = CreateTexture(iteration_params);
 
     if (real_iteration_count > 2) {
       // Create a second texture bounce off
-      input_tex = CreateTexture(destination_params);
+      input_tex = CreateTexture(iteration_params);
     }
   }
 
@@ -533,6 +535,12 @@ void OpenGLRenderer::Blit(QVariant s, ShaderJob job, Texture *destination, Video
     // Set iteration number
     shader->setUniformValue("ove_iteration", iteration);
 
+    // Set the viewport to the "physical" resolution of what we're drawing to
+    const VideoParams& viewport_params = (iteration == real_iteration_count-1) ? destination_params : iteration_params;
+    functions_->glViewport(0, 0,
+                           viewport_params.effective_width(),
+                           viewport_params.effective_height());
+
     // Replace iterative input
     if (iteration == real_iteration_count-1) {
       // This is the last iteration, draw to the destination
@@ -548,6 +556,20 @@ void OpenGLRenderer::Blit(QVariant s, ShaderJob job, Texture *destination, Video
       if (clear_destination) {
         ClearDestination();
       }
+
+      if (job.HasRegion()) {
+        // Nothing outside of the job's region is visible, so don't run the shader there
+        QRectF region = job.GetRegion();
+        int w = destination_params.effective_width();
+        int h = destination_params.effective_height();
+        int x0 = qBound(0, qFloor(region.left() * w), w);
+        int y0 = qBound(0, qFloor(region.top() * h), h);
+        int x1 = qBound(0, qCeil(region.right() * w), w);
+        int y1 = qBound(0, qCeil(region.bottom() * h), h);
+
+        functions_->glEnable(GL_SCISSOR_TEST);
+        functions_->glScissor(x0, y0, qMax(0, x1 - x0), qMax(0, y1 - y0));
+      }
     } else {
       // Always draw to output_tex, which gets swapped with input_tex every iteration
       AttachTextureAsDestination(output_tex.get());
@@ -573,6 +595,10 @@ void OpenGLRenderer::Blit(QVariant s, ShaderJob job, Texture *destination, Video
     }
   }
 
+  if (job.HasRegion()) {
+    functions_->glDisable(GL_SCISSOR_TEST);
+  }
+
   if (destination) {
     // Reset framebuffer to default if we were drawing to a texture
     DetachTextureAsDestination();
@@ -1,11 +1,13 @@
 #include "previewautocacher.h"
 
 #include <QApplication>
+#include <QMouseEvent>
 #include <QtConcurrent/QtConcurrent>
 
 #include "node/project/project.h"
 #include "render/rendermanager.h"
 #include "render/renderprocessor.h"
+#include "render/renderprofiler.h"
 
 namespace olive {
 
@@ -15,6 +17,8 @@ PreviewAutoCacher::PreviewAutoCacher() :
   has_changed_(false),
   use_custom_range_(false),
   single_frame_render_(nullptr),
+  interactive_divider_(1),
+  waiting_for_release_(false),
   last_update_time_(0),
   ignore_next_mouse_button_(false)
 {
@@ -31,17 +35,22 @@ PreviewAutoCacher::~PreviewAutoCacher()
   SetViewerNode(nullptr);
 }
 
-RenderTicketPtr PreviewAutoCacher::GetSingleFrame(const rational &t, bool prioritize)
+RenderTicketPtr PreviewAutoCacher::GetSingleFrame(const rational &t, ThreadPool::Priority priority, qint64 deadline)
 {
   CancelQueuedSingleFrameRender();
 
   QByteArray hash = viewer_node_->video_frame_cache()->GetHash(t);
 
+  // If the mouse is held, the user is probably dragging something and wants feedback quickly
+  bool interactive = !ignore_next_mouse_button_ && (qApp->mouseButtons() & Qt::LeftButton);
+
   auto sfr = std::make_shared<RenderTicket>();
   sfr->Start();
   sfr->setProperty("time", QVariant::fromValue(t));
-  sfr->setProperty("prioritize", prioritize);
+  sfr->setProperty("priority", priority);
+  sfr->setProperty("deadline", deadline);
   sfr->setProperty("hash", hash);
+  sfr->setProperty("interactive", interactive);
 
   // Attempt to queue
   single_frame_render_ = sfr;
@@ -127,12 +136,13 @@ void PreviewAutoCacher::HashesProcessed()
     delayed_requeue_timer_.start();
   }
 
-  // The cacher might be waiting for this job to finish
+  // Releasing this job may have freed the current snapshot, in which case pending graph changes
+  // can now be applied to it in place rather than publishing a new one
+  delete watcher;
+
   if (!graph_update_queue_.isEmpty()) {
     TryRender();
   }
-
-  delete watcher;
 }
 
 void PreviewAutoCacher::AudioRendered()
@@ -148,10 +158,11 @@ void PreviewAutoCacher::AudioRendered()
       // Retrieve visual waveforms
       QVector<RenderProcessor::RenderedWaveform> waveform_list = watcher->GetTicket()->property("waveforms").value< QVector<RenderProcessor::RenderedWaveform> >();
       foreach (const RenderProcessor::RenderedWaveform& waveform_info, waveform_list) {
-        // Find original track
+        // Find original track in the snapshot this audio was rendered from
+        PreviewGraphSnapshotPtr snapshot = watcher->property("snapshot").value<PreviewGraphSnapshotPtr>();
         Track* track = nullptr;
 
-        for (auto it=copy_map_.cbegin(); it!=copy_map_.cend(); it++) {
+        for (auto it=snapshot->copy_map.cbegin(); it!=snapshot->copy_map.cend(); it++) {
           if (it.value() == waveform_info.track) {
             track = static_cast<Track*>(it.key());
             break;
@@ -178,12 +189,13 @@ void PreviewAutoCacher::AudioRendered()
     audio_tasks_.remove(watcher);
   }
 
-  // The cacher might be waiting for this job to finish
+  // Releasing this job may have freed the current snapshot, in which case pending graph changes
+  // can now be applied to it in place rather than publishing a new one
+  delete watcher;
+
   if (!graph_update_queue_.isEmpty()) {
     TryRender();
   }
-
-  delete watcher;
 }
 
 void PreviewAutoCacher::VideoRendered()
@@ -201,32 +213,53 @@ void PreviewAutoCacher::VideoRendered()
         w->setProperty("frame", QVariant::fromValue(frame));
         video_download_tasks_.insert(w, hash);
         connect(w, &RenderTicketWatcher::Finished, this, &PreviewAutoCacher::VideoDownloaded);
+        // Saving frees the frame's memory and makes it available to the viewer, so run it ahead of
+        // other rendering (though after any frames due for playback)
         w->SetTicket(RenderManager::instance()->SaveFrameToCache(viewer_node_->video_frame_cache(),
                                                                  frame,
                                                                  hash,
-                                                                 true));
+                                                                 RenderManager::kPriorityPlayback));
       }
     }
 
     video_tasks_.remove(watcher);
   }
 
-  // Process passthroughs
-  QVector<RenderTicketPtr> tickets = video_immediate_passthroughs_.take(watcher);
-  foreach (RenderTicketPtr t, tickets) {
-    if (watcher->HasResult()) {
-      t->Finish(watcher->Get());
-    } else {
-      t->Finish();
-    }
-  }
+  FinishImmediatePassthroughs(watcher);
+
+  // Releasing this job may have freed the current snapshot, in which case pending graph changes
+  // can now be applied to it in place rather than publishing a new one
+  delete watcher;
 
-  // The cacher might be waiting for this job to finish
   if (!graph_update_queue_.isEmpty()) {
     TryRender();
   }
+}
+
+void PreviewAutoCacher::InteractiveFrameRendered()
+{
+  RenderTicketWatcher* watcher = static_cast<RenderTicketWatcher*>(sender());
+
+  interactive_tasks_.removeOne(watcher);
+
+  if (watcher->HasResult()) {
+    // Time spent queued behind other work says nothing about how fast this divider renders
+    UpdateInteractiveDivider(watcher->property("divider").toInt(), watcher->GetTicket()->GetRunTime());
+  }
+
+  FinishImmediatePassthroughs(watcher);
+
+  if (!waiting_for_release_) {
+    // Watch for the end of the drag so the viewer can replace this with a full resolution frame
+    waiting_for_release_ = true;
+    qApp->installEventFilter(this);
+  }
 
   delete watcher;
+
+  if (!graph_update_queue_.isEmpty()) {
+    TryRender();
+  }
 }
 
 void PreviewAutoCacher::VideoDownloaded()
@@ -247,20 +280,34 @@ void PreviewAutoCacher::VideoDownloaded()
     video_download_tasks_.remove(watcher);
   }
 
-  // The cacher might be waiting for this job to finish
+  // Releasing this job may have freed the current snapshot, in which case pending graph changes
+  // can now be applied to it in place rather than publishing a new one
+  delete watcher;
+
   if (!graph_update_queue_.isEmpty()) {
     TryRender();
   }
-
-  delete watcher;
 }
 
 void PreviewAutoCacher::ProcessUpdateQueue()
 {
+  if (snapshot_.use_count() > 1) {
+    // Jobs are still reading from the current snapshot. Rather than waiting for all of them to
+    // finish, publish a new one for future jobs. The live graph already reflects every queued
+    // change, so the queue is simply superseded by the new copy.
+    PublishSnapshot();
+    return;
+  }
+
+  // Nodes whose keyframes may need baking, looked up in the copy map afterwards since a later job
+  // may remove them again
+  QVector<Node*> changed;
+
   foreach (const QueuedJob& job, graph_update_queue_) {
     switch (job.type) {
     case QueuedJob::kNodeAdded:
       AddNode(job.node);
+      changed.append(job.node);
       break;
     case QueuedJob::kNodeRemoved:
       RemoveNode(job.node);
@@ -273,19 +320,106 @@ void PreviewAutoCacher::ProcessUpdateQueue()
       break;
     case QueuedJob::kValueChanged:
       CopyValue(job.input);
+      changed.append(job.input.node());
       break;
     }
   }
   graph_update_queue_.clear();
 
+  BakeSnapshot(changed);
+
+  UpdateLastSyncedValue();
+}
+
+void PreviewAutoCacher::PublishSnapshot()
+{
+  NodeGraph* graph = viewer_node_->parent();
+
+  // Any snapshot still referenced by a job stays alive until that job is deleted
+  PreviewGraphSnapshotPtr previous = snapshot_;
+  snapshot_ = std::make_shared<PreviewGraphSnapshot>();
+
+  // Add all nodes, the project's default nodes are already present in the copy so we only
+  // need to map them
+  for (int i=0; i<snapshot_->project.nodes().size(); i++) {
+    InsertIntoCopyMap(graph->nodes().at(i), snapshot_->project.nodes().at(i));
+  }
+  for (int i=snapshot_->project.nodes().size(); i<graph->nodes().size(); i++) {
+    AddNode(graph->nodes().at(i));
+  }
+
+  // Find copied viewer node
+  snapshot_->viewer = static_cast<ViewerOutput*>(snapshot_->copy_map.value(viewer_node_));
+  snapshot_->color_manager = static_cast<ColorManager*>(snapshot_->copy_map.value(viewer_node_->project()->color_manager()));
+
+  // Add all connections
+  foreach (Node* node, graph->nodes()) {
+    for (auto it=node->input_connections().cbegin(); it!=node->input_connections().cend(); it++) {
+      AddEdge(it->second, it->first);
+    }
+  }
+
+  QVector<Node*> changed;
+
+  if (previous) {
+    // Baked keyframes are unchanged for anything that wasn't queued as modified since the
+    // previous snapshot, so share those tables rather than baking them again
+    snapshot_->baked_timebase = previous->baked_timebase;
+
+    for (auto it=snapshot_->copy_map.cbegin(); it!=snapshot_->copy_map.cend(); it++) {
+      Node* previous_copy = previous->copy_map.value(it.key());
+
+      if (previous_copy) {
+        Node::CopyBakedKeyframes(previous_copy, it.value());
+      } else {
+        changed.append(it.key());
+      }
+    }
+
+    foreach (const QueuedJob& job, graph_update_queue_) {
+      if (job.type == QueuedJob::kValueChanged) {
+        Node* our_input = snapshot_->copy_map.value(job.input.node());
+
+        if (our_input) {
+          our_input->ClearBakedKeyframes(job.input.input(), job.input.element());
+          changed.append(job.input.node());
+        }
+      }
+    }
+  }
+
+  graph_update_queue_.clear();
+
+  BakeSnapshot(changed);
+
   UpdateLastSyncedValue();
 }
 
-bool PreviewAutoCacher::HasActiveJobs() const
+void PreviewAutoCacher::BakeSnapshot(const QVector<Node*>& changed)
+{
+  rational timebase = viewer_node_->GetVideoParams().frame_rate_as_time_base();
+
+  if (timebase != snapshot_->baked_timebase) {
+    // Every table is at the wrong frame rate (or the snapshot was never baked)
+    snapshot_->baked_timebase = timebase;
+
+    foreach (Node* n, snapshot_->project.nodes()) {
+      n->BakeKeyframes(timebase);
+    }
+  } else {
+    foreach (Node* n, changed) {
+      Node* copy = snapshot_->copy_map.value(n);
+
+      if (copy) {
+        copy->BakeKeyframes(timebase);
+      }
+    }
+  }
+}
+
+void PreviewAutoCacher::AttachSnapshot(QObject *job)
 {
-  return !hash_tasks_.isEmpty()
-      || !audio_tasks_.isEmpty()
-      || !video_tasks_.isEmpty();
+  job->setProperty("snapshot", QVariant::fromValue(snapshot_));
 }
 
 void PreviewAutoCacher::AddNode(Node *node)
@@ -294,53 +428,48 @@ void PreviewAutoCacher::AddNode(Node *node)
   Node* copy = node->copy();
 
   // Add to project
-  copy->setParent(&copied_project_);
+  copy->setParent(&snapshot_->project);
 
   // Insert into map
   InsertIntoCopyMap(node, copy);
-
-  // Keep track of our nodes
-  created_nodes_.append(copy);
 }
 
 void PreviewAutoCacher::RemoveNode(Node *node)
 {
-  // Find our copy and remove it
-  Node* copy = copy_map_.take(node);
-
-  // Remove from created list
-  created_nodes_.removeOne(copy);
-
-  // Delete it
+  // Find our copy and delete it
+  Node* copy = snapshot_->copy_map.take(node);
   delete copy;
 }
 
 void PreviewAutoCacher::AddEdge(const NodeOutput &output, const NodeInput &input)
 {
-  Node* our_output = copy_map_.value(output.node());
-  Node* our_input = copy_map_.value(input.node());
+  Node* our_output = snapshot_->copy_map.value(output.node());
+  Node* our_input = snapshot_->copy_map.value(input.node());
 
   Node::ConnectEdge(NodeOutput(our_output, output.output()), NodeInput(our_input, input.input(), input.element()));
 }
 
 void PreviewAutoCacher::RemoveEdge(const NodeOutput &output, const NodeInput &input)
 {
-  Node* our_output = copy_map_.value(output.node());
-  Node* our_input = copy_map_.value(input.node());
+  Node* our_output = snapshot_->copy_map.value(output.node());
+  Node* our_input = snapshot_->copy_map.value(input.node());
 
   Node::DisconnectEdge(NodeOutput(our_output, output.output()), NodeInput(our_input, input.input(), input.element()));
 }
 
 void PreviewAutoCacher::CopyValue(const NodeInput &input)
 {
-  Node* our_input = copy_map_.value(input.node());
+  Node* our_input = snapshot_->copy_map.value(input.node());
   Node::CopyValuesOfElement(input.node(), our_input, input.input(), input.element());
 }
 
 void PreviewAutoCacher::InsertIntoCopyMap(Node *node, Node *copy)
 {
   // Insert into map
-  copy_map_.insert(node, copy);
+  snapshot_->copy_map.insert(node, copy);
+
+  // Profile renders of the copy as the original
+  RenderProfiler::instance()->SetAlias(copy, node);
 
   // Copy parameters
   Node::CopyInputs(node, copy, false);
@@ -434,24 +563,19 @@ void PreviewAutoCacher::ValueChanged(const NodeInput &input)
 void PreviewAutoCacher::TryRender()
 {
   if (!graph_update_queue_.isEmpty()) {
-    if (HasActiveJobs()) {
-      // Still waiting for jobs to finish
-      return;
-    }
-
-    // No jobs are active, we can process the update queue
     ProcessUpdateQueue();
   }
 
-  // If we're here, we must be able to render
   if (!invalidated_video_.isEmpty()) {
     QVector<rational> frames = viewer_node_->video_frame_cache()->GetFrameListFromTimeRange(invalidated_video_);
 
-    QFutureWatcher<void>* watcher = new QFutureWatcher<void>();
+    // Parented to us so the snapshot it holds is released even if we're destroyed first
+    QFutureWatcher<void>* watcher = new QFutureWatcher<void>(this);
     hash_tasks_.append(watcher);
+    AttachSnapshot(watcher);
     connect(watcher, &QFutureWatcher<void>::finished, this, &PreviewAutoCacher::HashesProcessed);
     watcher->setFuture(QtConcurrent::run(&PreviewAutoCacher::GenerateHashes,
-                                         copied_viewer_node_,
+                                         snapshot_->viewer,
                                          viewer_node_->video_frame_cache(),
                                          frames,
                                          last_update_time_));
@@ -467,7 +591,8 @@ void PreviewAutoCacher::TryRender()
         RenderTicketWatcher* watcher = new RenderTicketWatcher();
         connect(watcher, &RenderTicketWatcher::Finished, this, &PreviewAutoCacher::AudioRendered);
         audio_tasks_.insert(watcher, r);
-        watcher->SetTicket(RenderManager::instance()->RenderAudio(copied_viewer_node_, r, true));
+        AttachSnapshot(watcher);
+        watcher->SetTicket(RenderManager::instance()->RenderAudio(snapshot_->viewer, r, true));
       }
     }
 
@@ -478,14 +603,25 @@ void PreviewAutoCacher::TryRender()
     // Check if already caching this
     QByteArray hash = single_frame_render_->property("hash").toByteArray();
     RenderTicketWatcher* watcher;
-    if (!hash.isEmpty() && (watcher = video_tasks_.key(hash))) {
+    if (single_frame_render_->property("interactive").toBool()) {
+      watcher = RenderInteractiveFrame(single_frame_render_->property("time").value<rational>());
+
+      video_immediate_passthroughs_[watcher].append(single_frame_render_);
+    } else if (!hash.isEmpty() && (watcher = video_tasks_.key(hash))) {
+      // Already queued, but possibly behind less urgent work, so move it up to where this frame
+      // wants to be
+      RenderManager::instance()->PromoteTicket(watcher->GetTicket(),
+                                               static_cast<ThreadPool::Priority>(single_frame_render_->property("priority").toInt()),
+                                               single_frame_render_->property("deadline").toLongLong());
+
       video_immediate_passthroughs_[watcher].append(single_frame_render_);
     } else if (!hash.isEmpty() && (watcher = video_download_tasks_.key(hash))) {
       single_frame_render_->Finish(watcher->property("frame"));
     } else {
       watcher = RenderFrame(hash,
                             single_frame_render_->property("time").value<rational>(),
-                            single_frame_render_->property("prioritize").toBool());
+                            static_cast<ThreadPool::Priority>(single_frame_render_->property("priority").toInt()),
+                            single_frame_render_->property("deadline").toLongLong());
 
       video_immediate_passthroughs_[watcher].append(single_frame_render_);
     }
@@ -494,21 +630,102 @@ void PreviewAutoCacher::TryRender()
   }
 }
 
-RenderTicketWatcher* PreviewAutoCacher::RenderFrame(const QByteArray &hash, const rational& time, bool prioritize)
+RenderTicketWatcher* PreviewAutoCacher::RenderFrame(const QByteArray &hash, const rational& time, ThreadPool::Priority priority, qint64 deadline)
 {
   RenderTicketWatcher* watcher = new RenderTicketWatcher();
   watcher->setProperty("hash", hash);
   connect(watcher, &RenderTicketWatcher::Finished, this, &PreviewAutoCacher::VideoRendered);
   video_tasks_.insert(watcher, hash);
-  watcher->SetTicket(RenderManager::instance()->RenderFrame(copied_viewer_node_,
-                                                            copied_color_manager_,
+  AttachSnapshot(watcher);
+  watcher->SetTicket(RenderManager::instance()->RenderFrame(snapshot_->viewer,
+                                                            snapshot_->color_manager,
                                                             time,
                                                             RenderMode::kOffline,
                                                             viewer_node_->video_frame_cache(),
-                                                            prioritize));
+                                                            priority,
+                                                            deadline));
   return watcher;
 }
 
+RenderTicketWatcher *PreviewAutoCacher::RenderInteractiveFrame(const rational &time)
+{
+  // Only the newest interactive frame matters, so drop any older ones that haven't started yet
+  ClearQueueInternal(interactive_tasks_, false, &PreviewAutoCacher::InteractiveFrameRendered);
+
+  VideoParams params = viewer_node_->GetVideoParams();
+  params.set_divider(qMax(params.divider(), interactive_divider_));
+
+  RenderTicketWatcher* watcher = new RenderTicketWatcher();
+  watcher->setProperty("divider", params.divider());
+  connect(watcher, &RenderTicketWatcher::Finished, this, &PreviewAutoCacher::InteractiveFrameRendered);
+  interactive_tasks_.append(watcher);
+  AttachSnapshot(watcher);
+
+  // No FrameHashCache is provided so this frame is neither read from nor written to the disk cache
+  watcher->SetTicket(RenderManager::instance()->RenderFrame(snapshot_->viewer,
+                                                            snapshot_->color_manager,
+                                                            time,
+                                                            RenderMode::kOffline,
+                                                            params,
+                                                            viewer_node_->GetAudioParams(),
+                                                            QSize(0, 0),
+                                                            QMatrix4x4(),
+                                                            VideoParams::kFormatInvalid,
+                                                            nullptr,
+                                                            nullptr,
+                                                            RenderManager::kPriorityInteractive));
+  return watcher;
+}
+
+void PreviewAutoCacher::UpdateInteractiveDivider(int last_divider, qint64 last_render_time)
+{
+  qint64 target = Config::Current()[QStringLiteral("InteractiveRenderLatency")].toInt();
+  int next_divider = VideoParams::kSupportedDividers.last();
+
+  // Render time scales roughly with pixel count, so estimate how long the last frame would have
+  // taken at each divider and pick the highest resolution that would have met the target
+  foreach (int d, VideoParams::kSupportedDividers) {
+    double scale = double(last_divider) / double(d);
+
+    if (last_render_time * scale * scale <= target) {
+      next_divider = d;
+      break;
+    }
+  }
+
+  interactive_divider_ = next_divider;
+
+  emit InteractiveDividerUpdated(interactive_divider_, last_render_time);
+}
+
+void PreviewAutoCacher::FinishImmediatePassthroughs(RenderTicketWatcher *watcher)
+{
+  QVector<RenderTicketPtr> tickets = video_immediate_passthroughs_.take(watcher);
+  foreach (RenderTicketPtr t, tickets) {
+    if (watcher->HasResult()) {
+      t->Finish(watcher->Get());
+    } else {
+      t->Finish();
+    }
+  }
+}
+
+bool PreviewAutoCacher::eventFilter(QObject *o, QEvent *e)
+{
+  if (waiting_for_release_
+      && e->type() == QEvent::MouseButtonRelease
+      && static_cast<QMouseEvent*>(e)->button() == Qt::LeftButton) {
+    waiting_for_release_ = false;
+    qApp->removeEventFilter(this);
+
+    // Queued so that whatever the release commits (e.g. the final value of a drag) is processed
+    // before a full resolution frame is requested
+    QMetaObject::invokeMethod(this, "InteractiveDragFinished", Qt::QueuedConnection);
+  }
+
+  return QObject::eventFilter(o, e);
+}
+
 void PreviewAutoCacher::RequeueFrames()
 {
   delayed_requeue_timer_.stop();
@@ -540,14 +757,18 @@ void PreviewAutoCacher::RequeueFrames()
         // We want this hash, if we're not already rendering, start render now
         if (!render_task && !video_download_tasks_.key(hash)) {
           // Don't render any hash more than once
-          RenderFrame(hash, t, false);
+          RenderFrame(hash, t, RenderManager::kPriorityBackground);
         }
-      } else if (render_task) {
-        // Cancel this frame unless it's already started
+      } else if (render_task && !video_immediate_passthroughs_.contains(render_task)) {
+        // Cancel this frame unless it's already started or the viewer is waiting for it. The
+        // watcher holds the snapshot the ticket renders from, so it can only go once the ticket
+        // is off the queue.
         QMutexLocker locker(render_task->GetTicket()->lock());
 
-        if (!render_task->GetTicket()->IsRunning(false)) {
+        if (!render_task->GetTicket()->IsRunning(false)
+            && RenderManager::instance()->RemoveTicket(render_task->GetTicket())) {
           video_tasks_.remove(render_task);
+          locker.unlock();
           delete render_task;
         }
       }
@@ -594,17 +815,22 @@ void PreviewAutoCacher::SetViewerNode(ViewerOutput *viewer_node)
     // be in the cache for later use.
     ClearVideoDownloadQueue(true);
 
+    // Interactive frames are only useful to the viewer we're detaching from
+    ClearQueueInternal(interactive_tasks_, true, &PreviewAutoCacher::InteractiveFrameRendered);
+
+    if (waiting_for_release_) {
+      waiting_for_release_ = false;
+      qApp->removeEventFilter(this);
+    }
+
     // Clear any single frame render that might be queued
     CancelQueuedSingleFrameRender();
 
     // No more immediate passthroughts
     video_immediate_passthroughs_.clear();
 
-    // Delete all of our copied nodes
-    qDeleteAll(created_nodes_);
-    created_nodes_.clear();
-    copy_map_.clear();
-    copied_viewer_node_ = nullptr;
+    // Release our copy of the graph, it'll be destroyed once any job still holding it is gone
+    snapshot_ = nullptr;
     graph_update_queue_.clear();
 
     // Disconnect signals for future node additions/deletions
@@ -632,28 +858,9 @@ void PreviewAutoCacher::SetViewerNode(ViewerOutput *viewer_node)
 
   if (viewer_node_) {
     // Copy graph
-    NodeGraph* graph = viewer_node_->parent();
+    PublishSnapshot();
 
-    // Add all nodes
-    for (int i=0; i<copied_project_.nodes().size(); i++) {
-      InsertIntoCopyMap(graph->nodes().at(i), copied_project_.nodes().at(i));
-    }
-    for (int i=copied_project_.nodes().size(); i<graph->nodes().size(); i++) {
-      AddNode(graph->nodes().at(i));
-    }
-
-    // Find copied viewer node
-    copied_viewer_node_ = static_cast<ViewerOutput*>(copy_map_.value(viewer_node_));
-    copied_color_manager_ = static_cast<ColorManager*>(copy_map_.value(viewer_node_->project()->color_manager()));
-
-    // Add all connections
-    foreach (Node* node, graph->nodes()) {
-      for (auto it=node->input_connections().cbegin(); it!=node->input_connections().cend(); it++) {
-        AddEdge(it->second, it->first);
-      }
-    }
-
-    UpdateLastSyncedValue();
+    NodeGraph* graph = viewer_node_->parent();
 
     // Connect signals for future node additions/deletions
     connect(graph, &NodeGraph::NodeAdded, this, &PreviewAutoCacher::NodeAdded);
@@ -735,6 +942,9 @@ void PreviewAutoCacher::ClearQueueInternal(T& list, bool hard, Func member)
       // Special functionality for certain queues
       ClearQueueRemoveEventInternal(it);
 
+      // Don't leave anything waiting on a watcher that's about to be gone
+      FinishImmediatePassthroughs(ticket);
+
       // Destroy ticket
       locker.unlock();
       delete ticket;
@@ -9,10 +9,44 @@
 #include "node/node.h"
 #include "node/output/viewer/viewer.h"
 #include "node/project/project.h"
+#include "threading/threadpool.h"
 #include "threading/threadticketwatcher.h"
 
 namespace olive {
 
+/**
+ * @brief One version of PreviewAutoCacher's copy of a NodeGraph
+ *
+ * Every render job holds a reference to the version it was started with, so PreviewAutoCacher can
+ * publish a new version for new jobs while older ones finish against the graph they began with.
+ * A version is destroyed once nothing references it anymore.
+ */
+class PreviewGraphSnapshot
+{
+public:
+  PreviewGraphSnapshot() :
+    viewer(nullptr),
+    color_manager(nullptr)
+  {
+  }
+
+  DISABLE_COPY_MOVE(PreviewGraphSnapshot)
+
+  Project project;
+
+  QHash<Node*, Node*> copy_map;
+
+  ViewerOutput* viewer;
+
+  ColorManager* color_manager;
+
+  // Frame rate keyframes in this snapshot have been baked at
+  rational baked_timebase;
+
+};
+
+using PreviewGraphSnapshotPtr = std::shared_ptr<PreviewGraphSnapshot>;
+
 /**
  * @brief Manager for dynamically caching a sequence in the background
  *
@@ -26,7 +60,25 @@ public:
 
   virtual ~PreviewAutoCacher() override;
 
-  RenderTicketPtr GetSingleFrame(const rational& t, bool prioritize);
+  /**
+   * @brief Render a single frame for display
+   *
+   * If the left mouse button is held (i.e. the user is dragging something), the frame is rendered
+   * as an interactive preview instead: at a reduced resolution chosen to meet the
+   * "InteractiveRenderLatency" target and without touching the disk cache. InteractiveDragFinished()
+   * is emitted on release so a full resolution frame can be requested.
+   *
+   * `priority` and `deadline` are passed on to RenderManager::RenderFrame().
+   */
+  RenderTicketPtr GetSingleFrame(const rational& t, ThreadPool::Priority priority, qint64 deadline = 0);
+
+  /**
+   * @brief Divider that the next interactive render will use (before the viewer's own divider)
+   */
+  int GetInteractiveDivider() const
+  {
+    return interactive_divider_;
+  }
 
   /**
    * @brief Set the viewer node to auto-cache
@@ -79,22 +131,67 @@ public:
   void ClearAudioQueue(bool wait = false);
   void ClearVideoDownloadQueue(bool wait = false);
 
+signals:
+  /**
+   * @brief Emitted after each interactive render with how long it took and the divider chosen
+   * for the next one
+   */
+  void InteractiveDividerUpdated(int divider, qint64 last_render_time);
+
+  /**
+   * @brief Emitted when the mouse is released after interactive renders were shown
+   */
+  void InteractiveDragFinished();
+
+protected:
+  virtual bool eventFilter(QObject* o, QEvent* e) override;
+
 private:
   static void GenerateHashes(ViewerOutput *viewer, FrameHashCache *cache, const QVector<rational>& times, qint64 job_time);
 
   void TryRender();
 
-  RenderTicketWatcher *RenderFrame(const QByteArray& hash, const rational &time, bool prioritize);
+  RenderTicketWatcher *RenderFrame(const QByteArray& hash, const rational &time, ThreadPool::Priority priority, qint64 deadline = 0);
+
+  RenderTicketWatcher *RenderInteractiveFrame(const rational &time);
+
+  /**
+   * @brief Choose the divider for the next interactive render from how long the last one took
+   */
+  void UpdateInteractiveDivider(int last_divider, qint64 last_render_time);
+
+  void FinishImmediatePassthroughs(RenderTicketWatcher* watcher);
 
   /**
    * @brief Process all changes to internal NodeGraph copy
    *
-   * PreviewAutoCacher staggers updates to its internal NodeGraph copy, only applying them when the
-   * RenderManager is not reading from it. This function is called when such an opportunity arises.
+   * PreviewAutoCacher staggers updates to its internal NodeGraph copy. If no job is reading from
+   * the current snapshot, the queued changes are applied to it in place. Otherwise, a new snapshot
+   * is published and the jobs still using the old one are left to finish undisturbed.
    */
   void ProcessUpdateQueue();
 
-  bool HasActiveJobs() const;
+  /**
+   * @brief Replace the current snapshot with a fresh copy of the viewer's graph
+   */
+  void PublishSnapshot();
+
+  /**
+   * @brief Tie a job to the snapshot it was started with, keeping that snapshot alive
+   *
+   * Tickets only hold raw pointers into the snapshot, so a watcher must not be deleted while its
+   * ticket is still queued (remove it from the RenderManager first) or running.
+   */
+  void AttachSnapshot(QObject* job);
+
+  /**
+   * @brief Bake keyframed inputs of the current snapshot so jobs read flat per-frame tables
+   *
+   * Only the copies of `changed` (nodes in the live graph) are baked, unless the frame rate has
+   * changed since the snapshot was last baked, in which case every node is. Only called while no
+   * job is using the snapshot.
+   */
+  void BakeSnapshot(const QVector<Node*>& changed);
 
   void AddNode(Node* node);
   void RemoveNode(Node* node);
@@ -133,13 +230,9 @@ private:
 
   ViewerOutput* viewer_node_;
 
-  Project copied_project_;
+  PreviewGraphSnapshotPtr snapshot_;
 
   QVector<QueuedJob> graph_update_queue_;
-  QHash<Node*, Node*> copy_map_;
-  ViewerOutput* copied_viewer_node_;
-  ColorManager* copied_color_manager_;
-  QVector<Node*> created_nodes_;
 
   bool paused_;
 
@@ -160,6 +253,11 @@ private:
   QMap<RenderTicketWatcher*, QByteArray> video_tasks_;
   QMap<RenderTicketWatcher*, QByteArray> video_download_tasks_;
   QMap<RenderTicketWatcher*, QVector<RenderTicketPtr> > video_immediate_passthroughs_;
+  QVector<RenderTicketWatcher*> interactive_tasks_;
+
+  int interactive_divider_;
+
+  bool waiting_for_release_;
 
   qint64 last_update_time_;
 
@@ -198,6 +296,11 @@ private slots:
    */
   void VideoDownloaded();
 
+  /**
+   * @brief Handler for when the RenderManager has returned an interactive preview frame
+   */
+  void InteractiveFrameRendered();
+
   void NodeAdded(Node* node);
 
   void NodeRemoved(Node* node);
@@ -217,4 +320,6 @@ private slots:
 
 }
 
+Q_DECLARE_METATYPE(olive::PreviewGraphSnapshotPtr)
+
 #endif // AUTOCACHER_H
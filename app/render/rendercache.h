@@ -39,7 +39,34 @@ private:
 
 };
 
-using DecoderCache = RenderCache<Decoder::CodecStream, DecoderPtr>;
+/**
+ * @brief Decoders are shared per stream and per reduced resolution level
+ *
+ * \see Decoder::GetReducedResolutionLevel()
+ */
+struct DecoderCacheKey
+{
+  DecoderCacheKey(const Decoder::CodecStream& s, int l) :
+    stream(s),
+    level(l)
+  {
+  }
+
+  bool operator==(const DecoderCacheKey& rhs) const
+  {
+    return stream == rhs.stream && level == rhs.level;
+  }
+
+  Decoder::CodecStream stream;
+  int level;
+};
+
+inline uint qHash(const DecoderCacheKey& key, uint seed = 0)
+{
+  return qHash(key.stream, seed) ^ qHash(key.level, seed);
+}
+
+using DecoderCache = RenderCache<DecoderCacheKey, DecoderPtr>;
 using ShaderCache = RenderCache<QString, QVariant>;
 
 }
@@ -32,6 +32,20 @@ Renderer::Renderer(QObject *parent) :
 
 TexturePtr Renderer::CreateTexture(const VideoParams &params, Texture::Type type, const void *data, int linesize)
 {
+  if (type == Texture::k2D) {
+    QVariant recycled = texture_pool_.Take(TexturePool::GetKey(params));
+
+    if (!recycled.isNull()) {
+      TexturePtr texture = std::make_shared<Texture>(this, recycled, params, type);
+
+      if (data) {
+        UploadToTexture(texture.get(), data, linesize);
+      }
+
+      return texture;
+    }
+  }
+
   QVariant v;
 
   if (type == Texture::k3D) {
@@ -64,10 +78,51 @@ void Renderer::BlitColorManaged(ColorProcessorPtr color_processor, TexturePtr so
   BlitColorManagedInternal(color_processor, source, source_is_premultiplied, nullptr, params, clear_destination, matrix, crop_matrix);
 }
 
+bool Renderer::WarmColorContext(ColorProcessorPtr color_processor)
+{
+  ColorContext ctx;
+  return GetColorContext(color_processor, &ctx);
+}
+
+void Renderer::ReleaseTexture(Texture *texture)
+{
+  if (texture->type() == Texture::k2D) {
+    QVector<QVariant> evicted;
+
+    texture_pool_.Give(TexturePool::GetKey(texture->params()), texture->id(), &evicted);
+
+    foreach (const QVariant& v, evicted) {
+      DestroyNativeTexture(v);
+    }
+  } else {
+    DestroyNativeTexture(texture->id());
+  }
+}
+
+void Renderer::SetTexturePoolBudget(qint64 bytes)
+{
+  QVector<QVariant> evicted;
+
+  texture_pool_.SetBudget(bytes, &evicted);
+
+  foreach (const QVariant& v, evicted) {
+    DestroyNativeTexture(v);
+  }
+}
+
+void Renderer::ClearTexturePool()
+{
+  foreach (const QVariant& v, texture_pool_.Clear()) {
+    DestroyNativeTexture(v);
+  }
+}
+
 void Renderer::Destroy()
 {
   color_cache_.clear();
 
+  ClearTexturePool();
+
   DestroyInternal();
 }
 
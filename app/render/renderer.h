@@ -31,6 +31,7 @@
 #include "render/colorprocessor.h"
 #include "render/videoparams.h"
 #include "texture.h"
+#include "texturepool.h"
 
 namespace olive {
 
@@ -47,6 +48,16 @@ public:
   TexturePtr CreateTexture(const VideoParams& params, Texture::Type type, const void* data = nullptr, int linesize = 0);
   TexturePtr CreateTexture(const VideoParams& params, const void *data = nullptr, int linesize = 0);
 
+  /**
+   * @brief Called by Texture when it's destroyed, recycles its native texture if possible
+   */
+  void ReleaseTexture(Texture* texture);
+
+  /**
+   * @brief Set how much memory unused textures may hold onto for reuse, evicting any over it
+   */
+  void SetTexturePoolBudget(qint64 bytes);
+
   void BlitToTexture(QVariant shader,
                      olive::ShaderJob job,
                      olive::Texture* destination,
@@ -66,6 +77,11 @@ public:
   void BlitColorManaged(ColorProcessorPtr color_processor, TexturePtr source, bool source_is_premultiplied, Texture* destination, bool clear_destination = true, const QMatrix4x4& matrix = QMatrix4x4(), const QMatrix4x4 &crop_matrix = QMatrix4x4());
   void BlitColorManaged(ColorProcessorPtr color_processor, TexturePtr source, bool source_is_premultiplied, VideoParams params, bool clear_destination = true, const QMatrix4x4& matrix = QMatrix4x4(), const QMatrix4x4 &crop_matrix = QMatrix4x4());
 
+  /**
+   * @brief Compile the shader and LUT textures for a ColorProcessor ahead of its first use
+   */
+  bool WarmColorContext(ColorProcessorPtr color_processor);
+
   void Destroy();
 
   virtual void PostDestroy() = 0;
@@ -73,6 +89,11 @@ public:
 public slots:
   virtual void PostInit() = 0;
 
+  /**
+   * @brief Destroy every texture waiting in the texture pool
+   */
+  void ClearTexturePool();
+
   virtual void DestroyInternal() = 0;
 
   virtual void ClearDestination(double r = 0.0, double g = 0.0, double b = 0.0, double a = 0.0) = 0;
@@ -126,6 +147,8 @@ private:
 
   QHash<QString, ColorContext> color_cache_;
 
+  TexturePool texture_pool_;
+
   QMutex color_cache_mutex_;
 
 };
@@ -57,6 +57,8 @@ void RendererThreadWrapper::PostInit()
 void RendererThreadWrapper::DestroyInternal()
 {
   if (thread_) {
+    // Textures the inner renderer made for itself (e.g. for iterative shaders) are pooled there
+    QMetaObject::invokeMethod(inner_, "ClearTexturePool", Qt::BlockingQueuedConnection);
     QMetaObject::invokeMethod(inner_, "DestroyInternal", Qt::BlockingQueuedConnection);
 
     thread_->quit();
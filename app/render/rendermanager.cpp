@@ -21,14 +21,17 @@
 #include "rendermanager.h"
 
 #include <QApplication>
+#include <QJsonObject>
 #include <QMatrix4x4>
 #include <QThread>
 
 #include "config/config.h"
 #include "core.h"
+#include "node/project/project.h"
 #include "render/opengl/openglrenderer.h"
 #include "render/rendererthreadwrapper.h"
 #include "renderprocessor.h"
+#include "renderprofiler.h"
 #include "task/conform/conform.h"
 #include "task/taskmanager.h"
 #include "window/mainwindow/mainwindow.h"
@@ -42,6 +45,11 @@ RenderManager::RenderManager(QObject *parent) :
   ThreadPool(QThread::IdlePriority, 0, parent),
   backend_(kOpenGL)
 {
+  // Each render thread waits on its own frame's decodes, so one prefetch thread per render thread
+  // lets every frame in flight overlap its branches without the two pools oversubscribing the CPU
+  prefetch_pool_ = new QThreadPool(this);
+  prefetch_pool_->setMaxThreadCount(GetThreadCount());
+
   Renderer* graphics_renderer = nullptr;
 
   if (backend_ == kOpenGL) {
@@ -53,7 +61,11 @@ RenderManager::RenderManager(QObject *parent) :
     context_->Init();
     context_->PostInit();
 
-    still_cache_ = new StillImageCache();
+    // Config is in MiB
+    context_->SetTexturePoolBudget(Config::Current()[QStringLiteral("TexturePoolMemory")].toLongLong() * 1024 * 1024);
+
+    frame_texture_cache_ = new FrameTextureCache();
+    frame_texture_cache_->SetBudget(Config::Current()[QStringLiteral("FrameTextureCacheMemory")].toLongLong() * 1024 * 1024);
     decoder_cache_ = new DecoderCache();
     shader_cache_ = new ShaderCache();
     default_shader_ = context_->CreateNativeShader(ShaderCode(QString(), QString()));
@@ -64,19 +76,59 @@ RenderManager::RenderManager(QObject *parent) :
   } else {
     qCritical() << "Tried to initialize unknown graphics backend";
     context_ = nullptr;
-    still_cache_ = nullptr;
+    frame_texture_cache_ = nullptr;
     decoder_cache_ = nullptr;
   }
 }
 
 RenderManager::~RenderManager()
 {
+  if (RenderProfiler::instance()->IsEnabled()) {
+    QJsonObject queue_stats;
+
+    for (int i=0; i<kPriorityCount; i++) {
+      QueueStats stats = GetQueueStats(static_cast<Priority>(i));
+
+      QJsonObject o;
+      o.insert(QStringLiteral("queued"), stats.queued);
+      o.insert(QStringLiteral("started"), stats.started);
+      o.insert(QStringLiteral("removed"), stats.removed);
+      o.insert(QStringLiteral("completed"), stats.completed);
+      o.insert(QStringLiteral("total_wait_ms"), stats.total_wait);
+      o.insert(QStringLiteral("max_wait_ms"), stats.max_wait);
+      o.insert(QStringLiteral("total_run_ms"), stats.total_run);
+      o.insert(QStringLiteral("missed_deadlines"), stats.missed_deadlines);
+      queue_stats.insert(GetPriorityName(static_cast<Priority>(i)), o);
+    }
+
+    RenderProfiler::instance()->SetStatistics(QStringLiteral("renderQueue"), queue_stats);
+  }
+
   if (context_) {
+    if (RenderProfiler::instance()->IsEnabled()) {
+      // Everything has finished rendering, so these cover the whole profiled session
+      FrameTextureCache::Stats stats = frame_texture_cache_->GetStats();
+
+      QJsonObject cache_stats;
+      cache_stats.insert(QStringLiteral("hits"), stats.hits);
+      cache_stats.insert(QStringLiteral("misses"), stats.misses);
+      cache_stats.insert(QStringLiteral("evictions"), stats.evictions);
+      cache_stats.insert(QStringLiteral("cached_bytes"), stats.cached_bytes);
+      cache_stats.insert(QStringLiteral("cached_count"), stats.cached_count);
+      RenderProfiler::instance()->SetStatistics(QStringLiteral("frameTextureCache"), cache_stats);
+    }
+
     context_->DestroyNativeShader(default_shader_);
 
+    foreach (const QVariant& shader, *shader_cache_) {
+      if (!shader.isNull()) {
+        context_->DestroyNativeShader(shader);
+      }
+    }
+
     delete shader_cache_;
     delete decoder_cache_;
-    delete still_cache_;
+    delete frame_texture_cache_;
 
     context_->Destroy();
     context_->PostDestroy();
@@ -102,6 +154,44 @@ void RenderManager::ClearOldDecoders()
   }
 }
 
+void RenderManager::WarmColorProcessors(Project *project)
+{
+  if (!context_) {
+    return;
+  }
+
+  ColorManager* color_manager = project->color_manager();
+  ColorTransform reference(color_manager->GetReferenceColorSpace());
+  QStringList warmed;
+
+  foreach (Node* n, project->nodes()) {
+    Footage* footage = dynamic_cast<Footage*>(n);
+
+    if (!footage || !footage->IsValid()) {
+      continue;
+    }
+
+    for (int i=0; i<footage->GetVideoStreamCount(); i++) {
+      VideoParams vp = footage->GetVideoParams(i);
+
+      if (!vp.enabled()) {
+        continue;
+      }
+
+      QString colorspace = footage->GetColorspaceToUse(vp);
+
+      if (warmed.contains(colorspace)) {
+        continue;
+      }
+
+      warmed.append(colorspace);
+
+      ColorProcessorPtr processor = ColorProcessorCache::instance()->Get(color_manager, colorspace, reference);
+      context_->WarmColorContext(processor);
+    }
+  }
+}
+
 QByteArray RenderManager::Hash(const Node *n, const QString& output, const VideoParams &params, const rational &time)
 {
   QCryptographicHash hasher(QCryptographicHash::Sha1);
@@ -126,7 +216,7 @@ QByteArray RenderManager::Hash(const Node *n, const QString& output, const Video
 
 RenderTicketPtr RenderManager::RenderFrame(ViewerOutput *viewer, ColorManager* color_manager,
                                            const rational& time, RenderMode::Mode mode,
-                                           FrameHashCache* cache, bool prioritize)
+                                           FrameHashCache* cache, Priority priority, qint64 deadline)
 {
   return RenderFrame(viewer,
                      color_manager,
@@ -139,7 +229,8 @@ RenderTicketPtr RenderManager::RenderFrame(ViewerOutput *viewer, ColorManager* c
                      VideoParams::kFormatInvalid,
                      nullptr,
                      cache,
-                     prioritize);
+                     priority,
+                     deadline);
 }
 
 RenderTicketPtr RenderManager::RenderFrame(ViewerOutput *viewer, ColorManager* color_manager,
@@ -148,7 +239,7 @@ RenderTicketPtr RenderManager::RenderFrame(ViewerOutput *viewer, ColorManager* c
                                            const QSize& force_size,
                                            const QMatrix4x4& force_matrix, VideoParams::Format force_format,
                                            ColorProcessorPtr force_color_output,
-                                           FrameHashCache* cache, bool prioritize)
+                                           FrameHashCache* cache, Priority priority, qint64 deadline)
 {
   // Create ticket
   RenderTicketPtr ticket = std::make_shared<RenderTicket>();
@@ -164,6 +255,9 @@ RenderTicketPtr RenderManager::RenderFrame(ViewerOutput *viewer, ColorManager* c
   ticket->setProperty("coloroutput", QVariant::fromValue(force_color_output));
   ticket->setProperty("vparam", QVariant::fromValue(video_params));
   ticket->setProperty("aparam", QVariant::fromValue(audio_params));
+  ticket->setProperty("priority", priority);
+  ticket->setProperty("deadline", deadline);
+  ticket->setProperty("owner", Node::PtrToValue(viewer));
 
   if (cache) {
     ticket->setProperty("cache", cache->GetCacheDirectory());
@@ -175,18 +269,17 @@ RenderTicketPtr RenderManager::RenderFrame(ViewerOutput *viewer, ColorManager* c
 
   // Queue appending the ticket and running the next job on our thread to make this function thread-safe
   QMetaObject::invokeMethod(this, "AddTicket", Qt::AutoConnection,
-                            OLIVE_NS_ARG(RenderTicketPtr, ticket),
-                            Q_ARG(bool, prioritize));
+                            OLIVE_NS_ARG(RenderTicketPtr, ticket));
 
   return ticket;
 }
 
-RenderTicketPtr RenderManager::RenderAudio(ViewerOutput* viewer, const TimeRange& r, bool generate_waveforms, bool prioritize)
+RenderTicketPtr RenderManager::RenderAudio(ViewerOutput* viewer, const TimeRange& r, bool generate_waveforms, Priority priority)
 {
-  return RenderAudio(viewer, r, viewer->GetAudioParams(), generate_waveforms, prioritize);
+  return RenderAudio(viewer, r, viewer->GetAudioParams(), generate_waveforms, priority);
 }
 
-RenderTicketPtr RenderManager::RenderAudio(ViewerOutput* viewer, const TimeRange &r, const AudioParams &params, bool generate_waveforms, bool prioritize)
+RenderTicketPtr RenderManager::RenderAudio(ViewerOutput* viewer, const TimeRange &r, const AudioParams &params, bool generate_waveforms, Priority priority)
 {
   // Create ticket
   RenderTicketPtr ticket = std::make_shared<RenderTicket>();
@@ -196,6 +289,8 @@ RenderTicketPtr RenderManager::RenderAudio(ViewerOutput* viewer, const TimeRange
   ticket->setProperty("type", kTypeAudio);
   ticket->setProperty("enablewaveforms", generate_waveforms);
   ticket->setProperty("aparam", QVariant::fromValue(params));
+  ticket->setProperty("priority", priority);
+  ticket->setProperty("owner", Node::PtrToValue(viewer));
 
   if (ticket->thread() != this->thread()) {
     ticket->moveToThread(this->thread());
@@ -203,13 +298,12 @@ RenderTicketPtr RenderManager::RenderAudio(ViewerOutput* viewer, const TimeRange
 
   // Queue appending the ticket and running the next job on our thread to make this function thread-safe
   QMetaObject::invokeMethod(this, "AddTicket", Qt::AutoConnection,
-                            OLIVE_NS_ARG(RenderTicketPtr, ticket),
-                            Q_ARG(bool, prioritize));
+                            OLIVE_NS_ARG(RenderTicketPtr, ticket));
 
   return ticket;
 }
 
-RenderTicketPtr RenderManager::SaveFrameToCache(FrameHashCache *cache, FramePtr frame, const QByteArray &hash, bool prioritize)
+RenderTicketPtr RenderManager::SaveFrameToCache(FrameHashCache *cache, FramePtr frame, const QByteArray &hash, Priority priority)
 {
   // Create ticket
   RenderTicketPtr ticket = std::make_shared<RenderTicket>();
@@ -217,6 +311,7 @@ RenderTicketPtr RenderManager::SaveFrameToCache(FrameHashCache *cache, FramePtr
   ticket->setProperty("cache", cache->GetCacheDirectory());
   ticket->setProperty("frame", QVariant::fromValue(frame));
   ticket->setProperty("hash", hash);
+  ticket->setProperty("priority", priority);
   ticket->setProperty("type", kTypeVideoDownload);
 
   if (ticket->thread() != this->thread()) {
@@ -225,15 +320,14 @@ RenderTicketPtr RenderManager::SaveFrameToCache(FrameHashCache *cache, FramePtr
 
   // Queue appending the ticket and running the next job on our thread to make this function thread-safe
   QMetaObject::invokeMethod(this, "AddTicket", Qt::AutoConnection,
-                            OLIVE_NS_ARG(RenderTicketPtr, ticket),
-                            Q_ARG(bool, prioritize));
+                            OLIVE_NS_ARG(RenderTicketPtr, ticket));
 
   return ticket;
 }
 
 void RenderManager::RunTicket(RenderTicketPtr ticket) const
 {
-  RenderProcessor::Process(ticket, context_, still_cache_, decoder_cache_, shader_cache_, default_shader_);
+  RenderProcessor::Process(ticket, context_, frame_texture_cache_, decoder_cache_, shader_cache_, default_shader_, prefetch_pool_);
 }
 
 }
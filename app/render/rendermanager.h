@@ -29,13 +29,15 @@
 #include "node/graph.h"
 #include "node/output/viewer/viewer.h"
 #include "node/traverser.h"
+#include "render/frametexturecache.h"
 #include "render/renderer.h"
 #include "rendercache.h"
-#include "stillimagecache.h"
 #include "threading/threadpool.h"
 
 namespace olive {
 
+class Project;
+
 class RenderManager : public ThreadPool
 {
   Q_OBJECT
@@ -79,36 +81,45 @@ public:
    * The ticket from this function will return a FramePtr - the rendered frame in reference color
    * space.
    *
-   * Setting `prioritize` to TRUE puts this ticket at the top of the queue. Leaving it as FALSE
-   * appends it to the bottom.
+   * `priority` sets which class of the render queue this frame waits in. For kPriorityPlayback,
+   * `deadline` is when the frame will be displayed, in ThreadPool::Now() time.
    *
    * This function is thread-safe.
    */
   RenderTicketPtr RenderFrame(ViewerOutput *viewer, ColorManager* color_manager,
                               const rational& time, RenderMode::Mode mode,
-                              FrameHashCache* cache = nullptr, bool prioritize = false);
+                              FrameHashCache* cache = nullptr, Priority priority = kPriorityBackground,
+                              qint64 deadline = 0);
   RenderTicketPtr RenderFrame(ViewerOutput* viewer, ColorManager* color_manager,
                               const rational& time, RenderMode::Mode mode,
                               const VideoParams& video_params, const AudioParams& audio_params,
                               const QSize& force_size,
                               const QMatrix4x4& force_matrix, VideoParams::Format force_format,
                               ColorProcessorPtr force_color_output,
-                              FrameHashCache* cache = nullptr, bool prioritize = false);
+                              FrameHashCache* cache = nullptr, Priority priority = kPriorityBackground,
+                              qint64 deadline = 0);
 
   /**
    * @brief Asynchronously generate a chunk of audio
    *
    * The ticket from this function will return a SampleBufferPtr - the rendered audio.
    *
-   * Setting `prioritize` to TRUE puts this ticket at the top of the queue. Leaving it as FALSE
-   * appends it to the bottom.
+   * `priority` sets which class of the render queue this chunk waits in.
    *
    * This function is thread-safe.
    */
-  RenderTicketPtr RenderAudio(ViewerOutput* viewer, const TimeRange& r, const AudioParams& params, bool generate_waveforms, bool prioritize = false);
-  RenderTicketPtr RenderAudio(ViewerOutput *viewer, const TimeRange& r, bool generate_waveforms, bool prioritize = false);
+  RenderTicketPtr RenderAudio(ViewerOutput* viewer, const TimeRange& r, const AudioParams& params, bool generate_waveforms, Priority priority = kPriorityBackground);
+  RenderTicketPtr RenderAudio(ViewerOutput *viewer, const TimeRange& r, bool generate_waveforms, Priority priority = kPriorityBackground);
 
-  RenderTicketPtr SaveFrameToCache(FrameHashCache* cache, FramePtr frame, const QByteArray& hash, bool prioritize = false);
+  RenderTicketPtr SaveFrameToCache(FrameHashCache* cache, FramePtr frame, const QByteArray& hash, Priority priority = kPriorityBackground);
+
+  /**
+   * @brief Prepare color management for all footage in a project ahead of rendering
+   *
+   * Creates the ColorProcessor for each enabled video stream's colorspace and compiles its shader
+   * and LUT textures so the first frames rendered don't have to.
+   */
+  void WarmColorProcessors(Project* project);
 
   virtual void RunTicket(RenderTicketPtr ticket) const override;
 
@@ -123,6 +134,14 @@ public:
     return backend_;
   }
 
+  /**
+   * @brief Decoded footage textures shared between render jobs, may be null if there's no backend
+   */
+  FrameTextureCache* frame_texture_cache() const
+  {
+    return frame_texture_cache_;
+  }
+
 signals:
 
 private:
@@ -136,7 +155,7 @@ private:
 
   Backend backend_;
 
-  StillImageCache* still_cache_;
+  FrameTextureCache* frame_texture_cache_;
 
   DecoderCache* decoder_cache_;
 
@@ -144,6 +163,11 @@ private:
 
   QVariant default_shader_;
 
+  /**
+   * @brief Threads for CPU-side work a frame can do ahead of time (see RenderPrefetchTask)
+   */
+  QThreadPool* prefetch_pool_;
+
   QTimer decoder_clear_timer_;
 
   static const int kDecoderMaximumInactivity;
@@ -0,0 +1,85 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2021 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "renderprefetch.h"
+
+namespace olive {
+
+RenderPrefetchTask::RenderPrefetchTask(const std::function<FramePtr ()> &func) :
+  func_(func),
+  claimed_(0)
+{
+}
+
+void RenderPrefetchTask::Run()
+{
+  if (Claim()) {
+    RunClaimed();
+  }
+}
+
+FramePtr RenderPrefetchTask::Wait()
+{
+  if (Claim()) {
+    // Nothing has started this yet, do it ourselves rather than waiting for a pool thread
+    RunClaimed();
+  } else {
+    WaitForDone();
+  }
+
+  return result_;
+}
+
+void RenderPrefetchTask::Cancel()
+{
+  if (Claim()) {
+    // Never going to run, but anything chained after this mustn't wait for it forever
+    previous_ = nullptr;
+    done_.release();
+  } else {
+    // Already running, don't let whatever it references go away underneath it
+    WaitForDone();
+  }
+}
+
+bool RenderPrefetchTask::Claim()
+{
+  return claimed_.testAndSetAcquire(0, 1);
+}
+
+void RenderPrefetchTask::RunClaimed()
+{
+  if (previous_) {
+    previous_->Wait();
+    previous_ = nullptr;
+  }
+
+  result_ = func_();
+  done_.release();
+}
+
+void RenderPrefetchTask::WaitForDone()
+{
+  // Put the token back so any number of threads can wait on the same task
+  done_.acquire();
+  done_.release();
+}
+
+}
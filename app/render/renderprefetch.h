@@ -0,0 +1,95 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2021 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#ifndef RENDERPREFETCH_H
+#define RENDERPREFETCH_H
+
+#include <functional>
+#include <QSemaphore>
+
+#include "codec/frame.h"
+
+namespace olive {
+
+/**
+ * @brief A piece of CPU-side frame work (decoding, frame generation) that can run ahead of time
+ *
+ * Whichever thread gets to the task first runs it. If the renderer needs the result before a pool
+ * thread has picked the task up, it simply runs it itself, so waiting never depends on the pool
+ * having a free thread.
+ *
+ * Tasks can be chained with SetPrevious() so that work which has to happen in order (e.g. decoding
+ * successive frames of one stream, which decoders read ahead for) does, whichever thread ends up
+ * running it.
+ */
+class RenderPrefetchTask
+{
+public:
+  RenderPrefetchTask(const std::function<FramePtr()>& func);
+
+  /**
+   * @brief Set a task that must finish before this one starts
+   *
+   * Must be called before the task is run.
+   */
+  void SetPrevious(const std::shared_ptr<RenderPrefetchTask>& previous)
+  {
+    previous_ = previous;
+  }
+
+  /**
+   * @brief Run the task if nothing else has started it yet, called from the pool
+   */
+  void Run();
+
+  /**
+   * @brief Get the result, running the task on this thread if it hasn't started yet
+   */
+  FramePtr Wait();
+
+  /**
+   * @brief Prevent the task from running if it hasn't started, or wait for it if it has
+   */
+  void Cancel();
+
+private:
+  bool Claim();
+
+  void RunClaimed();
+
+  void WaitForDone();
+
+  std::function<FramePtr()> func_;
+
+  std::shared_ptr<RenderPrefetchTask> previous_;
+
+  QAtomicInt claimed_;
+
+  QSemaphore done_;
+
+  FramePtr result_;
+
+};
+
+using RenderPrefetchTaskPtr = std::shared_ptr<RenderPrefetchTask>;
+
+}
+
+#endif // RENDERPREFETCH_H
@@ -20,23 +20,28 @@
 
 #include "renderprocessor.h"
 
+#include <algorithm>
 #include <QOpenGLContext>
+#include <QtConcurrent/QtConcurrent>
 #include <QVector2D>
 #include <QVector3D>
 #include <QVector4D>
 
+#include "common/timecodefunctions.h"
 #include "node/project/project.h"
 #include "rendermanager.h"
 
 namespace olive {
 
-RenderProcessor::RenderProcessor(RenderTicketPtr ticket, Renderer *render_ctx, StillImageCache* still_image_cache, DecoderCache* decoder_cache, ShaderCache *shader_cache, QVariant default_shader) :
+RenderProcessor::RenderProcessor(RenderTicketPtr ticket, Renderer *render_ctx, FrameTextureCache* frame_texture_cache, DecoderCache* decoder_cache, ShaderCache *shader_cache, QVariant default_shader, QThreadPool *prefetch_pool) :
   ticket_(ticket),
   render_ctx_(render_ctx),
-  still_image_cache_(still_image_cache),
+  frame_texture_cache_(frame_texture_cache),
   decoder_cache_(decoder_cache),
   shader_cache_(shader_cache),
-  default_shader_(default_shader)
+  default_shader_(default_shader),
+  prefetch_pool_(prefetch_pool),
+  has_unsubmitted_work_(false)
 {
 }
 
@@ -47,11 +52,15 @@ FramePtr RenderProcessor::GenerateFrame(const rational& time, const rational& fr
   NodeValueTable table;
   NodeOutput texture_output = viewer->GetConnectedTextureOutput();
   if (texture_output.IsValid()) {
-    table = GenerateTable(texture_output.node(), texture_output.output(),
-                          TimeRange(time, time + frame_length));
+    TimeRange range(time, time + frame_length);
+
+    table = GenerateTable(texture_output.node(), texture_output.output(), range);
   }
 
-  TexturePtr texture = table.Get(NodeValue::kTexture).value<TexturePtr>();
+  // The traversal only lists what the frame needs, this does the decoding and rendering
+  TexturePtr texture = MaterializeTexture(table.Get<TexturePtr>(NodeValue::kTexture));
+
+  ClearPrefetch();
 
   // Set up output frame parameters
   VideoParams frame_params = GetCacheVideoParams();
@@ -106,7 +115,9 @@ FramePtr RenderProcessor::GenerateFrame(const rational& time, const rational& fr
       texture = blit_tex;
     }
 
+    qint64 download_start = RenderProfiler::Now();
     render_ctx_->DownloadFromTexture(texture.get(), frame->data(), frame->linesize_pixels());
+    AddProfileEvent(RenderProfiler::kCategoryDownload, nullptr, QStringLiteral("Frame"), download_start, RenderProfiler::Now());
   }
 
   return frame;
@@ -128,6 +139,12 @@ void RenderProcessor::Run()
       frame_length /= 2;
     }
 
+    std::unique_ptr<RenderProfiler::Recorder> profile;
+    if (RenderProfiler::instance()->IsEnabled()) {
+      profile = std::unique_ptr<RenderProfiler::Recorder>(new RenderProfiler::Recorder(Node::ValueToPtr<ViewerOutput>(ticket_->property("viewer")), time));
+      SetProfile(profile.get());
+    }
+
     FramePtr frame = GenerateFrame(time, frame_length);
 
     if (GetCacheVideoParams().interlacing() != VideoParams::kInterlaceNone) {
@@ -146,6 +163,11 @@ void RenderProcessor::Run()
       frame = Frame::Interlace(top, bottom);
     }
 
+    if (profile) {
+      SetProfile(nullptr);
+      profile->Submit();
+    }
+
     ticket_->Finish(QVariant::fromValue(frame));
     break;
   }
@@ -178,7 +200,7 @@ void RenderProcessor::Run()
   }
 }
 
-DecoderPtr RenderProcessor::ResolveDecoderFromInput(const QString& decoder_id, const Decoder::CodecStream &stream)
+DecoderPtr RenderProcessor::ResolveDecoderFromInput(const QString& decoder_id, const Decoder::CodecStream &stream, int divider)
 {
   if (!stream.IsValid()) {
     qWarning() << "Attempted to resolve the decoder of a null stream";
@@ -187,14 +209,34 @@ DecoderPtr RenderProcessor::ResolveDecoderFromInput(const QString& decoder_id, c
 
   QMutexLocker locker(decoder_cache_->mutex());
 
-  DecoderPtr decoder = decoder_cache_->value(stream);
+  // The full resolution decoder always exists, it tells us which level this divider would use
+  DecoderPtr decoder = OpenCachedDecoder(decoder_id, stream, 0);
+
+  if (decoder && divider > 1) {
+    // Decoders that must re-open to change resolution get their own instance per level so that
+    // consumers at different dividers don't keep flipping a shared one back and forth
+    int level = decoder->GetReducedResolutionLevel(divider);
+
+    if (level > 0) {
+      decoder = OpenCachedDecoder(decoder_id, stream, level);
+    }
+  }
+
+  return decoder;
+}
+
+DecoderPtr RenderProcessor::OpenCachedDecoder(const QString &decoder_id, const Decoder::CodecStream &stream, int level)
+{
+  DecoderCacheKey key(stream, level);
+
+  DecoderPtr decoder = decoder_cache_->value(key);
 
   if (!decoder) {
     // No decoder
     decoder = Decoder::CreateFromID(decoder_id);
 
     if (decoder->Open(stream)) {
-      decoder_cache_->insert(stream, decoder);
+      decoder_cache_->insert(key, decoder);
     } else {
       qWarning() << "Failed to open decoder for" << stream.filename()
                  << "::" << stream.stream();
@@ -205,9 +247,9 @@ DecoderPtr RenderProcessor::ResolveDecoderFromInput(const QString& decoder_id, c
   return decoder;
 }
 
-void RenderProcessor::Process(RenderTicketPtr ticket, Renderer *render_ctx, StillImageCache *still_image_cache, DecoderCache *decoder_cache, ShaderCache *shader_cache, QVariant default_shader)
+void RenderProcessor::Process(RenderTicketPtr ticket, Renderer *render_ctx, FrameTextureCache *frame_texture_cache, DecoderCache *decoder_cache, ShaderCache *shader_cache, QVariant default_shader, QThreadPool *prefetch_pool)
 {
-  RenderProcessor p(ticket, render_ctx, still_image_cache, decoder_cache, shader_cache, default_shader);
+  RenderProcessor p(ticket, render_ctx, frame_texture_cache, decoder_cache, shader_cache, default_shader, prefetch_pool);
   p.Run();
 }
 
@@ -236,7 +278,7 @@ NodeValueTable RenderProcessor::GenerateBlockTable(const Track *track, const Tim
 
       // Destination buffer
       NodeValueTable table = GenerateTable(b, Track::TransformRangeForBlock(b, range_for_block));
-      SampleBufferPtr samples_from_this_block = table.Take(NodeValue::kSamples).value<SampleBufferPtr>();
+      SampleBufferPtr samples_from_this_block = table.Take<SampleBufferPtr>(NodeValue::kSamples);
 
       if (!samples_from_this_block) {
         // If we retrieved no samples from this block, do nothing
@@ -288,30 +330,61 @@ NodeValueTable RenderProcessor::GenerateBlockTable(const Track *track, const Tim
   }
 }
 
-QVariant RenderProcessor::ProcessVideoFootage(const FootageJob &stream, const rational &input_time)
+QVariant RenderProcessor::ProcessVideoFootage(const Node *node, const FootageJob &stream, const rational &input_time)
 {
   if (ticket_->property("type").value<RenderManager::TicketType>() != RenderManager::kTypeVideo) {
     // Video cannot contribute to audio, so we do nothing here
     return QVariant();
   }
 
-  TexturePtr value = nullptr;
+  VideoParams stream_data = stream.video_params();
+  int footage_divider = GetFootageDivider(stream_data);
+
+  PendingFootage pending;
+  pending.node = node;
+  pending.job = stream;
+  pending.time = input_time;
+  pending.submitted = false;
+
+  FrameTextureCache::Key key = GetFrameTextureKey(stream, input_time);
 
-  // Check the still frame cache. On large frames such as high resolution still images, uploading
-  // and color managing them for every frame is a waste of time, so we implement a small cache here
-  // to optimize such a situation
+  if (!queued_footage_.contains(key) && !frame_texture_cache_->Contains(key)) {
+    // Queue the decode now, StartPrefetch() hands it to the pool once something needs a real texture
+    queued_footage_.insert(key);
+
+    bool allow_proxy = (ticket_->property("mode").toInt() == RenderMode::kOffline);
+    VideoParams::Interlacing dst_interlacing = GetCacheVideoParams().interlacing();
+
+    pending.task = std::make_shared<RenderPrefetchTask>([this, node, stream, input_time, footage_divider, allow_proxy, dst_interlacing]{
+      return DecodeFootage(node, stream, input_time, footage_divider, allow_proxy, dst_interlacing);
+    });
+    has_unsubmitted_work_ = true;
+  }
+
+  // Describe the texture this will become so nodes downstream can already use its dimensions
+  VideoParams managed_params = stream_data;
+  managed_params.set_divider(footage_divider);
+  managed_params.set_format(GetCacheVideoParams().format());
+
+  pending.placeholder = std::make_shared<Texture>(managed_params);
+  pending_footage_.insert(pending.placeholder.get(), pending);
+
+  return QVariant::fromValue(pending.placeholder);
+}
+
+TexturePtr RenderProcessor::MaterializeFootage(PendingFootage &pending)
+{
+  // Uploading and color managing footage is expensive, especially at high resolutions, and the same
+  // frame is often used more than once (stills, multicam, nested sequences, duplicated layers), so
+  // textures are shared between render jobs through the frame texture cache
+  const FootageJob& stream = pending.job;
+  const rational& input_time = pending.time;
   const VideoParams& render_params = GetCacheVideoParams();
   VideoParams stream_data = stream.video_params();
 
   ColorManager* color_manager = Node::ValueToPtr<ColorManager>(ticket_->property("colormanager"));
 
-  // See if we can make this divider larger (i.e. if the fooage is smaller)
-  int footage_divider = render_params.divider();
-  while (footage_divider > 1
-         && VideoParams::GetScaledDimension(stream_data.width(), footage_divider-1) <= render_params.effective_width()
-         && VideoParams::GetScaledDimension(stream_data.height(), footage_divider-1) <= render_params.effective_height()) {
-    footage_divider--;
-  }
+  int footage_divider = GetFootageDivider(stream_data);
 
   QString using_colorspace = stream_data.colorspace();
 
@@ -320,59 +393,159 @@ QVariant RenderProcessor::ProcessVideoFootage(const FootageJob &stream, const ra
     qWarning() << "HAVEN'T GOTTEN DEFAULT INPUT COLORSPACE";
   }
 
-  Decoder::CodecStream default_codec_stream(stream.filename(), stream_data.stream_index());
+  FrameTextureCache::Key key = GetFrameTextureKey(stream, input_time);
 
-  StillImageCache::EntryPtr want_entry = std::make_shared<StillImageCache::Entry>(
-        nullptr,
-        default_codec_stream,
-        ColorProcessor::GenerateID(color_manager, using_colorspace, color_manager->GetReferenceColorSpace()),
-        stream_data.premultiplied_alpha(),
-        footage_divider,
-        (stream_data.video_type() == VideoParams::kVideoTypeStill) ? 0 : input_time,
-        true);
+  qint64 cache_start = RenderProfiler::Now();
 
-  bool found_existing = false;
+  TexturePtr value = frame_texture_cache_->Acquire(key);
 
-  still_image_cache_->mutex()->lock();
+  if (profile()) {
+    profile()->AddCacheResult(pending.node, stream.filename(), cache_start, value != nullptr);
+  }
 
-  foreach (StillImageCache::EntryPtr e, still_image_cache_->entries()) {
-    if (StillImageCache::CompareEntryMetadata(want_entry, e)) {
-      // Found an exact match of the texture we want in the cache. See if it's working or if it's
-      // ready.
-      want_entry = e;
-      found_existing = true;
+  if (value) {
+    if (pending.task) {
+      // Another render job got there first
+      pending.task->Cancel();
+    }
+  } else {
+    // Wasn't in the cache, so we've claimed it and have to retrieve it from the decoder
+    FramePtr frame;
 
-      while (want_entry->working) {
-        still_image_cache_->wait_cond()->wait(still_image_cache_->mutex());
-      }
+    if (pending.task) {
+      frame = pending.task->Wait();
+    } else {
+      frame = DecodeFootage(pending.node, stream, input_time, footage_divider,
+                            ticket_->property("mode").toInt() == RenderMode::kOffline,
+                            GetCacheVideoParams().interlacing());
+    }
 
-      value = want_entry->texture;
-      break;
+    if (frame) {
+      // Return a texture from the derived class
+      qint64 upload_start = RenderProfiler::Now();
+      TexturePtr unmanaged_texture = render_ctx_->CreateTexture(frame->video_params(),
+                                                                frame->data(),
+                                                                frame->linesize_pixels());
+      AddProfileEvent(RenderProfiler::kCategoryUpload, pending.node, stream.filename(), upload_start, RenderProfiler::Now());
+
+      // We convert to our rendering pixel format, since that will always be float-based which
+      // is necessary for correct color conversion
+      VideoParams managed_params = frame->video_params();
+      managed_params.set_format(render_params.format());
+      managed_params.set_pixel_aspect_ratio(stream_data.pixel_aspect_ratio());
+      managed_params.set_interlacing(stream_data.interlacing());
+      value = render_ctx_->CreateTexture(managed_params);
+
+      ColorProcessorPtr processor = ColorProcessorCache::instance()->Get(color_manager,
+                                                                         using_colorspace,
+                                                                         color_manager->GetReferenceColorSpace());
+
+      qint64 blit_start = RenderProfiler::Now();
+      render_ctx_->BlitColorManaged(processor, unmanaged_texture,
+                                    stream_data.premultiplied_alpha(),
+                                    value.get());
+      AddProfileEvent(RenderProfiler::kCategoryShader, pending.node, stream.filename(), blit_start, RenderProfiler::Now());
+
+      frame_texture_cache_->Fulfill(key, value);
+    } else {
+      // Let anyone waiting on this frame try for themselves
+      frame_texture_cache_->Abandon(key);
     }
   }
 
-  if (value) {
-    // Found the texture, we can release the cache now
-    still_image_cache_->mutex()->unlock();
+  // The decoded frame isn't needed any more now that it's on the GPU
+  pending.task = nullptr;
+
+  return value;
+}
+
+FrameTextureCache::Key RenderProcessor::GetFrameTextureKey(const FootageJob &stream, const rational &input_time) const
+{
+  const VideoParams& stream_data = stream.video_params();
+
+  ColorManager* color_manager = Node::ValueToPtr<ColorManager>(ticket_->property("colormanager"));
+
+  FrameTextureCache::Key key;
+
+  key.stream = Decoder::CodecStream(stream.filename(), stream_data.stream_index());
+  key.colorspace = ColorProcessor::GenerateID(color_manager, stream_data.colorspace(), color_manager->GetReferenceColorSpace());
+  key.alpha_is_associated = stream_data.premultiplied_alpha();
+  key.divider = GetFootageDivider(stream_data);
+  key.format = GetCacheVideoParams().format();
+  key.allow_proxy = (ticket_->property("mode").toInt() == RenderMode::kOffline);
+  key.src_interlacing = stream_data.interlacing();
+  key.dst_interlacing = GetCacheVideoParams().interlacing();
+
+  if (stream_data.video_type() == VideoParams::kVideoTypeStill) {
+    key.timestamp = 0;
   } else {
-    // Wasn't in still image cache, so we'll have to retrieve it from the decoder
+    // Key on the timestamp the decoder will seek to rather than the exact time, so clips that land
+    // on the same source frame from different sequence times share it
+    rational timebase = stream_data.time_base();
 
-    // Let other processors know we're getting this texture (want_entry's `working` field is
-    // already set to true in the initializer above)
-    if (!found_existing) {
-      still_image_cache_->PushEntry(want_entry);
+    if (timebase.isNull()) {
+      timebase = stream_data.frame_rate_as_time_base();
     }
 
-    still_image_cache_->mutex()->unlock();
+    key.timestamp = Timecode::time_to_timestamp(input_time, timebase);
+  }
 
-    QString decoder_id = stream.decoder();
+  return key;
+}
 
-    DecoderPtr decoder = nullptr;
+FramePtr RenderProcessor::DecodeFootage(const Node *node, const FootageJob &stream, const rational &input_time, int footage_divider, bool allow_proxy, VideoParams::Interlacing dst_interlacing)
+{
+  const VideoParams& stream_data = stream.video_params();
 
-    if (stream_data.video_type() == VideoParams::kVideoTypeVideo) {
-      decoder = ResolveDecoderFromInput(decoder_id, default_codec_stream);
-    } else {
-      // Since image sequences involve multiple files, we don't engage the decoder cache
+  Decoder::CodecStream default_codec_stream(stream.filename(), stream_data.stream_index());
+
+  QString decoder_id = stream.decoder();
+
+  DecoderPtr decoder = nullptr;
+
+  // Divider to request from the decoder, differs from `footage_divider` if a proxy is used
+  int decoder_divider = footage_divider;
+
+  int64_t sequence_index = AV_NOPTS_VALUE;
+
+  // Proxies are de-interlaced when they're generated, so they're always decoded as progressive
+  VideoParams::Interlacing src_interlacing = stream_data.interlacing();
+
+  if (stream_data.video_type() == VideoParams::kVideoTypeVideo) {
+    // Preview renders may substitute a pre-generated proxy, but exports always use the original
+    if (allow_proxy) {
+      int proxy_divider;
+      QString proxy_fn = Decoder::FindProxy(stream.cache_path(), default_codec_stream, footage_divider, &proxy_divider);
+
+      if (!proxy_fn.isEmpty()) {
+        // Proxies are always encoded by FFmpeg
+        decoder = ResolveDecoderFromInput(QStringLiteral("ffmpeg"), Decoder::CodecStream(proxy_fn, 0), footage_divider / proxy_divider);
+
+        if (decoder) {
+          decoder_divider = footage_divider / proxy_divider;
+          src_interlacing = VideoParams::kInterlaceNone;
+        }
+      }
+    }
+
+    if (!decoder) {
+      decoder = ResolveDecoderFromInput(decoder_id, default_codec_stream, footage_divider);
+    }
+  } else {
+    if (stream_data.video_type() == VideoParams::kVideoTypeImageSequence) {
+      // If the decoder can handle the sequence itself, keep one instance per sequence in the
+      // decoder cache so it can reuse state and prefetch upcoming files between frames
+      decoder = ResolveDecoderFromInput(decoder_id, default_codec_stream, footage_divider);
+
+      if (decoder && decoder->SupportsImageSequences()) {
+        sequence_index = stream_data.get_time_in_timebase_units(input_time);
+      } else {
+        decoder = nullptr;
+      }
+    }
+
+    if (!decoder) {
+      // Otherwise, since image sequences involve multiple files, we don't engage the decoder cache
       decoder = Decoder::CreateFromID(decoder_id);
 
       QString frame_filename;
@@ -387,51 +560,161 @@ QVariant RenderProcessor::ProcessVideoFootage(const FootageJob &stream, const ra
       // Decoder will close automatically since it's a stream_ptr
       decoder->Open(Decoder::CodecStream(frame_filename, stream_data.stream_index()));
     }
+  }
+
+  if (decoder) {
+    Decoder::RetrieveVideoParams p;
+    p.divider = decoder_divider;
+    p.src_interlacing = src_interlacing;
+    p.dst_interlacing = dst_interlacing;
+    p.sequence_index = sequence_index;
+
+    qint64 decode_start = RenderProfiler::Now();
+
+    FramePtr frame = decoder->RetrieveVideo((stream_data.video_type() == VideoParams::kVideoTypeVideo) ? input_time : Decoder::kAnyTimecode, p);
+
+    // May be on a prefetch thread, so this goes straight to the profile without affecting whatever
+    // node the traversal is in
+    if (profile()) {
+      profile()->AddEvent(RenderProfiler::kCategoryDecode, node, stream.filename(), decode_start, RenderProfiler::Now());
+    }
+
+    if (frame) {
+      if (decoder_divider != footage_divider) {
+        // Frame came from a proxy, describe it as the original footage at the requested divider
+        // so nodes downstream see the same dimensions either way
+        VideoParams original_params = frame->video_params();
+        original_params.set_width(stream_data.width());
+        original_params.set_height(stream_data.height());
+        original_params.set_divider(footage_divider);
+        frame->set_video_params(original_params);
+      }
+
+      return frame;
+    }
+  }
+
+  return nullptr;
+}
+
+int RenderProcessor::GetFootageDivider(const VideoParams &stream_data) const
+{
+  const VideoParams& render_params = GetCacheVideoParams();
+
+  // See if we can make this divider larger (i.e. if the fooage is smaller)
+  int footage_divider = render_params.divider();
+  while (footage_divider > 1
+         && VideoParams::GetScaledDimension(stream_data.width(), footage_divider-1) <= render_params.effective_width()
+         && VideoParams::GetScaledDimension(stream_data.height(), footage_divider-1) <= render_params.effective_height()) {
+    footage_divider--;
+  }
+
+  return footage_divider;
+}
+
+void RenderProcessor::StartPrefetch()
+{
+  if (!prefetch_pool_ || !has_unsubmitted_work_) {
+    return;
+  }
 
-    if (decoder) {
-      Decoder::RetrieveVideoParams p;
-      p.divider = footage_divider;
-      p.src_interlacing = stream_data.interlacing();
-      p.dst_interlacing = GetCacheVideoParams().interlacing();
+  has_unsubmitted_work_ = false;
 
-      FramePtr frame = decoder->RetrieveVideo((stream_data.video_type() == VideoParams::kVideoTypeVideo) ? input_time : Decoder::kAnyTimecode, p);
+  QHash<Decoder::CodecStream, QVector<PendingFootage*> > streams;
+  QVector<PendingGeneration*> generations;
+  int task_count = 0;
 
-      if (frame) {
-        // Return a texture from the derived class
-        TexturePtr unmanaged_texture = render_ctx_->CreateTexture(frame->video_params(),
-                                                                  frame->data(),
-                                                                  frame->linesize_pixels());
+  for (auto it=pending_footage_.begin(); it!=pending_footage_.end(); it++) {
+    if (it->task && !it->submitted) {
+      streams[Decoder::CodecStream(it->job.filename(), it->job.video_params().stream_index())].append(&it.value());
+      task_count++;
+    }
+  }
 
-        // We convert to our rendering pixel format, since that will always be float-based which
-        // is necessary for correct color conversion
-        VideoParams managed_params = frame->video_params();
-        managed_params.set_format(render_params.format());
-        managed_params.set_pixel_aspect_ratio(stream_data.pixel_aspect_ratio());
-        managed_params.set_interlacing(stream_data.interlacing());
-        value = render_ctx_->CreateTexture(managed_params);
+  for (auto it=pending_generation_.begin(); it!=pending_generation_.end(); it++) {
+    if (!it->submitted) {
+      generations.append(&it.value());
+      task_count++;
+    }
+  }
 
-        ColorProcessorPtr processor = ColorProcessor::Create(color_manager,
-                                                             using_colorspace,
-                                                             color_manager->GetReferenceColorSpace());
+  if (task_count < 2) {
+    // Nothing independent to overlap, it may as well happen inline
+    return;
+  }
+
+  for (auto it=streams.begin(); it!=streams.end(); it++) {
+    QVector<PendingFootage*>& list = it.value();
 
-        render_ctx_->BlitColorManaged(processor, unmanaged_texture,
-                                      stream_data.premultiplied_alpha(),
-                                      value.get());
+    // Decoders read ahead from the last frame they were asked for, so keep each stream in order
+    std::sort(list.begin(), list.end(), [](PendingFootage* a, PendingFootage* b){
+      return a->time < b->time;
+    });
 
-        still_image_cache_->mutex()->lock();
+    QVector<RenderPrefetchTaskPtr> tasks;
+    RenderPrefetchTaskPtr previous = last_stream_task_.value(it.key());
+
+    foreach (PendingFootage* p, list) {
+      if (previous) {
+        p->task->SetPrevious(previous);
+      }
 
-        // Put this into the image cache instead
-        want_entry->texture = value;
-        want_entry->working = false;
+      p->submitted = true;
+      tasks.append(p->task);
+      previous = p->task;
+    }
 
-        still_image_cache_->wait_cond()->wakeAll();
+    last_stream_task_.insert(it.key(), previous);
 
-        still_image_cache_->mutex()->unlock();
+    // One pool job per stream so its decodes don't compete with each other for threads
+    QtConcurrent::run(prefetch_pool_, [tasks]{
+      foreach (const RenderPrefetchTaskPtr& t, tasks) {
+        t->Run();
       }
+    });
+  }
+
+  foreach (PendingGeneration* p, generations) {
+    p->submitted = true;
+
+    RenderPrefetchTaskPtr task = p->task;
+    QtConcurrent::run(prefetch_pool_, [task]{ task->Run(); });
+  }
+}
+
+void RenderProcessor::ClearPrefetch()
+{
+  // Anything left over wasn't needed after all (e.g. its branch was replaced by a cached frame),
+  // make sure nothing is still running that references this processor
+  foreach (const PendingFootage& p, pending_footage_) {
+    if (p.task) {
+      p.task->Cancel();
+    }
+  }
+
+  foreach (const PendingGeneration& p, pending_generation_) {
+    if (p.task) {
+      p.task->Cancel();
     }
   }
 
-  return QVariant::fromValue(value);
+  pending_shaders_.clear();
+  pending_footage_.clear();
+  pending_generation_.clear();
+  last_stream_task_.clear();
+  queued_footage_.clear();
+  has_unsubmitted_work_ = false;
+}
+
+FramePtr RenderProcessor::GenerateFrameOnCPU(const Node *node, const GenerateJob &job, const VideoParams &params)
+{
+  FramePtr frame = Frame::Create();
+  frame->set_video_params(params);
+  frame->allocate();
+
+  node->GenerateFrame(frame, job);
+
+  return frame;
 }
 
 QVariant RenderProcessor::ProcessAudioFootage(const FootageJob &stream, const TimeRange &input_time)
@@ -460,32 +743,297 @@ QVariant RenderProcessor::ProcessShader(const Node *node, const TimeRange &range
 {
   Q_UNUSED(range)
 
-  QString full_shader_id = QStringLiteral("%1:%2").arg(node->id(), job.GetShaderID());
+  ReleaseUnusedPlaceholders();
 
-  QMutexLocker locker(shader_cache_->mutex());
+  VideoParams tex_params = GetCacheVideoParams();
 
-  QVariant shader = shader_cache_->value(full_shader_id);
+  tex_params.set_channel_count(GetChannelCountFromJob(job));
 
-  if (shader.isNull()) {
-    // Since we have shader code, compile it now
-    shader = render_ctx_->CreateNativeShader(node->GetShaderCode(job.GetShaderID()));
+  // Defer rendering until something needs this texture. By then the footage it depends on has been
+  // decoding in the background, and whatever samples it may be able to compute it inline instead.
+  TexturePtr placeholder = std::make_shared<Texture>(tex_params);
+  placeholder->set_region(job.GetRegion());
+  pending_shaders_.insert(placeholder.get(), {placeholder, node, job, ShaderFusion::CanInline(node, job), nullptr});
+  return QVariant::fromValue(placeholder);
+}
+
+TexturePtr RenderProcessor::RenderShader(const Node *node, const ShaderJob &job, const VideoParams &params)
+{
+  QString full_shader_id = ShaderFusion::GetShaderKey(node, job);
+
+  QVariant shader;
+
+  {
+    QMutexLocker locker(shader_cache_->mutex());
+
+    shader = shader_cache_->value(full_shader_id);
 
     if (shader.isNull()) {
-      // Couldn't find or build the shader required
-      return QVariant();
+      // Since we have shader code, compile it now
+      shader = render_ctx_->CreateNativeShader(node->GetShaderCode(job.GetShaderID()));
+
+      if (shader.isNull()) {
+        // Couldn't find or build the shader required
+        return nullptr;
+      }
+
+      shader_cache_->insert(full_shader_id, shader);
     }
   }
 
-  VideoParams tex_params = GetCacheVideoParams();
+  TexturePtr destination = render_ctx_->CreateTexture(params);
 
-  tex_params.set_channel_count(GetChannelCountFromJob(job));
+  ShaderJob materialized = MaterializeJob(job);
 
-  TexturePtr destination = render_ctx_->CreateTexture(tex_params);
+  // Run shader (measured on the CPU, so this is the time to submit it rather than GPU time)
+  qint64 blit_start = RenderProfiler::Now();
+  render_ctx_->BlitToTexture(shader, materialized, destination.get());
+  AddProfileEvent(RenderProfiler::kCategoryShader, node, GetProfileName(node), blit_start, RenderProfiler::Now());
 
-  // Run shader
-  render_ctx_->BlitToTexture(shader, job, destination.get());
+  destination->set_region(job.GetRegion());
 
-  return QVariant::fromValue(destination);
+  return destination;
+}
+
+TexturePtr RenderProcessor::MaterializeTexture(const TexturePtr &texture)
+{
+  if (!texture || !texture->IsDummy()) {
+    return texture;
+  }
+
+  // Whatever is needed first, every decode the traversal has asked for so far should be underway
+  StartPrefetch();
+
+  auto footage = pending_footage_.find(texture.get());
+  if (footage != pending_footage_.end()) {
+    if (!footage->result) {
+      footage->result = MaterializeFootage(footage.value());
+    }
+
+    return footage->result;
+  }
+
+  auto generation = pending_generation_.find(texture.get());
+  if (generation != pending_generation_.end()) {
+    if (!generation->result) {
+      generation->result = MaterializeGeneration(generation.value());
+    }
+
+    return generation->result;
+  }
+
+  auto it = pending_shaders_.find(texture.get());
+
+  if (it == pending_shaders_.end()) {
+    return texture;
+  }
+
+  if (!it->result) {
+    // Nothing is added to pending_shaders_ while rendering, so this reference stays valid
+    PendingShader& pending = it.value();
+
+    if (pending.inlinable) {
+      QVector<ShaderFusion::Stage> stages;
+      QHash<Texture*, int> stage_indices;
+      int budget = kMaximumFusedStages;
+
+      AddFusionStage(texture.get(), true, &stages, &stage_indices, &budget);
+
+      if (stages.size() > 1) {
+        pending.result = RenderFused(stages, pending.placeholder->params());
+      }
+    }
+
+    if (!pending.result) {
+      // Nothing to fuse or fusion failed, render this on its own
+      pending.result = RenderShader(pending.node, pending.job, pending.placeholder->params());
+    }
+
+    // Don't hold onto the inputs any longer than necessary
+    QVector<Texture*> inputs;
+    GetJobTextures(pending.job, &inputs);
+    pending.job = ShaderJob();
+    ReleaseMaterialized(inputs);
+  }
+
+  return it->result;
+}
+
+TexturePtr RenderProcessor::MaterializeGeneration(PendingGeneration &pending)
+{
+  FramePtr frame = pending.task->Wait();
+  pending.task = nullptr;
+
+  qint64 upload_start = RenderProfiler::Now();
+  TexturePtr texture = render_ctx_->CreateTexture(frame->video_params(),
+                                                  frame->data(),
+                                                  frame->linesize_pixels());
+  AddProfileEvent(RenderProfiler::kCategoryUpload, pending.node, GetProfileName(pending.node), upload_start, RenderProfiler::Now());
+
+  return texture;
+}
+
+void RenderProcessor::ReleaseMaterialized(const QVector<Texture *> &textures)
+{
+  foreach (Texture* t, textures) {
+    // Only the pending entry refers to the placeholder, so nothing will ask for its result again
+    auto shader = pending_shaders_.find(t);
+    if (shader != pending_shaders_.end() && shader->placeholder.use_count() == 1) {
+      shader->result = nullptr;
+      continue;
+    }
+
+    auto footage = pending_footage_.find(t);
+    if (footage != pending_footage_.end() && footage->placeholder.use_count() == 1) {
+      footage->result = nullptr;
+      continue;
+    }
+
+    auto generation = pending_generation_.find(t);
+    if (generation != pending_generation_.end() && generation->placeholder.use_count() == 1) {
+      generation->result = nullptr;
+    }
+  }
+}
+
+void RenderProcessor::ReleaseUnusedPlaceholders()
+{
+  // Nothing refers to these placeholders but us, so nothing will ever ask for their textures
+  for (auto it=pending_shaders_.begin(); it!=pending_shaders_.end(); ) {
+    if (it->placeholder.use_count() == 1) {
+      it = pending_shaders_.erase(it);
+    } else {
+      it++;
+    }
+  }
+
+  // Work that hasn't been handed to the pool yet can be dropped before it starts
+  for (auto it=pending_footage_.begin(); it!=pending_footage_.end(); ) {
+    if (it->placeholder.use_count() == 1 && !it->submitted) {
+      if (it->task) {
+        it->task->Cancel();
+      }
+      it = pending_footage_.erase(it);
+    } else {
+      it++;
+    }
+  }
+
+  for (auto it=pending_generation_.begin(); it!=pending_generation_.end(); ) {
+    if (it->placeholder.use_count() == 1 && !it->submitted) {
+      it->task->Cancel();
+      it = pending_generation_.erase(it);
+    } else {
+      it++;
+    }
+  }
+}
+
+ShaderJob RenderProcessor::MaterializeJob(const ShaderJob &job)
+{
+  ShaderJob real_job = job;
+
+  for (auto it=job.GetValues().cbegin(); it!=job.GetValues().cend(); it++) {
+    const NodeValue& v = it.value();
+
+    if (v.type() == NodeValue::kTexture && !v.array()) {
+      TexturePtr tex = v.value<TexturePtr>();
+      TexturePtr real = MaterializeTexture(tex);
+
+      if (real != tex) {
+        real_job.InsertValue(it.key(), NodeValue(NodeValue::kTexture, QVariant::fromValue(real), v.source(), false, v.tag()));
+      }
+    }
+  }
+
+  return real_job;
+}
+
+int RenderProcessor::AddFusionStage(Texture *texture, bool root, QVector<ShaderFusion::Stage> *stages, QHash<Texture *, int> *stage_indices, int *budget)
+{
+  auto existing = stage_indices->constFind(texture);
+
+  if (existing != stage_indices->constEnd()) {
+    // Used more than once in this chain, share one stage
+    return existing.value();
+  }
+
+  (*budget)--;
+
+  const PendingShader& pending = pending_shaders_.value(texture);
+
+  ShaderFusion::Stage stage;
+  stage.node = pending.node;
+  stage.job = pending.job;
+  stage.channel_count = pending.placeholder->channel_count();
+  stage.mapped = !root && pending.job.GetValues().contains(QStringLiteral("ove_mvpmat"));
+
+  foreach (const QString& input, pending.job.GetPerPixelInputs()) {
+    TexturePtr input_tex = pending.job.GetValue(input).value<TexturePtr>();
+
+    auto input_pending = input_tex ? pending_shaders_.constFind(input_tex.get()) : pending_shaders_.constEnd();
+
+    if (*budget > 0
+        && input_pending != pending_shaders_.constEnd()
+        && input_pending->inlinable
+        && !input_pending->result) {
+      stage.inputs.insert(input, AddFusionStage(input_tex.get(), false, stages, stage_indices, budget));
+    }
+  }
+
+  stages->append(stage);
+
+  int index = stages->size() - 1;
+  stage_indices->insert(texture, index);
+
+  return index;
+}
+
+TexturePtr RenderProcessor::RenderFused(const QVector<ShaderFusion::Stage> &stages, const VideoParams &params)
+{
+  QString key = ShaderFusion::GetCacheKey(stages);
+
+  QVariant shader;
+
+  {
+    QMutexLocker locker(shader_cache_->mutex());
+
+    auto it = shader_cache_->constFind(key);
+
+    if (it == shader_cache_->constEnd()) {
+      ShaderCode code;
+
+      if (ShaderFusion::GenerateCode(stages, &code)) {
+        shader = render_ctx_->CreateNativeShader(code);
+      }
+
+      // A null entry remembers that this chain can't be fused so we don't try every frame
+      shader_cache_->insert(key, shader);
+    } else {
+      shader = it.value();
+    }
+  }
+
+  if (shader.isNull()) {
+    return nullptr;
+  }
+
+  TexturePtr destination = render_ctx_->CreateTexture(params);
+
+  ShaderJob merged = ShaderFusion::MergeJobs(stages);
+
+  ShaderJob materialized = MaterializeJob(merged);
+
+  // Attributed to the last node in the chain, which the others were fused into
+  qint64 blit_start = RenderProfiler::Now();
+  render_ctx_->BlitToTexture(shader, materialized, destination.get());
+  AddProfileEvent(RenderProfiler::kCategoryShader, stages.last().node,
+                  QStringLiteral("%1 (%2 fused)").arg(GetProfileName(stages.last().node), QString::number(stages.size())),
+                  blit_start, RenderProfiler::Now());
+
+  destination->set_region(merged.GetRegion());
+
+  return destination;
 }
 
 QVariant RenderProcessor::ProcessSamples(const Node *node, const TimeRange &range, const SampleJob &job)
@@ -525,20 +1073,32 @@ QVariant RenderProcessor::ProcessSamples(const Node *node, const TimeRange &rang
 
 QVariant RenderProcessor::ProcessFrameGeneration(const Node *node, const GenerateJob &job)
 {
-  FramePtr frame = Frame::Create();
-
   VideoParams frame_params = GetCacheVideoParams();
   frame_params.set_channel_count(GetChannelCountFromJob(job));
-  frame->set_video_params(frame_params);
-  frame->allocate();
 
-  node->GenerateFrame(frame, job);
+  // Generated on the CPU, so it can happen in the background like decoding
+  PendingGeneration pending;
+  pending.placeholder = std::make_shared<Texture>(frame_params);
+  pending.node = node;
+  QString profile_name = GetProfileName(node);
+  pending.task = std::make_shared<RenderPrefetchTask>([this, node, job, frame_params, profile_name]{
+    qint64 generate_start = RenderProfiler::Now();
 
-  TexturePtr texture = render_ctx_->CreateTexture(frame->video_params(),
-                                                  frame->data(),
-                                                  frame->linesize_pixels());
+    FramePtr frame = GenerateFrameOnCPU(node, job, frame_params);
+
+    // Like decoding, this may be on a prefetch thread so it goes straight to the profile
+    if (profile()) {
+      profile()->AddEvent(RenderProfiler::kCategoryGenerate, node, profile_name, generate_start, RenderProfiler::Now());
+    }
 
-  return QVariant::fromValue(texture);
+    return frame;
+  });
+  pending.submitted = false;
+  has_unsubmitted_work_ = true;
+
+  pending_generation_.insert(pending.placeholder.get(), pending);
+
+  return QVariant::fromValue(pending.placeholder);
 }
 
 bool RenderProcessor::CanCacheFrames()
@@ -553,16 +1113,55 @@ QVariant RenderProcessor::GetCachedTexture(const QByteArray& hash)
     return QVariant();
   }
 
+  qint64 cache_start = RenderProfiler::Now();
+
   FramePtr f = FrameHashCache::LoadCacheFrame(cache_dir, hash);
 
+  if (profile()) {
+    profile()->AddCacheResult(nullptr, QString::fromLatin1(hash.toHex()), cache_start, f != nullptr);
+  }
+
   if (f) {
+    qint64 upload_start = RenderProfiler::Now();
     TexturePtr texture = render_ctx_->CreateTexture(f->video_params(), f->data(), f->linesize_pixels());
+    AddProfileEvent(RenderProfiler::kCategoryUpload, nullptr, QString::fromLatin1(hash.toHex()), upload_start, RenderProfiler::Now());
     return QVariant::fromValue(texture);
   }
 
   return QVariant();
 }
 
+void RenderProcessor::SaveNestedTexture(const QByteArray &hash, const QVariant &texture)
+{
+  // Downloading the frame stalls this thread on the GPU, which previews and playback can't afford.
+  // Exports wait on every frame anyway, so leave it to them to fill in the nested sequence's cache.
+  if (ticket_->property("priority").toInt() != RenderManager::kPriorityExport) {
+    return;
+  }
+
+  QString cache_dir = ticket_->property("cache").toString();
+  if (cache_dir.isEmpty()) {
+    return;
+  }
+
+  TexturePtr tex = MaterializeTexture(texture.value<TexturePtr>());
+  if (!tex) {
+    return;
+  }
+
+  FramePtr frame = Frame::Create();
+  frame->set_video_params(tex->params());
+  frame->allocate();
+  qint64 download_start = RenderProfiler::Now();
+  render_ctx_->DownloadFromTexture(tex.get(), frame->data(), frame->linesize_pixels());
+  AddProfileEvent(RenderProfiler::kCategoryDownload, nullptr, QString::fromLatin1(hash.toHex()), download_start, RenderProfiler::Now());
+
+  // Writing the file is slow and this frame doesn't depend on it, so don't hold up the render
+  QtConcurrent::run(prefetch_pool_, [cache_dir, hash, frame]{
+    FrameHashCache::SaveCacheFrame(cache_dir, hash, frame);
+  });
+}
+
 void RenderProcessor::SaveCachedTexture(const QByteArray &hash, const QVariant &tex_var)
 {
   // FIXME: Temporarily disabled because I don't know how to ensure that the frame saved here is
@@ -21,10 +21,14 @@
 #ifndef RENDERPROCESSOR_H
 #define RENDERPROCESSOR_H
 
+#include <QThreadPool>
+
 #include "node/traverser.h"
+#include "render/frametexturecache.h"
 #include "render/renderer.h"
 #include "rendercache.h"
-#include "stillimagecache.h"
+#include "renderprefetch.h"
+#include "shaderfusion.h"
 #include "threading/threadticket.h"
 
 namespace olive {
@@ -32,7 +36,7 @@ namespace olive {
 class RenderProcessor : public NodeTraverser
 {
 public:
-  static void Process(RenderTicketPtr ticket, Renderer* render_ctx, StillImageCache* still_image_cache, DecoderCache* decoder_cache, ShaderCache* shader_cache, QVariant default_shader);
+  static void Process(RenderTicketPtr ticket, Renderer* render_ctx, FrameTextureCache* frame_texture_cache, DecoderCache* decoder_cache, ShaderCache* shader_cache, QVariant default_shader, QThreadPool* prefetch_pool);
 
   struct RenderedWaveform {
     const Track* track;
@@ -43,7 +47,7 @@ public:
 protected:
   virtual NodeValueTable GenerateBlockTable(const Track *track, const TimeRange &range) override;
 
-  virtual QVariant ProcessVideoFootage(const FootageJob &stream, const rational &input_time) override;
+  virtual QVariant ProcessVideoFootage(const Node *node, const FootageJob &stream, const rational &input_time) override;
 
   virtual QVariant ProcessAudioFootage(const FootageJob &stream, const TimeRange &input_time) override;
 
@@ -59,20 +63,103 @@ protected:
 
   virtual void SaveCachedTexture(const QByteArray& hash, const QVariant& texture) override;
 
+  virtual void SaveNestedTexture(const QByteArray& hash, const QVariant& texture) override;
+
 private:
-  RenderProcessor(RenderTicketPtr ticket, Renderer* render_ctx, StillImageCache* still_image_cache, DecoderCache* decoder_cache, ShaderCache* shader_cache, QVariant default_shader);
+  struct PendingShader {
+    TexturePtr placeholder;
+    const Node* node;
+    ShaderJob job;
+    bool inlinable;
+    TexturePtr result;
+  };
+
+  struct PendingFootage {
+    TexturePtr placeholder;
+    const Node* node;
+    FootageJob job;
+    rational time;
+    RenderPrefetchTaskPtr task;
+    bool submitted;
+    TexturePtr result;
+  };
+
+  struct PendingGeneration {
+    TexturePtr placeholder;
+    const Node* node;
+    RenderPrefetchTaskPtr task;
+    bool submitted;
+    TexturePtr result;
+  };
+
+  RenderProcessor(RenderTicketPtr ticket, Renderer* render_ctx, FrameTextureCache* frame_texture_cache, DecoderCache* decoder_cache, ShaderCache* shader_cache, QVariant default_shader, QThreadPool* prefetch_pool);
 
   FramePtr GenerateFrame(const rational &time, const rational &frame_length);
 
   void Run();
 
-  DecoderPtr ResolveDecoderFromInput(const QString &decoder_id, const Decoder::CodecStream& stream);
+  DecoderPtr ResolveDecoderFromInput(const QString &decoder_id, const Decoder::CodecStream& stream, int divider = 1);
+
+  DecoderPtr OpenCachedDecoder(const QString &decoder_id, const Decoder::CodecStream& stream, int level);
+
+  FramePtr DecodeFootage(const Node* node, const FootageJob& stream, const rational& input_time, int footage_divider, bool allow_proxy, VideoParams::Interlacing dst_interlacing);
+
+  int GetFootageDivider(const VideoParams& stream_data) const;
+
+  FrameTextureCache::Key GetFrameTextureKey(const FootageJob& stream, const rational& input_time) const;
+
+  /**
+   * @brief Queue the decoding and frame generation the traversal has asked for onto the prefetch pool
+   *
+   * The traversal only returns placeholders for footage, frame generation and shaders, so by the time
+   * anything needs a real texture it has already listed all the CPU work the frame needs. Independent
+   * branches then decode in parallel while the GPU work (which has to stay on this thread) waits for
+   * them in order. Each stream's frames are decoded one after another in time order so decoders can
+   * keep reading ahead.
+   */
+  void StartPrefetch();
+
+  void ClearPrefetch();
+
+  static FramePtr GenerateFrameOnCPU(const Node* node, const GenerateJob& job, const VideoParams& params);
+
+  TexturePtr RenderShader(const Node* node, const ShaderJob& job, const VideoParams& params);
+
+  /**
+   * @brief Get the real texture for a placeholder returned by the traversal, creating it if necessary
+   *
+   * Any shaders it was produced from that can be computed inline are fused into one pass.
+   */
+  TexturePtr MaterializeTexture(const TexturePtr& texture);
+
+  ShaderJob MaterializeJob(const ShaderJob& job);
+
+  TexturePtr MaterializeFootage(PendingFootage& pending);
+
+  TexturePtr MaterializeGeneration(PendingGeneration& pending);
+
+  void ReleaseUnusedPlaceholders();
+
+  /**
+   * @brief Drop the results of these placeholders if nothing else will ask for them again
+   */
+  void ReleaseMaterialized(const QVector<Texture*>& textures);
+
+  int AddFusionStage(Texture* texture, bool root, QVector<ShaderFusion::Stage>* stages, QHash<Texture*, int>* stage_indices, int* budget);
+
+  TexturePtr RenderFused(const QVector<ShaderFusion::Stage>& stages, const VideoParams& params);
+
+  /**
+   * @brief Limits how many shaders are inlined into one, keeping generated shaders (and the
+   * number of textures they bind) reasonable
+   */
+  static const int kMaximumFusedStages = 8;
 
   RenderTicketPtr ticket_;
 
   Renderer* render_ctx_;
 
-  StillImageCache* still_image_cache_;
+  FrameTextureCache* frame_texture_cache_;
 
   DecoderCache* decoder_cache_;
 
@@ -80,6 +167,22 @@ private:
 
   QVariant default_shader_;
 
+  QThreadPool* prefetch_pool_;
+
+  QHash<Texture*, PendingShader> pending_shaders_;
+
+  QHash<Texture*, PendingFootage> pending_footage_;
+
+  QHash<Texture*, PendingGeneration> pending_generation_;
+
+  // Last decode queued for each stream, so the next one for it runs after it
+  QHash<Decoder::CodecStream, RenderPrefetchTaskPtr> last_stream_task_;
+
+  // Frames already being decoded for this frame, so the same one used twice is only decoded once
+  QSet<FrameTextureCache::Key> queued_footage_;
+
+  bool has_unsubmitted_work_;
+
 };
 
 }
@@ -0,0 +1,418 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2021 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#include "renderprofiler.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QThread>
+
+#include "node/output/viewer/viewer.h"
+
+namespace olive {
+
+RenderProfiler* RenderProfiler::instance_ = nullptr;
+
+const int RenderProfiler::kMaximumFrames = 512;
+
+RenderProfiler::Recorder::Recorder(const ViewerOutput *viewer, const rational &time)
+{
+  frame_.viewer = static_cast<const Node*>(viewer);
+  frame_.viewer_id = 0;
+  frame_.time = time;
+  frame_.thread = reinterpret_cast<quintptr>(QThread::currentThreadId());
+  frame_.start = Now();
+  frame_.duration = 0;
+}
+
+void RenderProfiler::Recorder::AddEvent(Category category, const Node *node, const QString &name, qint64 start, qint64 end, qint64 self)
+{
+  QMutexLocker locker(&mutex_);
+
+  frame_.events.append({category, node, 0, name, start, end - start, self, false});
+}
+
+void RenderProfiler::Recorder::AddCacheResult(const Node *node, const QString &name, qint64 start, bool hit)
+{
+  QMutexLocker locker(&mutex_);
+
+  frame_.events.append({kCategoryCache, node, 0, name, start, Now() - start, 0, hit});
+}
+
+void RenderProfiler::Recorder::Submit()
+{
+  QMutexLocker locker(&mutex_);
+
+  frame_.duration = Now() - frame_.start;
+
+  RenderProfiler::instance()->AddFrame(frame_);
+}
+
+qint64 RenderProfiler::Now()
+{
+  static QElapsedTimer timer = []{
+    QElapsedTimer t;
+    t.start();
+    return t;
+  }();
+
+  return timer.nsecsElapsed();
+}
+
+void RenderProfiler::Enable()
+{
+  enabled_.ref();
+}
+
+void RenderProfiler::Disable()
+{
+  if (!enabled_.deref()) {
+    // Nothing's looking at them any more
+    Clear();
+  }
+}
+
+void RenderProfiler::SetAlias(const Node *copy, const Node *original)
+{
+  QMutexLocker locker(&mutex_);
+
+  aliases_.insert(copy, GetNodeId(original));
+}
+
+void RenderProfiler::RemoveNode(const Node *node)
+{
+  QMutexLocker locker(&mutex_);
+
+  // Copies never have IDs of their own, see GetNodeId()
+  if (aliases_.remove(node)) {
+    return;
+  }
+
+  quint64 id = node_ids_.take(node);
+
+  if (id) {
+    // Events with this ID are left in place and just won't resolve to a node any more
+    nodes_.remove(id);
+  }
+}
+
+QVector<RenderProfiler::Frame> RenderProfiler::GetFrames() const
+{
+  QMutexLocker locker(&mutex_);
+
+  // Return oldest first
+  QVector<Frame> ordered;
+  ordered.reserve(frames_.size());
+
+  for (int i=0; i<frames_.size(); i++) {
+    Frame f = frames_.at((next_frame_ + i) % frames_.size());
+
+    f.viewer = nodes_.value(f.viewer_id);
+
+    for (int j=0; j<f.events.size(); j++) {
+      Event& e = f.events[j];
+      e.node = nodes_.value(e.node_id);
+    }
+
+    ordered.append(f);
+  }
+
+  return ordered;
+}
+
+QHash<const Node*, RenderProfiler::NodeCost> RenderProfiler::GetNodeCosts(const ViewerOutput *viewer) const
+{
+  QMutexLocker locker(&mutex_);
+
+  quint64 viewer_id = 0;
+
+  if (viewer) {
+    viewer_id = node_ids_.value(static_cast<const Node*>(viewer));
+
+    if (!viewer_id) {
+      // Nothing has been rendered from this viewer
+      return QHash<const Node*, NodeCost>();
+    }
+  }
+
+  QHash<quint64, NodeCost> totals;
+
+  foreach (const Frame& f, frames_) {
+    if (viewer_id && f.viewer_id != viewer_id) {
+      continue;
+    }
+
+    // A node can be traversed several times in one frame, only count the frame once
+    QHash<quint64, bool> seen;
+
+    foreach (const Event& e, f.events) {
+      if (!e.node_id || !CountsTowardsCost(e.category)) {
+        continue;
+      }
+
+      NodeCost& c = totals[e.node_id];
+
+      // The traversal's time upstream is attributed to the upstream nodes themselves
+      c.cost += (e.category == kCategoryNode) ? e.self : e.duration;
+
+      if (!seen.contains(e.node_id)) {
+        seen.insert(e.node_id, true);
+        c.frames++;
+      }
+    }
+  }
+
+  // Only report nodes that still exist
+  QHash<const Node*, NodeCost> costs;
+
+  for (auto it=totals.begin(); it!=totals.end(); it++) {
+    const Node* node = nodes_.value(it.key());
+
+    if (node) {
+      NodeCost c = it.value();
+      c.cost /= c.frames;
+      costs.insert(node, c);
+    }
+  }
+
+  return costs;
+}
+
+void RenderProfiler::Clear()
+{
+  {
+    QMutexLocker locker(&mutex_);
+
+    frames_.clear();
+    next_frame_ = 0;
+  }
+
+  emit FramesChanged();
+}
+
+bool RenderProfiler::WriteChromeTrace(const QString &filename) const
+{
+  QFile f(filename);
+
+  if (!f.open(QFile::WriteOnly)) {
+    qWarning() << "Failed to open" << filename << "for writing render profile";
+    return false;
+  }
+
+  f.write(GetChromeTrace());
+  f.close();
+
+  return true;
+}
+
+QByteArray RenderProfiler::GetChromeTrace() const
+{
+  QVector<Frame> frames = GetFrames();
+
+  QJsonArray trace_events;
+
+  // Chrome traces are in microseconds
+  auto to_us = [](qint64 ns){
+    return double(ns) / 1000.0;
+  };
+
+  auto node_id = [](const Node* n){
+    return QStringLiteral("0x%1").arg(reinterpret_cast<quintptr>(n), 0, 16);
+  };
+
+  foreach (const Frame& f, frames) {
+    qint64 tid = qint64(f.thread);
+
+    QJsonObject frame_event;
+    frame_event.insert(QStringLiteral("name"), QStringLiteral("Frame %1").arg(f.time.toDouble()));
+    frame_event.insert(QStringLiteral("cat"), QStringLiteral("frame"));
+    frame_event.insert(QStringLiteral("ph"), QStringLiteral("X"));
+    frame_event.insert(QStringLiteral("ts"), to_us(f.start));
+    frame_event.insert(QStringLiteral("dur"), to_us(f.duration));
+    frame_event.insert(QStringLiteral("pid"), 0);
+    frame_event.insert(QStringLiteral("tid"), tid);
+    trace_events.append(frame_event);
+
+    foreach (const Event& e, f.events) {
+      QJsonObject args;
+      args.insert(QStringLiteral("time"), f.time.toDouble());
+
+      if (e.node) {
+        args.insert(QStringLiteral("node"), node_id(e.node));
+      }
+
+      if (e.category == kCategoryNode) {
+        args.insert(QStringLiteral("self_us"), to_us(e.self));
+      } else if (e.category == kCategoryCache) {
+        args.insert(QStringLiteral("hit"), e.hit);
+      }
+
+      QJsonObject event;
+      event.insert(QStringLiteral("name"), e.name);
+      event.insert(QStringLiteral("cat"), GetCategoryName(e.category));
+      event.insert(QStringLiteral("ph"), QStringLiteral("X"));
+      event.insert(QStringLiteral("ts"), to_us(e.start));
+      event.insert(QStringLiteral("dur"), to_us(e.duration));
+      event.insert(QStringLiteral("pid"), 0);
+      event.insert(QStringLiteral("tid"), tid);
+      event.insert(QStringLiteral("args"), args);
+      trace_events.append(event);
+    }
+  }
+
+  // Summary of each node, named after the first event we find for it
+  QHash<const Node*, NodeCost> costs = GetNodeCosts();
+  QHash<const Node*, QString> names;
+
+  foreach (const Frame& f, frames) {
+    foreach (const Event& e, f.events) {
+      if (e.node && e.category == kCategoryNode && !names.contains(e.node)) {
+        names.insert(e.node, e.name);
+      }
+    }
+  }
+
+  QJsonArray node_costs;
+
+  for (auto it=costs.cbegin(); it!=costs.cend(); it++) {
+    QJsonObject c;
+    c.insert(QStringLiteral("node"), node_id(it.key()));
+    c.insert(QStringLiteral("name"), names.value(it.key()));
+    c.insert(QStringLiteral("cost_us"), to_us(it->cost));
+    c.insert(QStringLiteral("frames"), it->frames);
+    node_costs.append(c);
+  }
+
+  QJsonObject root;
+  root.insert(QStringLiteral("traceEvents"), trace_events);
+  root.insert(QStringLiteral("displayTimeUnit"), QStringLiteral("ms"));
+  root.insert(QStringLiteral("nodeCosts"), node_costs);
+
+  {
+    QMutexLocker locker(&mutex_);
+    root.insert(QStringLiteral("statistics"), statistics_);
+  }
+
+  return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
+
+void RenderProfiler::SetStatistics(const QString &name, const QJsonObject &stats)
+{
+  QMutexLocker locker(&mutex_);
+
+  statistics_.insert(name, stats);
+}
+
+QString RenderProfiler::GetCategoryName(Category c)
+{
+  switch (c) {
+  case kCategoryNode:
+    return QStringLiteral("node");
+  case kCategoryShader:
+    return QStringLiteral("shader");
+  case kCategoryDecode:
+    return QStringLiteral("decode");
+  case kCategoryGenerate:
+    return QStringLiteral("generate");
+  case kCategoryUpload:
+    return QStringLiteral("upload");
+  case kCategoryDownload:
+    return QStringLiteral("download");
+  case kCategoryCache:
+    return QStringLiteral("cache");
+  case kCategoryCount:
+    break;
+  }
+
+  return QString();
+}
+
+bool RenderProfiler::CountsTowardsCost(Category c)
+{
+  switch (c) {
+  case kCategoryNode:
+  case kCategoryShader:
+  case kCategoryDecode:
+  case kCategoryGenerate:
+  case kCategoryUpload:
+    return true;
+  case kCategoryDownload:
+  case kCategoryCache:
+  case kCategoryCount:
+    break;
+  }
+
+  return false;
+}
+
+void RenderProfiler::AddFrame(Frame frame)
+{
+  {
+    QMutexLocker locker(&mutex_);
+
+    // Attribute events to the nodes the user actually sees, and don't hold onto the pointers so
+    // nothing needs updating when a node is deleted
+    if (frame.viewer) {
+      frame.viewer_id = GetNodeId(frame.viewer);
+      frame.viewer = nullptr;
+    }
+
+    for (int i=0; i<frame.events.size(); i++) {
+      Event& e = frame.events[i];
+
+      if (e.node) {
+        e.node_id = GetNodeId(e.node);
+        e.node = nullptr;
+      }
+    }
+
+    if (frames_.size() < kMaximumFrames) {
+      frames_.append(frame);
+    } else {
+      frames_[next_frame_] = frame;
+      next_frame_ = (next_frame_ + 1) % kMaximumFrames;
+    }
+  }
+
+  emit FramesChanged();
+}
+
+quint64 RenderProfiler::GetNodeId(const Node *node)
+{
+  auto alias = aliases_.constFind(node);
+  if (alias != aliases_.constEnd()) {
+    return alias.value();
+  }
+
+  auto it = node_ids_.constFind(node);
+  if (it != node_ids_.constEnd()) {
+    return it.value();
+  }
+
+  quint64 id = next_node_id_++;
+  node_ids_.insert(node, id);
+  nodes_.insert(id, node);
+  return id;
+}
+
+}
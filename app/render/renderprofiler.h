@@ -0,0 +1,292 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2021 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#ifndef RENDERPROFILER_H
+#define RENDERPROFILER_H
+
+#include <QHash>
+#include <QJsonObject>
+#include <QMutex>
+#include <QObject>
+#include <QVector>
+
+#include "common/define.h"
+#include "common/rational.h"
+
+namespace olive {
+
+class Node;
+class ViewerOutput;
+
+/**
+ * @brief Records where render time goes, per frame and per node
+ *
+ * Profiling is off unless something has called Enable() (the NodeView and timeline cost overlays,
+ * or the `--profile` command line option). While it's on, every video frame RenderProcessor
+ * renders is recorded as a flat list of timed events: each node's traversal (with the time spent
+ * upstream subtracted out), shader blits, footage decodes, CPU frame generation, texture
+ * uploads/downloads, and cache hits and misses. Work is attributed to the node that asked for it
+ * even though most of it runs after the traversal (see RenderProcessor::MaterializeTexture()).
+ *
+ * The most recent kMaximumFrames frames are kept in a ring buffer, which can be summarized into
+ * per-node costs or written out as a Chrome trace (viewable in chrome://tracing or Perfetto).
+ *
+ * Renders usually run on PreviewAutoCacher's copy of the graph, so copies are registered here as
+ * aliases of the nodes they were copied from and frames are stored against the originals.
+ * Stored frames refer to nodes by an ID handed out here rather than by pointer, so forgetting a
+ * deleted node is cheap and a new node allocated at the same address starts with a clean slate.
+ *
+ * This class is thread safe.
+ */
+class RenderProfiler : public QObject
+{
+  Q_OBJECT
+public:
+  DISABLE_COPY_MOVE(RenderProfiler)
+
+  static void CreateInstance()
+  {
+    instance_ = new RenderProfiler();
+  }
+
+  static void DestroyInstance()
+  {
+    delete instance_;
+    instance_ = nullptr;
+  }
+
+  static RenderProfiler* instance()
+  {
+    return instance_;
+  }
+
+  enum Category {
+    // Traversing a node, not including its upstream nodes or its shaders
+    kCategoryNode,
+
+    // Submitting a node's shader (or a fused chain of them) to the GPU
+    kCategoryShader,
+
+    kCategoryDecode,
+
+    // Generating a frame on the CPU (e.g. rasterizing text)
+    kCategoryGenerate,
+
+    kCategoryUpload,
+    kCategoryDownload,
+
+    // Looking up a frame or texture in a cache
+    kCategoryCache,
+
+    kCategoryCount
+  };
+
+  struct Event {
+    Category category;
+
+    // Node this event is attributed to, may be null (including if it has since been deleted)
+    const Node* node;
+
+    // ID of the node in stored frames, 0 for none
+    quint64 node_id;
+
+    // Node label or other detail (e.g. the file being decoded)
+    QString name;
+
+    // In nanoseconds, see Now()
+    qint64 start;
+    qint64 duration;
+
+    // kCategoryNode only, duration minus time spent upstream and in shaders
+    qint64 self;
+
+    // kCategoryCache only
+    bool hit;
+  };
+
+  struct Frame {
+    // The ViewerOutput this frame was rendered from, and its ID in stored frames
+    const Node* viewer;
+    quint64 viewer_id;
+
+    rational time;
+    quintptr thread;
+    qint64 start;
+    qint64 duration;
+    QVector<Event> events;
+  };
+
+  struct NodeCost {
+    // Average nanoseconds per frame that this node's own traversal, shaders, decodes, frame
+    // generation and uploads took. Upstream nodes aren't included, add their costs for that.
+    qint64 cost = 0;
+
+    // Number of recorded frames this node was rendered in
+    int frames = 0;
+  };
+
+  /**
+   * @brief Collects the events of a single frame while it's rendering
+   *
+   * Events may be added from any thread (e.g. decodes on the prefetch pool).
+   */
+  class Recorder
+  {
+  public:
+    Recorder(const ViewerOutput* viewer, const rational& time);
+
+    DISABLE_COPY_MOVE(Recorder)
+
+    void AddEvent(Category category, const Node* node, const QString& name, qint64 start, qint64 end, qint64 self = 0);
+
+    void AddCacheResult(const Node* node, const QString& name, qint64 start, bool hit);
+
+    /**
+     * @brief Finish the frame and store it in the profiler
+     */
+    void Submit();
+
+  private:
+    QMutex mutex_;
+
+    Frame frame_;
+
+  };
+
+  /**
+   * @brief Monotonic time in nanoseconds that all events are measured in
+   */
+  static qint64 Now();
+
+  bool IsEnabled() const
+  {
+    return enabled_.load() > 0;
+  }
+
+  /**
+   * @brief Request profiling, calls are counted so every Enable() needs a matching Disable()
+   *
+   * Recorded frames are cleared once nothing wants profiling any more.
+   */
+  void Enable();
+  void Disable();
+
+  /**
+   * @brief Register a graph copy so its events are attributed to the node it was copied from
+   */
+  void SetAlias(const Node* copy, const Node* original);
+
+  /**
+   * @brief Forget a node that's being deleted
+   *
+   * Drops it as an alias and retires its ID, so its costs can't be attributed to a new node that
+   * happens to be allocated at the same address. This doesn't touch any recorded frames.
+   */
+  void RemoveNode(const Node* node);
+
+  /**
+   * @brief Get every recorded frame, oldest first
+   *
+   * Events of nodes that have been deleted since have a null `node`.
+   */
+  QVector<Frame> GetFrames() const;
+
+  /**
+   * @brief Summarize every recorded frame into average per-node costs
+   *
+   * If `viewer` is set, only frames rendered from that viewer are included.
+   */
+  QHash<const Node*, NodeCost> GetNodeCosts(const ViewerOutput* viewer = nullptr) const;
+
+  void Clear();
+
+  /**
+   * @brief Write all recorded frames to a Chrome trace event JSON file
+   *
+   * A per-node summary is included alongside the trace events under "nodeCosts".
+   */
+  bool WriteChromeTrace(const QString& filename) const;
+
+  QByteArray GetChromeTrace() const;
+
+  /**
+   * @brief Attach summary statistics from elsewhere in the renderer (e.g. a cache) to the trace
+   *
+   * They're written under "statistics" with this name, replacing any set before.
+   */
+  void SetStatistics(const QString& name, const QJsonObject& stats);
+
+  static QString GetCategoryName(Category c);
+
+  static const int kMaximumFrames;
+
+signals:
+  /**
+   * @brief Emitted whenever a frame is recorded or the recording is cleared
+   *
+   * This may be emitted from any thread and frequently during playback, receivers should
+   * coalesce their updates.
+   */
+  void FramesChanged();
+
+private:
+  RenderProfiler() = default;
+
+  /**
+   * @brief Whether events of this category are work done for their node, see NodeCost
+   *
+   * Downloads are of the finished frame and cache lookups are mostly waiting on other threads, so
+   * neither says much about a node.
+   */
+  static bool CountsTowardsCost(Category c);
+
+  void AddFrame(Frame frame);
+
+  /**
+   * @brief Get the ID that stored frames refer to this node by, assigning one if necessary
+   *
+   * Copies resolve to the node they were copied from. The mutex must be locked.
+   */
+  quint64 GetNodeId(const Node* node);
+
+  mutable QMutex mutex_;
+
+  QVector<Frame> frames_;
+
+  // Next index of frames_ to overwrite once the buffer is full
+  int next_frame_ = 0;
+
+  // Graph copies to the ID of the node they were copied from
+  QHash<const Node*, quint64> aliases_;
+
+  QHash<const Node*, quint64> node_ids_;
+  QHash<quint64, const Node*> nodes_;
+  quint64 next_node_id_ = 1;
+
+  QJsonObject statistics_;
+
+  QAtomicInt enabled_;
+
+  static RenderProfiler* instance_;
+
+};
+
+}
+
+#endif // RENDERPROFILER_H
@@ -0,0 +1,355 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2021 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#include "shaderfusion.h"
+
+#include <QCryptographicHash>
+#include <QRegularExpression>
+#include <QVector4D>
+
+namespace olive {
+
+QMutex ShaderFusion::fusable_mutex_;
+QHash<QString, bool> ShaderFusion::fusable_;
+
+bool ShaderFusion::CanInline(const Node *node, const ShaderJob &job)
+{
+  if (job.GetIterationCount() > 1 && !job.GetIterativeInput().isEmpty()) {
+    // Iterative shaders need to see their own output
+    return false;
+  }
+
+  QString key = GetShaderKey(node, job);
+
+  QMutexLocker locker(&fusable_mutex_);
+
+  auto it = fusable_.constFind(key);
+
+  if (it == fusable_.constEnd()) {
+    it = fusable_.insert(key, IsFusableCode(node->GetShaderCode(job.GetShaderID())));
+  }
+
+  return it.value();
+}
+
+QString ShaderFusion::GetShaderKey(const Node *node, const ShaderJob &job)
+{
+  return QStringLiteral("%1:%2").arg(node->id(), job.GetShaderID());
+}
+
+QString ShaderFusion::GetCacheKey(const QVector<Stage> &stages)
+{
+  QCryptographicHash hash(QCryptographicHash::Sha1);
+
+  for (int i=0; i<stages.size(); i++) {
+    const Stage& s = stages.at(i);
+    bool root = (i == stages.size() - 1);
+
+    hash.addData(GetShaderKey(s.node, s.job).toUtf8());
+    hash.addData(s.mapped ? "m" : "-");
+    hash.addData((!root && s.channel_count != VideoParams::kRGBAChannelCount) ? "o" : "-");
+
+    // Sort inputs so the key doesn't depend on hash ordering
+    QStringList inputs = s.inputs.keys();
+    inputs.sort();
+
+    foreach (const QString& input, inputs) {
+      hash.addData(QStringLiteral("%1=%2;").arg(input, QString::number(s.inputs.value(input))).toUtf8());
+    }
+
+    hash.addData("|");
+  }
+
+  return QStringLiteral("fused:%1").arg(QString::fromLatin1(hash.result().toHex()));
+}
+
+bool ShaderFusion::GenerateCode(const QVector<Stage> &stages, ShaderCode *code)
+{
+  QString frag = QStringLiteral("in vec2 ove_texcoord;\n"
+                                "\n"
+                                "out vec4 fragColor;\n"
+                                "\n");
+
+  for (int i=0; i<stages.size(); i++) {
+    QString stage_code;
+
+    if (!GenerateStage(i, stages.at(i), i == stages.size() - 1, &stage_code)) {
+      return false;
+    }
+
+    frag.append(stage_code);
+  }
+
+  frag.append(QStringLiteral("void main() {\n"
+                             "  fragColor = ove_fused_stage%1(ove_texcoord);\n"
+                             "}\n").arg(stages.size() - 1));
+
+  // All stages use the default vertex shader, which is what an empty string gives us
+  *code = ShaderCode(frag, QString());
+
+  return true;
+}
+
+ShaderJob ShaderFusion::MergeJobs(const QVector<Stage> &stages)
+{
+  ShaderJob merged;
+
+  for (int i=0; i<stages.size(); i++) {
+    const Stage& s = stages.at(i);
+    QString prefix = GetStagePrefix(i);
+    bool root = (i == stages.size() - 1);
+
+    for (auto it=s.job.GetValues().cbegin(); it!=s.job.GetValues().cend(); it++) {
+      const QString& id = it.key();
+
+      if (s.inputs.contains(id)) {
+        // Computed inline, but the shader may still check whether it's connected
+        merged.InsertValue(QStringLiteral("%1%2_enabled").arg(prefix, id),
+                           NodeValue(NodeValue::kBoolean, true));
+      } else if (id == QStringLiteral("ove_mvpmat")) {
+        QMatrix4x4 mvp = it.value().value<QMatrix4x4>();
+
+        if (root) {
+          merged.InsertValue(id, it.value());
+        } else if (s.mapped) {
+          merged.InsertValue(QStringLiteral("%1ove_texmat").arg(prefix),
+                             NodeValue(NodeValue::kMatrix, GenerateTextureMatrix(mvp)));
+        }
+      } else {
+        QString renamed = prefix + id;
+
+        merged.InsertValue(renamed, it.value());
+        merged.SetInterpolation(renamed, s.job.GetInterpolation(id));
+      }
+    }
+  }
+
+  const ShaderJob& root_job = stages.last().job;
+  merged.SetAlphaChannelRequired(root_job.GetAlphaChannelRequired());
+
+  if (root_job.HasRegion()) {
+    merged.SetRegion(root_job.GetRegion());
+  }
+
+  return merged;
+}
+
+bool ShaderFusion::IsFusableCode(const ShaderCode &code)
+{
+  static const QString default_vert = ShaderCode().vert_code();
+
+  if (code.vert_code() != default_vert) {
+    // The vertex stage is shared, so only shaders that leave it alone can be combined
+    return false;
+  }
+
+  const QString& frag = code.frag_code();
+
+  // These depend on where the fragment is actually drawn, which is no longer true once inlined
+  static const QRegularExpression position_dependent(QStringLiteral("\\b(gl_FragCoord|gl_FragData|dFdx|dFdy|fwidth|discard)\\b"));
+
+  if (frag.contains(position_dependent)) {
+    return false;
+  }
+
+  static const QRegularExpression main_regex(QStringLiteral("\\bvoid\\s+main\\s*\\(\\s*(void)?\\s*\\)\\s*\\{"));
+  static const QRegularExpression texcoord_regex(QStringLiteral("\\b(in|varying)\\s+vec2\\s+ove_texcoord\\s*;"));
+  static const QRegularExpression output_regex(QStringLiteral("\\bout\\s+vec4\\s+fragColor\\s*;"));
+
+  return frag.contains(main_regex)
+      && frag.contains(texcoord_regex)
+      && frag.contains(output_regex);
+}
+
+bool ShaderFusion::GenerateStage(int index, const Stage &stage, bool root, QString *out)
+{
+  ShaderCode code = stage.node->GetShaderCode(stage.job.GetShaderID());
+
+  if (!IsFusableCode(code)) {
+    return false;
+  }
+
+  QString src = code.frag_code();
+  QString prefix = GetStagePrefix(index);
+
+  // Stage functions take the coordinate as a parameter and return their color
+  src.remove(QRegularExpression(QStringLiteral("\\b(in|varying)\\s+vec2\\s+ove_texcoord\\s*;")));
+  src.remove(QRegularExpression(QStringLiteral("\\bout\\s+vec4\\s+fragColor\\s*;")));
+
+  // Prefix everything declared at the top level so stages can't collide with each other
+  QStringList names;
+
+  static const QRegularExpression uniform_regex(QStringLiteral("\\buniform\\s+(?:\\w+\\s+)*(\\w+)\\s*(?:\\[[^\\]]*\\])?\\s*;"));
+  static const QRegularExpression define_regex(QStringLiteral("^[ \\t]*#[ \\t]*define[ \\t]+(\\w+)"),
+                                               QRegularExpression::MultilineOption);
+  static const QRegularExpression const_regex(QStringLiteral("^const[ \\t]+(?:\\w+[ \\t]+)*(\\w+)\\s*="),
+                                              QRegularExpression::MultilineOption);
+  static const QRegularExpression function_regex(QStringLiteral("^(?:\\w+[ \\t]+)+(\\w+)\\s*\\("),
+                                                 QRegularExpression::MultilineOption);
+
+  static const QStringList reserved = {QStringLiteral("main"), QStringLiteral("if"),
+                                       QStringLiteral("for"), QStringLiteral("while"),
+                                       QStringLiteral("switch"), QStringLiteral("return")};
+
+  const QRegularExpression* declaration_regexes[] = {&uniform_regex, &define_regex, &const_regex, &function_regex};
+
+  for (const QRegularExpression* r : declaration_regexes) {
+    QRegularExpressionMatchIterator it = r->globalMatch(src);
+
+    while (it.hasNext()) {
+      QString name = it.next().captured(1);
+
+      if (!reserved.contains(name) && !names.contains(name)) {
+        names.append(name);
+      }
+    }
+  }
+
+  foreach (const QString& name, names) {
+    src.replace(QRegularExpression(QStringLiteral("\\b%1\\b").arg(QRegularExpression::escape(name))),
+                prefix + name);
+  }
+
+  // Replace samples of inlined inputs with calls to the stage that computes them
+  for (auto it=stage.inputs.cbegin(); it!=stage.inputs.cend(); it++) {
+    QString sampler = QRegularExpression::escape(prefix + it.key());
+
+    src.replace(QRegularExpression(QStringLiteral("\\btexture\\s*\\(\\s*%1\\s*,").arg(sampler)),
+                QStringLiteral("ove_fused_stage%1(").arg(it.value()));
+    src.remove(QRegularExpression(QStringLiteral("\\buniform\\s+sampler2D\\s+%1\\s*;").arg(sampler)));
+
+    if (src.contains(QRegularExpression(QStringLiteral("\\b%1\\b").arg(sampler)))) {
+      // The sampler is used some other way (e.g. textureSize()) that we can't emulate
+      return false;
+    }
+  }
+
+  src.replace(QRegularExpression(QStringLiteral("\\bove_texcoord\\b")), QStringLiteral("ove_stage_coord"));
+  src.replace(QRegularExpression(QStringLiteral("\\bfragColor\\b")), QStringLiteral("ove_stage_color"));
+
+  // Turn main() into a function returning the color
+  static const QRegularExpression main_regex(QStringLiteral("\\bvoid\\s+main\\s*\\(\\s*(void)?\\s*\\)\\s*\\{"));
+  QRegularExpressionMatch main_match = main_regex.match(src);
+
+  if (!main_match.hasMatch()) {
+    return false;
+  }
+
+  int body_start = main_match.capturedEnd();
+  int body_end = -1;
+  int depth = 1;
+
+  for (int i=body_start; i<src.size(); i++) {
+    if (src.at(i) == '{') {
+      depth++;
+    } else if (src.at(i) == '}') {
+      depth--;
+
+      if (depth == 0) {
+        body_end = i;
+        break;
+      }
+    }
+  }
+
+  if (body_end == -1) {
+    return false;
+  }
+
+  QString body = src.mid(body_start, body_end - body_start);
+  body.replace(QRegularExpression(QStringLiteral("\\breturn\\s*;")), QStringLiteral("return ove_stage_color;"));
+
+  QString function = QStringLiteral("vec4 ove_fused_stage%1_main(vec2 ove_stage_coord) {\n"
+                                    "  vec4 ove_stage_color = vec4(0.0);\n"
+                                    "%2\n"
+                                    "  return ove_stage_color;\n"
+                                    "}").arg(QString::number(index), body);
+
+  src.replace(main_match.capturedStart(), body_end + 1 - main_match.capturedStart(), function);
+
+  // Wrap it in the function other stages call, which emulates what sampling the intermediate
+  // texture would have given
+  QString wrapper;
+
+  if (stage.mapped && !root) {
+    wrapper = QStringLiteral("uniform mat4 %1ove_texmat;\n"
+                             "\n"
+                             "vec4 ove_fused_stage%2(vec2 ove_fused_coord) {\n"
+                             "  vec4 ove_fused_pos = %1ove_texmat * vec4(ove_fused_coord, 0.0, 1.0);\n"
+                             "  vec2 ove_fused_src = ove_fused_pos.xy / ove_fused_pos.w;\n"
+                             "  vec4 ove_fused_color = ove_fused_stage%2_main(ove_fused_src);\n"
+                             "\n"
+                             "  // Outside of the transformed quad, the intermediate would have been cleared\n"
+                             "  if (any(lessThan(ove_fused_src, vec2(0.0))) || any(greaterThan(ove_fused_src, vec2(1.0)))) {\n"
+                             "    ove_fused_color = vec4(0.0);\n"
+                             "  }\n").arg(prefix, QString::number(index));
+  } else {
+    wrapper = QStringLiteral("vec4 ove_fused_stage%1(vec2 ove_fused_coord) {\n"
+                             "  vec4 ove_fused_color = ove_fused_stage%1_main(ove_fused_coord);\n").arg(index);
+  }
+
+  if (!root && stage.channel_count != VideoParams::kRGBAChannelCount) {
+    // The intermediate would have had no alpha channel to store this in
+    wrapper.append(QStringLiteral("  ove_fused_color.a = 1.0;\n"));
+  }
+
+  wrapper.append(QStringLiteral("  return ove_fused_color;\n"
+                                "}\n"));
+
+  *out = QStringLiteral("// Stage %1: %2\n%3\n\n%4\n").arg(QString::number(index),
+                                                          GetShaderKey(stage.node, stage.job),
+                                                          src,
+                                                          wrapper);
+
+  return true;
+}
+
+QString ShaderFusion::GetStagePrefix(int index)
+{
+  return QStringLiteral("s%1_").arg(index);
+}
+
+QMatrix4x4 ShaderFusion::GenerateTextureMatrix(const QMatrix4x4 &mvp)
+{
+  bool invertible;
+  QMatrix4x4 inverse = mvp.inverted(&invertible);
+
+  if (!invertible) {
+    // The quad was degenerate so nothing was drawn, map everything outside of it
+    QMatrix4x4 outside;
+    outside.setColumn(0, QVector4D(0, 0, 0, 0));
+    outside.setColumn(1, QVector4D(0, 0, 0, 0));
+    outside.setColumn(3, QVector4D(-1, -1, 0, 1));
+    return outside;
+  }
+
+  // Destination texture coordinate to clip space
+  QMatrix4x4 to_clip;
+  to_clip.translate(-1, -1);
+  to_clip.scale(2, 2);
+
+  // Source vertex position to source texture coordinate
+  QMatrix4x4 to_texcoord;
+  to_texcoord.translate(0.5, 0.5);
+  to_texcoord.scale(0.5, 0.5);
+
+  return to_texcoord * inverse * to_clip;
+}
+
+}
@@ -0,0 +1,114 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2021 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#ifndef SHADERFUSION_H
+#define SHADERFUSION_H
+
+#include <QHash>
+#include <QMutex>
+
+#include "node/node.h"
+#include "render/job/shaderjob.h"
+#include "render/shadercode.h"
+
+namespace olive {
+
+/**
+ * @brief Compiles chains of shader jobs into a single shader
+ *
+ * Every ShaderJob normally renders to its own full-frame texture before the next node samples it.
+ * When a shader only samples an input once, at the fragment's own coordinate (see
+ * ShaderJob::SetPerPixelInput()), and that input was produced by another shader, the producer can
+ * instead be evaluated inline at that coordinate, eliminating the intermediate texture and its pass.
+ *
+ * Each inlined shader's code is turned into a function of the texture coordinate with its
+ * top-level names prefixed so stages can't collide. A matrix-only stage (e.g. a transform) that
+ * isn't the last one is applied to the coordinate rather than the vertices, so a chain of any
+ * length still draws a single quad.
+ *
+ * The generated shader only depends on the structure of the chain (which shaders, connected to
+ * which inputs), so GetCacheKey() can be used to share one compiled shader between every frame
+ * and every clip with the same chain.
+ */
+class ShaderFusion
+{
+public:
+  struct Stage {
+    const Node* node;
+    ShaderJob job;
+    int channel_count;
+
+    /// True if this stage's matrix should be applied to the texture coordinate
+    bool mapped;
+
+    /// Inputs computed inline, mapped to the index of the stage that computes them. Stages always
+    /// come after the stages they use, so the last stage is the one that's actually drawn.
+    QHash<QString, int> inputs;
+  };
+
+  /**
+   * @brief Returns whether this job's output can be computed inline by another shader
+   *
+   * This class is thread safe.
+   */
+  static bool CanInline(const Node* node, const ShaderJob& job);
+
+  /**
+   * @brief Key identifying this job's shader in the ShaderCache
+   */
+  static QString GetShaderKey(const Node* node, const ShaderJob& job);
+
+  /**
+   * @brief Key identifying the fused shader for these stages in the ShaderCache
+   */
+  static QString GetCacheKey(const QVector<Stage>& stages);
+
+  /**
+   * @brief Generate the fused shader code for these stages
+   *
+   * Returns FALSE if any stage's code couldn't be converted, in which case the stages should be
+   * rendered separately.
+   */
+  static bool GenerateCode(const QVector<Stage>& stages, ShaderCode* code);
+
+  /**
+   * @brief Combine the stages' values into a job for the fused shader
+   *
+   * Texture values are passed through untouched so the caller can swap in real textures.
+   */
+  static ShaderJob MergeJobs(const QVector<Stage>& stages);
+
+private:
+  static bool IsFusableCode(const ShaderCode& code);
+
+  static bool GenerateStage(int index, const Stage& stage, bool root, QString* out);
+
+  static QString GetStagePrefix(int index);
+
+  static QMatrix4x4 GenerateTextureMatrix(const QMatrix4x4& mvp);
+
+  static QMutex fusable_mutex_;
+
+  static QHash<QString, bool> fusable_;
+
+};
+
+}
+
+#endif // SHADERFUSION_H
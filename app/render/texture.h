@@ -22,6 +22,7 @@
 #define RENDERTEXTURE_H
 
 #include <memory>
+#include <QRectF>
 
 #include "render/videoparams.h"
 
@@ -51,7 +52,8 @@ public:
   Texture(const VideoParams& param) :
     renderer_(nullptr),
     params_(param),
-    type_(k2D)
+    type_(k2D),
+    region_(0, 0, 1, 1)
   {
   }
 
@@ -62,7 +64,8 @@ public:
     renderer_(renderer),
     params_(param),
     id_(native),
-    type_(type)
+    type_(type),
+    region_(0, 0, 1, 1)
   {
   }
 
@@ -120,6 +123,22 @@ public:
     return type_;
   }
 
+  /**
+   * @brief The part of this texture that may have visible content, in normalized texture
+   * coordinates
+   *
+   * Everything outside of it is transparent. Defaults to the whole texture.
+   */
+  const QRectF& region() const
+  {
+    return region_;
+  }
+
+  void set_region(const QRectF& r)
+  {
+    region_ = r;
+  }
+
 private:
   Renderer* renderer_;
 
@@ -129,6 +148,8 @@ private:
 
   Type type_;
 
+  QRectF region_;
+
 };
 
 using TexturePtr = std::shared_ptr<Texture>;
@@ -0,0 +1,123 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2021 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#include "texturepool.h"
+
+namespace olive {
+
+const qint64 TexturePool::kDefaultBudget = 512LL * 1024LL * 1024LL;
+
+TexturePool::TexturePool() :
+  budget_(kDefaultBudget)
+{
+}
+
+TexturePool::Key TexturePool::GetKey(const VideoParams &params)
+{
+  return {params.effective_width(), params.effective_height(), params.format(), params.channel_count()};
+}
+
+QVariant TexturePool::Take(const Key &key)
+{
+  QMutexLocker locker(&mutex_);
+
+  // Search from the most recently released since it's the most likely to still be resident
+  for (int i=entries_.size()-1; i>=0; i--) {
+    if (entries_.at(i).key == key) {
+      Entry e = entries_.takeAt(i);
+
+      stats_.hits++;
+      stats_.pooled_bytes -= e.size;
+      stats_.pooled_count--;
+
+      return e.native;
+    }
+  }
+
+  stats_.misses++;
+
+  return QVariant();
+}
+
+void TexturePool::Give(const Key &key, const QVariant &native, QVector<QVariant> *evicted)
+{
+  QMutexLocker locker(&mutex_);
+
+  Entry e = {key, native, GetSize(key)};
+
+  entries_.append(e);
+  stats_.pooled_bytes += e.size;
+  stats_.pooled_count++;
+
+  EvictToBudget(evicted);
+}
+
+QVector<QVariant> TexturePool::Clear()
+{
+  QMutexLocker locker(&mutex_);
+
+  QVector<QVariant> textures;
+  textures.reserve(entries_.size());
+
+  foreach (const Entry& e, entries_) {
+    textures.append(e.native);
+  }
+
+  entries_.clear();
+  stats_.pooled_bytes = 0;
+  stats_.pooled_count = 0;
+
+  return textures;
+}
+
+void TexturePool::SetBudget(qint64 bytes, QVector<QVariant> *evicted)
+{
+  QMutexLocker locker(&mutex_);
+
+  budget_ = bytes;
+
+  EvictToBudget(evicted);
+}
+
+TexturePool::Stats TexturePool::GetStats() const
+{
+  QMutexLocker locker(&mutex_);
+
+  return stats_;
+}
+
+qint64 TexturePool::GetSize(const Key &key)
+{
+  return qint64(key.width) * qint64(key.height) * VideoParams::GetBytesPerPixel(key.format, key.channel_count);
+}
+
+void TexturePool::EvictToBudget(QVector<QVariant> *evicted)
+{
+  while (stats_.pooled_bytes > budget_ && !entries_.isEmpty()) {
+    Entry e = entries_.takeFirst();
+
+    stats_.pooled_bytes -= e.size;
+    stats_.pooled_count--;
+    stats_.evictions++;
+
+    evicted->append(e.native);
+  }
+}
+
+}
@@ -0,0 +1,131 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2021 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#ifndef TEXTUREPOOL_H
+#define TEXTUREPOOL_H
+
+#include <QList>
+#include <QMutex>
+#include <QVariant>
+
+#include "common/define.h"
+#include "render/videoparams.h"
+
+namespace olive {
+
+/**
+ * @brief Recycles native textures between frames
+ *
+ * A frame allocates a texture for nearly every node it renders, and nearly all of them have the
+ * same dimensions and format as the last frame's. Rather than deleting a texture once its last
+ * TexturePtr is gone, Renderer hands its native handle here so the next request for a texture of
+ * the same size and format can reuse it without going through the driver.
+ *
+ * Textures are kept in the order they were released and the oldest are evicted once the pool
+ * exceeds its budget. Evicted textures are returned to the caller to destroy, since only the
+ * Renderer can do that.
+ *
+ * Recycled textures have undefined contents, just like new ones.
+ *
+ * This class is thread safe.
+ */
+class TexturePool
+{
+public:
+  TexturePool();
+
+  DISABLE_COPY_MOVE(TexturePool)
+
+  struct Key {
+    int width;
+    int height;
+    VideoParams::Format format;
+    int channel_count;
+
+    bool operator==(const Key& rhs) const
+    {
+      return width == rhs.width
+          && height == rhs.height
+          && format == rhs.format
+          && channel_count == rhs.channel_count;
+    }
+  };
+
+  struct Stats {
+    qint64 hits = 0;
+    qint64 misses = 0;
+    qint64 evictions = 0;
+    qint64 pooled_bytes = 0;
+    int pooled_count = 0;
+  };
+
+  static Key GetKey(const VideoParams& params);
+
+  /**
+   * @brief Take a texture matching this key out of the pool, or a null QVariant if there isn't one
+   */
+  QVariant Take(const Key& key);
+
+  /**
+   * @brief Return a texture to the pool
+   *
+   * Any textures that had to be evicted to stay under budget are appended to `evicted`.
+   */
+  void Give(const Key& key, const QVariant& native, QVector<QVariant>* evicted);
+
+  /**
+   * @brief Empty the pool, returning every texture that was in it
+   */
+  QVector<QVariant> Clear();
+
+  qint64 GetBudget() const
+  {
+    return budget_;
+  }
+
+  void SetBudget(qint64 bytes, QVector<QVariant>* evicted);
+
+  Stats GetStats() const;
+
+  static const qint64 kDefaultBudget;
+
+private:
+  struct Entry {
+    Key key;
+    QVariant native;
+    qint64 size;
+  };
+
+  static qint64 GetSize(const Key& key);
+
+  void EvictToBudget(QVector<QVariant>* evicted);
+
+  mutable QMutex mutex_;
+
+  QList<Entry> entries_;
+
+  qint64 budget_;
+
+  Stats stats_;
+
+};
+
+}
+
+#endif // TEXTUREPOOL_H
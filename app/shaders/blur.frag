@@ -6,6 +6,12 @@ uniform bool vert_in;
 uniform bool repeat_edge_pixels_in;
 uniform vec2 resolution_in;
 
+// Large radius plan (see BlurFilterNode::PlanBlur), boxes is 0 if sampling the radius directly
+uniform int blur_boxes_in;
+uniform int blur_box_width_in;
+uniform int blur_taps_in;
+uniform int blur_passes_in;
+
 uniform int ove_iteration;
 
 in vec2 ove_texcoord;
@@ -35,6 +41,14 @@ float gaussian2(float x, float y, float sigma) {
     return (1.0/((sigma*sigma)*2.0*M_PI))*exp(-0.5*(((x*x) + (y*y))/(sigma*sigma)));
 }
 
+int passes_per_axis() {
+    if (blur_boxes_in == 0) {
+        return 1;
+    }
+
+    return blur_boxes_in * blur_passes_in;
+}
+
 int determine_mode() {
     if (radius_in == 0.0) {
         return MODE_NONE;
@@ -52,13 +66,55 @@ int determine_mode() {
         return MODE_VERTICAL;
     }
 
-    if (ove_iteration == 0) {
+    // Blurring both, every pass along the horizontal axis runs before the vertical ones
+    if (ove_iteration < passes_per_axis()) {
         return MODE_HORIZONTAL;
+    } else {
+        return MODE_VERTICAL;
     }
+}
 
-    if (ove_iteration == 1) {
-        return MODE_VERTICAL;
+// Samples one pass of a box filter, the box being split into sparse passes whose strides grow by
+// a factor of blur_taps_in, so large boxes only cost a handful of samples per pass
+vec4 box_pass(int mode) {
+    int pass = ove_iteration % passes_per_axis() % blur_passes_in;
+
+    int stride = 1;
+    for (int i = 0; i < pass; i++) {
+        stride *= blur_taps_in;
+    }
+
+    int taps = blur_taps_in;
+    if (pass == blur_passes_in - 1) {
+        // Last pass makes up the rest of the box width
+        taps = max(1, int(floor(float(blur_box_width_in) / float(stride) + 0.5)));
+    }
+
+    vec2 step;
+    if (mode == MODE_HORIZONTAL) {
+        step = vec2(float(stride) / resolution_in.x, 0.0);
+    } else {
+        step = vec2(0.0, float(stride) / resolution_in.y);
+    }
+
+    float weight = 1.0 / float(taps);
+    float first = -0.5 * float(taps - 1);
+
+    vec4 composite = vec4(0.0);
+
+    for (int i = 0; i < taps; i++) {
+        vec2 pixel_coord = ove_texcoord + step * (first + float(i));
+
+        if (repeat_edge_pixels_in
+            || (pixel_coord.x >= 0.0
+                && pixel_coord.x < 1.0
+                && pixel_coord.y >= 0.0
+                && pixel_coord.y < 1.0)) {
+            composite += texture(tex_in, pixel_coord) * weight;
+        }
     }
+
+    return composite;
 }
 
 void main(void) {
@@ -69,6 +125,11 @@ void main(void) {
         return;
     }
 
+    if (blur_boxes_in > 0) {
+        fragColor = box_pass(mode);
+        return;
+    }
+
     // We only sample on hard pixels, so we don't accept decimal radii
     float real_radius = ceil(radius_in);
 
@@ -22,6 +22,7 @@
 
 #include "common/timecodefunctions.h"
 #include "node/color/colormanager/colormanager.h"
+#include "node/graph.h"
 
 namespace olive {
 
@@ -33,6 +34,23 @@ ExportTask::ExportTask(ViewerOutput *viewer_node,
   params_(params)
 {
   SetTitle(tr("Exporting \"%1\"").arg(viewer_node->GetLabel()));
+
+  // Sample keyframes once per output frame up front, rather than evaluating them for every frame
+  // and every hash. This happens here, on the main thread, before any render job can read them.
+  rational timebase = params.video_params().frame_rate_as_time_base();
+  foreach (Node* n, viewer_node->parent()->nodes()) {
+    n->BakeKeyframes(timebase);
+  }
+}
+
+ExportTask::~ExportTask()
+{
+  // Tasks are deleted on the main thread after rendering has finished, so nothing is reading the
+  // tables anymore. They're only useful at the export's frame rate, so don't leave them in the
+  // live graph taking up memory.
+  foreach (Node* n, viewer()->parent()->nodes()) {
+    n->ClearBakedKeyframes();
+  }
 }
 
 bool ExportTask::Run()
@@ -35,6 +35,8 @@ class ExportTask : public RenderTask
 public:
   ExportTask(ViewerOutput *viewer_node, ColorManager *color_manager, const ExportParams &params);
 
+  virtual ~ExportTask() override;
+
 protected:
   virtual bool Run() override;
 
@@ -0,0 +1,162 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2021 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "proxy.h"
+
+#include <QFile>
+
+#include "codec/decoder.h"
+#include "codec/encoder.h"
+#include "common/filefunctions.h"
+#include "common/timecodefunctions.h"
+#include "node/project/project.h"
+
+namespace olive {
+
+ProxyTask::ProxyTask(Footage *footage, int index, int divider) :
+  params_(footage->GetVideoParams(index)),
+  filename_(footage->filename()),
+  decoder_id_(footage->decoder()),
+  cache_path_(footage->project()->cache_path()),
+  index_(index),
+  divider_(divider)
+{
+  SetTitle(tr("Generating 1/%1 Proxy %2:%3").arg(QString::number(divider_),
+                                                 filename_,
+                                                 QString::number(index_)));
+}
+
+bool ProxyTask::Run()
+{
+  const VideoParams& vp = params_;
+
+  if (vp.video_type() != VideoParams::kVideoTypeVideo) {
+    SetError(tr("Proxies can only be generated for video streams"));
+    return false;
+  }
+
+  Decoder::CodecStream stream(filename_, vp.stream_index());
+  QString proxy_fn = Decoder::GetProxyFilename(cache_path_, stream, divider_);
+
+  if (QFileInfo::exists(proxy_fn)) {
+    // Nothing to do, this proxy has already been generated
+    return true;
+  }
+
+  DecoderPtr decoder = Decoder::CreateFromID(decoder_id_);
+
+  if (!decoder || !decoder->Open(stream)) {
+    SetError(tr("Failed to open decoder for \"%1\"").arg(filename_));
+    return false;
+  }
+
+  // Like conforming, we encode to a different filename until it's done so that the renderer never
+  // picks up an incomplete proxy. The extension is kept so FFmpeg can still guess the container.
+  QString working_fn = proxy_fn;
+  working_fn.insert(working_fn.lastIndexOf('.'), QStringLiteral(".working"));
+
+  // Scaling interleaved fields together blends them, so de-interlace before the decoder scales.
+  // The renderer knows proxies are progressive and won't de-interlace them again.
+  Decoder::RetrieveVideoParams rvp;
+  rvp.divider = divider_;
+  rvp.src_interlacing = vp.interlacing();
+  rvp.dst_interlacing = VideoParams::kInterlaceNone;
+
+  rational frame_length = vp.frame_rate_as_time_base();
+  rational length = Timecode::timestamp_to_time(vp.duration(), vp.time_base());
+
+  Encoder* encoder = nullptr;
+  bool success = true;
+
+  for (rational t=0; t<length; t+=frame_length) {
+    if (IsCancelled()) {
+      success = false;
+      break;
+    }
+
+    FramePtr frame = decoder->RetrieveVideo(t, rvp);
+
+    if (!frame) {
+      SetError(tr("Failed to decode frame at %1").arg(t.toDouble()));
+      success = false;
+      break;
+    }
+
+    if (!encoder) {
+      // Set up the encoder now that we know what the decoder produces
+      VideoParams proxy_params(frame->width(), frame->height(), frame_length,
+                               frame->format(), frame->channel_count(),
+                               vp.pixel_aspect_ratio(), VideoParams::kInterlaceNone);
+
+      EncodingParams params;
+      params.SetFilename(working_fn);
+      params.EnableVideo(proxy_params, ExportCodec::kCodecProRes);
+
+      // ProRes is intra-frame only, so every proxy frame can be decoded without any GOP overhead
+      if (frame->channel_count() == VideoParams::kRGBAChannelCount) {
+        params.set_video_pix_fmt(QStringLiteral("yuva444p10le"));
+        params.set_video_option(QStringLiteral("profile"), QStringLiteral("4"));
+      } else {
+        params.set_video_pix_fmt(QStringLiteral("yuv422p10le"));
+        params.set_video_option(QStringLiteral("profile"), QStringLiteral("0"));
+      }
+
+      encoder = Encoder::CreateFromID(QString(), params);
+
+      if (!encoder->Open()) {
+        SetError(tr("Failed to open proxy file for writing: %1").arg(encoder->GetError()));
+        success = false;
+        break;
+      }
+    }
+
+    if (!encoder->WriteFrame(frame, t)) {
+      SetError(tr("Failed to encode proxy frame: %1").arg(encoder->GetError()));
+      success = false;
+      break;
+    }
+
+    emit ProgressChanged(t.toDouble() / length.toDouble());
+  }
+
+  if (encoder) {
+    encoder->Close();
+    delete encoder;
+  }
+
+  decoder->Close();
+
+  if (success) {
+    // Move file to standard proxy name, making it available to the renderer
+    if (!FileFunctions::RenameFileAllowOverwrite(working_fn, proxy_fn)) {
+      SetError(tr("Failed to move proxy into place at \"%1\"").arg(proxy_fn));
+      success = false;
+    }
+  }
+
+  if (!success) {
+    QFile::remove(working_fn);
+  }
+
+  // A cancelled proxy isn't an error, it just won't be used
+  return success || IsCancelled();
+}
+
+}
@@ -0,0 +1,66 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2021 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#ifndef PROXYTASK_H
+#define PROXYTASK_H
+
+#include "node/project/footage/footage.h"
+#include "render/videoparams.h"
+#include "task/task.h"
+
+namespace olive {
+
+/**
+ * @brief Transcodes a video stream to a reduced-resolution intra-frame proxy in the project cache
+ *
+ * Proxies are only used by preview renders whose divider is a multiple of the proxy's divider,
+ * exports will always decode the original media. Interlaced sources are de-interlaced before
+ * scaling so the proxy is always progressive.
+ *
+ * Everything needed from the footage is captured on construction, the footage itself is never
+ * touched from the task's thread.
+ */
+class ProxyTask : public Task
+{
+  Q_OBJECT
+public:
+  ProxyTask(Footage* footage, int index, int divider);
+
+protected:
+  virtual bool Run() override;
+
+private:
+  VideoParams params_;
+
+  QString filename_;
+
+  QString decoder_id_;
+
+  QString cache_path_;
+
+  int index_;
+
+  int divider_;
+
+};
+
+}
+
+#endif // PROXYTASK_H
@@ -67,7 +67,7 @@ bool RenderTask::Render(ColorManager* manager,
     RenderTicketWatcher* watcher = new RenderTicketWatcher();
     watcher->setProperty("range", QVariant::fromValue(r));
     PrepareWatcher(watcher, &watcher_thread);
-    watcher->SetTicket(RenderManager::instance()->RenderAudio(viewer_, r, audio_params_, false));
+    watcher->SetTicket(RenderManager::instance()->RenderAudio(viewer_, r, audio_params_, false, RenderManager::kPriorityExport));
   }
 
   // Look up hashes
@@ -222,7 +222,8 @@ void RenderTask::DownloadFrame(QThread *thread, FramePtr frame, const QByteArray
 
   watcher->SetTicket(RenderManager::instance()->SaveFrameToCache(viewer_->video_frame_cache(),
                                                                  frame,
-                                                                 hash));
+                                                                 hash,
+                                                                 RenderManager::kPriorityExport));
 }
 
 void RenderTask::PrepareWatcher(RenderTicketWatcher *watcher, QThread *thread)
@@ -254,7 +255,7 @@ void RenderTask::StartTicket(const QByteArray& hash, QThread* watcher_thread, Co
                                                             mode, video_params_, audio_params_,
                                                             force_size, force_matrix,
                                                             force_format, force_color_output,
-                                                            cache));
+                                                            cache, RenderManager::kPriorityExport));
 }
 
 void RenderTask::TicketDone(RenderTicketWatcher* watcher)
@@ -20,10 +20,14 @@
 
 #include "threadpool.h"
 
+#include <limits>
+#include <QElapsedTimer>
+
 namespace olive {
 
 ThreadPool::ThreadPool(QThread::Priority priority, int threads, QObject *parent) :
-  QObject(parent)
+  QObject(parent),
+  next_sequence_(0)
 {
   all_threads_.resize(threads ? threads : QThread::idealThreadCount());
 
@@ -56,36 +60,145 @@ ThreadPool::~ThreadPool()
 
 bool ThreadPool::RemoveTicket(RenderTicketPtr ticket)
 {
-  auto it = std::find(ticket_queue_.begin(), ticket_queue_.end(), ticket);
-  if (it == ticket_queue_.end()) {
+  if (!queued_tickets_.contains(ticket.get())) {
     return false;
   }
 
-  ticket_queue_.erase(it);
+  QueuedTicket q = Unqueue(ticket.get());
+  queues_[q.priority].stats.removed++;
+
+  return true;
+}
+
+bool ThreadPool::PromoteTicket(RenderTicketPtr ticket, Priority priority, qint64 deadline)
+{
+  auto it = queued_tickets_.constFind(ticket.get());
+  if (it == queued_tickets_.constEnd()) {
+    return false;
+  }
+
+  bool more_urgent = priority < it->priority
+      || (priority == kPriorityPlayback && it->priority == kPriorityPlayback
+          && deadline > 0 && (it->deadline == 0 || deadline < it->deadline));
+
+  if (!more_urgent) {
+    return false;
+  }
+
+  QueuedTicket q = Unqueue(ticket.get());
+
+  ticket->setProperty("priority", priority);
+  ticket->setProperty("deadline", deadline);
+
+  // Keep the original queue time so the wait is still measured from when it was first requested
+  queues_[priority].stats.queued++;
+  Enqueue(ticket, q.queued_time);
+
   return true;
 }
 
-void ThreadPool::AddTicket(RenderTicketPtr ticket, bool prioritize)
+QString ThreadPool::GetPriorityName(Priority priority)
 {
-  if (prioritize) {
-    ticket_queue_.push_front(ticket);
-  } else {
-    ticket_queue_.push_back(ticket);
+  switch (priority) {
+  case kPriorityInteractive:
+    return tr("Interactive");
+  case kPriorityPlayback:
+    return tr("Playback");
+  case kPriorityExport:
+    return tr("Export");
+  case kPriorityBackground:
+    return tr("Background");
+  case kPriorityCount:
+    break;
   }
 
+  return QString();
+}
+
+qint64 ThreadPool::Now()
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  // Milliseconds since the monotonic clock's reference point (e.g. boot), which keeps it well
+  // clear of 0, since a deadline of 0 means there isn't one
+  return timer.msecsSinceReference();
+}
+
+void ThreadPool::AddTicket(RenderTicketPtr ticket)
+{
+  if (queued_tickets_.contains(ticket.get())) {
+    return;
+  }
+
+  Priority priority = Enqueue(ticket, Now());
+  queues_[priority].stats.queued++;
+
   RunNext();
 }
 
+ThreadPool::Priority ThreadPool::Enqueue(RenderTicketPtr ticket, qint64 queued_time)
+{
+  QueuedTicket q;
+
+  QVariant priority = ticket->property("priority");
+  q.priority = priority.isValid() ? static_cast<Priority>(priority.toInt()) : kPriorityBackground;
+  q.owner = static_cast<quintptr>(ticket->property("owner").toULongLong());
+  q.queued_time = queued_time;
+  q.deadline = ticket->property("deadline").toLongLong();
+  q.key.sequence = next_sequence_++;
+
+  switch (q.priority) {
+  case kPriorityInteractive:
+    // Newest first
+    q.key.order = -q.key.sequence;
+    break;
+  case kPriorityPlayback:
+    // Earliest deadline first, anything without one goes after those that have one
+    q.key.order = (q.deadline > 0) ? q.deadline : std::numeric_limits<qint64>::max();
+    break;
+  default:
+    // Oldest first
+    q.key.order = 0;
+    break;
+  }
+
+  PriorityQueue& queue = queues_[q.priority];
+  queue.owners[q.owner].insert({q.key, ticket});
+  queue.stats.depth++;
+
+  queued_tickets_.insert(ticket.get(), q);
+
+  return q.priority;
+}
+
+ThreadPool::QueuedTicket ThreadPool::Unqueue(RenderTicket *ticket)
+{
+  QueuedTicket q = queued_tickets_.take(ticket);
+  PriorityQueue& queue = queues_[q.priority];
+
+  auto owner = queue.owners.find(q.owner);
+  owner->second.erase(q.key);
+  if (owner->second.empty()) {
+    queue.owners.erase(owner);
+  }
+
+  queue.stats.depth--;
+
+  return q;
+}
+
 void ThreadPool::RunNext()
 {
-  while (!ticket_queue_.empty() && !available_threads_.empty()) {
-    // Run function
-    RenderTicketPtr ticket = ticket_queue_.front();
-    ticket_queue_.pop_front();
+  while (!queued_tickets_.isEmpty() && !available_threads_.empty()) {
+    Priority priority;
+    RenderTicketPtr ticket = TakeNext(&priority);
 
     ThreadPoolThread* thread = available_threads_.front();
     available_threads_.pop_front();
 
+    running_tickets_.insert(thread, {priority, Now()});
+
     // Move ticket to other thread so event processing can occur there
     ticket->Start();
     ticket->moveToThread(thread);
@@ -95,10 +208,67 @@ void ThreadPool::RunNext()
   }
 }
 
+RenderTicketPtr ThreadPool::TakeNext(Priority *priority)
+{
+  for (int i=0; i<kPriorityCount; i++) {
+    PriorityQueue& queue = queues_[i];
+
+    if (queue.owners.empty()) {
+      continue;
+    }
+
+    std::map<quintptr, OwnerQueue>::iterator owner;
+
+    if (i == kPriorityPlayback) {
+      // Whichever owner has the most urgent frame
+      owner = queue.owners.begin();
+      for (auto it=queue.owners.begin(); it!=queue.owners.end(); it++) {
+        if (it->second.begin()->first < owner->second.begin()->first) {
+          owner = it;
+        }
+      }
+    } else {
+      // Take turns, starting from the owner after the one that went last
+      owner = queue.owners.upper_bound(queue.last_owner);
+      if (owner == queue.owners.end()) {
+        owner = queue.owners.begin();
+      }
+    }
+
+    RenderTicketPtr ticket = owner->second.begin()->second;
+    queue.last_owner = owner->first;
+
+    QueuedTicket q = Unqueue(ticket.get());
+    qint64 now = Now();
+    qint64 wait = now - q.queued_time;
+
+    queue.stats.started++;
+    queue.stats.total_wait += wait;
+    queue.stats.max_wait = qMax(queue.stats.max_wait, wait);
+
+    if (q.deadline > 0 && now > q.deadline) {
+      queue.stats.missed_deadlines++;
+    }
+
+    *priority = static_cast<Priority>(i);
+    return ticket;
+  }
+
+  return nullptr;
+}
+
 void ThreadPool::ThreadDone()
 {
   ThreadPoolThread* thread = static_cast<ThreadPoolThread*>(sender());
 
+  auto running = running_tickets_.find(thread);
+  if (running != running_tickets_.end()) {
+    QueueStats& stats = queues_[running->priority].stats;
+    stats.completed++;
+    stats.total_run += Now() - running->start_time;
+    running_tickets_.erase(running);
+  }
+
   available_threads_.push_back(thread);
 
   RunNext();
@@ -21,6 +21,8 @@
 #ifndef THREADPOOL_H
 #define THREADPOOL_H
 
+#include <map>
+#include <QHash>
 #include <QThread>
 
 #include "common/cancelableobject.h"
@@ -30,6 +32,21 @@ namespace olive {
 
 class ThreadPoolThread;
 
+/**
+ * @brief Runs RenderTickets on a fixed set of threads in order of priority
+ *
+ * Every ticket is queued in one of the Priority classes, read from its "priority" property
+ * (kPriorityBackground if unset). Higher classes always run before lower ones. Within a class,
+ * tickets are shared between their owners (the "owner" property, e.g. the viewer they're for) so
+ * one viewer's backlog can't starve another's:
+ *
+ * * kPriorityInteractive runs the newest ticket first, since older requests are usually stale
+ * * kPriorityPlayback runs the earliest "deadline" (see Now()) first across all owners
+ * * kPriorityExport and kPriorityBackground take turns between owners, oldest first
+ *
+ * Queueing and removing tickets are O(log n). Per-class queue depth and latency are kept in
+ * QueueStats.
+ */
 class ThreadPool : public QObject
 {
   Q_OBJECT
@@ -38,23 +55,132 @@ public:
 
   virtual ~ThreadPool() override;
 
+  enum Priority {
+    /// A frame the user is waiting on right now, e.g. while scrubbing
+    kPriorityInteractive,
+
+    /// A frame a playing viewer will need by its deadline
+    kPriorityPlayback,
+
+    /// Work for an export the user started
+    kPriorityExport,
+
+    /// Speculative work like auto-caching
+    kPriorityBackground,
+
+    kPriorityCount
+  };
+
+  struct QueueStats {
+    /// Tickets currently queued
+    int depth = 0;
+
+    qint64 queued = 0;
+    qint64 started = 0;
+    qint64 removed = 0;
+    qint64 completed = 0;
+
+    /// Milliseconds tickets spent queued before starting
+    qint64 total_wait = 0;
+    qint64 max_wait = 0;
+
+    /// Milliseconds tickets spent running
+    qint64 total_run = 0;
+
+    /// Tickets that started after their deadline had passed
+    qint64 missed_deadlines = 0;
+  };
+
   RenderTicketPtr Queue();
 
   virtual void RunTicket(RenderTicketPtr ticket) const = 0;
 
   bool RemoveTicket(RenderTicketPtr ticket);
 
+  /**
+   * @brief Move a queued ticket up to a more urgent class or an earlier deadline
+   *
+   * Returns false if the ticket isn't queued or is already at least as urgent.
+   */
+  bool PromoteTicket(RenderTicketPtr ticket, Priority priority, qint64 deadline = 0);
+
+  QueueStats GetQueueStats(Priority priority) const
+  {
+    return queues_[priority].stats;
+  }
+
+  static QString GetPriorityName(Priority priority);
+
+  /**
+   * @brief Monotonic time in milliseconds that deadlines and queue latency are measured in
+   *
+   * Unlike wall clock time, this can't jump if the system clock is changed during playback.
+   */
+  static qint64 Now();
+
+  int GetThreadCount() const
+  {
+    return all_threads_.size();
+  }
+
 public slots:
-  void AddTicket(olive::RenderTicketPtr ticket, bool prioritize = false);
+  void AddTicket(olive::RenderTicketPtr ticket);
 
 private:
   void RunNext();
 
+  RenderTicketPtr TakeNext(Priority* priority);
+
+  struct QueueKey {
+    qint64 order;
+    qint64 sequence;
+
+    bool operator<(const QueueKey& rhs) const
+    {
+      return order < rhs.order || (order == rhs.order && sequence < rhs.sequence);
+    }
+  };
+
+  // One owner's tickets within a class, in the order they should run
+  using OwnerQueue = std::map<QueueKey, RenderTicketPtr>;
+
+  struct PriorityQueue {
+    std::map<quintptr, OwnerQueue> owners;
+
+    // Owner that was served last, for taking turns
+    quintptr last_owner = 0;
+
+    QueueStats stats;
+  };
+
+  struct QueuedTicket {
+    Priority priority;
+    quintptr owner;
+    QueueKey key;
+    qint64 queued_time;
+    qint64 deadline;
+  };
+
+  struct RunningTicket {
+    Priority priority;
+    qint64 start_time;
+  };
+
+  Priority Enqueue(RenderTicketPtr ticket, qint64 queued_time);
+
+  QueuedTicket Unqueue(RenderTicket* ticket);
+
   QVector<ThreadPoolThread*> all_threads_;
 
   std::list<ThreadPoolThread*> available_threads_;
 
-  std::list<RenderTicketPtr> ticket_queue_;
+  PriorityQueue queues_[kPriorityCount];
+
+  QHash<RenderTicket*, QueuedTicket> queued_tickets_;
+
+  QHash<ThreadPoolThread*, RunningTicket> running_tickets_;
+
+  qint64 next_sequence_;
 
 private slots:
   void ThreadDone();
@@ -25,7 +25,8 @@ namespace olive {
 RenderTicket::RenderTicket() :
   is_running_(false),
   has_result_(false),
-  finish_count_(0)
+  finish_count_(0),
+  run_time_(0)
 {
   SetJobTime();
 }
@@ -44,6 +45,7 @@ void RenderTicket::Start()
   is_running_ = true;
   has_result_ = false;
   result_.clear();
+  run_timer_.start();
 }
 
 void RenderTicket::Finish()
@@ -102,6 +104,13 @@ int RenderTicket::GetFinishCount(bool lock)
   return count;
 }
 
+qint64 RenderTicket::GetRunTime()
+{
+  QMutexLocker locker(&lock_);
+
+  return run_time_;
+}
+
 bool RenderTicket::HasResult()
 {
   QMutexLocker locker(&lock_);
@@ -117,6 +126,7 @@ void RenderTicket::FinishInternal(bool has_result, QVariant result)
     qWarning() << "Tried to finish ticket that wasn't running";
   } else {
     is_running_ = false;
+    run_time_ = run_timer_.elapsed();
     has_result_ = has_result;
     result_ = result;
     finish_count_++;
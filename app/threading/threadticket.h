@@ -22,6 +22,7 @@
 #define RENDERTICKET_H
 
 #include <QDateTime>
+#include <QElapsedTimer>
 #include <QMutex>
 #include <QWaitCondition>
 
@@ -64,6 +65,13 @@ public:
    */
   int GetFinishCount(bool lock = true);
 
+  /**
+   * @brief How long the ticket ran for in milliseconds, from Start() until it finished
+   *
+   * Unlike the job time, this doesn't include any time the ticket spent waiting in a queue.
+   */
+  qint64 GetRunTime();
+
   /**
    * @brief Check if this ticket has a result
    *
@@ -139,6 +147,10 @@ private:
 
   qint64 job_time_;
 
+  QElapsedTimer run_timer_;
+
+  qint64 run_time_;
+
 };
 
 using RenderTicketPtr = std::shared_ptr<RenderTicket>;
@@ -21,6 +21,7 @@
 #include "undocommand.h"
 
 #include "core.h"
+#include "node/invalidationbatcher.h"
 
 namespace olive {
 
@@ -40,7 +41,10 @@ void MultiUndoCommand::undo()
 
 void UndoCommand::redo_and_set_modified()
 {
+  // Commands often change several values at once, only propagate the merged result
+  InvalidationBatcher::Begin();
   redo();
+  InvalidationBatcher::End();
 
   project_ = GetRelevantProject();
   if (project_) {
@@ -51,7 +55,9 @@ void UndoCommand::redo_and_set_modified()
 
 void UndoCommand::undo_and_set_modified()
 {
+  InvalidationBatcher::Begin();
   undo();
+  InvalidationBatcher::End();
 
   if (project_) {
     project_->set_modified(modified_);
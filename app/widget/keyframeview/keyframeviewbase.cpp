@@ -26,6 +26,7 @@
 
 #include "dialog/keyframeproperties/keyframeproperties.h"
 #include "keyframeviewundo.h"
+#include "node/invalidationbatcher.h"
 #include "node/node.h"
 #include "widget/menu/menu.h"
 #include "widget/menu/menushared.h"
@@ -313,6 +314,8 @@ void KeyframeViewBase::mouseMoveEvent(QMouseEvent *event)
           }
         }
 
+        // Moving several keyframes invalidates overlapping ranges, merge them into one pass
+        InvalidationBatcher::Begin();
         foreach (const KeyframeItemAndTime& keypair, selected_keys_) {
           rational node_time = GetAdjustedTime(GetTimeTarget(),
                                                keypair.key->key()->parent(),
@@ -325,6 +328,7 @@ void KeyframeViewBase::mouseMoveEvent(QMouseEvent *event)
             keypair.key->key()->set_value(keypair.value - mouse_diff_scaled.y());
           }
         }
+        InvalidationBatcher::End();
 
         // Show information about this keyframe
         QString tip = Timecode::time_to_timecode(initial_drag_item_->key()->time(), timebase(),
@@ -28,6 +28,7 @@
 #include "nodeviewundo.h"
 #include "node/factory.h"
 #include "node/traverser.h"
+#include "render/renderprofiler.h"
 #include "widget/menu/menushared.h"
 #include "widget/timebased/timebasedview.h"
 
@@ -45,7 +46,8 @@ NodeView::NodeView(QWidget *parent) :
   create_edge_dst_(nullptr),
   create_edge_dst_temp_expanded_(false),
   filter_mode_(kFilterShowSelectedBlocks),
-  scale_(1.0)
+  scale_(1.0),
+  show_render_cost_(false)
 {
   setScene(&scene_);
   SetDefaultDragMode(RubberBandDrag);
@@ -64,10 +66,18 @@ NodeView::NodeView(QWidget *parent) :
   scene_.setSceneRect(-1000000, -1000000, 2000000, 2000000);
   setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
   setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+
+  // Frames arrive from the profiler at playback rate, coalesce them so we don't repaint constantly
+  render_cost_timer_.setSingleShot(true);
+  render_cost_timer_.setInterval(250);
+  connect(&render_cost_timer_, &QTimer::timeout, this, &NodeView::UpdateRenderCosts);
 }
 
 NodeView::~NodeView()
 {
+  // Release our hold on the profiler
+  SetShowRenderCost(false);
+
   // Unset the current graph
   SetGraph(nullptr);
 }
@@ -346,6 +356,30 @@ void NodeView::ZoomOut()
   ZoomFromKeyboard(0.8);
 }
 
+void NodeView::SetShowRenderCost(bool e)
+{
+  if (show_render_cost_ == e) {
+    return;
+  }
+
+  show_render_cost_ = e;
+
+  if (show_render_cost_) {
+    RenderProfiler::instance()->Enable();
+    connect(RenderProfiler::instance(), &RenderProfiler::FramesChanged, this, [this](){
+      if (!render_cost_timer_.isActive()) {
+        render_cost_timer_.start();
+      }
+    });
+  } else {
+    disconnect(RenderProfiler::instance(), &RenderProfiler::FramesChanged, this, nullptr);
+    RenderProfiler::instance()->Disable();
+    render_cost_timer_.stop();
+  }
+
+  UpdateRenderCosts();
+}
+
 void NodeView::keyPressEvent(QKeyEvent *event)
 {
   super::keyPressEvent(event);
@@ -727,6 +761,11 @@ void NodeView::ShowContextMenu(const QPoint &pos)
     curved_action->setChecked(scene_.GetEdgesAreCurved());
     connect(curved_action, &QAction::triggered, &scene_, &NodeViewScene::SetEdgesAreCurved);
 
+    QAction* render_cost_action = m.addAction(tr("Show Render Cost"));
+    render_cost_action->setCheckable(true);
+    render_cost_action->setChecked(show_render_cost_);
+    connect(render_cost_action, &QAction::triggered, this, &NodeView::SetShowRenderCost);
+
     m.addSeparator();
 
     Menu* filter_menu = new Menu(tr("Filter"), &m);
@@ -818,6 +857,37 @@ void NodeView::OpenSelectedNodeInViewer()
   }
 }
 
+void NodeView::UpdateRenderCosts()
+{
+  QHash<const Node*, RenderProfiler::NodeCost> costs;
+
+  if (show_render_cost_) {
+    costs = RenderProfiler::instance()->GetNodeCosts();
+  }
+
+  // Shade relative to the most expensive node we're showing
+  qint64 max_cost = 0;
+
+  for (auto it=scene_.item_map().cbegin(); it!=scene_.item_map().cend(); it++) {
+    auto cost = costs.constFind(it.key());
+
+    if (cost != costs.constEnd()) {
+      max_cost = qMax(max_cost, cost->cost);
+    }
+  }
+
+  for (auto it=scene_.item_map().cbegin(); it!=scene_.item_map().cend(); it++) {
+    auto cost = costs.constFind(it.key());
+
+    if (cost == costs.constEnd()) {
+      it.value()->SetRenderCost(-1.0, 0);
+    } else {
+      double share = (max_cost > 0) ? double(cost->cost) / double(max_cost) : 0.0;
+      it.value()->SetRenderCost(share, cost->cost);
+    }
+  }
+}
+
 void NodeView::AttachNodesToCursor(const QVector<Node *> &nodes)
 {
   QVector<NodeViewItem*> items(nodes.size());
@@ -78,6 +78,11 @@ public:
 
   void ZoomOut();
 
+  /**
+   * @brief Shade nodes by how long they took to render in recently profiled frames
+   */
+  void SetShowRenderCost(bool e);
+
 signals:
   void NodesSelected(const QVector<Node*>& nodes);
 
@@ -164,6 +169,10 @@ private:
 
   bool create_edge_already_exists_;
 
+  bool show_render_cost_;
+
+  QTimer render_cost_timer_;
+
   static const double kMinimumScale;
 
 private slots:
@@ -202,6 +211,11 @@ private slots:
    */
   void OpenSelectedNodeInViewer();
 
+  /**
+   * @brief Applies the profiler's latest per-node costs to the items in the scene
+   */
+  void UpdateRenderCosts();
+
 };
 
 }
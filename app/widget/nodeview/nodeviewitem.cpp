@@ -45,6 +45,8 @@ NodeViewItem::NodeViewItem(QGraphicsItem *parent) :
   expanded_(false),
   hide_titlebar_(false),
   highlighted_index_(-1),
+  render_cost_share_(-1.0),
+  render_cost_(0),
   flow_dir_(NodeViewCommon::kLeftToRight)
 {
   // Set flags for this widget
@@ -303,6 +305,22 @@ void NodeViewItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *opti
 
   }
 
+  // Draw render cost, from green for the cheapest to red for the most expensive
+  if (render_cost_share_ >= 0.0) {
+    QColor heat = QColor::fromHsvF((1.0 - render_cost_share_) / 3.0, 1.0, 1.0, 0.4);
+    painter->fillRect(rect(), heat);
+
+    QFont f;
+    f.setPointSizeF(f.pointSizeF() * 0.6);
+    painter->setFont(f);
+    painter->setPen(app_pal.color(QPalette::Text));
+
+    int text_pad = DefaultTextPadding()/2;
+    painter->drawText(rect().adjusted(text_pad, text_pad, -text_pad, -text_pad),
+                      Qt::AlignRight | Qt::AlignBottom,
+                      QCoreApplication::translate("NodeViewItem", "%1 ms").arg(double(render_cost_) / 1000000.0, 0, 'f', 2));
+  }
+
   // Draw final border
   QPen border_pen;
   border_pen.setWidth(node_border_width_);
@@ -319,6 +337,14 @@ void NodeViewItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *opti
   painter->drawRect(rect());
 }
 
+void NodeViewItem::SetRenderCost(double share, qint64 nsecs)
+{
+  render_cost_share_ = share;
+  render_cost_ = nsecs;
+
+  update();
+}
+
 void NodeViewItem::mousePressEvent(QGraphicsSceneMouseEvent *event)
 {
   event->setModifiers(FlipControlAndShiftModifiers(event->modifiers()));
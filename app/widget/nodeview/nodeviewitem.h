@@ -111,6 +111,14 @@ public:
 
   void SetHighlightedIndex(int index);
 
+  /**
+   * @brief Shade this item by how long its node took to render
+   *
+   * `share` is the cost relative to the most expensive node in view (0.0 - 1.0), or negative to
+   * show nothing.
+   */
+  void SetRenderCost(double share, qint64 nsecs);
+
 protected:
   virtual void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget = nullptr) override;
 
@@ -163,6 +171,10 @@ private:
 
   int highlighted_index_;
 
+  double render_cost_share_;
+
+  qint64 render_cost_;
+
   NodeViewCommon::FlowDirection flow_dir_;
 
   QVector<NodeViewEdge*> edges_;
@@ -33,6 +33,7 @@
 #include "dialog/sequence/sequence.h"
 #include "projectexplorerundo.h"
 #include "task/precache/precachetask.h"
+#include "task/proxy/proxy.h"
 #include "task/taskmanager.h"
 #include "widget/menu/menu.h"
 #include "widget/menu/menushared.h"
@@ -412,6 +413,18 @@ void ProjectExplorer::ShowContextMenu()
 
         connect(proxy_menu, &Menu::triggered, this, &ProjectExplorer::ContextMenuStartProxy);
       }
+
+      Menu* generate_proxy_menu = new Menu(tr("Generate Proxy"), &menu);
+      menu.addMenu(generate_proxy_menu);
+
+      foreach (int d, VideoParams::kSupportedDividers) {
+        if (d > 1) {
+          QAction* a = generate_proxy_menu->addAction(tr("1/%1 Resolution").arg(d));
+          a->setData(d);
+        }
+      }
+
+      connect(generate_proxy_menu, &Menu::triggered, this, &ProjectExplorer::ContextMenuGenerateProxy);
     }
 
     Q_UNUSED(all_items_are_footage_or_sequence)
@@ -505,6 +518,28 @@ void ProjectExplorer::ContextMenuStartProxy(QAction *a)
   }
 }
 
+void ProjectExplorer::ContextMenuGenerateProxy(QAction *a)
+{
+  int divider = a->data().toInt();
+
+  // To get here, the `context_menu_items_` must be all kFootage
+  foreach (Node* item, context_menu_items_) {
+    Footage* f = static_cast<Footage*>(item);
+
+    int sz = f->InputArraySize(Footage::kVideoParamsInput);
+
+    for (int j=0; j<sz; j++) {
+      VideoParams vp = f->GetVideoParams(j);
+
+      // Stills and image sequences don't benefit from an intra-frame proxy
+      if (vp.enabled() && vp.video_type() == VideoParams::kVideoTypeVideo) {
+        ProxyTask* proxy_task = new ProxyTask(f, j, divider);
+        TaskManager::instance()->AddTask(proxy_task);
+      }
+    }
+  }
+}
+
 Project *ProjectExplorer::project() const
 {
   return model_.project();
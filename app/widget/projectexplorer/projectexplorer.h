@@ -185,6 +185,8 @@ private slots:
 
   void ContextMenuStartProxy(QAction* a);
 
+  void ContextMenuGenerateProxy(QAction* a);
+
 };
 
 }
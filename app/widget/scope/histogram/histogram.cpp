@@ -22,10 +22,8 @@
 
 #include <QPainter>
 #include <QtMath>
-#include <QVector2D>
 
 #include "common/qtutils.h"
-#include "node/node.h"
 
 namespace olive {
 
@@ -36,63 +34,58 @@ HistogramScope::HistogramScope(QWidget* parent) :
 {
 }
 
-void HistogramScope::OnInit()
+void HistogramScope::DrawScope(QPainter* p, const ScopeAnalysis& analysis)
 {
-  super::OnInit();
+  float histogram_scale = 0.80f;
+  // This value is eyeballed for usefulness. Heights are raised to this power so that small counts
+  // are still visible next to the peak.
+  float histogram_base = 2.5f;
+  float histogram_power = 1.0f / histogram_base;
 
-  ShaderCode secondary_code(FileFunctions::ReadFileAsString(":/shaders/rgbhistogram_secondary.frag"),
-                            FileFunctions::ReadFileAsString(":/shaders/rgbhistogram.vert"));
-  pipeline_secondary_ = renderer()->CreateNativeShader(secondary_code);
-}
+  float histogram_dim_x = ceil((width() - 1.0) * histogram_scale);
+  float histogram_dim_y = ceil((height() - 1.0) * histogram_scale);
+  float histogram_start_dim_x =
+      ((width() - 1.0) - histogram_dim_x) / 2.0f;
+  float histogram_start_dim_y =
+      ((height() - 1.0) - histogram_dim_y) / 2.0f;
+  float histogram_end_dim_x = (width() - 1.0) - histogram_start_dim_x;
+  float histogram_end_dim_y = histogram_start_dim_y + histogram_dim_y;
 
-void HistogramScope::OnDestroy()
-{
-  super::OnDestroy();
+  // Normalize against the highest of the color channels so they stay comparable to each other
+  quint32 peak = qMax(analysis.histogram_peak[ScopeAnalysis::kRed],
+                      qMax(analysis.histogram_peak[ScopeAnalysis::kGreen],
+                           analysis.histogram_peak[ScopeAnalysis::kBlue]));
 
-  pipeline_secondary_.clear();
-  texture_row_sums_ = nullptr;
-}
+  if (peak > 0) {
+    const QColor channel_colors[] = {Qt::red, Qt::green, Qt::blue};
 
-ShaderCode HistogramScope::GenerateShaderCode()
-{
-  return ShaderCode(FileFunctions::ReadFileAsString(":/shaders/rgbhistogram.frag"),
-                    FileFunctions::ReadFileAsString(":/shaders/default.vert"));
-}
+    // Overlapping channels add up to white like they did in the old shader
+    p->setCompositionMode(QPainter::CompositionMode_Plus);
+    p->setPen(Qt::NoPen);
 
-void HistogramScope::DrawScope(TexturePtr managed_tex, QVariant pipeline)
-{
-  float histogram_scale = 0.80f;
-  // This value is eyeballed for usefulness. Until we have a geometry
-  // shader approach, it is impossible to normalize against a peak
-  // sum of image values.
-  float histogram_base = 2.5f;
-  float histogram_power = 1.0f / histogram_base;
+    for (int c=ScopeAnalysis::kRed; c<=ScopeAnalysis::kBlue; c++) {
+      const quint32* bins = analysis.histogram_channel(c);
 
-  ShaderJob shader_job;
+      QPolygonF polygon;
+      polygon.reserve(ScopeAnalysis::kLevels + 2);
+      polygon.append(QPointF(histogram_start_dim_x, histogram_end_dim_y));
 
-  shader_job.InsertValue(QStringLiteral("viewport"), NodeValue(NodeValue::kVec2, QVector2D(width(), height())));
-  shader_job.InsertValue(QStringLiteral("histogram_scale"), NodeValue(NodeValue::kFloat, histogram_scale));
-  shader_job.InsertValue(QStringLiteral("histogram_power"), NodeValue(NodeValue::kFloat, histogram_power));
+      for (int i=0; i<ScopeAnalysis::kLevels; i++) {
+        double x = histogram_start_dim_x + histogram_dim_x * i / double(ScopeAnalysis::kLevels - 1);
+        double y = histogram_end_dim_y - histogram_dim_y * std::pow(double(bins[i]) / double(peak), double(histogram_power));
 
-  if (!texture_row_sums_
-      || texture_row_sums_->width() != this->width()
-      || texture_row_sums_->height() != this->height()) {
-    texture_row_sums_ = renderer()->CreateTexture(VideoParams(width(), height(),
-                                                              managed_tex->format(),
-                                                              managed_tex->channel_count()));
-  }
+        polygon.append(QPointF(x, y));
+      }
 
-  // Draw managed texture to a sums texture
-  shader_job.InsertValue(QStringLiteral("ove_maintex"), NodeValue(NodeValue::kTexture, QVariant::fromValue(managed_tex)));
-  renderer()->BlitToTexture(pipeline, shader_job, texture_row_sums_.get());
+      polygon.append(QPointF(histogram_end_dim_x, histogram_end_dim_y));
 
-  // Draw sums into a histogram
-  shader_job.InsertValue(QStringLiteral("ove_maintex"), NodeValue(NodeValue::kTexture, QVariant::fromValue(texture_row_sums_)));
-  renderer()->Blit(pipeline_secondary_, shader_job, texture_row_sums_->params());
+      p->setBrush(channel_colors[c]);
+      p->drawPolygon(polygon);
+    }
+  }
 
   // Draw line overlays
-  QPainter p(inner_widget());
-  QFont font = p.font();
+  QFont font = p->font();
   font.setPixelSize(10);
   QFontMetrics font_metrics = QFontMetrics(font);
   QString label;
@@ -104,43 +97,29 @@ void HistogramScope::DrawScope(TexturePtr managed_tex, QVariant pipeline)
   };
 
   int histogram_steps = histogram_increments.size();
-  QVector<QLine> histogram_lines(histogram_steps + 1);
+  QVector<QLine> histogram_lines(histogram_steps);
   int font_x_offset = 0;
   int font_y_offset = font_metrics.capHeight() / 2.0f;
 
-  p.setCompositionMode(QPainter::CompositionMode_Plus);
+  p->setCompositionMode(QPainter::CompositionMode_Plus);
 
-  p.setPen(QColor(0.0, 0.6 * 255.0, 0.0));
-  p.setFont(font);
+  p->setPen(QColor(0.0, 0.6 * 255.0, 0.0));
+  p->setBrush(Qt::NoBrush);
+  p->setFont(font);
 
-  float histogram_dim_x = ceil((width() - 1.0) * histogram_scale);
-  float histogram_dim_y = ceil((height() - 1.0) * histogram_scale);
-  float histogram_start_dim_x =
-      ((width() - 1.0) - histogram_dim_x) / 2.0f;
-  float histogram_start_dim_y =
-      ((height() - 1.0) - histogram_dim_y) / 2.0f;
-  float histogram_end_dim_x = (width() - 1.0) - histogram_start_dim_x;
+  for (int i=0; i<histogram_steps; i++) {
+    // Lines are labelled as a percentage of the peak
+    float y = histogram_end_dim_y - histogram_dim_y * std::pow(histogram_increments.at(i), histogram_power);
+
+    histogram_lines[i].setLine(histogram_start_dim_x, y, histogram_end_dim_x, y);
 
-  // for (int i=0; i <= histogram_steps; i++) {
-  for(std::vector<float>::iterator it = histogram_increments.begin();
-      it != histogram_increments.end(); it++) {
-    histogram_lines[it - histogram_increments.begin()].setLine(
-          histogram_start_dim_x,
-          (histogram_dim_y * pow(1.0 - *it, histogram_base)) +
-          histogram_start_dim_y,
-          histogram_end_dim_x,
-          (histogram_dim_y * pow(1.0 - *it, histogram_base)) +
-          histogram_start_dim_y);
-    label = QString::number(
-          *it * 100, 'f', 1) + "%";
+    label = QString::number(histogram_increments.at(i) * 100, 'f', 1) + "%";
     font_x_offset = QtUtils::QFontMetricsWidth(font_metrics, label) + 4;
 
-    p.drawText(
-          histogram_start_dim_x - font_x_offset,
-          (histogram_dim_y * pow(1.0 - *it, histogram_base)) +
-          histogram_start_dim_y + font_y_offset, label);
+    p->drawText(histogram_start_dim_x - font_x_offset, y + font_y_offset, label);
   }
-  p.drawLines(histogram_lines);
+
+  p->drawLines(histogram_lines);
 }
 
 }
@@ -33,20 +33,8 @@ public:
 
   MANAGEDDISPLAYWIDGET_DEFAULT_DESTRUCTOR(HistogramScope)
 
-protected slots:
-  virtual void OnInit() override;
-
-  virtual void OnDestroy() override;
-
 protected:
-  virtual ShaderCode GenerateShaderCode() override;
-  QVariant CreateSecondaryShader();
-
-  virtual void DrawScope(TexturePtr managed_tex, QVariant pipeline) override;
-
-private:
-  QVariant pipeline_secondary_;
-  TexturePtr texture_row_sums_;
+  virtual void DrawScope(QPainter* p, const ScopeAnalysis& analysis) override;
 
 };
 
@@ -0,0 +1,255 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2021 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#include "scopeanalyzer.h"
+
+#include <algorithm>
+#include <OpenImageIO/imageio.h>
+#include <QtConcurrent/QtConcurrent>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "common/oiioutils.h"
+
+namespace olive {
+
+const int ScopeAnalyzer::kMaximumSampleWidth = 512;
+
+ScopeAnalyzer::ScopeAnalyzer(QObject *parent) :
+  QObject(parent),
+  has_pending_(false),
+  running_(false)
+{
+  connect(&watcher_, &QFutureWatcher<ScopeAnalysisPtr>::finished, this, &ScopeAnalyzer::WatcherFinished);
+}
+
+void ScopeAnalyzer::Analyze(FramePtr frame, ColorProcessorPtr processor, const double luma_coeffs[3])
+{
+  // Replaces whatever was waiting, we only ever care about the most recent frame
+  pending_.frame = frame;
+  pending_.processor = processor;
+  pending_.luma_coeffs = {luma_coeffs[0], luma_coeffs[1], luma_coeffs[2]};
+  has_pending_ = true;
+
+  if (!running_) {
+    StartNext();
+  }
+}
+
+ScopeAnalysisPtr ScopeAnalyzer::Compute(FramePtr frame, ColorProcessorPtr processor, QVector<double> luma_coeffs)
+{
+  std::shared_ptr<ScopeAnalysis> analysis = std::make_shared<ScopeAnalysis>();
+
+  if (!frame || !frame->is_allocated() || frame->width() <= 0 || frame->height() <= 0) {
+    return analysis;
+  }
+
+  FramePtr sample = SampleFrame(frame);
+
+  if (processor) {
+    processor->ConvertFrame(sample);
+  }
+
+  analysis->columns = sample->width();
+  analysis->rows = sample->height();
+  analysis->histogram.assign(ScopeAnalysis::kChannelCount * ScopeAnalysis::kLevels, 0);
+  analysis->waveform.assign(ScopeAnalysis::kChannelCount * analysis->columns * ScopeAnalysis::kLevels, 0);
+  analysis->vectorscope.assign(ScopeAnalysis::kLevels * ScopeAnalysis::kLevels, 0);
+
+  BinSamples(reinterpret_cast<const float*>(sample->const_data()), sample->width(), sample->height(),
+             sample->linesize_pixels(), luma_coeffs.constData(), analysis.get());
+
+  for (int c=0; c<ScopeAnalysis::kChannelCount; c++) {
+    const quint32* bins = analysis->histogram_channel(c);
+    analysis->histogram_peak[c] = *std::max_element(bins, bins + ScopeAnalysis::kLevels);
+  }
+
+  analysis->vectorscope_peak = *std::max_element(analysis->vectorscope.cbegin(), analysis->vectorscope.cend());
+
+  return analysis;
+}
+
+void ScopeAnalyzer::StartNext()
+{
+  Request r = pending_;
+
+  pending_ = Request();
+  has_pending_ = false;
+  running_ = true;
+
+  watcher_.setFuture(QtConcurrent::run(&ScopeAnalyzer::Compute, r.frame, r.processor, r.luma_coeffs));
+}
+
+FramePtr ScopeAnalyzer::SampleFrame(FramePtr frame)
+{
+  // Use the same stride on both axes so the vectorscope and histogram aren't weighted towards
+  // either direction
+  int step = qMax(1, (frame->width() + kMaximumSampleWidth - 1) / kMaximumSampleWidth);
+  int width = (frame->width() + step - 1) / step;
+  int height = (frame->height() + step - 1) / step;
+
+  FramePtr sample = Frame::Create();
+  sample->set_video_params(VideoParams(width, height, VideoParams::kFormatFloat32, VideoParams::kRGBAChannelCount));
+  sample->allocate();
+
+  // Alpha isn't analyzed, but clear it for sources that have none so the buffer is fully defined
+  memset(sample->data(), 0, sample->allocated_size());
+
+  OIIO::convert_image(qMin(frame->channel_count(), int(VideoParams::kRGBAChannelCount)), width, height, 1,
+                      frame->const_data(), OIIOUtils::GetOIIOBaseTypeFromFormat(frame->format()),
+                      OIIO::stride_t(frame->video_params().GetBytesPerPixel()) * step,
+                      OIIO::stride_t(frame->linesize_bytes()) * step,
+                      OIIO::AutoStride,
+                      sample->data(), OIIO::TypeDesc::FLOAT,
+                      OIIO::stride_t(sizeof(float) * VideoParams::kRGBAChannelCount),
+                      sample->linesize_bytes(),
+                      OIIO::AutoStride);
+
+  return sample;
+}
+
+namespace {
+
+inline int QuantizeLevel(float v)
+{
+  const float max_level = ScopeAnalysis::kLevels - 1;
+
+  v = v * max_level + 0.5f;
+
+  // Written so NaN lands in the first level
+  if (!(v > 0.0f)) {
+    return 0;
+  } else if (v >= max_level) {
+    return ScopeAnalysis::kLevels - 1;
+  } else {
+    return int(v);
+  }
+}
+
+}
+
+void ScopeAnalyzer::BinSamples(const float *rgba, int width, int height, int linesize_pixels, const double luma_coeffs[3], ScopeAnalysis *analysis)
+{
+  const int levels = ScopeAnalysis::kLevels;
+  const int columns = analysis->columns;
+
+  const float lr = luma_coeffs[0];
+  const float lg = luma_coeffs[1];
+  const float lb = luma_coeffs[2];
+
+  // Puts Cb and Cr into -0.5...0.5 for a fully saturated primary, which is then offset to 0.0...1.0
+  const float cb_scale = 0.5f / qMax(1.0f - lb, 0.0001f);
+  const float cr_scale = 0.5f / qMax(1.0f - lr, 0.0001f);
+
+  quint32* hist = analysis->histogram.data();
+  quint32* wave = analysis->waveform.data();
+  quint32* vec = analysis->vectorscope.data();
+
+  auto bin = [=](int x, int r, int g, int b, int l, int cb, int cr) {
+    hist[ScopeAnalysis::kRed * levels + r]++;
+    hist[ScopeAnalysis::kGreen * levels + g]++;
+    hist[ScopeAnalysis::kBlue * levels + b]++;
+    hist[ScopeAnalysis::kLuma * levels + l]++;
+
+    wave[(ScopeAnalysis::kRed * columns + x) * levels + r]++;
+    wave[(ScopeAnalysis::kGreen * columns + x) * levels + g]++;
+    wave[(ScopeAnalysis::kBlue * columns + x) * levels + b]++;
+    wave[(ScopeAnalysis::kLuma * columns + x) * levels + l]++;
+
+    vec[cr * levels + cb]++;
+  };
+
+#if defined(__SSE2__)
+  const __m128 v_lr = _mm_set1_ps(lr);
+  const __m128 v_lg = _mm_set1_ps(lg);
+  const __m128 v_lb = _mm_set1_ps(lb);
+  const __m128 v_cb_scale = _mm_set1_ps(cb_scale);
+  const __m128 v_cr_scale = _mm_set1_ps(cr_scale);
+  const __m128 v_half = _mm_set1_ps(0.5f);
+  const __m128 v_zero = _mm_setzero_ps();
+  const __m128 v_max_level = _mm_set1_ps(levels - 1);
+#endif
+
+  for (int y=0; y<height; y++) {
+    const float* row = rgba + y * linesize_pixels * VideoParams::kRGBAChannelCount;
+    int x = 0;
+
+#if defined(__SSE2__)
+    // Quantize four pixels at a time. The increments themselves scatter across the bins so they stay
+    // scalar.
+    for (; x+4<=width; x+=4) {
+      const float* px = row + x * VideoParams::kRGBAChannelCount;
+
+      __m128 r = _mm_loadu_ps(px);
+      __m128 g = _mm_loadu_ps(px + 4);
+      __m128 b = _mm_loadu_ps(px + 8);
+      __m128 a = _mm_loadu_ps(px + 12);
+      _MM_TRANSPOSE4_PS(r, g, b, a);
+
+      __m128 l = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r, v_lr), _mm_mul_ps(g, v_lg)), _mm_mul_ps(b, v_lb));
+      __m128 cb = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(b, l), v_cb_scale), v_half);
+      __m128 cr = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(r, l), v_cr_scale), v_half);
+
+      alignas(16) qint32 q[6][4];
+      __m128 values[6] = {r, g, b, l, cb, cr};
+      for (int i=0; i<6; i++) {
+        // _mm_max_ps returns its second operand for NaN, so NaN lands in the first level
+        __m128 v = _mm_add_ps(_mm_mul_ps(values[i], v_max_level), v_half);
+        v = _mm_min_ps(_mm_max_ps(v, v_zero), v_max_level);
+        _mm_store_si128(reinterpret_cast<__m128i*>(q[i]), _mm_cvttps_epi32(v));
+      }
+
+      for (int i=0; i<4; i++) {
+        bin(x + i, q[0][i], q[1][i], q[2][i], q[3][i], q[4][i], q[5][i]);
+      }
+    }
+#endif
+
+    for (; x<width; x++) {
+      const float* px = row + x * VideoParams::kRGBAChannelCount;
+
+      float l = px[0] * lr + px[1] * lg + px[2] * lb;
+
+      bin(x,
+          QuantizeLevel(px[0]),
+          QuantizeLevel(px[1]),
+          QuantizeLevel(px[2]),
+          QuantizeLevel(l),
+          QuantizeLevel((px[2] - l) * cb_scale + 0.5f),
+          QuantizeLevel((px[0] - l) * cr_scale + 0.5f));
+    }
+  }
+}
+
+void ScopeAnalyzer::WatcherFinished()
+{
+  running_ = false;
+
+  ScopeAnalysisPtr analysis = watcher_.result();
+
+  if (has_pending_) {
+    StartNext();
+  }
+
+  emit AnalysisReady(analysis);
+}
+
+}
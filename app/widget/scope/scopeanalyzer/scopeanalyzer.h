@@ -0,0 +1,151 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2021 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#ifndef SCOPEANALYZER_H
+#define SCOPEANALYZER_H
+
+#include <QFutureWatcher>
+#include <QObject>
+
+#include "codec/frame.h"
+#include "render/colorprocessor.h"
+
+namespace olive {
+
+/**
+ * @brief Binned summary of a frame that scopes draw from
+ *
+ * All values are in display space (i.e. after the scope's color transform) and quantized to
+ * kLevels levels between 0.0 and 1.0. Values outside that range are clamped into the first and last
+ * levels.
+ */
+struct ScopeAnalysis
+{
+  enum Channel {
+    kRed,
+    kGreen,
+    kBlue,
+    kLuma,
+
+    kChannelCount
+  };
+
+  static const int kLevels = 256;
+
+  /// Number of waveform columns, this is the width of the sampled frame
+  int columns = 0;
+
+  /// Number of pixels that were sampled from each column
+  int rows = 0;
+
+  /// kChannelCount x kLevels
+  std::vector<quint32> histogram;
+
+  /// Highest value in `histogram` for each channel
+  quint32 histogram_peak[kChannelCount] = {};
+
+  /// kChannelCount x columns x kLevels, so each column's levels are contiguous
+  std::vector<quint32> waveform;
+
+  /// kLevels x kLevels, indexed by Cr (row) and Cb (column) where the center is neutral
+  std::vector<quint32> vectorscope;
+
+  /// Highest value in `vectorscope`
+  quint32 vectorscope_peak = 0;
+
+  const quint32* histogram_channel(int c) const
+  {
+    return histogram.data() + c * kLevels;
+  }
+
+  const quint32* waveform_column(int c, int column) const
+  {
+    return waveform.data() + (c * columns + column) * kLevels;
+  }
+
+};
+
+using ScopeAnalysisPtr = std::shared_ptr<const ScopeAnalysis>;
+
+/**
+ * @brief Computes ScopeAnalysis data off the main thread
+ *
+ * Frames are sampled with a stride so no more than kMaximumSampleWidth columns are analyzed, then
+ * converted to display space and binned on the global thread pool. Only one analysis runs at a
+ * time. If new frames arrive while one is running (e.g. during playback), only the most recent one
+ * is analyzed next and the others are dropped, so the scope keeps up with the viewer without
+ * queueing stale work.
+ */
+class ScopeAnalyzer : public QObject
+{
+  Q_OBJECT
+public:
+  ScopeAnalyzer(QObject* parent = nullptr);
+
+  /**
+   * @brief Queue a frame for analysis
+   *
+   * `processor` converts the reference frame to display space and may be nullptr. `luma_coeffs`
+   * are the RGB weights used for the luma waveform and the vectorscope.
+   */
+  void Analyze(FramePtr frame, ColorProcessorPtr processor, const double luma_coeffs[3]);
+
+  /**
+   * @brief Synchronously computes an analysis (this is what Analyze() runs on the thread pool)
+   */
+  static ScopeAnalysisPtr Compute(FramePtr frame, ColorProcessorPtr processor, QVector<double> luma_coeffs);
+
+  static const int kMaximumSampleWidth;
+
+signals:
+  void AnalysisReady(olive::ScopeAnalysisPtr analysis);
+
+private:
+  struct Request
+  {
+    FramePtr frame;
+    ColorProcessorPtr processor;
+    QVector<double> luma_coeffs;
+  };
+
+  void StartNext();
+
+  static FramePtr SampleFrame(FramePtr frame);
+
+  static void BinSamples(const float* rgba, int width, int height, int linesize_pixels,
+                         const double luma_coeffs[3], ScopeAnalysis* analysis);
+
+  QFutureWatcher<ScopeAnalysisPtr> watcher_;
+
+  Request pending_;
+
+  bool has_pending_;
+
+  bool running_;
+
+private slots:
+  void WatcherFinished();
+
+};
+
+}
+
+Q_DECLARE_METATYPE(olive::ScopeAnalysisPtr)
+
+#endif // SCOPEANALYZER_H
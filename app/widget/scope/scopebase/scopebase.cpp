@@ -20,78 +20,69 @@
 
 #include "scopebase.h"
 
-#include "config/config.h"
-
 namespace olive {
 
 #define super ManagedDisplayWidget
 
 ScopeBase::ScopeBase(QWidget* parent) :
-  super(parent),
-  buffer_(nullptr)
+  super(parent)
 {
   EnableDefaultContextMenu();
+
+  analyzer_ = new ScopeAnalyzer(this);
+  connect(analyzer_, &ScopeAnalyzer::AnalysisReady, this, &ScopeBase::AnalysisReady);
 }
 
-void ScopeBase::SetBuffer(Frame *frame)
+void ScopeBase::SetBuffer(FramePtr frame)
 {
   buffer_ = frame;
 
-  UploadTextureFromBuffer();
+  RequestAnalysis();
 }
 
 void ScopeBase::showEvent(QShowEvent* e)
 {
   super::showEvent(e);
 
-  UploadTextureFromBuffer();
+  RequestAnalysis();
 }
 
-void ScopeBase::DrawScope(TexturePtr managed_tex, QVariant pipeline)
+void ScopeBase::ColorProcessorChangedEvent()
 {
-  ShaderJob job;
+  RequestAnalysis();
 
-  job.InsertValue(QStringLiteral("ove_maintex"), NodeValue(NodeValue::kTexture, QVariant::fromValue(managed_tex)));
-
-  renderer()->Blit(pipeline, job, VideoParams(width(), height(),
-                                              static_cast<VideoParams::Format>(Config::Current()["OfflinePixelFormat"].toInt()),
-                                              VideoParams::kInternalChannelCount));
+  super::ColorProcessorChangedEvent();
 }
 
-void ScopeBase::UploadTextureFromBuffer()
+void ScopeBase::RequestAnalysis()
 {
+  // Hidden scopes (e.g. the other pages of the scope panel) don't analyze anything, they catch up
+  // in showEvent()
   if (!isVisible()) {
     return;
   }
 
   if (buffer_) {
-    makeCurrent();
-
-    if (!texture_
-        || texture_->width() != buffer_->width()
-        || texture_->height() != buffer_->height()
-        || texture_->format() != buffer_->format()) {
-      texture_ = nullptr;
-      managed_tex_ = nullptr;
-
-      texture_ = renderer()->CreateTexture(buffer_->video_params(),
-                                           buffer_->data(), buffer_->linesize_pixels());
-      managed_tex_ = renderer()->CreateTexture(buffer_->video_params());
-    } else {
-      texture_->Upload(buffer_->data(), buffer_->linesize_pixels());
+    double luma_coeffs[3] = {0.2126, 0.7152, 0.0722};
+
+    if (color_manager()) {
+      color_manager()->GetDefaultLumaCoefs(luma_coeffs);
     }
 
-    doneCurrent();
+    analyzer_->Analyze(buffer_, color_service(), luma_coeffs);
+  } else {
+    analysis_ = nullptr;
+    update();
   }
-
-  update();
 }
 
-void ScopeBase::OnInit()
+void ScopeBase::AnalysisReady(ScopeAnalysisPtr analysis)
 {
-  super::OnInit();
-
-  pipeline_ = renderer()->CreateNativeShader(GenerateShaderCode());
+  // Buffer may have been cleared while this was computing
+  if (buffer_) {
+    analysis_ = analysis;
+    update();
+  }
 }
 
 void ScopeBase::OnPaint()
@@ -99,25 +90,11 @@ void ScopeBase::OnPaint()
   // Clear display surface
   renderer()->ClearDestination();
 
-  if (buffer_) {
-    // Convert reference frame to display space
-    if (!texture_ || !managed_tex_) {
-      UploadTextureFromBuffer();
-      makeCurrent(); // UploadTextureFromBuffer calls "doneCurrent", so we re-call "makeCurrent"
-    }
-    renderer()->BlitColorManaged(color_service(), texture_, true, managed_tex_.get());
+  if (analysis_ && analysis_->columns > 0) {
+    QPainter p(inner_widget());
 
-    DrawScope(managed_tex_, pipeline_);
+    DrawScope(&p, *analysis_);
   }
 }
 
-void ScopeBase::OnDestroy()
-{
-  super::OnDestroy();
-
-  managed_tex_ = nullptr;
-  texture_ = nullptr;
-  pipeline_.clear();
-}
-
 }
@@ -21,9 +21,12 @@
 #ifndef SCOPEBASE_H
 #define SCOPEBASE_H
 
+#include <QPainter>
+
 #include "codec/frame.h"
 #include "render/colorprocessor.h"
 #include "widget/manageddisplay/manageddisplay.h"
+#include "widget/scope/scopeanalyzer/scopeanalyzer.h"
 
 namespace olive {
 
@@ -35,37 +38,34 @@ public:
   MANAGEDDISPLAYWIDGET_DEFAULT_DESTRUCTOR(ScopeBase)
 
 public slots:
-  void SetBuffer(Frame* frame);
+  void SetBuffer(FramePtr frame);
 
 protected slots:
-  virtual void OnInit() override;
-
   virtual void OnPaint() override;
 
-  virtual void OnDestroy() override;
-
 protected:
   virtual void showEvent(QShowEvent* e) override;
 
-  virtual ShaderCode GenerateShaderCode() = 0;
+  virtual void ColorProcessorChangedEvent() override;
 
   /**
    * @brief Draw function
    *
-   * Override this if your sub-class scope needs extra drawing.
+   * Called while painting with the most recent analysis of the buffer. Analyses are computed on
+   * worker threads, so this may lag slightly behind the frame last passed to SetBuffer().
    */
-  virtual void DrawScope(TexturePtr managed_tex, QVariant pipeline);
+  virtual void DrawScope(QPainter* p, const ScopeAnalysis& analysis) = 0;
 
 private:
-  void UploadTextureFromBuffer();
+  void RequestAnalysis();
 
-  QVariant pipeline_;
+  void AnalysisReady(ScopeAnalysisPtr analysis);
 
-  TexturePtr texture_;
+  ScopeAnalyzer* analyzer_;
 
-  TexturePtr managed_tex_;
+  FramePtr buffer_;
 
-  Frame* buffer_;
+  ScopeAnalysisPtr analysis_;
 
 };
 
@@ -0,0 +1,92 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2021 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#include "vectorscope.h"
+
+#include <QtMath>
+
+namespace olive {
+
+#define super ScopeBase
+
+VectorScope::VectorScope(QWidget* parent) :
+  super(parent)
+{
+}
+
+void VectorScope::DrawScope(QPainter* p, const ScopeAnalysis& analysis)
+{
+  float vectorscope_scale = 0.80f;
+
+  float diameter = ceil(qMin(width() - 1.0, height() - 1.0) * vectorscope_scale);
+  QRectF scope_rect((width() - 1.0 - diameter) / 2.0, (height() - 1.0 - diameter) / 2.0, diameter, diameter);
+
+  if (analysis.vectorscope_peak > 0) {
+    // Log scale so sparse colors still show up next to large flat areas
+    double log_peak = std::log1p(double(analysis.vectorscope_peak));
+
+    QImage trace(ScopeAnalysis::kLevels, ScopeAnalysis::kLevels, QImage::Format_RGB32);
+
+    for (int cr=0; cr<ScopeAnalysis::kLevels; cr++) {
+      // Cr increases upwards
+      QRgb* line = reinterpret_cast<QRgb*>(trace.scanLine(ScopeAnalysis::kLevels - 1 - cr));
+      const quint32* bins = analysis.vectorscope.data() + cr * ScopeAnalysis::kLevels;
+
+      for (int cb=0; cb<ScopeAnalysis::kLevels; cb++) {
+        int v = bins[cb] ? qRound(std::log1p(double(bins[cb])) / log_peak * 255.0) : 0;
+        line[cb] = qRgb(v, v, v);
+      }
+    }
+
+    p->setRenderHint(QPainter::SmoothPixmapTransform);
+    p->drawImage(scope_rect, trace);
+  }
+
+  // Draw graticule
+  p->setCompositionMode(QPainter::CompositionMode_Plus);
+  p->setPen(QColor(0.0, 0.6 * 255.0, 0.0));
+  p->setBrush(Qt::NoBrush);
+
+  QPointF center = scope_rect.center();
+  p->drawEllipse(scope_rect);
+  p->drawLine(QPointF(scope_rect.left(), center.y()), QPointF(scope_rect.right(), center.y()));
+  p->drawLine(QPointF(center.x(), scope_rect.top()), QPointF(center.x(), scope_rect.bottom()));
+
+  // Targets for 100% primaries and secondaries, in the same space ScopeAnalyzer bins in
+  double luma_coeffs[3] = {0.2126, 0.7152, 0.0722};
+
+  if (color_manager()) {
+    color_manager()->GetDefaultLumaCoefs(luma_coeffs);
+  }
+
+  const QColor targets[] = {Qt::red, Qt::yellow, Qt::green, Qt::cyan, Qt::blue, Qt::magenta};
+
+  for (const QColor& c : targets) {
+    double l = c.redF() * luma_coeffs[0] + c.greenF() * luma_coeffs[1] + c.blueF() * luma_coeffs[2];
+    double cb = (c.blueF() - l) * 0.5 / (1.0 - luma_coeffs[2]);
+    double cr = (c.redF() - l) * 0.5 / (1.0 - luma_coeffs[0]);
+
+    QPointF pos(center.x() + cb * diameter, center.y() - cr * diameter);
+
+    p->setPen(c);
+    p->drawRect(QRectF(pos.x() - 4, pos.y() - 4, 8, 8));
+  }
+}
+
+}
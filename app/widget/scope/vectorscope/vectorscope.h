@@ -0,0 +1,42 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2021 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#ifndef VECTORSCOPE_H
+#define VECTORSCOPE_H
+
+#include "widget/scope/scopebase/scopebase.h"
+
+namespace olive {
+
+class VectorScope : public ScopeBase
+{
+  Q_OBJECT
+public:
+  VectorScope(QWidget* parent = nullptr);
+
+  MANAGEDDISPLAYWIDGET_DEFAULT_DESTRUCTOR(VectorScope)
+
+protected:
+  virtual void DrawScope(QPainter* p, const ScopeAnalysis& analysis) override;
+
+};
+
+}
+
+#endif // VECTORSCOPE_H
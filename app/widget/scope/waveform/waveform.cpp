@@ -23,58 +23,31 @@
 
 #include <QPainter>
 #include <QtMath>
-#include <QDebug>
-#include <QVector2D>
-#include <QVector3D>
 
 #include "common/qtutils.h"
-#include "config/config.h"
-#include "node/node.h"
 
 namespace olive {
 
 #define super ScopeBase
 
 WaveformScope::WaveformScope(QWidget* parent) :
-  super(parent)
+  super(parent),
+  parade_(false)
 {
 }
 
-ShaderCode WaveformScope::GenerateShaderCode()
+void WaveformScope::SetParade(bool e)
 {
-  return ShaderCode(FileFunctions::ReadFileAsString(":/shaders/rgbwaveform.frag"),
-                    FileFunctions::ReadFileAsString(":/shaders/rgbwaveform.vert"));
+  parade_ = e;
+  update();
 }
 
-void WaveformScope::DrawScope(TexturePtr managed_tex, QVariant pipeline)
+void WaveformScope::DrawScope(QPainter* p, const ScopeAnalysis& analysis)
 {
   float waveform_scale = 0.80f;
 
-  // Draw waveform through shader
-  ShaderJob job;
-
-  // Set viewport size
-  job.InsertValue(QStringLiteral("viewport"),
-                  NodeValue(NodeValue::kVec2, QVector2D(width(), height())));
-
-  // Set luma coefficients
-  double luma_coeffs[3] = {0.0f, 0.0f, 0.0f};
-  color_manager()->GetDefaultLumaCoefs(luma_coeffs);
-  job.InsertValue(QStringLiteral("luma_coeffs"),
-                  NodeValue(NodeValue::kVec3, QVector3D(luma_coeffs[0], luma_coeffs[1], luma_coeffs[2])));
-
-
-  // Scale of the waveform relative to the viewport surface.
-  job.InsertValue(QStringLiteral("waveform_scale"),
-                  NodeValue(NodeValue::kFloat, waveform_scale));
-
-  // Insert source texture
-  job.InsertValue(QStringLiteral("ove_maintex"),
-                  NodeValue(NodeValue::kTexture, QVariant::fromValue(managed_tex)));
-
-  renderer()->Blit(pipeline, job, VideoParams(width(), height(),
-                                              static_cast<VideoParams::Format>(Config::Current()["OfflinePixelFormat"].toInt()),
-                                              VideoParams::kInternalChannelCount));
+  // Brightness contributed by each sample, eyeballed so that a flat area saturates its level
+  float intensity = 16.0f / analysis.rows;
 
   float waveform_dim_x = ceil((width() - 1.0) * waveform_scale);
   float waveform_dim_y = ceil((height() - 1.0) * waveform_scale);
@@ -84,8 +57,37 @@ void WaveformScope::DrawScope(TexturePtr managed_tex, QVariant pipeline)
       ((height() - 1.0) - waveform_dim_y) / 2.0f;
   float waveform_end_dim_x = (width() - 1.0) - waveform_start_dim_x;
 
+  // Build the trace image from the bins, one pixel per column and level
+  int sections = parade_ ? 3 : 1;
+  QImage trace(analysis.columns * sections, ScopeAnalysis::kLevels, QImage::Format_RGB32);
+
+  for (int level=0; level<ScopeAnalysis::kLevels; level++) {
+    // Highest level at the top
+    QRgb* line = reinterpret_cast<QRgb*>(trace.scanLine(ScopeAnalysis::kLevels - 1 - level));
+
+    for (int x=0; x<analysis.columns; x++) {
+      float r = analysis.waveform_column(ScopeAnalysis::kRed, x)[level] * intensity;
+      float g = analysis.waveform_column(ScopeAnalysis::kGreen, x)[level] * intensity;
+      float b = analysis.waveform_column(ScopeAnalysis::kBlue, x)[level] * intensity;
+
+      if (parade_) {
+        line[x] = qRgb(qMin(255, int(r * 255)), 0, 0);
+        line[x + analysis.columns] = qRgb(0, qMin(255, int(g * 255)), 0);
+        line[x + analysis.columns * 2] = qRgb(0, 0, qMin(255, int(b * 255)));
+      } else {
+        float l = analysis.waveform_column(ScopeAnalysis::kLuma, x)[level] * intensity;
+
+        line[x] = qRgb(qMin(255, int((r + l) * 255)),
+                       qMin(255, int((g + l) * 255)),
+                       qMin(255, int((b + l) * 255)));
+      }
+    }
+  }
+
+  p->setRenderHint(QPainter::SmoothPixmapTransform);
+  p->drawImage(QRectF(waveform_start_dim_x, waveform_start_dim_y, waveform_dim_x, waveform_dim_y), trace);
+
   // Draw line overlays
-  QPainter p(inner_widget());
   QFont font;
   font.setPixelSize(10);
   QFontMetrics font_metrics = QFontMetrics(font);
@@ -96,10 +98,10 @@ void WaveformScope::DrawScope(TexturePtr managed_tex, QVariant pipeline)
   int font_x_offset = 0;
   int font_y_offset = font_metrics.capHeight() / 2.0f;
 
-  p.setCompositionMode(QPainter::CompositionMode_Plus);
+  p->setCompositionMode(QPainter::CompositionMode_Plus);
 
-  p.setPen(QColor(0.0, 0.6 * 255.0, 0.0));
-  p.setFont(font);
+  p->setPen(QColor(0.0, 0.6 * 255.0, 0.0));
+  p->setFont(font);
 
   for (int i=0; i <= ire_steps; i++) {
     ire_lines[i].setLine(
@@ -110,13 +112,13 @@ void WaveformScope::DrawScope(TexturePtr managed_tex, QVariant pipeline)
     label = QString::number(1.0 - (i * ire_increment), 'f', 1);
     font_x_offset = QtUtils::QFontMetricsWidth(font_metrics, label) + 4;
 
-    p.drawText(
+    p->drawText(
           waveform_start_dim_x - font_x_offset,
           (waveform_dim_y * (i * ire_increment)) + waveform_start_dim_y + font_y_offset,
           label);
   }
 
-  p.drawLines(ire_lines);
+  p->drawLines(ire_lines);
 }
 
 }
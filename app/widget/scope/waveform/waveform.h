@@ -33,10 +33,16 @@ public:
 
   MANAGEDDISPLAYWIDGET_DEFAULT_DESTRUCTOR(WaveformScope)
 
+  /**
+   * @brief Set whether to draw R, G and B side by side (RGB parade) rather than overlaid with luma
+   */
+  void SetParade(bool e);
+
 protected:
-  virtual ShaderCode GenerateShaderCode() override;
+  virtual void DrawScope(QPainter* p, const ScopeAnalysis& analysis) override;
 
-  virtual void DrawScope(TexturePtr managed_tex, QVariant pipeline) override;
+private:
+  bool parade_;
 
 };
 
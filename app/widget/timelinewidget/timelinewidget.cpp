@@ -979,6 +979,11 @@ void TimelineWidget::ShowContextMenu()
     show_waveforms->setChecked(views_.first()->view()->GetShowWaveforms());
     connect(show_waveforms, &QAction::triggered, this, &TimelineWidget::SetViewWaveformsEnabled);
 
+    QAction* show_render_cost = menu.addAction(tr("Show Render Cost"));
+    show_render_cost->setCheckable(true);
+    show_render_cost->setChecked(views_.first()->view()->GetShowRenderCost());
+    connect(show_render_cost, &QAction::triggered, this, &TimelineWidget::SetViewRenderCostEnabled);
+
     menu.addSeparator();
 
     QAction* properties_action = menu.addAction(tr("Properties"));
@@ -1054,6 +1059,13 @@ void TimelineWidget::SetViewWaveformsEnabled(bool e)
   }
 }
 
+void TimelineWidget::SetViewRenderCostEnabled(bool e)
+{
+  foreach (TimelineAndTrackView* tview, views_) {
+    tview->view()->SetShowRenderCost(e);
+  }
+}
+
 void TimelineWidget::FrameRateChanged()
 {
   SetTimebase(GetConnectedNode()->GetVideoParams().frame_rate_as_time_base());
@@ -347,6 +347,8 @@ private slots:
 
   void SetViewWaveformsEnabled(bool e);
 
+  void SetViewRenderCostEnabled(bool e);
+
   void FrameRateChanged();
 
   void SampleRateChanged();
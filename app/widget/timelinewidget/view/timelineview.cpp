@@ -32,6 +32,7 @@
 #include "common/qtutils.h"
 #include "common/timecodefunctions.h"
 #include "node/project/footage/footage.h"
+#include "render/renderprofiler.h"
 #include "ui/colorcoding.h"
 
 namespace olive {
@@ -42,7 +43,9 @@ TimelineView::TimelineView(Qt::Alignment vertical_alignment, QWidget *parent) :
   ghosts_(nullptr),
   show_beam_cursor_(false),
   connected_track_list_(nullptr),
-  show_waveforms_(true)
+  show_waveforms_(true),
+  show_render_cost_(false),
+  max_clip_cost_(0)
 {
   Q_ASSERT(vertical_alignment == Qt::AlignTop || vertical_alignment == Qt::AlignBottom);
   setAlignment(Qt::AlignLeft | vertical_alignment);
@@ -51,6 +54,41 @@ TimelineView::TimelineView(Qt::Alignment vertical_alignment, QWidget *parent) :
   setBackgroundRole(QPalette::Window);
   setContextMenuPolicy(Qt::CustomContextMenu);
   viewport()->setMouseTracking(true);
+
+  // Frames are recorded constantly during playback, so only repaint costs every so often
+  render_cost_timer_.setSingleShot(true);
+  render_cost_timer_.setInterval(250);
+  connect(&render_cost_timer_, &QTimer::timeout, this, &TimelineView::UpdateRenderCosts);
+}
+
+TimelineView::~TimelineView()
+{
+  // Release our hold on the profiler
+  SetShowRenderCost(false);
+}
+
+void TimelineView::SetShowRenderCost(bool e)
+{
+  if (show_render_cost_ == e) {
+    return;
+  }
+
+  show_render_cost_ = e;
+
+  if (show_render_cost_) {
+    RenderProfiler::instance()->Enable();
+    connect(RenderProfiler::instance(), &RenderProfiler::FramesChanged, this, [this](){
+      if (!render_cost_timer_.isActive()) {
+        render_cost_timer_.start();
+      }
+    });
+  } else {
+    disconnect(RenderProfiler::instance(), &RenderProfiler::FramesChanged, this, nullptr);
+    RenderProfiler::instance()->Disable();
+    render_cost_timer_.stop();
+  }
+
+  UpdateRenderCosts();
 }
 
 void TimelineView::mousePressEvent(QMouseEvent *event)
@@ -371,6 +409,38 @@ TimelineViewMouseEvent TimelineView::CreateMouseEvent(const QPoint& pos, Qt::Mou
                                 modifiers);
 }
 
+void TimelineView::UpdateRenderCosts()
+{
+  clip_costs_.clear();
+  max_clip_cost_ = 0;
+
+  if (show_render_cost_ && connected_track_list_) {
+    QHash<const Node*, RenderProfiler::NodeCost> costs = RenderProfiler::instance()->GetNodeCosts();
+
+    // Clips are shaded relative to the most expensive clip in the sequence, by the cost of
+    // everything that goes into them since that's where their render time actually goes
+    foreach (Track* track, connected_track_list_->GetTracks()) {
+      foreach (Block* b, track->Blocks()) {
+        if (!costs.contains(b)) {
+          // Not rendered recently
+          continue;
+        }
+
+        qint64 total = costs.value(b).cost;
+
+        foreach (Node* dep, b->GetDependencies()) {
+          total += costs.value(dep).cost;
+        }
+
+        clip_costs_.insert(b, total);
+        max_clip_cost_ = qMax(max_clip_cost_, total);
+      }
+    }
+  }
+
+  viewport()->update();
+}
+
 void TimelineView::DrawBlocks(QPainter *painter, bool foreground)
 {
   qreal left_bound = horizontalScrollBar()->value();
@@ -435,6 +505,16 @@ void TimelineView::DrawBlocks(QPainter *painter, bool foreground)
           painter->setBrush(block->is_enabled() ? block->brush(block_top, block_top + block_height) : Qt::gray);
           painter->drawRect(r);
 
+          // Draw render cost, from green for the cheapest to red for the most expensive
+          if (show_render_cost_ && max_clip_cost_ > 0) {
+            auto cost = clip_costs_.constFind(block);
+
+            if (cost != clip_costs_.constEnd()) {
+              double share = double(*cost) / double(max_clip_cost_);
+              painter->fillRect(r, QColor::fromHsvF((1.0 - share) / 3.0, 1.0, 1.0, 0.4));
+            }
+          }
+
           // Draw waveform
           if (show_waveforms_) {
             QRect waveform_rect = r.adjusted(0, text_total_height, 0, 0).toRect();
@@ -542,6 +622,11 @@ void TimelineView::ConnectTrackList(TrackList *list)
   if (connected_track_list_) {
     connect(connected_track_list_, &TrackList::TrackListChanged, this, &TimelineView::TrackListChanged);
   }
+
+  // Costs are per clip, so don't show the old sequence's
+  if (show_render_cost_) {
+    UpdateRenderCosts();
+  }
 }
 
 void TimelineView::SetBeamCursor(const TimelineCoordinate &coord)
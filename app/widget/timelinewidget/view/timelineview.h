@@ -26,6 +26,7 @@
 #include <QDragMoveEvent>
 #include <QDragLeaveEvent>
 #include <QDropEvent>
+#include <QTimer>
 
 #include "node/block/clip/clip.h"
 #include "timelineviewmouseevent.h"
@@ -46,6 +47,8 @@ public:
   TimelineView(Qt::Alignment vertical_alignment = Qt::AlignTop,
                QWidget* parent = nullptr);
 
+  virtual ~TimelineView() override;
+
   int GetTrackY(int track_index) const;
   int GetTrackHeight(int track_index) const;
 
@@ -81,6 +84,16 @@ public:
     viewport()->update();
   }
 
+  bool GetShowRenderCost() const
+  {
+    return show_render_cost_;
+  }
+
+  /**
+   * @brief Shade clips by how long they took to render in recently profiled frames
+   */
+  void SetShowRenderCost(bool e);
+
 signals:
   void MousePressed(TimelineViewMouseEvent* event);
   void MouseMoved(TimelineViewMouseEvent* event);
@@ -123,6 +136,8 @@ private:
 
   void DrawBlocks(QPainter* painter, bool foreground);
 
+  void UpdateRenderCosts();
+
   int GetHeightOfAllTracks() const;
 
   void UserSetTime(const int64_t& time);
@@ -141,6 +156,14 @@ private:
 
   bool show_waveforms_;
 
+  bool show_render_cost_;
+
+  QTimer render_cost_timer_;
+
+  // Each clip's cost including everything upstream of it, and the highest of those
+  QHash<const Block*, qint64> clip_costs_;
+  qint64 max_clip_cost_;
+
 private slots:
   void TrackListChanged();
 
@@ -20,7 +20,6 @@
 
 #include "viewer.h"
 
-#include <QDateTime>
 #include <QGuiApplication>
 #include <QInputDialog>
 #include <QLabel>
@@ -128,6 +127,9 @@ ViewerWidget::ViewerWidget(QWidget *parent) :
 
   connect(&playback_backup_timer_, &QTimer::timeout, this, &ViewerWidget::PlaybackTimerUpdate);
 
+  // Replace the low resolution previews rendered during a drag once it's over
+  connect(&auto_cacher_, &PreviewAutoCacher::InteractiveDragFinished, this, &ViewerWidget::UpdateTextureFromNode);
+
   SetAutoMaxScrollBar(true);
 
   instances_.append(this);
@@ -414,20 +416,12 @@ void ViewerWidget::SetEmptyImage()
   if (GetConnectedNode()) {
     frame = last_loaded_buffer_;
 
-    if (!frame) {
+    // Only reuse the last buffer if it's already blank. Frames that have been displayed may still
+    // be read elsewhere (e.g. by scope analysis on another thread) so they mustn't be overwritten.
+    if (!frame || !last_loaded_buffer_is_empty_ || frame->video_params() != GetConnectedNode()->GetVideoParams()) {
       frame = Frame::Create();
-    }
-
-    if (frame->video_params() != GetConnectedNode()->GetVideoParams()) {
-      frame->destroy();
       frame->set_video_params(GetConnectedNode()->GetVideoParams());
-    }
-
-    if (!frame->is_allocated()) {
       frame->allocate();
-    }
-
-    if (!last_loaded_buffer_is_empty_) {
       memset(frame->data(), 0, frame->allocated_size());
     }
   }
@@ -524,7 +518,7 @@ void ViewerWidget::UpdateTextureFromNode()
       RenderTicketWatcher* watcher = new RenderTicketWatcher();
       connect(watcher, &RenderTicketWatcher::Finished, this, &ViewerWidget::RendererGeneratedFrame);
       nonqueue_watchers_.append(watcher);
-      watcher->SetTicket(GetFrame(time, false, true));
+      watcher->SetTicket(GetFrame(time, false, RenderManager::kPriorityInteractive));
     }
   } else {
     // There is definitely no frame here, we can immediately flip to showing nothing
@@ -582,15 +576,15 @@ void ViewerWidget::PlayInternal(int speed, bool in_to_out_only)
     if (prequeue_length_ > 0) {
       prequeuing_ = true;
 
-      // We "prioritize" the frames, which means they're pushed to the top of the render queue,
-      // we queue in reverse so that they're still queued in order
+      // Playback frames are ordered by deadline in the render queue, so these run in order even
+      // though we request them in reverse
 
       playback_queue_next_frame_ += playback_speed_ * prequeue_length_;
       int64_t temp = playback_queue_next_frame_;
 
       for (int i=0; i<prequeue_length_; i++) {
         playback_queue_next_frame_ -= playback_speed_;
-        RequestNextFrameForQueue(true, false);
+        RequestNextFrameForQueue(false);
       }
 
       playback_queue_next_frame_ = temp;
@@ -706,12 +700,13 @@ void ViewerWidget::SetDisplayImage(FramePtr frame, bool main_only)
 
   last_loaded_buffer_ = frame;
   last_loaded_buffer_is_empty_ = false;
-  emit LoadedBuffer(frame.get());
+  emit LoadedBuffer(frame);
 }
 
-void ViewerWidget::RequestNextFrameForQueue(bool prioritize, bool increment)
+void ViewerWidget::RequestNextFrameForQueue(bool increment)
 {
-  rational next_time = Timecode::timestamp_to_time(playback_queue_next_frame_,
+  int64_t next_timestamp = playback_queue_next_frame_;
+  rational next_time = Timecode::timestamp_to_time(next_timestamp,
                                                    timebase());
 
   if (FrameExistsAtTime(next_time) || ViewerMightBeAStill()) {
@@ -721,12 +716,12 @@ void ViewerWidget::RequestNextFrameForQueue(bool prioritize, bool increment)
 
     RenderTicketWatcher* watcher = new RenderTicketWatcher();
     connect(watcher, &RenderTicketWatcher::Finished, this, &ViewerWidget::RendererGeneratedFrameForQueue);
-    watcher->SetTicket(GetFrame(next_time, false, prioritize));
+    watcher->SetTicket(GetFrame(next_time, false, RenderManager::kPriorityPlayback, GetPlaybackDeadline(next_timestamp)));
     active_queue_jobs_++;
   }
 }
 
-RenderTicketPtr ViewerWidget::GetFrame(const rational &t, bool clear_render_queue, bool prioritize)
+RenderTicketPtr ViewerWidget::GetFrame(const rational &t, bool clear_render_queue, ThreadPool::Priority priority, qint64 deadline)
 {
   QByteArray cached_hash = GetConnectedNode()->video_frame_cache()->GetHash(t);
 
@@ -738,7 +733,7 @@ RenderTicketPtr ViewerWidget::GetFrame(const rational &t, bool clear_render_queu
       auto_cacher_.ClearVideoQueue();
     }
 
-    return auto_cacher_.GetSingleFrame(t, prioritize);
+    return auto_cacher_.GetSingleFrame(t, priority, deadline);
   } else {
     // Frame has been cached, grab the frame
     RenderTicketPtr ticket = std::make_shared<RenderTicket>();
@@ -748,6 +743,18 @@ RenderTicketPtr ViewerWidget::GetFrame(const rational &t, bool clear_render_queu
   }
 }
 
+qint64 ViewerWidget::GetPlaybackDeadline(const int64_t &timestamp)
+{
+  if (prequeuing_) {
+    // Playback hasn't started yet, assume it's about to start from the playhead
+    int64_t frames_away = (timestamp - ruler()->GetTime()) / playback_speed_;
+
+    return ThreadPool::Now() + qRound64(frames_away * timebase_dbl() * 1000);
+  }
+
+  return playback_timer_.GetTimestampDeadline(timestamp);
+}
+
 void ViewerWidget::FinishPlayPreprocess()
 {
   int64_t playback_start_time = ruler()->GetTime();
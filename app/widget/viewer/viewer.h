@@ -128,7 +128,7 @@ signals:
   /**
    * @brief Signal emitted when a new frame is loaded
    */
-  void LoadedBuffer(Frame* load_buffer);
+  void LoadedBuffer(FramePtr load_buffer);
 
   /**
    * @brief Request a scope panel
@@ -187,9 +187,14 @@ private:
 
   void SetDisplayImage(FramePtr frame, bool main_only);
 
-  void RequestNextFrameForQueue(bool prioritize = false, bool increment = true);
+  void RequestNextFrameForQueue(bool increment = true);
 
-  RenderTicketPtr GetFrame(const rational& t, bool clear_render_queue, bool prioritize);
+  RenderTicketPtr GetFrame(const rational& t, bool clear_render_queue, ThreadPool::Priority priority, qint64 deadline = 0);
+
+  /**
+   * @brief Time (in ThreadPool::Now() time) that playback will display a timestamp
+   */
+  qint64 GetPlaybackDeadline(const int64_t& timestamp);
 
   void FinishPlayPreprocess();
 
@@ -20,14 +20,15 @@
 
 #include "viewerplaybacktimer.h"
 
-#include <QDateTime>
 #include <QtMath>
 
+#include "threading/threadpool.h"
+
 namespace olive {
 
 void ViewerPlaybackTimer::Start(const int64_t &start_timestamp, const int &playback_speed, const double &timebase)
 {
-  start_msec_ = QDateTime::currentMSecsSinceEpoch();
+  start_msec_ = ThreadPool::Now();
   start_timestamp_ = start_timestamp;
   playback_speed_ = playback_speed;
   timebase_ = timebase * 1000;
@@ -35,11 +36,18 @@ void ViewerPlaybackTimer::Start(const int64_t &start_timestamp, const int &playb
 
 int64_t ViewerPlaybackTimer::GetTimestampNow() const
 {
-  int64_t real_time = QDateTime::currentMSecsSinceEpoch() - start_msec_;
+  int64_t real_time = ThreadPool::Now() - start_msec_;
 
   int64_t frames_since_start = qFloor(static_cast<double>(real_time) / (timebase_));
 
   return start_timestamp_ + frames_since_start * playback_speed_;
 }
 
+qint64 ViewerPlaybackTimer::GetTimestampDeadline(const int64_t &timestamp) const
+{
+  int64_t frames_since_start = (timestamp - start_timestamp_) / playback_speed_;
+
+  return start_msec_ + qRound64(frames_since_start * timebase_);
+}
+
 }
@@ -33,6 +33,11 @@ public:
 
   int64_t GetTimestampNow() const;
 
+  /**
+   * @brief Time (in ThreadPool::Now() time) that a timestamp will be displayed
+   */
+  qint64 GetTimestampDeadline(const int64_t& timestamp) const;
+
 private:
   qint64 start_msec_;
   int64_t start_timestamp_;
@@ -0,0 +1,63 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2021 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#ifndef BENCHMARKUTIL_H
+#define BENCHMARKUTIL_H
+
+#include <iostream>
+#include <QDateTime>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+namespace olive {
+
+/**
+ * @brief Reports one measurement from a benchmark
+ *
+ * The result is printed after the test's name. If the OLIVE_BENCHMARK_OUTPUT environment variable
+ * is set, it's also appended to that file as one line of JSON so runs can be compared over time.
+ */
+inline void BenchmarkResult(const QString& name, double value, const QString& unit)
+{
+  std::cout << " (" << name.toStdString() << ": " << value << " " << unit.toStdString() << ")";
+
+  QString output = QString::fromLocal8Bit(qgetenv("OLIVE_BENCHMARK_OUTPUT"));
+  if (output.isEmpty()) {
+    return;
+  }
+
+  QFile f(output);
+  if (f.open(QFile::WriteOnly | QFile::Append)) {
+    QJsonObject result;
+    result.insert(QStringLiteral("benchmark"), name);
+    result.insert(QStringLiteral("value"), value);
+    result.insert(QStringLiteral("unit"), unit);
+    result.insert(QStringLiteral("time"), QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+
+    f.write(QJsonDocument(result).toJson(QJsonDocument::Compact));
+    f.write("\n");
+    f.close();
+  }
+}
+
+}
+
+#endif // BENCHMARKUTIL_H
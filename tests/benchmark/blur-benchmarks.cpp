@@ -0,0 +1,70 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2021 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#include "testutil.h"
+
+#include "benchmark/benchmarkutil.h"
+#include "node/filter/blur/blur.h"
+
+namespace olive {
+
+/**
+ * @brief Reports how many texture samples blur.frag takes per output pixel as the radius grows
+ *
+ * There's no headless GPU renderer to time blur.frag with, so this only counts taps, it doesn't
+ * measure time or bandwidth. For a blur along both axes it reports the largest number of
+ * iterations (full-frame draws), the largest number of taps per output pixel, and those taps
+ * weighted by the fraction of the frame each iteration draws at its divider.
+ * The plan's own limits are checked by blur-tests.
+ */
+OLIVE_ADD_TEST(BlurTapsOverRadius)
+{
+  const int kMaximumRadius = 500;
+
+  for (int method=BlurFilterNode::kMethodBox; method<=BlurFilterNode::kMethodGaussian; method++) {
+    int max_iterations = 0;
+    int max_taps = 0;
+    double max_weighted_taps = 0;
+
+    for (int radius=1; radius<=kMaximumRadius; radius++) {
+      BlurFilterNode::Plan plan = BlurFilterNode::PlanBlur(static_cast<BlurFilterNode::Method>(method), radius, true);
+
+      int iterations = plan.GetPassesPerAxis() * 2;
+      int taps = plan.GetTapsPerPixel() * 2;
+
+      // Every iteration but the last draws 1/divider^2 of the pixels
+      double last_taps = plan.boxes ? plan.GetLastPassTaps() : plan.direct_taps;
+      double weighted_taps = (taps - last_taps) / (plan.divider * plan.divider) + last_taps;
+
+      max_iterations = qMax(max_iterations, iterations);
+      max_taps = qMax(max_taps, taps);
+      max_weighted_taps = qMax(max_weighted_taps, weighted_taps);
+    }
+
+    QString name = (method == BlurFilterNode::kMethodBox) ? QStringLiteral("box") : QStringLiteral("gaussian");
+
+    BenchmarkResult(QStringLiteral("blur_%1_max_iterations").arg(name), max_iterations, QStringLiteral("draws"));
+    BenchmarkResult(QStringLiteral("blur_%1_max_taps").arg(name), max_taps, QStringLiteral("samples/pixel"));
+    BenchmarkResult(QStringLiteral("blur_%1_max_weighted_taps").arg(name), max_weighted_taps, QStringLiteral("samples/output pixel"));
+  }
+
+  OLIVE_TEST_END;
+}
+
+}
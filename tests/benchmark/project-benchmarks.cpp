@@ -0,0 +1,369 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2021 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "testutil.h"
+
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+
+extern "C" {
+#include <libavutil/channel_layout.h>
+}
+
+#include "benchmark/benchmarkutil.h"
+#include "node/block/clip/clip.h"
+#include "node/distort/transform/transformdistortnode.h"
+#include "node/generator/solid/solid.h"
+#include "node/project/project.h"
+#include "node/project/sequence/sequence.h"
+#include "node/traverser.h"
+#include "render/framehashcache.h"
+#include "render/rendermanager.h"
+#include "render/renderprocessor.h"
+#include "widget/timelinewidget/timelineundo.h"
+
+namespace olive {
+
+// Shape of the synthetic project every benchmark here runs against
+const int kVideoTracks = 8;
+const int kAudioTracks = 4;
+const int kClipsPerTrack = 50;
+const int kEffectDepth = 8;
+const int kKeyframesPerEffect = 10;
+const rational kClipLength(2);
+
+#define BENCHMARK_PROJECT_START \
+  Project project; \
+  Sequence sequence; \
+  sequence.setParent(&project); \
+  BuildSyntheticSequence(&project, &sequence)
+
+static VideoParams GetBenchmarkVideoParams()
+{
+  VideoParams params(1920, 1080, rational(1, 30), VideoParams::kFormatFloat16, VideoParams::kRGBAChannelCount);
+  params.set_frame_rate(rational(30));
+  return params;
+}
+
+static AudioParams GetBenchmarkAudioParams()
+{
+  return AudioParams(48000, AV_CH_LAYOUT_STEREO, AudioParams::kInternalFormat);
+}
+
+static rational GetSequenceLength()
+{
+  return kClipLength * kClipsPerTrack;
+}
+
+/**
+ * @brief Fills a sequence with tracks of clips, each with a deep chain of keyframed effects
+ *
+ * Video clips are a solid passed through kEffectDepth transforms, each with its rotation keyframed
+ * kKeyframesPerEffect times over the clip. Audio clips are empty, so audio renders measure the
+ * timeline's mixing and waveform work rather than decoding.
+ */
+static void BuildSyntheticSequence(Project* project, Sequence* sequence)
+{
+  sequence->SetVideoParams(GetBenchmarkVideoParams());
+  sequence->SetAudioParams(GetBenchmarkAudioParams());
+
+  for (int i=0; i<kVideoTracks; i++) {
+    Track* track = TimelineAddTrackCommand::RunImmediately(sequence->track_list(Track::kVideo), true);
+
+    for (int j=0; j<kClipsPerTrack; j++) {
+      SolidGenerator* solid = new SolidGenerator();
+      solid->setParent(project);
+      solid->SetStandardValue(SolidGenerator::kColorInput, QVariant::fromValue(Color(double(i) / kVideoTracks, double(j) / kClipsPerTrack, 0.5)));
+
+      Node* last = solid;
+
+      for (int k=0; k<kEffectDepth; k++) {
+        TransformDistortNode* transform = new TransformDistortNode();
+        transform->setParent(project);
+        transform->SetInputIsKeyframing(TransformDistortNode::kRotationInput, true);
+
+        for (int l=0; l<kKeyframesPerEffect; l++) {
+          rational key_time = kClipLength * rational(l, kKeyframesPerEffect);
+          new NodeKeyframe(key_time, double(l * 10 + k), NodeKeyframe::kLinear, 0, -1, TransformDistortNode::kRotationInput, transform);
+        }
+
+        Node::ConnectEdge(last, NodeInput(transform, TransformDistortNode::kTextureInput));
+        last = transform;
+      }
+
+      ClipBlock* clip = new ClipBlock();
+      clip->setParent(project);
+      clip->set_length_and_media_out(kClipLength);
+      Node::ConnectEdge(last, NodeInput(clip, ClipBlock::kBufferIn));
+      track->AppendBlock(clip);
+    }
+  }
+
+  for (int i=0; i<kAudioTracks; i++) {
+    Track* track = TimelineAddTrackCommand::RunImmediately(sequence->track_list(Track::kAudio), true);
+
+    for (int j=0; j<kClipsPerTrack; j++) {
+      ClipBlock* clip = new ClipBlock();
+      clip->setParent(project);
+      clip->set_length_and_media_out(kClipLength);
+      track->AppendBlock(clip);
+    }
+  }
+}
+
+/**
+ * @brief Times hashing frames spread across the whole synthetic sequence
+ */
+OLIVE_ADD_TEST(HashSyntheticSequence)
+{
+  const int kFrames = 300;
+
+  BENCHMARK_PROJECT_START;
+
+  VideoParams params = GetBenchmarkVideoParams();
+  NodeOutput output = sequence.GetConnectedTextureOutput();
+  OLIVE_ASSERT(output.IsValid());
+
+  rational step = GetSequenceLength() / kFrames;
+
+  // Hashing must be stable, and keyframes must make neighbouring frames differ
+  QByteArray first = RenderManager::Hash(output, params, 0);
+  OLIVE_ASSERT(first == RenderManager::Hash(output, params, 0));
+  OLIVE_ASSERT(first != RenderManager::Hash(output, params, rational(1, 2)));
+
+  QElapsedTimer timer;
+  timer.start();
+
+  for (int i=0; i<kFrames; i++) {
+    RenderManager::Hash(output, params, step * i);
+  }
+
+  qint64 elapsed = timer.nsecsElapsed();
+
+  BenchmarkResult(QStringLiteral("hash_synthetic_sequence"), double(elapsed) / kFrames / 1000.0, QStringLiteral("us/frame"));
+
+  OLIVE_TEST_END;
+}
+
+/**
+ * @brief Times traversing frames spread across the whole synthetic sequence
+ *
+ * The plain NodeTraverser doesn't run shaders, so this is the cost of resolving values, keyframes
+ * and jobs for every node that contributes to each frame.
+ */
+OLIVE_ADD_TEST(TraverseSyntheticSequence)
+{
+  const int kFrames = 300;
+
+  BENCHMARK_PROJECT_START;
+
+  VideoParams params = GetBenchmarkVideoParams();
+  NodeOutput output = sequence.GetConnectedTextureOutput();
+  OLIVE_ASSERT(output.IsValid());
+
+  NodeTraverser traverser;
+  traverser.SetCacheVideoParams(params);
+
+  rational frame_length = params.frame_rate_as_time_base();
+  rational step = GetSequenceLength() / kFrames;
+
+  NodeValueTable table = traverser.GenerateTable(output, TimeRange(0, frame_length));
+  OLIVE_ASSERT(table.Has(NodeValue::kTexture));
+
+  QElapsedTimer timer;
+  timer.start();
+
+  for (int i=0; i<kFrames; i++) {
+    rational t = step * i;
+    traverser.GenerateTable(output, TimeRange(t, t + frame_length));
+  }
+
+  qint64 elapsed = timer.nsecsElapsed();
+
+  BenchmarkResult(QStringLiteral("traverse_synthetic_sequence"), double(elapsed) / kFrames / 1000.0, QStringLiteral("us/frame"));
+
+  OLIVE_TEST_END;
+}
+
+static qint64 RenderSequenceAudio(Sequence* sequence, bool waveforms, bool* ok)
+{
+  AudioParams params = GetBenchmarkAudioParams();
+
+  // Render in the same one-second chunks the preview cacher does
+  const rational kChunk(1);
+
+  QElapsedTimer timer;
+  timer.start();
+
+  for (rational t=0; t<GetSequenceLength(); t+=kChunk) {
+    RenderTicketPtr ticket = std::make_shared<RenderTicket>();
+
+    ticket->setProperty("viewer", Node::PtrToValue(sequence));
+    ticket->setProperty("time", QVariant::fromValue(TimeRange(t, t + kChunk)));
+    ticket->setProperty("type", RenderManager::kTypeAudio);
+    ticket->setProperty("enablewaveforms", waveforms);
+    ticket->setProperty("aparam", QVariant::fromValue(params));
+
+    ticket->Start();
+    RenderProcessor::Process(ticket, nullptr, nullptr, nullptr, nullptr, QVariant(), nullptr);
+
+    SampleBufferPtr samples = ticket->Get().value<SampleBufferPtr>();
+    if (!samples || samples->sample_count() != params.time_to_samples(kChunk)) {
+      *ok = false;
+    }
+  }
+
+  return timer.elapsed();
+}
+
+/**
+ * @brief Times rendering the synthetic sequence's audio, with and without waveform generation
+ */
+OLIVE_ADD_TEST(RenderSyntheticAudio)
+{
+  BENCHMARK_PROJECT_START;
+
+  bool ok = true;
+
+  qint64 without_waveforms = RenderSequenceAudio(&sequence, false, &ok);
+  qint64 with_waveforms = RenderSequenceAudio(&sequence, true, &ok);
+
+  OLIVE_ASSERT(ok);
+
+  double length_ms = GetSequenceLength().toDouble() * 1000.0;
+
+  BenchmarkResult(QStringLiteral("render_audio"), length_ms / qMax(without_waveforms, qint64(1)), QStringLiteral("x realtime"));
+  BenchmarkResult(QStringLiteral("render_audio_waveforms"), length_ms / qMax(with_waveforms, qint64(1)), QStringLiteral("x realtime"));
+
+  OLIVE_TEST_END;
+}
+
+/**
+ * @brief Times the TimeRangeList operations the frame and audio caches lean on
+ */
+OLIVE_ADD_TEST(TimeRangeListOperations)
+{
+  const int kRanges = 20000;
+
+  QElapsedTimer timer;
+  timer.start();
+
+  // Insert every other half second, leaving gaps
+  TimeRangeList list;
+  for (int i=0; i<kRanges; i++) {
+    list.insert(TimeRange(i, rational(i * 2 + 1, 2)));
+  }
+  OLIVE_ASSERT(list.size() == kRanges);
+
+  qint64 insert_elapsed = timer.nsecsElapsed();
+  timer.restart();
+
+  // Query every range against a second-long window
+  int intersections = 0;
+  for (int i=0; i<kRanges; i++) {
+    intersections += list.Intersects(TimeRange(rational(i * 2 + 1, 4), rational(i * 2 + 5, 4))).size();
+    if (list.contains(TimeRange(i, rational(i * 4 + 1, 4)))) {
+      intersections++;
+    }
+  }
+  OLIVE_ASSERT(intersections > 0);
+
+  qint64 query_elapsed = timer.nsecsElapsed();
+  timer.restart();
+
+  // Fill the gaps so everything merges into one range, then punch them out again
+  for (int i=0; i<kRanges; i++) {
+    list.insert(TimeRange(rational(i * 2 + 1, 2), i + 1));
+  }
+  OLIVE_ASSERT(list.size() == 1);
+
+  for (int i=0; i<kRanges; i++) {
+    list.remove(TimeRange(rational(i * 2 + 1, 2), i + 1));
+  }
+  OLIVE_ASSERT(list.size() == kRanges);
+
+  qint64 merge_elapsed = timer.nsecsElapsed();
+
+  BenchmarkResult(QStringLiteral("timerangelist_insert"), double(insert_elapsed) / kRanges, QStringLiteral("ns/op"));
+  BenchmarkResult(QStringLiteral("timerangelist_query"), double(query_elapsed) / kRanges, QStringLiteral("ns/op"));
+  BenchmarkResult(QStringLiteral("timerangelist_merge_remove"), double(merge_elapsed) / (kRanges * 2), QStringLiteral("ns/op"));
+
+  OLIVE_TEST_END;
+}
+
+/**
+ * @brief Times writing and reading full HD frames through the disk frame cache
+ */
+OLIVE_ADD_TEST(FrameCacheIO)
+{
+  const int kFrames = 30;
+
+  QTemporaryDir cache_dir;
+  OLIVE_ASSERT(cache_dir.isValid());
+
+  VideoParams params = GetBenchmarkVideoParams();
+  params.set_format(VideoParams::kFormatFloat32);
+
+  FramePtr frame = Frame::Create();
+  frame->set_video_params(params);
+  OLIVE_ASSERT(frame->allocate());
+
+  // A gradient compresses like real footage far more than noise or a flat color would
+  for (int y=0; y<params.height(); y++) {
+    float* line = reinterpret_cast<float*>(frame->data() + y * frame->linesize_bytes());
+    for (int x=0; x<params.width(); x++) {
+      line[x * 4 + 0] = float(x) / params.width();
+      line[x * 4 + 1] = float(y) / params.height();
+      line[x * 4 + 2] = 0.5f;
+      line[x * 4 + 3] = 1.0f;
+    }
+  }
+
+  QVector<QByteArray> hashes(kFrames);
+  for (int i=0; i<kFrames; i++) {
+    hashes[i] = QCryptographicHash::hash(QByteArray::number(i), QCryptographicHash::Sha1);
+  }
+
+  QElapsedTimer timer;
+  timer.start();
+
+  for (int i=0; i<kFrames; i++) {
+    OLIVE_ASSERT(FrameHashCache::SaveCacheFrame(cache_dir.path(), hashes.at(i), frame));
+  }
+
+  qint64 write_elapsed = timer.elapsed();
+  timer.restart();
+
+  for (int i=0; i<kFrames; i++) {
+    FramePtr loaded = FrameHashCache::LoadCacheFrame(cache_dir.path(), hashes.at(i));
+    OLIVE_ASSERT(loaded);
+    OLIVE_ASSERT(loaded->width() == params.width() && loaded->height() == params.height());
+  }
+
+  qint64 read_elapsed = timer.elapsed();
+
+  BenchmarkResult(QStringLiteral("frame_cache_write"), double(write_elapsed) / kFrames, QStringLiteral("ms/frame"));
+  BenchmarkResult(QStringLiteral("frame_cache_read"), double(read_elapsed) / kFrames, QStringLiteral("ms/frame"));
+
+  OLIVE_TEST_END;
+}
+
+}
@@ -0,0 +1,118 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2021 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "testutil.h"
+
+#include <QElapsedTimer>
+#include <QMatrix4x4>
+
+#include "benchmark/benchmarkutil.h"
+#include "node/math/math/math.h"
+#include "node/project/project.h"
+#include "node/traverser.h"
+
+namespace olive {
+
+/**
+ * @brief Times NodeTraverser::GenerateTable() over a long chain of math nodes
+ *
+ * Every node in the chain reads one connected input and one standard value, so this mostly
+ * measures value lookups and table handling rather than any actual processing.
+ */
+OLIVE_ADD_TEST(GenerateTable200Nodes)
+{
+  const int kNodeCount = 200;
+  const int kIterations = 200;
+
+  Project project;
+
+  MathNode* last = nullptr;
+
+  for (int i=0; i<kNodeCount; i++) {
+    MathNode* math = new MathNode();
+    math->setParent(&project);
+    math->SetOperation(MathNode::kOpAdd);
+    math->SetStandardValue(MathNode::kParamBIn, 1.0);
+
+    if (last) {
+      Node::ConnectEdge(last, NodeInput(math, MathNode::kParamAIn));
+    }
+
+    last = math;
+  }
+
+  NodeTraverser traverser;
+  TimeRange range(0, rational(1, 30));
+
+  // Warm up once and make sure the chain actually evaluated
+  NodeValueTable table = traverser.GenerateTable(last, Node::kDefaultOutput, range);
+  OLIVE_ASSERT(qAbs(table.Get<double>(NodeValue::kFloat) - kNodeCount) < 0.000001);
+
+  QElapsedTimer timer;
+  timer.start();
+
+  for (int i=0; i<kIterations; i++) {
+    traverser.GenerateTable(last, Node::kDefaultOutput, range);
+  }
+
+  qint64 elapsed = timer.nsecsElapsed();
+
+  BenchmarkResult(QStringLiteral("generate_table_200_nodes"), double(elapsed) / kIterations / 1000.0, QStringLiteral("us/table"));
+
+  OLIVE_TEST_END;
+}
+
+/**
+ * @brief Times looking up a matrix in a table boxed through QVariant and typed
+ *
+ * Matrices are too large for QVariant to hold without allocating, so the boxed lookup allocates
+ * every time while the typed one shouldn't touch the heap at all.
+ */
+OLIVE_ADD_TEST(TableMatrixLookup)
+{
+  const int kIterations = 1000000;
+
+  NodeValueTable table;
+  QMatrix4x4 m;
+  m.translate(1.0f, 2.0f);
+  table.Push(NodeValue::kMatrix, m, nullptr);
+  table.Push(NodeValue::kFloat, 1.0, nullptr);
+
+  QElapsedTimer timer;
+  float sum = 0;
+
+  timer.start();
+  for (int i=0; i<kIterations; i++) {
+    sum += table.Get(NodeValue::kMatrix).value<QMatrix4x4>()(0, 3);
+  }
+  BenchmarkResult(QStringLiteral("table_matrix_lookup_boxed"), double(timer.nsecsElapsed()) / kIterations, QStringLiteral("ns/lookup"));
+
+  timer.restart();
+  for (int i=0; i<kIterations; i++) {
+    sum += table.Get<QMatrix4x4>(NodeValue::kMatrix)(0, 3);
+  }
+  BenchmarkResult(QStringLiteral("table_matrix_lookup_typed"), double(timer.nsecsElapsed()) / kIterations, QStringLiteral("ns/lookup"));
+
+  OLIVE_ASSERT(sum == 2.0f * kIterations);
+
+  OLIVE_TEST_END;
+}
+
+}
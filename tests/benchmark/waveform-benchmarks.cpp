@@ -0,0 +1,83 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2021 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#include "testutil.h"
+
+#include <cmath>
+#include <QElapsedTimer>
+
+extern "C" {
+#include <libavutil/channel_layout.h>
+}
+
+#include "audio/audiovisualwaveform.h"
+#include "benchmark/benchmarkutil.h"
+
+namespace olive {
+
+static SampleBufferPtr CreateTestBuffer(int sample_rate, int seconds)
+{
+  SampleBufferPtr buffer = SampleBuffer::CreateAllocated(AudioParams(sample_rate, AV_CH_LAYOUT_STEREO, AudioParams::kInternalFormat),
+                                                         sample_rate * seconds);
+
+  for (int channel=0; channel<buffer->audio_params().channel_count(); channel++) {
+    float* data = buffer->data(channel);
+
+    for (int i=0; i<buffer->sample_count(); i++) {
+      data[i] = 0.5f * std::sin(i * 0.01f * (channel + 1));
+    }
+  }
+
+  return buffer;
+}
+
+/**
+ * @brief Times waveform generation over an hour of 48 kHz stereo
+ *
+ * Audio is summarized in 10 second chunks, each into its own AudioVisualWaveform, the same way
+ * render tickets generate waveforms before they're merged into a track.
+ */
+OLIVE_ADD_TEST(GenerateWaveformHourStereo)
+{
+  const int kSampleRate = 48000;
+  const int kChunkSeconds = 10;
+  const int kTotalSeconds = 3600;
+
+  SampleBufferPtr buffer = CreateTestBuffer(kSampleRate, kChunkSeconds);
+
+  QElapsedTimer timer;
+  timer.start();
+
+  for (int i=0; i<kTotalSeconds; i+=kChunkSeconds) {
+    AudioVisualWaveform waveform;
+    waveform.set_channel_count(buffer->audio_params().channel_count());
+    waveform.OverwriteSamples(buffer, kSampleRate);
+
+    OLIVE_ASSERT(waveform.length() == rational(kChunkSeconds));
+  }
+
+  qint64 elapsed = timer.elapsed();
+
+  BenchmarkResult(QStringLiteral("generate_waveform_hour_stereo"), elapsed, QStringLiteral("ms"));
+  BenchmarkResult(QStringLiteral("generate_waveform_realtime"), elapsed > 0 ? double(kTotalSeconds) * 1000.0 / elapsed : 0.0, QStringLiteral("x realtime"));
+
+  OLIVE_TEST_END;
+}
+
+}
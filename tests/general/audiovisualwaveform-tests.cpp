@@ -0,0 +1,323 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2021 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "testutil.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <QVector>
+
+extern "C" {
+#include <libavutil/channel_layout.h>
+}
+
+#include "audio/audiovisualwaveform.h"
+
+namespace olive {
+
+using SamplePerChannel = AudioVisualWaveform::SamplePerChannel;
+
+static const float kNaN = std::numeric_limits<float>::quiet_NaN();
+
+/**
+ * @brief Small deterministic generator so failures are reproducible
+ */
+static float NextValue(quint32* state)
+{
+  *state = *state * 1664525u + 1013904223u;
+  return float(*state >> 8) / float(1 << 24) * 2.0f - 1.0f;
+}
+
+// Scalar references, written the way the summaries were computed before they were vectorized
+
+static void ReferenceSumPlanar(const float* samples, int nb_samples, SamplePerChannel* out)
+{
+  for (int i=0; i<nb_samples; i++) {
+    if (samples[i] < out->min) {
+      out->min = samples[i];
+    }
+
+    if (samples[i] > out->max) {
+      out->max = samples[i];
+    }
+  }
+}
+
+static void ReferenceReSum(const SamplePerChannel* samples, int nb_samples, int nb_channels, SamplePerChannel* out)
+{
+  for (int i=0; i+nb_channels<=nb_samples; i+=nb_channels) {
+    for (int j=0; j<nb_channels; j++) {
+      const SamplePerChannel& sample = samples[i + j];
+
+      if (sample.min < out[j].min) {
+        out[j].min = sample.min;
+      }
+
+      if (sample.max > out[j].max) {
+        out[j].max = sample.max;
+      }
+    }
+  }
+}
+
+static bool SameSummary(const SamplePerChannel& a, const SamplePerChannel& b)
+{
+  // NaNs must never leak into a summary, so they don't compare equal here either
+  return a.min == b.min && a.max == b.max;
+}
+
+OLIVE_ADD_TEST(SumPlanarMatchesScalar)
+{
+  quint32 state = 1;
+
+  // Every length around the vector width, including ones that leave a scalar tail
+  for (int length=0; length<=37; length++) {
+    QVector<float> samples(length);
+    for (int i=0; i<length; i++) {
+      samples[i] = NextValue(&state);
+    }
+
+    for (int start=0; start<2; start++) {
+      // Summaries either start empty or carry over from a previous chunk
+      SamplePerChannel initial = (start == 0) ? SamplePerChannel{0.0f, 0.0f} : SamplePerChannel{-0.25f, 0.25f};
+
+      SamplePerChannel expected = initial;
+      SamplePerChannel actual = initial;
+
+      ReferenceSumPlanar(samples.constData(), length, &expected);
+      AudioVisualWaveform::SumPlanarSamplesInto(samples.constData(), length, &actual);
+
+      OLIVE_ASSERT(SameSummary(actual, expected));
+    }
+  }
+
+  OLIVE_TEST_END;
+}
+
+OLIVE_ADD_TEST(SumPlanarSkipsNaN)
+{
+  quint32 state = 2;
+
+  for (int length=1; length<=19; length++) {
+    // Put a NaN at every position in turn, so it lands in the vector part and the scalar tail
+    for (int nan_index=0; nan_index<length; nan_index++) {
+      QVector<float> samples(length);
+      for (int i=0; i<length; i++) {
+        samples[i] = NextValue(&state);
+      }
+      samples[nan_index] = kNaN;
+
+      SamplePerChannel expected = {0.0f, 0.0f};
+      SamplePerChannel actual = {0.0f, 0.0f};
+
+      ReferenceSumPlanar(samples.constData(), length, &expected);
+      AudioVisualWaveform::SumPlanarSamplesInto(samples.constData(), length, &actual);
+
+      OLIVE_ASSERT(!std::isnan(actual.min) && !std::isnan(actual.max));
+      OLIVE_ASSERT(SameSummary(actual, expected));
+    }
+  }
+
+  // All NaN leaves the summary untouched
+  QVector<float> all_nan(9, kNaN);
+  SamplePerChannel sum = {-0.5f, 0.5f};
+  AudioVisualWaveform::SumPlanarSamplesInto(all_nan.constData(), all_nan.size(), &sum);
+  OLIVE_ASSERT(sum.min == -0.5f && sum.max == 0.5f);
+
+  OLIVE_TEST_END;
+}
+
+OLIVE_ADD_TEST(SumPlanarSilence)
+{
+  for (int length=0; length<=9; length++) {
+    QVector<float> silence(length, 0.0f);
+
+    SamplePerChannel sum = {0.0f, 0.0f};
+    AudioVisualWaveform::SumPlanarSamplesInto(silence.constData(), length, &sum);
+    OLIVE_ASSERT(sum.min == 0.0f && sum.max == 0.0f);
+  }
+
+  OLIVE_TEST_END;
+}
+
+OLIVE_ADD_TEST(ReSumMatchesScalar)
+{
+  quint32 state = 3;
+
+  // Odd channel counts leave a channel for the scalar path after the vectorized pairs
+  for (int channels=1; channels<=7; channels++) {
+    for (int rows=0; rows<=9; rows++) {
+      for (int with_nan=0; with_nan<2; with_nan++) {
+        QVector<SamplePerChannel> samples(rows * channels);
+
+        for (int i=0; i<samples.size(); i++) {
+          float a = NextValue(&state);
+          float b = NextValue(&state);
+          samples[i] = {qMin(a, b), qMax(a, b)};
+        }
+
+        if (with_nan && !samples.isEmpty()) {
+          // Poison the first and last channel of a row, covering both the vector and scalar path
+          samples[(rows / 2) * channels].min = kNaN;
+          samples[(rows / 2) * channels + channels - 1].max = kNaN;
+        }
+
+        QVector<SamplePerChannel> expected(channels);
+        QVector<SamplePerChannel> actual(channels);
+        for (int i=0; i<channels; i++) {
+          expected[i] = actual[i] = {-0.125f * i, 0.125f * i};
+        }
+
+        ReferenceReSum(samples.constData(), samples.size(), channels, expected.data());
+        AudioVisualWaveform::ReSumSamplesInto(samples.constData(), samples.size(), channels, actual.data());
+
+        for (int i=0; i<channels; i++) {
+          OLIVE_ASSERT(!std::isnan(actual.at(i).min) && !std::isnan(actual.at(i).max));
+          OLIVE_ASSERT(SameSummary(actual.at(i), expected.at(i)));
+        }
+
+        // The allocating version starts from an empty summary
+        QVector<SamplePerChannel> expected_from_zero(channels);
+        ReferenceReSum(samples.constData(), samples.size(), channels, expected_from_zero.data());
+
+        AudioVisualWaveform::Sample resum = AudioVisualWaveform::ReSumSamples(samples.constData(), samples.size(), channels);
+        OLIVE_ASSERT(resum.size() == channels);
+
+        for (int i=0; i<channels; i++) {
+          OLIVE_ASSERT(SameSummary(resum.at(i), expected_from_zero.at(i)));
+        }
+      }
+    }
+  }
+
+  OLIVE_TEST_END;
+}
+
+static SampleBufferPtr CreateTestBuffer(uint64_t layout, int sample_rate, int length)
+{
+  SampleBufferPtr buffer = SampleBuffer::CreateAllocated(AudioParams(sample_rate, layout, AudioParams::kInternalFormat),
+                                                         length);
+
+  for (int channel=0; channel<buffer->audio_params().channel_count(); channel++) {
+    float* data = buffer->data(channel);
+
+    for (int i=0; i<buffer->sample_count(); i++) {
+      data[i] = 0.5f * std::sin(i * 0.01f * (channel + 1));
+    }
+  }
+
+  return buffer;
+}
+
+OLIVE_ADD_TEST(SumSamplesOddChannels)
+{
+  // Three channels and a length that isn't a multiple of the vector width
+  SampleBufferPtr buffer = CreateTestBuffer(AV_CH_LAYOUT_2POINT1, 48000, 1001);
+  OLIVE_ASSERT(buffer->audio_params().channel_count() == 3);
+
+  buffer->data(2)[1000] = kNaN;
+  buffer->data(1)[999] = 0.75f;
+
+  for (int start=0; start<7; start++) {
+    int length = buffer->sample_count() - start * 3;
+
+    AudioVisualWaveform::Sample sum = AudioVisualWaveform::SumSamples(buffer, start, length);
+    OLIVE_ASSERT(sum.size() == 3);
+
+    for (int channel=0; channel<3; channel++) {
+      SamplePerChannel expected = {0.0f, 0.0f};
+      ReferenceSumPlanar(buffer->data(channel) + start, length, &expected);
+      OLIVE_ASSERT(SameSummary(sum.at(channel), expected));
+    }
+  }
+
+  OLIVE_TEST_END;
+}
+
+/**
+ * @brief Checks summaries against known peaks written into the buffer
+ */
+OLIVE_ADD_TEST(SummaryMatchesSamples)
+{
+  const int kSampleRate = 48000;
+
+  SampleBufferPtr buffer = CreateTestBuffer(AV_CH_LAYOUT_STEREO, kSampleRate, kSampleRate);
+
+  buffer->data(0)[1000] = 0.9f;
+  buffer->data(1)[1001] = -0.8f;
+
+  AudioVisualWaveform waveform;
+  waveform.set_channel_count(buffer->audio_params().channel_count());
+  waveform.OverwriteSamples(buffer, kSampleRate);
+
+  AudioVisualWaveform::Sample direct = AudioVisualWaveform::SumSamples(buffer, 0, buffer->sample_count());
+  OLIVE_ASSERT(direct.size() == 2);
+  OLIVE_ASSERT(direct.at(0).max == 0.9f);
+  OLIVE_ASSERT(direct.at(1).min == -0.8f);
+
+  // The smallest mipmaps are reduced from the larger ones, so the peaks must survive every level
+  // (to within the mipmaps' 16-bit quantization)
+  AudioVisualWaveform::Sample summary = waveform.GetSummaryFromTime(0, rational(1, 2));
+  OLIVE_ASSERT(summary.size() == 2);
+  OLIVE_ASSERT(qAbs(summary.at(0).max - 0.9f) < 0.0001f);
+  OLIVE_ASSERT(qAbs(summary.at(1).min + 0.8f) < 0.0001f);
+  OLIVE_ASSERT(summary.at(0).min >= -0.5001f && summary.at(1).max <= 0.5001f);
+
+  OLIVE_TEST_END;
+}
+
+OLIVE_ADD_TEST(SummaryOddChannelsNaNAndSilence)
+{
+  const int kSampleRate = 48000;
+
+  // Five channels: one is silent and one has NaNs scattered through it
+  SampleBufferPtr buffer = CreateTestBuffer(AV_CH_LAYOUT_5POINT0, kSampleRate, kSampleRate / 2 + 3);
+  OLIVE_ASSERT(buffer->audio_params().channel_count() == 5);
+
+  memset(buffer->data(0), 0, buffer->sample_count() * sizeof(float));
+
+  for (int i=0; i<buffer->sample_count(); i+=97) {
+    buffer->data(3)[i] = kNaN;
+  }
+
+  AudioVisualWaveform waveform;
+  waveform.set_channel_count(buffer->audio_params().channel_count());
+  waveform.OverwriteSamples(buffer, kSampleRate);
+
+  AudioVisualWaveform::Sample summary = waveform.GetSummaryFromTime(0, rational(1, 4));
+  OLIVE_ASSERT(summary.size() == 5);
+
+  // Silence stays exactly zero through quantization
+  OLIVE_ASSERT(summary.at(0).min == 0.0f && summary.at(0).max == 0.0f);
+
+  for (int channel=1; channel<5; channel++) {
+    const SamplePerChannel& s = summary.at(channel);
+
+    // NaNs are skipped rather than being quantized into a full-scale peak
+    OLIVE_ASSERT(!std::isnan(s.min) && !std::isnan(s.max));
+    OLIVE_ASSERT(s.min >= -0.5001f && s.max <= 0.5001f);
+    OLIVE_ASSERT(s.max > 0.4f && s.min < -0.4f);
+  }
+
+  OLIVE_TEST_END;
+}
+
+}
@@ -0,0 +1,328 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2021 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "testutil.h"
+
+#include <QtMath>
+#include <QVector2D>
+
+#include "common/bezier.h"
+#include "common/lerp.h"
+#include "node/keyframe.h"
+#include "node/node.h"
+
+namespace olive {
+
+// Both bezier solvers stop once they're within this distance of the target X
+static const double kSolverTolerance = 0.0001;
+
+// ...so the Y they arrive at can differ by a little more than that once scaled up by the curve
+static const double kTolerance = 0.01;
+
+/**
+ * @brief Node with a few keyframable inputs of different types
+ */
+class KeyframeTestNode : public Node
+{
+public:
+  KeyframeTestNode()
+  {
+    AddInput(kFloatIn, NodeValue::kFloat, 0.0);
+    AddInput(kVec2In, NodeValue::kVec2, QVector2D(0, 0));
+    AddInput(kComboIn, NodeValue::kCombo, 0);
+
+    SetInputIsKeyframing(kFloatIn, true);
+    SetInputIsKeyframing(kVec2In, true);
+    SetInputIsKeyframing(kComboIn, true);
+  }
+
+  NODE_DEFAULT_DESTRUCTOR(KeyframeTestNode)
+
+  virtual Node* copy() const override
+  {
+    return new KeyframeTestNode();
+  }
+
+  virtual QString Name() const override
+  {
+    return QStringLiteral("Keyframe Test");
+  }
+
+  virtual QString id() const override
+  {
+    return QStringLiteral("org.olivevideoeditor.Olive.keyframetest");
+  }
+
+  virtual QVector<CategoryID> Category() const override
+  {
+    return {kCategoryUnknown};
+  }
+
+  static const QString kFloatIn;
+  static const QString kVec2In;
+  static const QString kComboIn;
+};
+
+const QString KeyframeTestNode::kFloatIn = QStringLiteral("float_in");
+const QString KeyframeTestNode::kVec2In = QStringLiteral("vec2_in");
+const QString KeyframeTestNode::kComboIn = QStringLiteral("combo_in");
+
+static NodeKeyframe* AddKey(Node* node, const QString& input, int track, const rational& time, double value,
+                            NodeKeyframe::Type type, const QPointF& control_in = QPointF(), const QPointF& control_out = QPointF())
+{
+  NodeKeyframe* key = new NodeKeyframe(time, value, type, track, -1, input, node);
+  key->set_bezier_control_in(control_in);
+  key->set_bezier_control_out(control_out);
+  return key;
+}
+
+/**
+ * @brief Evaluates a track the way Node did before segments were precomputed, scanning linearly
+ * and solving beziers with Bezier::CubicXtoT
+ */
+static double ReferenceValueAtTime(const NodeKeyframeTrack& key_track, const rational& time)
+{
+  if (key_track.first()->time() >= time) {
+    return key_track.first()->value().toDouble();
+  }
+
+  if (key_track.last()->time() <= time) {
+    return key_track.last()->value().toDouble();
+  }
+
+  for (int i=0;i<key_track.size()-1;i++) {
+    NodeKeyframe* before = key_track.at(i);
+    NodeKeyframe* after = key_track.at(i+1);
+
+    if (before->time() == time
+        || (before->type() == NodeKeyframe::kHold && after->time() > time)) {
+      return before->value().toDouble();
+    } else if (after->time() == time) {
+      return after->value().toDouble();
+    } else if (before->time() < time && after->time() > time) {
+      double before_val = before->value().toDouble();
+      double after_val = after->value().toDouble();
+
+      if (before->type() == NodeKeyframe::kBezier && after->type() == NodeKeyframe::kBezier) {
+        double t = Bezier::CubicXtoT(time.toDouble(),
+                                     before->time().toDouble(),
+                                     before->time().toDouble() + before->valid_bezier_control_out().x(),
+                                     after->time().toDouble() + after->valid_bezier_control_in().x(),
+                                     after->time().toDouble());
+
+        return Bezier::CubicTtoY(before_val,
+                                 before_val + before->valid_bezier_control_out().y(),
+                                 after_val + after->valid_bezier_control_in().y(),
+                                 after_val,
+                                 t);
+      } else if (before->type() == NodeKeyframe::kBezier || after->type() == NodeKeyframe::kBezier) {
+        QPointF control_point;
+        double control_point_value;
+
+        if (before->type() == NodeKeyframe::kBezier) {
+          control_point = before->valid_bezier_control_out();
+          control_point.rx() += before->time().toDouble();
+          control_point_value = before_val + control_point.y();
+        } else {
+          control_point = after->valid_bezier_control_in();
+          control_point.rx() += after->time().toDouble();
+          control_point_value = after_val + control_point.y();
+        }
+
+        double t = Bezier::QuadraticXtoT(time.toDouble(), before->time().toDouble(), control_point.x(), after->time().toDouble());
+
+        return Bezier::QuadraticTtoY(before_val, control_point_value, after_val, t);
+      } else {
+        return lerp(before_val, after_val, (time.toDouble() - before->time().toDouble()) / (after->time().toDouble() - before->time().toDouble()));
+      }
+    }
+  }
+
+  return 0.0;
+}
+
+static bool MatchesReference(const Node& node, const QString& input, int track, const rational& time)
+{
+  double actual = node.GetSplitValueAtTimeOnTrack(input, time, track).toDouble();
+  double expected = ReferenceValueAtTime(node.GetKeyframeTracks(input, -1).at(track), time);
+
+  return qAbs(actual - expected) <= kTolerance;
+}
+
+/**
+ * @brief Fills the float input with linear, hold and bezier segments (including a cubic, a
+ * quadratic on either side, and a control point pulled to the keyframe's own time)
+ */
+static void AddMixedKeyframes(Node* node)
+{
+  const QString& in = KeyframeTestNode::kFloatIn;
+
+  AddKey(node, in, 0, rational(0), 0.0, NodeKeyframe::kLinear);
+  AddKey(node, in, 0, rational(1), 10.0, NodeKeyframe::kBezier, QPointF(-0.4, 0.0), QPointF(0.3, 6.0));
+  AddKey(node, in, 0, rational(2), -5.0, NodeKeyframe::kBezier, QPointF(-0.5, -4.0), QPointF(0.0, 0.0));
+  AddKey(node, in, 0, rational(3), 3.0, NodeKeyframe::kBezier, QPointF(-0.2, 1.0), QPointF(0.5, 0.0));
+  AddKey(node, in, 0, rational(7, 2), 4.0, NodeKeyframe::kHold);
+  AddKey(node, in, 0, rational(5), 7.0, NodeKeyframe::kLinear);
+  AddKey(node, in, 0, rational(6), 1.0, NodeKeyframe::kBezier, QPointF(-0.3, 3.0), QPointF(0.5, 0.0));
+}
+
+OLIVE_ADD_TEST(BezierCoefficientsMatchCubic)
+{
+  // {a, b, c, d} for x followed by the same for y. X stays monotonic, as keyframe controls do.
+  const double curves[][8] = {
+    {0.0, 0.3, 0.6, 1.0,    0.0, 6.0, -4.0, 10.0},
+    {1.0, 1.0, 2.0, 2.0,    2.0, 2.0, 0.0, 0.0},
+    {0.0, 0.9, 0.1, 1.0,    0.0, 1.0, 0.0, 1.0},
+    {-3.0, -3.0, -3.0, 5.0, 1.0, 1.0, 1.0, 1.0},
+    {2.0, 2.5, 9.0, 10.0,   100.0, 50.0, -50.0, 0.0},
+  };
+
+  for (const double* c : curves) {
+    double x_coeffs[4], y_coeffs[4];
+    Bezier::CubicToCoefficients(c[0], c[1], c[2], c[3], x_coeffs);
+    Bezier::CubicToCoefficients(c[4], c[5], c[6], c[7], y_coeffs);
+
+    // Steeper curves turn the same error in X into a larger one in Y
+    double y_tolerance = kTolerance * qMax(1.0, qMax(qAbs(c[5] - c[4]), qAbs(c[6] - c[7])) / 10.0);
+
+    for (int i=0;i<=64;i++) {
+      double x = c[0] + (c[3] - c[0]) * i / 64.0;
+
+      double old_t = Bezier::CubicXtoT(x, c[0], c[1], c[2], c[3]);
+      double new_t = Bezier::CubicCoefficientsXtoT(x, x_coeffs);
+
+      // Both must land on the requested X, even where dX/dT is zero and Newton-Raphson can't
+      OLIVE_ASSERT(new_t >= 0.0 && new_t <= 1.0);
+      OLIVE_ASSERT(qAbs(Bezier::CubicCoefficientsTtoY(x_coeffs, new_t) - x) <= kSolverTolerance);
+
+      double old_y = Bezier::CubicTtoY(c[4], c[5], c[6], c[7], old_t);
+      double new_y = Bezier::CubicCoefficientsTtoY(y_coeffs, new_t);
+
+      OLIVE_ASSERT(qAbs(old_y - new_y) <= y_tolerance);
+      OLIVE_ASSERT(qAbs(Bezier::CubicTtoY(c[4], c[5], c[6], c[7], new_t) - new_y) <= 1e-9);
+    }
+  }
+
+  OLIVE_TEST_END;
+}
+
+OLIVE_ADD_TEST(KeyframeTrackMatchesReference)
+{
+  KeyframeTestNode node;
+  AddMixedKeyframes(&node);
+
+  const QString& in = KeyframeTestNode::kFloatIn;
+
+  // Before the first keyframe, after the last, and exactly on each one
+  OLIVE_ASSERT(node.GetSplitValueAtTimeOnTrack(in, rational(-1), 0).toDouble() == 0.0);
+  OLIVE_ASSERT(node.GetSplitValueAtTimeOnTrack(in, rational(100), 0).toDouble() == 1.0);
+
+  for (NodeKeyframe* key : node.GetKeyframeTracks(in, -1).first()) {
+    OLIVE_ASSERT(node.GetSplitValueAtTimeOnTrack(in, key->time(), 0) == key->value());
+  }
+
+  // Holds keep their value right up to the next keyframe
+  OLIVE_ASSERT(node.GetSplitValueAtTimeOnTrack(in, rational(4999, 1000), 0).toDouble() == 4.0);
+
+  // Walk forward, then backward, through every segment
+  for (int i=-16;i<=112;i++) {
+    OLIVE_ASSERT(MatchesReference(node, in, 0, rational(i, 16)));
+  }
+
+  for (int i=112;i>=-16;i--) {
+    OLIVE_ASSERT(MatchesReference(node, in, 0, rational(i, 16)));
+  }
+
+  OLIVE_TEST_END;
+}
+
+OLIVE_ADD_TEST(KeyframeNonMonotonicAccess)
+{
+  KeyframeTestNode node;
+  AddMixedKeyframes(&node);
+
+  const QString& float_in = KeyframeTestNode::kFloatIn;
+  const QString& vec2_in = KeyframeTestNode::kVec2In;
+
+  AddKey(&node, vec2_in, 0, rational(0), 1.0, NodeKeyframe::kLinear);
+  AddKey(&node, vec2_in, 0, rational(4), 2.0, NodeKeyframe::kBezier, QPointF(-1.0, 1.0), QPointF(0.5, 0.0));
+  AddKey(&node, vec2_in, 0, rational(6), -2.0, NodeKeyframe::kLinear);
+  AddKey(&node, vec2_in, 1, rational(1, 2), 0.0, NodeKeyframe::kHold);
+  AddKey(&node, vec2_in, 1, rational(3), 8.0, NodeKeyframe::kLinear);
+
+  // Jump around in time and between tracks so each lookup lands away from the segment remembered
+  // from the last one
+  quint32 state = 1;
+  for (int i=0;i<2000;i++) {
+    state = state * 1664525u + 1013904223u;
+    rational time(int(state >> 16) % 128 - 16, 16);
+
+    switch (i % 3) {
+    case 0:
+      OLIVE_ASSERT(MatchesReference(node, float_in, 0, time));
+      break;
+    case 1:
+      OLIVE_ASSERT(MatchesReference(node, vec2_in, 0, time));
+      break;
+    case 2:
+      OLIVE_ASSERT(MatchesReference(node, vec2_in, 1, time));
+      break;
+    }
+  }
+
+  // Remembered segments must not outlive the keyframes they pointed at
+  OLIVE_ASSERT(MatchesReference(node, float_in, 0, rational(95, 16)));
+  delete node.GetKeyframeTracks(float_in, -1).first().last();
+  delete node.GetKeyframeTracks(float_in, -1).first().last();
+  for (int i=112;i>=-16;i--) {
+    OLIVE_ASSERT(MatchesReference(node, float_in, 0, rational(i, 16)));
+  }
+
+  // Moving a keyframe reorders nothing here, but changes the segment it starts
+  node.GetKeyframeTracks(float_in, -1).first().at(1)->set_time(rational(3, 2));
+  for (int i=-16;i<=112;i++) {
+    OLIVE_ASSERT(MatchesReference(node, float_in, 0, rational(i, 16)));
+  }
+
+  OLIVE_TEST_END;
+}
+
+OLIVE_ADD_TEST(KeyframeNonInterpolatableHoldsFirst)
+{
+  KeyframeTestNode node;
+
+  const QString& in = KeyframeTestNode::kComboIn;
+
+  AddKey(&node, in, 0, rational(0), 1, NodeKeyframe::kLinear);
+  AddKey(&node, in, 0, rational(2), 2, NodeKeyframe::kBezier);
+  AddKey(&node, in, 0, rational(4), 3, NodeKeyframe::kHold);
+
+  OLIVE_ASSERT(node.GetSplitValueAtTimeOnTrack(in, rational(-1), 0).toInt() == 1);
+  OLIVE_ASSERT(node.GetSplitValueAtTimeOnTrack(in, rational(0), 0).toInt() == 1);
+  OLIVE_ASSERT(node.GetSplitValueAtTimeOnTrack(in, rational(1), 0).toInt() == 1);
+  OLIVE_ASSERT(node.GetSplitValueAtTimeOnTrack(in, rational(2), 0).toInt() == 1);
+  OLIVE_ASSERT(node.GetSplitValueAtTimeOnTrack(in, rational(3), 0).toInt() == 1);
+  OLIVE_ASSERT(node.GetSplitValueAtTimeOnTrack(in, rational(4), 0).toInt() == 3);
+  OLIVE_ASSERT(node.GetSplitValueAtTimeOnTrack(in, rational(5), 0).toInt() == 3);
+
+  OLIVE_TEST_END;
+}
+
+}
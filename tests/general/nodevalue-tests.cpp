@@ -0,0 +1,163 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2021 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "testutil.h"
+
+#include <QMatrix4x4>
+#include <QVector2D>
+#include <QVector3D>
+#include <QVector4D>
+
+#include "common/rational.h"
+#include "node/value.h"
+#include "render/color.h"
+
+namespace olive {
+
+/**
+ * @brief Checks that a value held unboxed comes back out of data() as exactly what went in
+ */
+bool RoundTrips(NodeValue::Type type, const QVariant& in)
+{
+  QVariant out = NodeValue(type, in).data();
+
+  return out.userType() == in.userType() && out == in;
+}
+
+OLIVE_ADD_TEST(NodeValueRoundTrip)
+{
+  OLIVE_ASSERT(RoundTrips(NodeValue::kCombo, 3));
+  OLIVE_ASSERT(RoundTrips(NodeValue::kInt, QVariant::fromValue(int64_t(-5000000000LL))));
+  OLIVE_ASSERT(RoundTrips(NodeValue::kInt, QVariant::fromValue(qlonglong(42))));
+  OLIVE_ASSERT(RoundTrips(NodeValue::kFloat, 0.1));
+  OLIVE_ASSERT(RoundTrips(NodeValue::kFloat, 0.1f));
+  OLIVE_ASSERT(RoundTrips(NodeValue::kBoolean, true));
+  OLIVE_ASSERT(RoundTrips(NodeValue::kRational, QVariant::fromValue(rational(1001, 30000))));
+  OLIVE_ASSERT(RoundTrips(NodeValue::kVec2, QVector2D(1.5f, -2.0f)));
+  OLIVE_ASSERT(RoundTrips(NodeValue::kVec3, QVector3D(1.0f, 2.0f, 3.0f)));
+  OLIVE_ASSERT(RoundTrips(NodeValue::kVec4, QVector4D(1.0f, 2.0f, 3.0f, 4.0f)));
+  OLIVE_ASSERT(RoundTrips(NodeValue::kText, QStringLiteral("text")));
+
+  // Color has no operator==, so compare the channels
+  Color c(0.25, 0.5, 0.75, 1.0);
+  Color c_out = NodeValue(NodeValue::kColor, QVariant::fromValue(c)).data().value<Color>();
+  OLIVE_ASSERT(c_out.red() == c.red() && c_out.green() == c.green()
+               && c_out.blue() == c.blue() && c_out.alpha() == c.alpha());
+
+  QMatrix4x4 m;
+  m.translate(10.0f, 20.0f);
+  m.rotate(45.0f, 0.0f, 0.0f, 1.0f);
+  OLIVE_ASSERT(RoundTrips(NodeValue::kMatrix, m));
+  OLIVE_ASSERT(NodeValue(NodeValue::kMatrix, m).value<QMatrix4x4>() == m);
+
+  // Nulls stay null rather than turning into a zero of the value's type
+  OLIVE_ASSERT(NodeValue(NodeValue::kFloat, QVariant()).isNull());
+  OLIVE_ASSERT(NodeValue(NodeValue::kFloat, QVariant()).data().isNull());
+
+  OLIVE_TEST_END;
+}
+
+OLIVE_ADD_TEST(NodeValueTypedMatchesVariant)
+{
+  // Typed access must convert exactly as QVariant would, including between types
+  QVector<QVariant> values = {
+    3,
+    QVariant::fromValue(int64_t(7)),
+    2.6,
+    -2.5,
+    1.25f,
+    true,
+    false,
+    QVariant::fromValue(rational(1, 3)),
+    QStringLiteral("4"),
+    QVariant()
+  };
+
+  foreach (const QVariant& v, values) {
+    NodeValue n(NodeValue::kFloat, v);
+
+    OLIVE_ASSERT(n.toDouble() == v.toDouble());
+    OLIVE_ASSERT(n.toFloat() == v.toFloat());
+    OLIVE_ASSERT(n.toInt() == v.toInt());
+    OLIVE_ASSERT(n.toBool() == v.toBool());
+    OLIVE_ASSERT(n.value<int64_t>() == v.value<int64_t>());
+    OLIVE_ASSERT(n.toString() == v.toString());
+    OLIVE_ASSERT(n.isNull() == v.isNull());
+  }
+
+  QVector2D vec(3.0f, 4.0f);
+  NodeValue n(NodeValue::kVec2, vec);
+  OLIVE_ASSERT(n.value<QVector2D>() == vec);
+  OLIVE_ASSERT(n.value<QVector3D>() == QVariant(vec).value<QVector3D>());
+
+  OLIVE_TEST_END;
+}
+
+OLIVE_ADD_TEST(NodeValueEquality)
+{
+  OLIVE_ASSERT(NodeValue(NodeValue::kFloat, 1.0) == NodeValue(NodeValue::kFloat, 1.0));
+  OLIVE_ASSERT(!(NodeValue(NodeValue::kFloat, 1.0) == NodeValue(NodeValue::kFloat, 2.0)));
+  OLIVE_ASSERT(!(NodeValue(NodeValue::kFloat, 1.0) == NodeValue(NodeValue::kInt, 1.0)));
+
+  // Values held differently still compare like their QVariants would
+  OLIVE_ASSERT(NodeValue(NodeValue::kFloat, 1.0) == NodeValue(NodeValue::kFloat, 1));
+
+  OLIVE_ASSERT(NodeValue(NodeValue::kVec2, QVector2D(1, 2)) == NodeValue(NodeValue::kVec2, QVector2D(1, 2)));
+  OLIVE_ASSERT(!(NodeValue(NodeValue::kVec2, QVector2D(1, 2)) == NodeValue(NodeValue::kVec2, QVector2D(2, 1))));
+
+  NodeValue red(NodeValue::kColor, QVariant::fromValue(Color(1, 0, 0)));
+  NodeValue green(NodeValue::kColor, QVariant::fromValue(Color(0, 1, 0)));
+  OLIVE_ASSERT(red == red);
+  OLIVE_ASSERT(!(red == green));
+
+  OLIVE_TEST_END;
+}
+
+OLIVE_ADD_TEST(NodeValueTableTypedLookup)
+{
+  NodeValueTable table;
+
+  table.Push(NodeValue::kFloat, 1.0, nullptr);
+  table.Push(NodeValue::kVec2, QVector2D(1, 2), nullptr, false, QStringLiteral("a"));
+  table.Push(NodeValue::kVec2, QVector2D(3, 4), nullptr);
+  table.Push(NodeValue::kFloat, 2.0, nullptr);
+
+  // Most recent value of a type wins unless a tag is asked for
+  OLIVE_ASSERT(table.Get<double>(NodeValue::kFloat) == 2.0);
+  OLIVE_ASSERT(table.Get<QVector2D>(NodeValue::kVec2) == QVector2D(3, 4));
+  OLIVE_ASSERT(table.Get<QVector2D>(NodeValue::kVec2, QStringLiteral("a")) == QVector2D(1, 2));
+
+  // Typed and boxed lookups agree
+  OLIVE_ASSERT(table.Get(NodeValue::kVec2).value<QVector2D>() == table.Get<QVector2D>(NodeValue::kVec2));
+
+  // Missing types give a default value
+  OLIVE_ASSERT(table.Get<double>(NodeValue::kMatrix) == 0.0);
+  OLIVE_ASSERT(table.Get<QMatrix4x4>(NodeValue::kMatrix).isIdentity());
+
+  // Typed take removes the value
+  OLIVE_ASSERT(table.Take<double>(NodeValue::kFloat) == 2.0);
+  OLIVE_ASSERT(table.Take<double>(NodeValue::kFloat) == 1.0);
+  OLIVE_ASSERT(!table.Has(NodeValue::kFloat));
+  OLIVE_ASSERT(table.Count() == 2);
+
+  OLIVE_TEST_END;
+}
+
+}
@@ -0,0 +1,251 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2021 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "testutil.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QSemaphore>
+
+#include "threading/threadpool.h"
+
+namespace olive {
+
+/**
+ * @brief Single threaded pool that records the order tickets ran in
+ *
+ * The first ticket queued should be named "gate", which holds the only thread until Release() so
+ * everything queued after it is ordered by the scheduler rather than by when it was added.
+ */
+class RecordingThreadPool : public ThreadPool
+{
+public:
+  RecordingThreadPool() :
+    ThreadPool(QThread::InheritPriority, 1)
+  {
+  }
+
+  virtual void RunTicket(RenderTicketPtr ticket) const override
+  {
+    QString name = ticket->property("name").toString();
+
+    if (name == QStringLiteral("gate")) {
+      gate_.acquire();
+    } else {
+      QMutexLocker locker(&mutex_);
+      order_.append(name);
+    }
+
+    ticket->Finish();
+  }
+
+  /**
+   * @brief Let the gate ticket finish and wait for `count` more tickets to run
+   */
+  QStringList Release(int count)
+  {
+    gate_.release();
+
+    QElapsedTimer timeout;
+    timeout.start();
+
+    forever {
+      // Finished threads are handed their next ticket through the event loop
+      QCoreApplication::processEvents();
+
+      QMutexLocker locker(&mutex_);
+      if (order_.size() >= count || timeout.elapsed() > 10000) {
+        return order_;
+      }
+    }
+  }
+
+private:
+  mutable QSemaphore gate_;
+
+  mutable QMutex mutex_;
+
+  mutable QStringList order_;
+
+};
+
+static void CreateApplication()
+{
+  // Needed to deliver the pool's queued signals
+  static int argc = 1;
+  static char arg0[] = "threadpool-tests";
+  static char* argv[] = {arg0, nullptr};
+  static QCoreApplication app(argc, argv);
+}
+
+static RenderTicketPtr CreateTicket(const QString& name, ThreadPool::Priority priority, quintptr owner = 0, qint64 deadline = 0)
+{
+  RenderTicketPtr ticket = std::make_shared<RenderTicket>();
+
+  ticket->setProperty("name", name);
+  ticket->setProperty("priority", priority);
+  ticket->setProperty("owner", qulonglong(owner));
+  ticket->setProperty("deadline", deadline);
+
+  return ticket;
+}
+
+OLIVE_ADD_TEST(ThreadPoolClassPrecedence)
+{
+  CreateApplication();
+
+  RecordingThreadPool pool;
+
+  pool.AddTicket(CreateTicket(QStringLiteral("gate"), ThreadPool::kPriorityInteractive));
+
+  pool.AddTicket(CreateTicket(QStringLiteral("background"), ThreadPool::kPriorityBackground));
+  pool.AddTicket(CreateTicket(QStringLiteral("export"), ThreadPool::kPriorityExport));
+  pool.AddTicket(CreateTicket(QStringLiteral("playback"), ThreadPool::kPriorityPlayback, 0, ThreadPool::Now() + 1000));
+  pool.AddTicket(CreateTicket(QStringLiteral("interactive1"), ThreadPool::kPriorityInteractive));
+  pool.AddTicket(CreateTicket(QStringLiteral("interactive2"), ThreadPool::kPriorityInteractive));
+
+  // Higher classes always go first, and the newest interactive ticket goes first within its class
+  QStringList order = pool.Release(5);
+  OLIVE_ASSERT(order == QStringList({QStringLiteral("interactive2"),
+                                     QStringLiteral("interactive1"),
+                                     QStringLiteral("playback"),
+                                     QStringLiteral("export"),
+                                     QStringLiteral("background")}));
+
+  OLIVE_TEST_END;
+}
+
+OLIVE_ADD_TEST(ThreadPoolEarliestDeadline)
+{
+  CreateApplication();
+
+  RecordingThreadPool pool;
+
+  pool.AddTicket(CreateTicket(QStringLiteral("gate"), ThreadPool::kPriorityInteractive));
+
+  qint64 now = ThreadPool::Now();
+
+  // Deadlines are compared across owners, and tickets without one go last
+  pool.AddTicket(CreateTicket(QStringLiteral("none"), ThreadPool::kPriorityPlayback, 1));
+  pool.AddTicket(CreateTicket(QStringLiteral("300"), ThreadPool::kPriorityPlayback, 1, now + 300));
+  pool.AddTicket(CreateTicket(QStringLiteral("100"), ThreadPool::kPriorityPlayback, 2, now + 100));
+  pool.AddTicket(CreateTicket(QStringLiteral("200"), ThreadPool::kPriorityPlayback, 1, now + 200));
+
+  QStringList order = pool.Release(4);
+  OLIVE_ASSERT(order == QStringList({QStringLiteral("100"),
+                                     QStringLiteral("200"),
+                                     QStringLiteral("300"),
+                                     QStringLiteral("none")}));
+
+  OLIVE_TEST_END;
+}
+
+OLIVE_ADD_TEST(ThreadPoolOwnerRoundRobin)
+{
+  CreateApplication();
+
+  RecordingThreadPool pool;
+
+  pool.AddTicket(CreateTicket(QStringLiteral("gate"), ThreadPool::kPriorityInteractive));
+
+  pool.AddTicket(CreateTicket(QStringLiteral("a1"), ThreadPool::kPriorityBackground, 1));
+  pool.AddTicket(CreateTicket(QStringLiteral("a2"), ThreadPool::kPriorityBackground, 1));
+  pool.AddTicket(CreateTicket(QStringLiteral("a3"), ThreadPool::kPriorityBackground, 1));
+  pool.AddTicket(CreateTicket(QStringLiteral("b1"), ThreadPool::kPriorityBackground, 2));
+  pool.AddTicket(CreateTicket(QStringLiteral("b2"), ThreadPool::kPriorityBackground, 2));
+
+  // Owners take turns, each oldest first, so A's backlog doesn't hold up B
+  QStringList order = pool.Release(5);
+  OLIVE_ASSERT(order == QStringList({QStringLiteral("a1"),
+                                     QStringLiteral("b1"),
+                                     QStringLiteral("a2"),
+                                     QStringLiteral("b2"),
+                                     QStringLiteral("a3")}));
+
+  OLIVE_TEST_END;
+}
+
+OLIVE_ADD_TEST(ThreadPoolPromoteTicket)
+{
+  CreateApplication();
+
+  RecordingThreadPool pool;
+
+  pool.AddTicket(CreateTicket(QStringLiteral("gate"), ThreadPool::kPriorityInteractive));
+
+  qint64 now = ThreadPool::Now();
+
+  RenderTicketPtr background = CreateTicket(QStringLiteral("background"), ThreadPool::kPriorityBackground);
+  RenderTicketPtr late = CreateTicket(QStringLiteral("late"), ThreadPool::kPriorityPlayback, 0, now + 500);
+  RenderTicketPtr early = CreateTicket(QStringLiteral("early"), ThreadPool::kPriorityPlayback, 0, now + 100);
+
+  pool.AddTicket(background);
+  pool.AddTicket(late);
+  pool.AddTicket(early);
+
+  // Only more urgent classes or earlier deadlines count as a promotion
+  OLIVE_ASSERT(!pool.PromoteTicket(late, ThreadPool::kPriorityBackground));
+  OLIVE_ASSERT(!pool.PromoteTicket(late, ThreadPool::kPriorityPlayback, now + 1000));
+  OLIVE_ASSERT(!pool.PromoteTicket(CreateTicket(QStringLiteral("unqueued"), ThreadPool::kPriorityBackground), ThreadPool::kPriorityInteractive));
+
+  OLIVE_ASSERT(pool.PromoteTicket(late, ThreadPool::kPriorityPlayback, now + 50));
+  OLIVE_ASSERT(pool.PromoteTicket(background, ThreadPool::kPriorityPlayback, now + 200));
+
+  QStringList order = pool.Release(3);
+  OLIVE_ASSERT(order == QStringList({QStringLiteral("late"),
+                                     QStringLiteral("early"),
+                                     QStringLiteral("background")}));
+
+  OLIVE_ASSERT(pool.GetQueueStats(ThreadPool::kPriorityBackground).depth == 0);
+  OLIVE_ASSERT(pool.GetQueueStats(ThreadPool::kPriorityPlayback).started == 3);
+
+  OLIVE_TEST_END;
+}
+
+OLIVE_ADD_TEST(ThreadPoolRemoveTicket)
+{
+  CreateApplication();
+
+  RecordingThreadPool pool;
+
+  pool.AddTicket(CreateTicket(QStringLiteral("gate"), ThreadPool::kPriorityInteractive));
+
+  RenderTicketPtr removed = CreateTicket(QStringLiteral("removed"), ThreadPool::kPriorityBackground);
+
+  pool.AddTicket(CreateTicket(QStringLiteral("kept1"), ThreadPool::kPriorityBackground));
+  pool.AddTicket(removed);
+  pool.AddTicket(CreateTicket(QStringLiteral("kept2"), ThreadPool::kPriorityBackground));
+
+  OLIVE_ASSERT(pool.RemoveTicket(removed));
+  OLIVE_ASSERT(!pool.RemoveTicket(removed));
+
+  ThreadPool::QueueStats stats = pool.GetQueueStats(ThreadPool::kPriorityBackground);
+  OLIVE_ASSERT(stats.depth == 2);
+  OLIVE_ASSERT(stats.queued == 3);
+  OLIVE_ASSERT(stats.removed == 1);
+
+  QStringList order = pool.Release(2);
+  OLIVE_ASSERT(order == QStringList({QStringLiteral("kept1"),
+                                     QStringLiteral("kept2")}));
+
+  OLIVE_TEST_END;
+}
+
+}
@@ -0,0 +1,113 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2021 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "testutil.h"
+
+#include <QtMath>
+
+#include "node/filter/blur/blur.h"
+
+namespace olive {
+
+OLIVE_ADD_TEST(BlurPlanSmallRadiusIsDirect)
+{
+  for (int radius=1; radius<=BlurFilterNode::kMaximumDirectTaps; radius++) {
+    BlurFilterNode::Plan box = BlurFilterNode::PlanBlur(BlurFilterNode::kMethodBox, radius, true);
+    OLIVE_ASSERT(box.boxes == 0);
+    OLIVE_ASSERT(box.direct_taps == radius);
+    OLIVE_ASSERT(box.GetPassesPerAxis() == 1);
+    OLIVE_ASSERT(box.divider == 1);
+  }
+
+  // Gaussians cover three standard deviations
+  BlurFilterNode::Plan gaussian = BlurFilterNode::PlanBlur(BlurFilterNode::kMethodGaussian, 5, true);
+  OLIVE_ASSERT(gaussian.boxes == 0);
+  OLIVE_ASSERT(gaussian.direct_taps == 15);
+
+  // Decimal radii round up
+  OLIVE_ASSERT(BlurFilterNode::PlanBlur(BlurFilterNode::kMethodBox, 2.1, true).direct_taps == 3);
+
+  OLIVE_TEST_END;
+}
+
+OLIVE_ADD_TEST(BlurPlanPassesAreBounded)
+{
+  for (int method=BlurFilterNode::kMethodBox; method<=BlurFilterNode::kMethodGaussian; method++) {
+    for (int radius=1; radius<=5000; radius++) {
+      for (int both_axes=0; both_axes<2; both_axes++) {
+        BlurFilterNode::Plan plan = BlurFilterNode::PlanBlur(static_cast<BlurFilterNode::Method>(method), radius, both_axes);
+
+        if (plan.boxes == 0) {
+          continue;
+        }
+
+        OLIVE_ASSERT(plan.boxes == ((method == BlurFilterNode::kMethodGaussian) ? 3 : 1));
+        OLIVE_ASSERT(plan.passes >= 1 && plan.passes <= BlurFilterNode::kMaximumPassesPerBox);
+        OLIVE_ASSERT(plan.GetPassesPerAxis() <= plan.boxes * BlurFilterNode::kMaximumPassesPerBox);
+
+        // Passes only take more than kMaximumPassTaps once the pass limit is reached
+        int max_bounded_width = qRound(std::pow(BlurFilterNode::kMaximumPassTaps, BlurFilterNode::kMaximumPassesPerBox));
+        if (plan.box_width <= max_bounded_width) {
+          OLIVE_ASSERT(plan.taps <= BlurFilterNode::kMaximumPassTaps);
+        } else {
+          OLIVE_ASSERT(plan.passes == BlurFilterNode::kMaximumPassesPerBox);
+        }
+
+        // ...and then only as many as the box width needs
+        OLIVE_ASSERT(plan.taps <= qMax(BlurFilterNode::kMaximumPassTaps, qCeil(std::sqrt(double(plan.box_width)))));
+        OLIVE_ASSERT(plan.GetLastPassTaps() <= plan.taps);
+
+        // The combined passes must cover close to the box width that was asked for
+        int stride = 1;
+        for (int i=1; i<plan.passes; i++) {
+          stride *= plan.taps;
+        }
+
+        int covered = stride * plan.GetLastPassTaps();
+        OLIVE_ASSERT(qAbs(covered - plan.box_width) <= stride / 2 + 1);
+      }
+    }
+  }
+
+  OLIVE_TEST_END;
+}
+
+OLIVE_ADD_TEST(BlurPlanDivider)
+{
+  for (int radius=1; radius<=5000; radius++) {
+    BlurFilterNode::Plan plan = BlurFilterNode::PlanBlur(BlurFilterNode::kMethodGaussian, radius, true);
+
+    // A power of two, small enough that the first pass prefilters it and sigma stays 4 pixels wide
+    OLIVE_ASSERT(plan.divider >= 1 && plan.divider <= BlurFilterNode::kMaximumDivider);
+    OLIVE_ASSERT((plan.divider & (plan.divider - 1)) == 0);
+    OLIVE_ASSERT(plan.divider == 1 || (plan.divider <= plan.taps && plan.divider * 4 <= radius));
+
+    // Never downsample when blurring one axis or using a box blur
+    OLIVE_ASSERT(BlurFilterNode::PlanBlur(BlurFilterNode::kMethodGaussian, radius, false).divider == 1);
+    OLIVE_ASSERT(BlurFilterNode::PlanBlur(BlurFilterNode::kMethodBox, radius, true).divider == 1);
+  }
+
+  // Large gaussians do downsample
+  OLIVE_ASSERT(BlurFilterNode::PlanBlur(BlurFilterNode::kMethodGaussian, 500, true).divider == BlurFilterNode::kMaximumDivider);
+
+  OLIVE_TEST_END;
+}
+
+}
@@ -0,0 +1,222 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2021 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "testutil.h"
+
+#include <QtConcurrent/QtConcurrent>
+
+#include "render/frametexturecache.h"
+
+namespace olive {
+
+static FrameTextureCache::Key CreateKey(const QString& filename, int64_t timestamp, const QString& colorspace = QStringLiteral("cfg:srgb"))
+{
+  FrameTextureCache::Key key;
+
+  key.stream = Decoder::CodecStream(filename, 0);
+  key.colorspace = colorspace;
+  key.alpha_is_associated = false;
+  key.divider = 1;
+  key.format = VideoParams::kFormatFloat16;
+  key.allow_proxy = false;
+  key.src_interlacing = VideoParams::kInterlaceNone;
+  key.dst_interlacing = VideoParams::kInterlaceNone;
+  key.timestamp = timestamp;
+
+  return key;
+}
+
+static TexturePtr CreateTexture()
+{
+  // 64x64 RGBA 8-bit is 16 KiB
+  return std::make_shared<Texture>(VideoParams(64, 64, VideoParams::kFormatUnsigned8, VideoParams::kRGBAChannelCount));
+}
+
+OLIVE_ADD_TEST(FrameTextureCacheAcquireFulfill)
+{
+  FrameTextureCache cache;
+  FrameTextureCache::Key key = CreateKey(QStringLiteral("a.mov"), 0);
+
+  OLIVE_ASSERT(!cache.Contains(key));
+
+  // A miss claims the entry for the caller
+  OLIVE_ASSERT(cache.Acquire(key) == nullptr);
+  OLIVE_ASSERT(cache.Contains(key));
+
+  TexturePtr tex = CreateTexture();
+  cache.Fulfill(key, tex);
+
+  OLIVE_ASSERT(cache.Acquire(key) == tex);
+
+  // Anything that changes the texture's contents must miss
+  FrameTextureCache::Key other_format = key;
+  other_format.format = VideoParams::kFormatFloat32;
+  OLIVE_ASSERT(!cache.Contains(other_format));
+
+  FrameTextureCache::Key other_proxy = key;
+  other_proxy.allow_proxy = true;
+  OLIVE_ASSERT(!cache.Contains(other_proxy));
+
+  FrameTextureCache::Stats stats = cache.GetStats();
+  OLIVE_ASSERT(stats.hits == 1);
+  OLIVE_ASSERT(stats.misses == 1);
+  OLIVE_ASSERT(stats.cached_count == 1);
+  OLIVE_ASSERT(stats.cached_bytes == 64 * 64 * 4);
+
+  OLIVE_TEST_END;
+}
+
+OLIVE_ADD_TEST(FrameTextureCacheInterlacing)
+{
+  FrameTextureCache cache;
+
+  FrameTextureCache::Key interlaced = CreateKey(QStringLiteral("a.mov"), 0);
+  interlaced.src_interlacing = VideoParams::kInterlacedTopFirst;
+  interlaced.dst_interlacing = VideoParams::kInterlacedTopFirst;
+
+  OLIVE_ASSERT(cache.Acquire(interlaced) == nullptr);
+  cache.Fulfill(interlaced, CreateTexture());
+
+  // Rendering the same footage for a progressive sequence gets a deinterlaced frame, so it can't
+  // share the interlaced one
+  FrameTextureCache::Key deinterlaced = interlaced;
+  deinterlaced.dst_interlacing = VideoParams::kInterlaceNone;
+  OLIVE_ASSERT(!cache.Contains(deinterlaced));
+
+  // Nor can frames decoded before the user changed the footage's interlacing
+  FrameTextureCache::Key changed = interlaced;
+  changed.src_interlacing = VideoParams::kInterlacedBottomFirst;
+  OLIVE_ASSERT(!cache.Contains(changed));
+
+  OLIVE_ASSERT(cache.Contains(interlaced));
+
+  OLIVE_TEST_END;
+}
+
+OLIVE_ADD_TEST(FrameTextureCacheAbandon)
+{
+  FrameTextureCache cache;
+  FrameTextureCache::Key key = CreateKey(QStringLiteral("a.mov"), 0);
+
+  OLIVE_ASSERT(cache.Acquire(key) == nullptr);
+
+  cache.Abandon(key);
+  OLIVE_ASSERT(!cache.Contains(key));
+
+  // The next caller gets to claim it instead
+  OLIVE_ASSERT(cache.Acquire(key) == nullptr);
+  OLIVE_ASSERT(cache.Contains(key));
+
+  OLIVE_TEST_END;
+}
+
+OLIVE_ADD_TEST(FrameTextureCacheWaiter)
+{
+  FrameTextureCache cache;
+  FrameTextureCache::Key key = CreateKey(QStringLiteral("a.mov"), 0);
+
+  OLIVE_ASSERT(cache.Acquire(key) == nullptr);
+
+  // Another thread wanting the same frame waits for this one to create it
+  QFuture<TexturePtr> waiter = QtConcurrent::run([&cache, key]{
+    return cache.Acquire(key);
+  });
+
+  TexturePtr tex = CreateTexture();
+  cache.Fulfill(key, tex);
+
+  OLIVE_ASSERT(waiter.result() == tex);
+
+  OLIVE_TEST_END;
+}
+
+OLIVE_ADD_TEST(FrameTextureCacheEviction)
+{
+  FrameTextureCache cache;
+  cache.SetBudget(2 * 64 * 64 * 4);
+
+  FrameTextureCache::Key a = CreateKey(QStringLiteral("a.mov"), 0);
+  FrameTextureCache::Key b = CreateKey(QStringLiteral("a.mov"), 1);
+  FrameTextureCache::Key c = CreateKey(QStringLiteral("a.mov"), 2);
+
+  cache.Acquire(a);
+  cache.Fulfill(a, CreateTexture());
+  cache.Acquire(b);
+  cache.Fulfill(b, CreateTexture());
+
+  // Touch A so B is the least recently used
+  OLIVE_ASSERT(cache.Acquire(a) != nullptr);
+
+  cache.Acquire(c);
+  cache.Fulfill(c, CreateTexture());
+
+  OLIVE_ASSERT(cache.Contains(a));
+  OLIVE_ASSERT(!cache.Contains(b));
+  OLIVE_ASSERT(cache.Contains(c));
+
+  FrameTextureCache::Stats stats = cache.GetStats();
+  OLIVE_ASSERT(stats.evictions == 1);
+  OLIVE_ASSERT(stats.cached_count == 2);
+  OLIVE_ASSERT(stats.cached_bytes == 2 * 64 * 64 * 4);
+
+  // Lowering the budget evicts immediately
+  cache.SetBudget(64 * 64 * 4);
+  OLIVE_ASSERT(cache.GetStats().cached_count == 1);
+  OLIVE_ASSERT(cache.Contains(c));
+
+  OLIVE_TEST_END;
+}
+
+OLIVE_ADD_TEST(FrameTextureCacheRemove)
+{
+  FrameTextureCache cache;
+
+  FrameTextureCache::Key a = CreateKey(QStringLiteral("a.mov"), 0);
+  FrameTextureCache::Key b = CreateKey(QStringLiteral("b.mov"), 0);
+  FrameTextureCache::Key c = CreateKey(QStringLiteral("b.mov"), 0, QStringLiteral("other:srgb"));
+
+  cache.Acquire(a);
+  cache.Fulfill(a, CreateTexture());
+  cache.Acquire(b);
+  cache.Fulfill(b, CreateTexture());
+  cache.Acquire(c);
+  cache.Fulfill(c, CreateTexture());
+
+  cache.RemoveFile(QStringLiteral("a.mov"));
+  OLIVE_ASSERT(!cache.Contains(a));
+  OLIVE_ASSERT(cache.Contains(b));
+  OLIVE_ASSERT(cache.Contains(c));
+
+  cache.RemoveColorConfig(QStringLiteral("cfg"));
+  OLIVE_ASSERT(!cache.Contains(b));
+  OLIVE_ASSERT(cache.Contains(c));
+
+  cache.Clear();
+  OLIVE_ASSERT(!cache.Contains(c));
+
+  FrameTextureCache::Stats stats = cache.GetStats();
+  OLIVE_ASSERT(stats.cached_count == 0);
+  OLIVE_ASSERT(stats.cached_bytes == 0);
+  OLIVE_ASSERT(stats.evictions == 0);
+
+  OLIVE_TEST_END;
+}
+
+}
@@ -0,0 +1,177 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2021 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "testutil.h"
+
+#include "node/generator/solid/solid.h"
+#include "render/renderprofiler.h"
+
+namespace olive {
+
+static void RecordFrame(const rational& time, const QVector<RenderProfiler::Event>& events)
+{
+  RenderProfiler::Recorder recorder(nullptr, time);
+
+  foreach (const RenderProfiler::Event& e, events) {
+    recorder.AddEvent(e.category, e.node, e.name, e.start, e.start + e.duration, e.self);
+  }
+
+  recorder.Submit();
+}
+
+static RenderProfiler::Event CreateEvent(RenderProfiler::Category category, const Node* node, qint64 duration, qint64 self = 0)
+{
+  return {category, node, 0, QString(), 0, duration, self, false};
+}
+
+OLIVE_ADD_TEST(RenderProfilerRingBuffer)
+{
+  RenderProfiler::CreateInstance();
+
+  const int extra = 10;
+
+  for (int i=0; i<RenderProfiler::kMaximumFrames + extra; i++) {
+    RecordFrame(rational(i), {});
+  }
+
+  // Only the newest frames are kept, and they come back oldest first
+  QVector<RenderProfiler::Frame> frames = RenderProfiler::instance()->GetFrames();
+  OLIVE_ASSERT(frames.size() == RenderProfiler::kMaximumFrames);
+
+  for (int i=0; i<frames.size(); i++) {
+    OLIVE_ASSERT(frames.at(i).time == rational(i + extra));
+  }
+
+  RenderProfiler::instance()->Clear();
+  OLIVE_ASSERT(RenderProfiler::instance()->GetFrames().isEmpty());
+
+  RenderProfiler::DestroyInstance();
+
+  OLIVE_TEST_END;
+}
+
+OLIVE_ADD_TEST(RenderProfilerNodeCosts)
+{
+  RenderProfiler::CreateInstance();
+
+  SolidGenerator a;
+  SolidGenerator b;
+
+  // A's traversal only counts its own time, plus whatever work was done for it after traversal
+  RecordFrame(0, {CreateEvent(RenderProfiler::kCategoryNode, &a, 1000, 100),
+                  CreateEvent(RenderProfiler::kCategoryShader, &a, 50)});
+
+  // Downloads and cache lookups aren't work for a node, and a node traversed twice in a frame is
+  // still only one frame
+  RecordFrame(1, {CreateEvent(RenderProfiler::kCategoryNode, &a, 1000, 200),
+                  CreateEvent(RenderProfiler::kCategoryNode, &a, 1000, 100),
+                  CreateEvent(RenderProfiler::kCategoryDecode, &a, 40),
+                  CreateEvent(RenderProfiler::kCategoryGenerate, &a, 30),
+                  CreateEvent(RenderProfiler::kCategoryUpload, &a, 30),
+                  CreateEvent(RenderProfiler::kCategoryDownload, &a, 5000),
+                  CreateEvent(RenderProfiler::kCategoryCache, &a, 5000),
+                  CreateEvent(RenderProfiler::kCategoryNode, &b, 500, 500)});
+
+  QHash<const Node*, RenderProfiler::NodeCost> costs = RenderProfiler::instance()->GetNodeCosts();
+  OLIVE_ASSERT(costs.size() == 2);
+
+  // (150 + 400) / 2 frames
+  OLIVE_ASSERT(costs.value(&a).cost == 275);
+  OLIVE_ASSERT(costs.value(&a).frames == 2);
+
+  OLIVE_ASSERT(costs.value(&b).cost == 500);
+  OLIVE_ASSERT(costs.value(&b).frames == 1);
+
+  RenderProfiler::DestroyInstance();
+
+  OLIVE_TEST_END;
+}
+
+OLIVE_ADD_TEST(RenderProfilerAliases)
+{
+  RenderProfiler::CreateInstance();
+
+  SolidGenerator original;
+  SolidGenerator* copy = new SolidGenerator();
+
+  RenderProfiler::instance()->SetAlias(copy, &original);
+
+  // Renders of the copy are stored against the original
+  RecordFrame(0, {CreateEvent(RenderProfiler::kCategoryNode, copy, 100, 100)});
+
+  QHash<const Node*, RenderProfiler::NodeCost> costs = RenderProfiler::instance()->GetNodeCosts();
+  OLIVE_ASSERT(costs.size() == 1);
+  OLIVE_ASSERT(costs.value(&original).cost == 100);
+
+  QVector<RenderProfiler::Frame> frames = RenderProfiler::instance()->GetFrames();
+  OLIVE_ASSERT(frames.first().events.first().node == &original);
+
+  // Deleting the copy doesn't affect what's been recorded for the original
+  delete copy;
+
+  costs = RenderProfiler::instance()->GetNodeCosts();
+  OLIVE_ASSERT(costs.value(&original).cost == 100);
+
+  RenderProfiler::DestroyInstance();
+
+  OLIVE_TEST_END;
+}
+
+OLIVE_ADD_TEST(RenderProfilerRemoveNode)
+{
+  RenderProfiler::CreateInstance();
+
+  SolidGenerator kept;
+  SolidGenerator* removed = new SolidGenerator();
+  SolidGenerator* copy = new SolidGenerator();
+
+  RenderProfiler::instance()->SetAlias(copy, removed);
+
+  RecordFrame(0, {CreateEvent(RenderProfiler::kCategoryNode, &kept, 100, 100),
+                  CreateEvent(RenderProfiler::kCategoryNode, removed, 100, 100)});
+
+  // Node destructors forget themselves
+  delete removed;
+
+  QHash<const Node*, RenderProfiler::NodeCost> costs = RenderProfiler::instance()->GetNodeCosts();
+  OLIVE_ASSERT(costs.size() == 1);
+  OLIVE_ASSERT(costs.contains(&kept));
+
+  QVector<RenderProfiler::Frame> frames = RenderProfiler::instance()->GetFrames();
+  OLIVE_ASSERT(frames.first().events.at(0).node == &kept);
+  OLIVE_ASSERT(frames.first().events.at(1).node == nullptr);
+
+  // A copy of the deleted node can't bring its costs back either
+  RecordFrame(1, {CreateEvent(RenderProfiler::kCategoryNode, copy, 100, 100)});
+  OLIVE_ASSERT(RenderProfiler::instance()->GetNodeCosts().size() == 1);
+
+  delete copy;
+
+  // Frames are dropped once nothing wants profiling any more
+  RenderProfiler::instance()->Enable();
+  RenderProfiler::instance()->Disable();
+  OLIVE_ASSERT(RenderProfiler::instance()->GetFrames().isEmpty());
+
+  RenderProfiler::DestroyInstance();
+
+  OLIVE_TEST_END;
+}
+
+}
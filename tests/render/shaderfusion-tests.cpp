@@ -0,0 +1,254 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2021 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "testutil.h"
+
+#include <QVector4D>
+
+#include "node/node.h"
+#include "render/shaderfusion.h"
+
+namespace olive {
+
+static const QString kProducerShader = QStringLiteral(
+  "uniform vec4 color_in;\n"
+  "in vec2 ove_texcoord;\n"
+  "out vec4 fragColor;\n"
+  "void main() {\n"
+  "  fragColor = color_in;\n"
+  "}\n");
+
+static const QString kConsumerShader = QStringLiteral(
+  "uniform sampler2D tex_in;\n"
+  "uniform float amount_in;\n"
+  "in vec2 ove_texcoord;\n"
+  "out vec4 fragColor;\n"
+  "void main() {\n"
+  "  fragColor = texture(tex_in, ove_texcoord) * amount_in;\n"
+  "}\n");
+
+static const QString kPositionShader = QStringLiteral(
+  "in vec2 ove_texcoord;\n"
+  "out vec4 fragColor;\n"
+  "void main() {\n"
+  "  fragColor = vec4(gl_FragCoord.xy, 0.0, 1.0);\n"
+  "}\n");
+
+static const QString kSizeShader = QStringLiteral(
+  "uniform sampler2D tex_in;\n"
+  "in vec2 ove_texcoord;\n"
+  "out vec4 fragColor;\n"
+  "void main() {\n"
+  "  fragColor = texture(tex_in, ove_texcoord / vec2(textureSize(tex_in, 0)));\n"
+  "}\n");
+
+/**
+ * @brief Node that returns one of the shaders above for each shader ID
+ */
+class FusionTestNode : public Node
+{
+public:
+  FusionTestNode() = default;
+
+  NODE_DEFAULT_DESTRUCTOR(FusionTestNode)
+
+  virtual Node* copy() const override
+  {
+    return new FusionTestNode();
+  }
+
+  virtual QString Name() const override
+  {
+    return QStringLiteral("Fusion Test");
+  }
+
+  virtual QString id() const override
+  {
+    return QStringLiteral("org.olivevideoeditor.Olive.fusiontest");
+  }
+
+  virtual QVector<CategoryID> Category() const override
+  {
+    return {kCategoryUnknown};
+  }
+
+  virtual ShaderCode GetShaderCode(const QString &shader_id) const override
+  {
+    if (shader_id == QStringLiteral("producer")) {
+      return ShaderCode(kProducerShader);
+    } else if (shader_id == QStringLiteral("consumer")) {
+      return ShaderCode(kConsumerShader);
+    } else if (shader_id == QStringLiteral("position")) {
+      return ShaderCode(kPositionShader);
+    } else if (shader_id == QStringLiteral("size")) {
+      return ShaderCode(kSizeShader);
+    } else if (shader_id == QStringLiteral("vertex")) {
+      return ShaderCode(kProducerShader, QStringLiteral("void main() {}\n"));
+    }
+
+    return ShaderCode();
+  }
+};
+
+static ShaderJob CreateJob(const QString& shader_id)
+{
+  ShaderJob job;
+  job.SetShaderID(shader_id);
+  return job;
+}
+
+static QVector<ShaderFusion::Stage> CreateChain(const Node* node, bool mapped)
+{
+  ShaderFusion::Stage producer;
+  producer.node = node;
+  producer.job = CreateJob(QStringLiteral("producer"));
+  producer.job.InsertValue(QStringLiteral("color_in"), NodeValue(NodeValue::kVec4, QVector4D(1.0, 0.0, 0.0, 1.0)));
+  producer.job.InsertValue(QStringLiteral("ove_mvpmat"), NodeValue(NodeValue::kMatrix, QMatrix4x4()));
+  producer.channel_count = VideoParams::kRGBAChannelCount;
+  producer.mapped = mapped;
+
+  ShaderFusion::Stage consumer;
+  consumer.node = node;
+  consumer.job = CreateJob(QStringLiteral("consumer"));
+  consumer.job.InsertValue(QStringLiteral("tex_in"), NodeValue(NodeValue::kTexture, QVariant()));
+  consumer.job.InsertValue(QStringLiteral("amount_in"), NodeValue(NodeValue::kFloat, 0.5));
+  consumer.job.InsertValue(QStringLiteral("ove_mvpmat"), NodeValue(NodeValue::kMatrix, QMatrix4x4()));
+  consumer.job.SetPerPixelInput(QStringLiteral("tex_in"));
+  consumer.channel_count = VideoParams::kRGBAChannelCount;
+  consumer.mapped = false;
+  consumer.inputs.insert(QStringLiteral("tex_in"), 0);
+
+  return {producer, consumer};
+}
+
+OLIVE_ADD_TEST(ShaderFusionCanInline)
+{
+  FusionTestNode node;
+
+  // A plain fragment shader can be turned into a function of its coordinate
+  OLIVE_ASSERT(ShaderFusion::CanInline(&node, CreateJob(QStringLiteral("producer"))));
+  OLIVE_ASSERT(ShaderFusion::CanInline(&node, CreateJob(QStringLiteral("consumer"))));
+
+  // Anything depending on where it's drawn can't
+  OLIVE_ASSERT(!ShaderFusion::CanInline(&node, CreateJob(QStringLiteral("position"))));
+
+  // Nor can anything with its own vertex shader, since that stage is shared
+  OLIVE_ASSERT(!ShaderFusion::CanInline(&node, CreateJob(QStringLiteral("vertex"))));
+
+  // Iterative shaders need their own output between iterations
+  ShaderJob iterative = CreateJob(QStringLiteral("consumer"));
+  iterative.SetIterations(2, QStringLiteral("tex_in"));
+  OLIVE_ASSERT(!ShaderFusion::CanInline(&node, iterative));
+
+  OLIVE_TEST_END;
+}
+
+OLIVE_ADD_TEST(ShaderFusionGenerateStages)
+{
+  FusionTestNode node;
+
+  ShaderCode code;
+  OLIVE_ASSERT(ShaderFusion::GenerateCode(CreateChain(&node, false), &code));
+
+  const QString& frag = code.frag_code();
+
+  // Uniforms are prefixed per stage so they can't collide
+  OLIVE_ASSERT(frag.contains(QStringLiteral("uniform vec4 s0_color_in;")));
+  OLIVE_ASSERT(frag.contains(QStringLiteral("uniform float s1_amount_in;")));
+
+  // The inlined input's sampler is replaced by a call to the stage that computes it
+  OLIVE_ASSERT(!frag.contains(QStringLiteral("s1_tex_in")));
+  OLIVE_ASSERT(frag.contains(QStringLiteral("ove_fused_stage0(")));
+
+  // The last stage is the one that's drawn
+  OLIVE_ASSERT(frag.contains(QStringLiteral("fragColor = ove_fused_stage1(ove_texcoord);")));
+
+  // An unmapped producer is evaluated at exactly the consumer's coordinate
+  OLIVE_ASSERT(!frag.contains(QStringLiteral("s0_ove_texmat")));
+
+  // All stages share the default vertex shader
+  OLIVE_ASSERT(code.vert_code() == ShaderCode().vert_code());
+
+  OLIVE_TEST_END;
+}
+
+OLIVE_ADD_TEST(ShaderFusionMappedStage)
+{
+  FusionTestNode node;
+
+  QVector<ShaderFusion::Stage> stages = CreateChain(&node, true);
+
+  ShaderCode code;
+  OLIVE_ASSERT(ShaderFusion::GenerateCode(stages, &code));
+
+  // A mapped producer's matrix is applied to the coordinate instead of the vertices
+  OLIVE_ASSERT(code.frag_code().contains(QStringLiteral("uniform mat4 s0_ove_texmat;")));
+
+  ShaderJob merged = ShaderFusion::MergeJobs(stages);
+
+  OLIVE_ASSERT(merged.GetValues().contains(QStringLiteral("s0_ove_texmat")));
+  OLIVE_ASSERT(merged.GetValues().contains(QStringLiteral("ove_mvpmat")));
+  OLIVE_ASSERT(merged.GetValues().contains(QStringLiteral("s0_color_in")));
+  OLIVE_ASSERT(merged.GetValues().contains(QStringLiteral("s1_amount_in")));
+
+  // The inlined input doesn't need a texture, but its shader may still check it's connected
+  OLIVE_ASSERT(!merged.GetValues().contains(QStringLiteral("s1_tex_in")));
+  OLIVE_ASSERT(merged.GetValue(QStringLiteral("s1_tex_in_enabled")).data().toBool());
+
+  OLIVE_TEST_END;
+}
+
+OLIVE_ADD_TEST(ShaderFusionUnsupportedSampler)
+{
+  FusionTestNode node;
+
+  QVector<ShaderFusion::Stage> stages = CreateChain(&node, false);
+  stages[1].job.SetShaderID(QStringLiteral("size"));
+
+  // textureSize() can't be answered without a real texture, so this chain can't be fused
+  ShaderCode code;
+  OLIVE_ASSERT(!ShaderFusion::GenerateCode(stages, &code));
+
+  OLIVE_TEST_END;
+}
+
+OLIVE_ADD_TEST(ShaderFusionCacheKey)
+{
+  FusionTestNode node;
+
+  QVector<ShaderFusion::Stage> chain = CreateChain(&node, false);
+
+  // Only the chain's structure matters, not its values
+  QVector<ShaderFusion::Stage> other_values = CreateChain(&node, false);
+  other_values[1].job.InsertValue(QStringLiteral("amount_in"), NodeValue(NodeValue::kFloat, 1.0));
+  OLIVE_ASSERT(ShaderFusion::GetCacheKey(chain) == ShaderFusion::GetCacheKey(other_values));
+
+  // Mapping a stage changes the code
+  OLIVE_ASSERT(ShaderFusion::GetCacheKey(chain) != ShaderFusion::GetCacheKey(CreateChain(&node, true)));
+
+  // So does dropping the alpha channel of an intermediate
+  QVector<ShaderFusion::Stage> opaque = CreateChain(&node, false);
+  opaque[0].channel_count = VideoParams::kRGBChannelCount;
+  OLIVE_ASSERT(ShaderFusion::GetCacheKey(chain) != ShaderFusion::GetCacheKey(opaque));
+
+  OLIVE_TEST_END;
+}
+
+}
@@ -0,0 +1,130 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2021 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "testutil.h"
+
+#include "render/texturepool.h"
+
+namespace olive {
+
+static TexturePool::Key CreateKey(int width, int height, VideoParams::Format format = VideoParams::kFormatUnsigned8, int channels = VideoParams::kRGBAChannelCount)
+{
+  return {width, height, format, channels};
+}
+
+OLIVE_ADD_TEST(TexturePoolKeyMatching)
+{
+  TexturePool pool;
+  QVector<QVariant> evicted;
+
+  pool.Give(CreateKey(1920, 1080), 1, &evicted);
+
+  // Textures are only reused for exactly the same dimensions, format and channel count
+  OLIVE_ASSERT(pool.Take(CreateKey(1280, 720)).isNull());
+  OLIVE_ASSERT(pool.Take(CreateKey(1920, 1080, VideoParams::kFormatFloat16)).isNull());
+  OLIVE_ASSERT(pool.Take(CreateKey(1920, 1080, VideoParams::kFormatUnsigned8, VideoParams::kRGBChannelCount)).isNull());
+
+  OLIVE_ASSERT(pool.Take(CreateKey(1920, 1080)).toInt() == 1);
+
+  // Taking a texture removes it from the pool
+  OLIVE_ASSERT(pool.Take(CreateKey(1920, 1080)).isNull());
+
+  TexturePool::Stats stats = pool.GetStats();
+  OLIVE_ASSERT(stats.hits == 1);
+  OLIVE_ASSERT(stats.misses == 4);
+  OLIVE_ASSERT(stats.pooled_count == 0);
+  OLIVE_ASSERT(stats.pooled_bytes == 0);
+  OLIVE_ASSERT(evicted.isEmpty());
+
+  OLIVE_TEST_END;
+}
+
+OLIVE_ADD_TEST(TexturePoolMostRecentFirst)
+{
+  TexturePool pool;
+  QVector<QVariant> evicted;
+
+  pool.Give(CreateKey(64, 64), 1, &evicted);
+  pool.Give(CreateKey(64, 64), 2, &evicted);
+
+  // The most recently released texture is the most likely to still be resident
+  OLIVE_ASSERT(pool.Take(CreateKey(64, 64)).toInt() == 2);
+  OLIVE_ASSERT(pool.Take(CreateKey(64, 64)).toInt() == 1);
+
+  OLIVE_TEST_END;
+}
+
+OLIVE_ADD_TEST(TexturePoolEviction)
+{
+  TexturePool pool;
+  QVector<QVariant> evicted;
+
+  // 64x64 RGBA 8-bit is 16 KiB, so this fits two of them
+  pool.SetBudget(2 * 64 * 64 * 4, &evicted);
+  OLIVE_ASSERT(evicted.isEmpty());
+
+  pool.Give(CreateKey(64, 64), 1, &evicted);
+  pool.Give(CreateKey(64, 64), 2, &evicted);
+  OLIVE_ASSERT(evicted.isEmpty());
+
+  // Going over budget evicts the texture that was released longest ago
+  pool.Give(CreateKey(64, 64), 3, &evicted);
+  OLIVE_ASSERT(evicted.size() == 1);
+  OLIVE_ASSERT(evicted.first().toInt() == 1);
+
+  TexturePool::Stats stats = pool.GetStats();
+  OLIVE_ASSERT(stats.evictions == 1);
+  OLIVE_ASSERT(stats.pooled_count == 2);
+  OLIVE_ASSERT(stats.pooled_bytes == 2 * 64 * 64 * 4);
+
+  // Lowering the budget evicts immediately
+  evicted.clear();
+  pool.SetBudget(64 * 64 * 4, &evicted);
+  OLIVE_ASSERT(evicted.size() == 1);
+  OLIVE_ASSERT(evicted.first().toInt() == 2);
+
+  // A texture bigger than the whole budget isn't kept at all
+  evicted.clear();
+  pool.Give(CreateKey(128, 128), 4, &evicted);
+  OLIVE_ASSERT(evicted.size() == 2);
+  OLIVE_ASSERT(pool.GetStats().pooled_count == 0);
+
+  OLIVE_TEST_END;
+}
+
+OLIVE_ADD_TEST(TexturePoolClear)
+{
+  TexturePool pool;
+  QVector<QVariant> evicted;
+
+  pool.Give(CreateKey(64, 64), 1, &evicted);
+  pool.Give(CreateKey(32, 32), 2, &evicted);
+
+  // Everything comes back so the renderer can destroy it
+  QVector<QVariant> cleared = pool.Clear();
+  OLIVE_ASSERT(cleared.size() == 2);
+  OLIVE_ASSERT(pool.GetStats().pooled_count == 0);
+  OLIVE_ASSERT(pool.GetStats().pooled_bytes == 0);
+  OLIVE_ASSERT(pool.Take(CreateKey(64, 64)).isNull());
+
+  OLIVE_TEST_END;
+}
+
+}